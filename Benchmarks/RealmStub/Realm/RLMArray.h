@@ -0,0 +1,50 @@
+// RLMArray.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class RLMObject;
+
+// declares the protocol used to type the elements of an `RLMArray` property, e.g. `RLMArray<Car> *cars`
+#define RLM_ARRAY_TYPE(RLM_OBJECT_SUBCLASS)                                                                            \
+    @protocol RLM_OBJECT_SUBCLASS <NSObject>                                                                           \
+    @end
+
+/**
+ *  stand-in for Realm's `RLMArray`, an ordered list of objects of one class backed by an `NSMutableArray`
+ */
+@interface RLMArray : NSObject <NSFastEnumeration>
+
+- (instancetype)initWithObjectClassName:(NSString *)objectClassName;
+
+// name of the class of the objects
+@property (nonatomic, readonly, copy) NSString *objectClassName;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+- (id)objectAtIndex:(NSUInteger)index;
+
+- (void)addObject:(RLMObject *)object;
+
+- (void)addObjects:(id<NSFastEnumeration>)objects;
+
+@end
@@ -0,0 +1,42 @@
+// RLMObject.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class RLMRealm;
+
+/**
+ *  stand-in for Realm's `RLMObject`, so that `SHRealmObject` builds and runs in the benchmarks on Linux. only the API
+ *  used by `SHRealmObject` and the benchmarks is declared, objects are kept in memory by `RLMRealm`.
+ *
+ *  unmanaged objects get an empty `RLMArray` for every `RLMArray<Class>` ivar when they are created, like the
+ *  accessors of Realm create them on first use.
+ */
+@interface RLMObject : NSObject
+
+// the realm managing the object, nil until the object is added to one
+@property (nonatomic, readonly) RLMRealm *realm;
+
+// nil, subclasses return the name of their primary key property
++ (NSString *)primaryKey;
+
+@end
@@ -0,0 +1,69 @@
+// RLMRealm.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class RLMObject;
+
+/**
+ *  stand-in for Realm's `RLMRealm`, keeping the objects in memory. objects of classes with a `+primaryKey` are kept
+ *  once per key, the objects in their `RLMArray` ivars are added with them.
+ *
+ *  like Realm, adding objects outside a write transaction raises an exception. the writes of a transaction are applied
+ *  when it is committed and dropped when it is cancelled. nothing is written to disk, so the cost of a commit is not
+ *  the cost of a Realm commit.
+ */
+@interface RLMRealm : NSObject
+
+// the shared realm, only to be used on one thread at a time
++ (instancetype)defaultRealm;
+
+@property (nonatomic, readonly) BOOL inWriteTransaction;
+
+- (void)beginWriteTransaction;
+
+- (BOOL)commitWriteTransaction:(NSError **)error;
+
+- (void)cancelWriteTransaction;
+
+- (void)transactionWithBlock:(void (^)(void))block;
+
+- (void)addObject:(RLMObject *)object;
+
+- (void)addObjects:(id<NSFastEnumeration>)objects;
+
+- (void)addOrUpdateObject:(RLMObject *)object;
+
+- (void)addOrUpdateObjects:(id<NSFastEnumeration>)objects;
+
+- (void)deleteAllObjects;
+
+// number of objects of the class in the realm, only in the stand-in
+- (NSUInteger)countOfObjectsOfClass:(Class)cls;
+
+// number of write transactions committed, only in the stand-in
+@property (nonatomic, readonly) NSUInteger commitCount;
+
+// the next commit fails with this error and leaves the transaction open, only in the stand-in
+@property (nonatomic, strong) NSError *nextCommitError;
+
+@end
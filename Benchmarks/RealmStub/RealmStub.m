@@ -0,0 +1,272 @@
+// RealmStub.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <objc/runtime.h>
+#import "Realm/Realm.h"
+
+static void SHStubRaise(NSString *reason) {
+    [NSException raise:@"RLMException" format:@"%@", reason];
+}
+
+#pragma mark - RLMObject
+
+@interface RLMObject ()
+
+@property (nonatomic, readwrite) RLMRealm *realm;
+
+@end
+
+@implementation RLMObject
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        // `@"RLMArray<Car>"` -> an empty array of `Car`
+        for (Class cls = [self class]; cls != [RLMObject class]; cls = class_getSuperclass(cls)) {
+            unsigned int count = 0;
+            Ivar *ivars = class_copyIvarList(cls, &count);
+            for (unsigned int i = 0; i < count; i++) {
+                const char *encoding = ivar_getTypeEncoding(ivars[i]);
+                if (NULL == encoding || strncmp(encoding, "@\"RLMArray<", 11) != 0) {
+                    continue;
+                }
+                NSString *className = [[NSString alloc] initWithBytes:encoding + 11
+                                                               length:strcspn(encoding + 11, ">")
+                                                             encoding:NSUTF8StringEncoding];
+                object_setIvar(self, ivars[i], [[RLMArray alloc] initWithObjectClassName:className]);
+            }
+            free(ivars);
+        }
+    }
+    return self;
+}
+
++ (NSString *)primaryKey {
+    return nil;
+}
+
+// objects in the `RLMArray` and `RLMObject` ivars, added to the realm with the object
+- (NSArray *)linkedObjects {
+    NSMutableArray *linked = [NSMutableArray array];
+    for (Class cls = [self class]; cls != [RLMObject class]; cls = class_getSuperclass(cls)) {
+        unsigned int count = 0;
+        Ivar *ivars = class_copyIvarList(cls, &count);
+        for (unsigned int i = 0; i < count; i++) {
+            const char *encoding = ivar_getTypeEncoding(ivars[i]);
+            if (NULL == encoding || encoding[0] != '@') {
+                continue;
+            }
+            id value = object_getIvar(self, ivars[i]);
+            if ([value isKindOfClass:[RLMArray class]]) {
+                for (id item in value) {
+                    [linked addObject:item];
+                }
+            } else if ([value isKindOfClass:[RLMObject class]]) {
+                [linked addObject:value];
+            }
+        }
+        free(ivars);
+    }
+    return linked;
+}
+
+@end
+
+#pragma mark - RLMArray
+
+@implementation RLMArray {
+    NSMutableArray *_objects;
+}
+
+- (instancetype)initWithObjectClassName:(NSString *)objectClassName {
+    if ((self = [super init])) {
+        _objectClassName = [objectClassName copy];
+        _objects = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (NSUInteger)count {
+    return [_objects count];
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+    return _objects[index];
+}
+
+- (void)addObject:(RLMObject *)object {
+    [_objects addObject:object];
+}
+
+- (void)addObjects:(id<NSFastEnumeration>)objects {
+    for (id object in objects) {
+        [_objects addObject:object];
+    }
+}
+
+- (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state
+                                  objects:(__unsafe_unretained id[])buffer
+                                    count:(NSUInteger)len {
+    return [_objects countByEnumeratingWithState:state objects:buffer count:len];
+}
+
+@end
+
+#pragma mark - RLMRealm
+
+@implementation RLMRealm {
+    // class name to primary key to object, for classes with a primary key
+    NSMutableDictionary *_keyedObjects;
+    // class name to array of objects, for classes without one
+    NSMutableDictionary *_objects;
+    // objects added in the current write transaction, in order
+    NSMutableArray *_pending;
+}
+
++ (instancetype)defaultRealm {
+    static RLMRealm *realm = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ realm = [[RLMRealm alloc] init]; });
+    return realm;
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        _keyedObjects = [NSMutableDictionary dictionary];
+        _objects = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (BOOL)inWriteTransaction {
+    return _pending != nil;
+}
+
+- (void)beginWriteTransaction {
+    if (_pending) {
+        SHStubRaise(@"The Realm is already in a write transaction");
+    }
+    _pending = [NSMutableArray array];
+}
+
+- (BOOL)commitWriteTransaction:(NSError **)error {
+    if (nil == _pending) {
+        SHStubRaise(@"Can't commit a non-existing write transaction");
+    }
+    if (_nextCommitError) {
+        if (error) {
+            *error = _nextCommitError;
+        }
+        _nextCommitError = nil;
+        return NO;
+    }
+    for (RLMObject *object in _pending) {
+        NSString *className = NSStringFromClass([object class]);
+        NSString *primaryKey = [[object class] primaryKey];
+        if (primaryKey) {
+            NSMutableDictionary *objects = _keyedObjects[className];
+            if (nil == objects) {
+                objects = [NSMutableDictionary dictionary];
+                _keyedObjects[className] = objects;
+            }
+            objects[[object valueForKey:primaryKey]] = object;
+        } else {
+            NSMutableArray *objects = _objects[className];
+            if (nil == objects) {
+                objects = [NSMutableArray array];
+                _objects[className] = objects;
+            }
+            [objects addObject:object];
+        }
+    }
+    _pending = nil;
+    _commitCount++;
+    return YES;
+}
+
+- (void)cancelWriteTransaction {
+    for (RLMObject *object in _pending) {
+        object.realm = nil;
+    }
+    _pending = nil;
+}
+
+- (void)transactionWithBlock:(void (^)(void))block {
+    [self beginWriteTransaction];
+    block();
+    [self commitWriteTransaction:NULL];
+}
+
+// adding an object whose primary key is taken raises in Realm, the stand-in replaces the object
+- (void)addObject:(RLMObject *)object {
+    [self addOrUpdateObject:object];
+}
+
+- (void)addObjects:(id<NSFastEnumeration>)objects {
+    for (RLMObject *object in objects) {
+        [self addObject:object];
+    }
+}
+
+- (void)addOrUpdateObject:(RLMObject *)object {
+    if (nil == _pending) {
+        SHStubRaise(@"Can only add objects to a Realm in a write transaction");
+    }
+    if (object.realm == self) {
+        return;
+    }
+    object.realm = self;
+    [_pending addObject:object];
+    for (RLMObject *linked in [object linkedObjects]) {
+        [self addOrUpdateObject:linked];
+    }
+}
+
+- (void)addOrUpdateObjects:(id<NSFastEnumeration>)objects {
+    for (RLMObject *object in objects) {
+        [self addOrUpdateObject:object];
+    }
+}
+
+- (void)deleteAllObjects {
+    if (nil == _pending) {
+        SHStubRaise(@"Can only delete objects from a Realm in a write transaction");
+    }
+    for (NSDictionary *objects in [_keyedObjects objectEnumerator]) {
+        for (RLMObject *object in [objects objectEnumerator]) {
+            object.realm = nil;
+        }
+    }
+    for (NSArray *objects in [_objects objectEnumerator]) {
+        for (RLMObject *object in objects) {
+            object.realm = nil;
+        }
+    }
+    [_keyedObjects removeAllObjects];
+    [_objects removeAllObjects];
+}
+
+- (NSUInteger)countOfObjectsOfClass:(Class)cls {
+    NSString *className = NSStringFromClass(cls);
+    return [_keyedObjects[className] count] + [_objects[className] count];
+}
+
+@end
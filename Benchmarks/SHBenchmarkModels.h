@@ -0,0 +1,96 @@
+// SHBenchmarkModels.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHModelObject.h"
+
+// field counts used to report the time per field
+#define WIDE_MODEL_FIELD_COUNT 24
+#define NODE_MODEL_FIELD_COUNT 4
+#define DATE_MODEL_FIELD_COUNT 5
+
+/**
+ *  flat model with 24 fields of the usual types, decoded from `snake_case` keys
+ */
+@interface SHBenchWideModel : SHModelObject {
+    NSString *_string1;
+    NSString *_string2;
+    NSString *_string3;
+    NSString *_string4;
+    NSString *_string5;
+    NSString *_string6;
+    NSString *_string7;
+    NSString *_string8;
+    int _int1;
+    int _int2;
+    int _int3;
+    int _int4;
+    int _int5;
+    int _int6;
+    double _double1;
+    double _double2;
+    double _double3;
+    double _double4;
+    BOOL _flag1;
+    BOOL _flag2;
+    NSNumber *_number1;
+    NSNumber *_number2;
+    long long _long1;
+    long long _long2;
+}
+
+@end
+
+/**
+ *  node of a chain of nested models, like `SHAnotherModel` children nested in each other
+ */
+@interface SHBenchNodeModel : SHModelObject {
+    NSString *_name;
+    int _level;
+    double _weight;
+    SHBenchNodeModel *_child;
+}
+
+@end
+
+/**
+ *  feed with a large array mapped to `SHAnotherModel`
+ */
+@interface SHBenchFeedModel : SHModelObject {
+    NSString *_title;
+    int _count;
+    NSArray *_entries;
+}
+
+@end
+
+/**
+ *  record with four dates, decoded to `NSDate`
+ */
+@interface SHBenchDateModel : SHModelObject {
+    NSString *_identifier;
+    NSDate *_created;
+    NSDate *_updated;
+    NSDate *_published;
+    NSDate *_expires;
+}
+
+@end
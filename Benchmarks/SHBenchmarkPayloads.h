@@ -0,0 +1,50 @@
+// SHBenchmarkPayloads.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "SHConstants.h"
+
+// date format of the custom date benchmarks
+extern NSString *const SHBenchCustomDateFormat;
+
+/**
+ *  the payloads are generated from a fixed seed, every run decodes exactly the same dictionaries. dates are formatted
+ *  in the default time zone, the runner sets it to UTC.
+ */
+
+// `count` flat dictionaries for `SHBenchWideModel`
+NSArray *SHBenchWidePayloads(NSUInteger count);
+
+// `count` chains of `depth` nested dictionaries for `SHBenchNodeModel`
+NSArray *SHBenchNestedPayloads(NSUInteger count, NSUInteger depth);
+
+// one dictionary for `SHBenchFeedModel` with `entryCount` entries for `SHAnotherModel`
+NSDictionary *SHBenchFeedPayload(NSUInteger entryCount);
+
+// `count` dictionaries for `SHBenchDateModel` with dates in the input format
+NSArray *SHBenchDatePayloads(NSUInteger count, kInputDateFormat format);
+
+// `count` date strings in the input format
+NSArray *SHBenchDateStrings(NSUInteger count, kInputDateFormat format);
+
+// short name of the input format, used in benchmark names
+NSString *SHBenchDateFormatName(kInputDateFormat format);
@@ -0,0 +1,165 @@
+// SHBenchmarkPayloads.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHBenchmarkPayloads.h"
+#import "SHDateParsing.h"
+
+NSString *const SHBenchCustomDateFormat = @"yyyy/MM/dd HH:mm:ss";
+
+#define PAYLOAD_SEED 20140420
+
+// 2000-01-01 and 2030-01-01 in seconds since 1970
+#define FIRST_DATE 946684800
+#define DATE_RANGE 946771200
+
+// xorshift32, the same sequence on every platform
+static uint32_t SHBenchRandom(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static NSString *SHBenchRandomString(uint32_t *state) {
+    static const char letters[] = "abcdefghijklmnopqrstuvwxyz ";
+    char buffer[33];
+    NSUInteger length = 8 + SHBenchRandom(state) % 24;
+    for (NSUInteger i = 0; i < length; i++) {
+        buffer[i] = letters[SHBenchRandom(state) % (sizeof(letters) - 1)];
+    }
+    return [[NSString alloc] initWithBytes:buffer length:length encoding:NSASCIIStringEncoding];
+}
+
+static double SHBenchRandomDouble(uint32_t *state) {
+    return (double)SHBenchRandom(state) / 1000.0;
+}
+
+// whole seconds, so every format can represent the date exactly
+static NSDate *SHBenchRandomDate(uint32_t *state) {
+    return [NSDate dateWithTimeIntervalSince1970:FIRST_DATE + SHBenchRandom(state) % DATE_RANGE];
+}
+
+static NSString *SHBenchDateString(NSDate *date, kInputDateFormat format) {
+    switch (format) {
+        case kInputDateFormatDotNetSimple:
+            return [SHDateFormatterForFormat(SHDotNetSimpleDateFormat) stringFromDate:date];
+        case kInputDateFormatDotNetWithTimeZone:
+            return [SHDateFormatterForFormat(SHDotNetDateWithTimeZoneFormat) stringFromDate:date];
+        case kInputDateFormatCustom:
+            return [SHDateFormatterForFormat(SHBenchCustomDateFormat) stringFromDate:date];
+        default:
+            return SHDotNetJSONDateString([date timeIntervalSince1970]);
+    }
+}
+
+NSArray *SHBenchWidePayloads(NSUInteger count) {
+    uint32_t state = PAYLOAD_SEED;
+    NSMutableArray *payloads = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSMutableDictionary *payload = [NSMutableDictionary dictionary];
+        for (int field = 1; field <= 8; field++) {
+            payload[[NSString stringWithFormat:@"string_%d", field]] = SHBenchRandomString(&state);
+        }
+        for (int field = 1; field <= 6; field++) {
+            payload[[NSString stringWithFormat:@"int_%d", field]] = @((int)(SHBenchRandom(&state) % 100000));
+        }
+        for (int field = 1; field <= 4; field++) {
+            payload[[NSString stringWithFormat:@"double_%d", field]] = @(SHBenchRandomDouble(&state));
+        }
+        for (int field = 1; field <= 2; field++) {
+            payload[[NSString stringWithFormat:@"flag_%d", field]] = (SHBenchRandom(&state) & 1) ? @YES : @NO;
+            payload[[NSString stringWithFormat:@"number_%d", field]] = @(SHBenchRandom(&state));
+            payload[[NSString stringWithFormat:@"long_%d", field]] = @((long long)SHBenchRandom(&state) << 20);
+        }
+        [payloads addObject:payload];
+    }
+    return payloads;
+}
+
+static NSDictionary *SHBenchNodePayload(NSUInteger level, NSUInteger depth, uint32_t *state) {
+    NSMutableDictionary *payload = [NSMutableDictionary dictionary];
+    payload[@"name"] = SHBenchRandomString(state);
+    payload[@"level"] = @(level);
+    payload[@"weight"] = @(SHBenchRandomDouble(state));
+    if (level + 1 < depth) {
+        payload[@"child"] = SHBenchNodePayload(level + 1, depth, state);
+    }
+    return payload;
+}
+
+NSArray *SHBenchNestedPayloads(NSUInteger count, NSUInteger depth) {
+    uint32_t state = PAYLOAD_SEED;
+    NSMutableArray *payloads = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [payloads addObject:SHBenchNodePayload(0, depth, &state)];
+    }
+    return payloads;
+}
+
+NSDictionary *SHBenchFeedPayload(NSUInteger entryCount) {
+    uint32_t state = PAYLOAD_SEED;
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:entryCount];
+    for (NSUInteger i = 0; i < entryCount; i++) {
+        [entries addObject:@{
+            @"model_id" : @(i),
+            @"model_name" : SHBenchRandomString(&state),
+            @"model_type" : SHBenchRandomString(&state)
+        }];
+    }
+    return @{ @"title" : @"feed", @"count" : @(entryCount), @"entries" : entries };
+}
+
+NSArray *SHBenchDatePayloads(NSUInteger count, kInputDateFormat format) {
+    uint32_t state = PAYLOAD_SEED;
+    NSMutableArray *payloads = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [payloads addObject:@{
+            @"identifier" : SHBenchRandomString(&state),
+            @"created" : SHBenchDateString(SHBenchRandomDate(&state), format),
+            @"updated" : SHBenchDateString(SHBenchRandomDate(&state), format),
+            @"published" : SHBenchDateString(SHBenchRandomDate(&state), format),
+            @"expires" : SHBenchDateString(SHBenchRandomDate(&state), format)
+        }];
+    }
+    return payloads;
+}
+
+NSArray *SHBenchDateStrings(NSUInteger count, kInputDateFormat format) {
+    uint32_t state = PAYLOAD_SEED;
+    NSMutableArray *strings = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [strings addObject:SHBenchDateString(SHBenchRandomDate(&state), format)];
+    }
+    return strings;
+}
+
+NSString *SHBenchDateFormatName(kInputDateFormat format) {
+    switch (format) {
+        case kInputDateFormatJSON: return @"json";
+        case kInputDateFormatDotNetSimple: return @"dotnet-simple";
+        case kInputDateFormatDotNetWithTimeZone: return @"dotnet-timezone";
+        case kInputDateFormatCustom: return @"custom";
+        default: return @"unknown";
+    }
+}
@@ -0,0 +1,35 @@
+// SHBenchmarkRealm.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class SHBenchmarkRunner;
+
+/**
+ *  imports rows into the in-memory `RLMRealm` stand-in of `RealmStub/`, one write transaction per object like
+ *  `SHAppDelegate` does, and with `createOrUpdateObjectsWithArray:inRealm:`. kept out of `main.m` because
+ *  `SHRealmObject.h` and `SHModelObject.h` both declare `NSString (Additions)`.
+ *
+ *  @param runner the runner
+ *  @param rows dictionaries with `model_id`, `model_name` and `model_type`
+ */
+void SHBenchRunRealmImport(SHBenchmarkRunner *runner, NSArray *rows);
@@ -0,0 +1,69 @@
+// SHBenchmarkRealm.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHBenchmarkRealm.h"
+#import <Realm/RLMRealm.h>
+#import "SHRealmObject.h"
+#import "SHBenchmarkRunner.h"
+
+// keeps the compiler from dropping the measured work
+static id _sink;
+
+/**
+ *  `SHAnotherModel` as a realm object, keyed by `modelId`
+ */
+@interface SHBenchRealmEntry : SHRealmObject
+
+@property int modelId;
+@property NSString *modelName;
+@property NSString *modelType;
+
+@end
+
+@implementation SHBenchRealmEntry
+
++ (NSString *)primaryKey {
+    return @"modelId";
+}
+
+@end
+
+void SHBenchRunRealmImport(SHBenchmarkRunner *runner, NSArray *rows) {
+    RLMRealm *realm = [RLMRealm defaultRealm];
+
+    [runner runBenchmark:@"import/realm-per-object"
+                 objects:[rows count]
+         fieldsPerObject:3
+                   block:^{
+                       for (NSDictionary *row in rows) {
+                           [realm transactionWithBlock:^{
+                               [realm addOrUpdateObject:[SHBenchRealmEntry objectWithDictionary:row]];
+                           }];
+                       }
+                   }];
+    [runner runBenchmark:@"import/realm-batched"
+                 objects:[rows count]
+         fieldsPerObject:3
+                   block:^{ _sink = [SHBenchRealmEntry createOrUpdateObjectsWithArray:rows inRealm:realm]; }];
+
+    [realm transactionWithBlock:^{ [realm deleteAllObjects]; }];
+}
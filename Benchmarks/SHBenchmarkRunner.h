@@ -0,0 +1,100 @@
+// SHBenchmarkRunner.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  The `SHBenchmarkResult` holds the numbers measured for one benchmark.
+ */
+@interface SHBenchmarkResult : NSObject
+
+@property (nonatomic, readonly) NSString *name;
+@property (nonatomic, readonly) double objectsPerSecond;
+@property (nonatomic, readonly) double nanosecondsPerField;
+
+// objective-c objects allocated per decoded object, negative where allocations cannot be counted
+@property (nonatomic, readonly) double allocationsPerObject;
+
+// the result as written to the results file
+- (NSDictionary *)JSONObject;
+
+@end
+
+/**
+ *  The `SHBenchmarkRunner` times benchmarks, writes the results as JSON and compares them with a baseline file.
+ *
+ *  every benchmark runs once to warm up (building the class plans and caches), then until it ran at least five
+ *  times and for at least `minimumDuration`. the median run is reported. allocations are counted in one extra run,
+ *  with the GNUstep allocation debugging, as counting slows the run down.
+ */
+@interface SHBenchmarkRunner : NSObject
+
+- (instancetype)initWithMinimumDuration:(NSTimeInterval)minimumDuration filter:(NSString *)filter;
+
+// array of `SHBenchmarkResult` in the order the benchmarks ran
+@property (nonatomic, readonly) NSArray *results;
+
+/**
+ *  runs a benchmark unless its name does not contain the filter
+ *
+ *  @param name unique name of the benchmark, results are matched with the baseline by it
+ *  @param objectCount number of objects one call of the block decodes (or encodes or parses)
+ *  @param fieldCount average number of fields per object
+ *  @param block the measured work
+ */
+- (void)runBenchmark:(NSString *)name
+             objects:(NSUInteger)objectCount
+     fieldsPerObject:(NSUInteger)fieldCount
+               block:(void (^)(void))block;
+
+/**
+ *  writes the results as JSON
+ *
+ *  @param path path of the results file
+ *
+ *  @return `NO` if the file could not be written
+ */
+- (BOOL)writeResultsToPath:(NSString *)path;
+
+/**
+ *  checks if a baseline was recorded. the checked-in baseline has no results until it is recorded on the reference
+ *  machine, runs skip the comparison then.
+ *
+ *  @param path path of the baseline file
+ *
+ *  @return `NO` if the file does not exist or holds no results
+ */
++ (BOOL)hasBaselineResultsAtPath:(NSString *)path;
+
+/**
+ *  compares the results with a results file written before. a benchmark regressed when its time per field grew by
+ *  more than `tolerance` or when it allocates more objects per object than before. a benchmark missing from a
+ *  recorded baseline counts as a regression, see `hasBaselineResultsAtPath:` for baselines without any results.
+ *
+ *  @param path path of the baseline file
+ *  @param tolerance allowed slowdown, e.g. `0.1` for 10%
+ *
+ *  @return descriptions of the regressions, nil if the baseline could not be read
+ */
+- (NSArray *)regressionsAgainstBaselineAtPath:(NSString *)path tolerance:(double)tolerance;
+
+@end
@@ -0,0 +1,236 @@
+// SHBenchmarkRunner.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHBenchmarkRunner.h"
+#include <time.h>
+#ifdef GNUSTEP
+#import <Foundation/NSDebug.h>
+#endif
+
+#define RESULTS_VERSION 1
+#define MINIMUM_RUNS 5
+
+// allocations are deterministic, anything above half an object more per object is a real change
+#define ALLOCATION_TOLERANCE 0.5
+
+static uint64_t SHBenchNanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+}
+
+// objects allocated since allocation debugging was turned on, -1 where it is not available
+static long long SHBenchAllocationCount(void) {
+#ifdef GNUSTEP
+    long long total = 0;
+    Class *classes = GSDebugAllocationClassList();
+    for (Class *cls = classes; cls && *cls; cls++) {
+        total += GSDebugAllocationTotal(*cls);
+    }
+    NSZoneFree(NSDefaultMallocZone(), classes);
+    return total;
+#else
+    return -1;
+#endif
+}
+
+static void SHBenchSetAllocationCounting(BOOL active) {
+#ifdef GNUSTEP
+    GSDebugAllocationActive(active);
+#endif
+}
+
+#pragma mark - SHBenchmarkResult
+
+@implementation SHBenchmarkResult
+
+- (instancetype)initWithName:(NSString *)name
+            objectsPerSecond:(double)objectsPerSecond
+         nanosecondsPerField:(double)nanosecondsPerField
+        allocationsPerObject:(double)allocationsPerObject {
+    if ((self = [super init])) {
+        _name = [name copy];
+        _objectsPerSecond = objectsPerSecond;
+        _nanosecondsPerField = nanosecondsPerField;
+        _allocationsPerObject = allocationsPerObject;
+    }
+    return self;
+}
+
+- (NSDictionary *)JSONObject {
+    return @{
+        @"name" : _name,
+        @"objectsPerSecond" : @(_objectsPerSecond),
+        @"nanosecondsPerField" : @(_nanosecondsPerField),
+        @"allocationsPerObject" : _allocationsPerObject < 0 ? [NSNull null] : @(_allocationsPerObject)
+    };
+}
+
+@end
+
+#pragma mark - SHBenchmarkRunner
+
+@implementation SHBenchmarkRunner {
+    NSTimeInterval _minimumDuration;
+    NSString *_filter;
+    NSMutableArray *_results;
+}
+
+- (instancetype)initWithMinimumDuration:(NSTimeInterval)minimumDuration filter:(NSString *)filter {
+    if ((self = [super init])) {
+        _minimumDuration = minimumDuration;
+        _filter = [filter copy];
+        _results = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (NSArray *)results {
+    return [_results copy];
+}
+
+- (void)runBenchmark:(NSString *)name
+             objects:(NSUInteger)objectCount
+     fieldsPerObject:(NSUInteger)fieldCount
+               block:(void (^)(void))block {
+    if ([_filter length] > 0 && [name rangeOfString:_filter].location == NSNotFound) {
+        return;
+    }
+
+    @autoreleasepool {
+        block();
+    }
+
+    NSMutableArray *durations = [NSMutableArray array];
+    uint64_t total = 0;
+    while ([durations count] < MINIMUM_RUNS || total < _minimumDuration * NSEC_PER_SEC) {
+        uint64_t start = SHBenchNanoseconds();
+        @autoreleasepool {
+            block();
+        }
+        uint64_t duration = SHBenchNanoseconds() - start;
+        [durations addObject:@(duration)];
+        total += duration;
+    }
+    [durations sortUsingSelector:@selector(compare:)];
+    double median = [durations[[durations count] / 2] doubleValue];
+
+    double allocationsPerObject = -1;
+    SHBenchSetAllocationCounting(YES);
+    long long before = SHBenchAllocationCount();
+    if (before >= 0) {
+        @autoreleasepool {
+            block();
+        }
+        allocationsPerObject = (double)(SHBenchAllocationCount() - before) / MAX(objectCount, 1);
+    }
+    SHBenchSetAllocationCounting(NO);
+
+    SHBenchmarkResult *result =
+        [[SHBenchmarkResult alloc] initWithName:name
+                               objectsPerSecond:objectCount / (median / NSEC_PER_SEC)
+                            nanosecondsPerField:median / MAX(objectCount * fieldCount, 1)
+                           allocationsPerObject:allocationsPerObject];
+    [_results addObject:result];
+
+    if (allocationsPerObject < 0) {
+        printf("%-40s %14.0f obj/s %10.1f ns/field %12s\n", [name UTF8String], result.objectsPerSecond,
+               result.nanosecondsPerField, "-");
+    } else {
+        printf("%-40s %14.0f obj/s %10.1f ns/field %6.1f allocs/obj\n", [name UTF8String], result.objectsPerSecond,
+               result.nanosecondsPerField, allocationsPerObject);
+    }
+    fflush(stdout);
+}
+
+- (BOOL)writeResultsToPath:(NSString *)path {
+    NSMutableArray *results = [NSMutableArray arrayWithCapacity:[_results count]];
+    for (SHBenchmarkResult *result in _results) {
+        [results addObject:[result JSONObject]];
+    }
+    NSDictionary *root = @{ @"version" : @RESULTS_VERSION, @"results" : results };
+
+    NSError *error = nil;
+    NSData *data = [NSJSONSerialization dataWithJSONObject:root options:NSJSONWritingPrettyPrinted error:&error];
+    if (nil == data || ![data writeToFile:path atomically:YES]) {
+        NSLog(@"could not write the results to %@: %@", path, error);
+        return NO;
+    }
+    return YES;
+}
+
++ (BOOL)hasBaselineResultsAtPath:(NSString *)path {
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    NSDictionary *root = data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+    if (![root isKindOfClass:[NSDictionary class]]) {
+        // a file that exists but cannot be read is reported by the comparison
+        return nil != data;
+    }
+    NSArray *results = root[@"results"];
+    return [results isKindOfClass:[NSArray class]] && [results count] > 0;
+}
+
+- (NSArray *)regressionsAgainstBaselineAtPath:(NSString *)path tolerance:(double)tolerance {
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    NSDictionary *root = data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+    if (![root isKindOfClass:[NSDictionary class]] || [root[@"version"] intValue] != RESULTS_VERSION) {
+        NSLog(@"%@ is not a baseline written by this version of the benchmarks.", path);
+        return nil;
+    }
+
+    NSMutableDictionary *baseline = [NSMutableDictionary dictionary];
+    for (NSDictionary *entry in root[@"results"]) {
+        if ([entry isKindOfClass:[NSDictionary class]] && [entry[@"name"] isKindOfClass:[NSString class]]) {
+            baseline[entry[@"name"]] = entry;
+        }
+    }
+
+    NSMutableArray *regressions = [NSMutableArray array];
+    for (SHBenchmarkResult *result in _results) {
+        NSDictionary *entry = baseline[result.name];
+        // a benchmark that was never recorded cannot pass, the baseline has to be recorded first
+        if (nil == entry) {
+            [regressions addObject:[NSString stringWithFormat:@"%@: no baseline, record one with `make baseline`",
+                                                              result.name]];
+            continue;
+        }
+
+        double nanosecondsPerField = [entry[@"nanosecondsPerField"] doubleValue];
+        if (nanosecondsPerField > 0 && result.nanosecondsPerField > nanosecondsPerField * (1 + tolerance)) {
+            double slowdown = (result.nanosecondsPerField / nanosecondsPerField - 1) * 100;
+            [regressions addObject:[NSString stringWithFormat:@"%@: %.1f ns/field, baseline %.1f ns/field (+%.0f%%)",
+                                                              result.name, result.nanosecondsPerField,
+                                                              nanosecondsPerField, slowdown]];
+        }
+
+        id allocations = entry[@"allocationsPerObject"];
+        if ([allocations isKindOfClass:[NSNumber class]] && result.allocationsPerObject >= 0 &&
+            result.allocationsPerObject > [allocations doubleValue] + ALLOCATION_TOLERANCE) {
+            [regressions addObject:[NSString stringWithFormat:@"%@: %.1f allocs/obj, baseline %.1f allocs/obj",
+                                                              result.name, result.allocationsPerObject,
+                                                              [allocations doubleValue]]];
+        }
+    }
+    return regressions;
+}
+
+@end
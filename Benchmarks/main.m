@@ -0,0 +1,293 @@
+// main.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "SHModelObject.h"
+#import "SHDateParsing.h"
+#import "SHAnotherModel.h"
+#import "SHModelCollection.h"
+#import "SHBenchmarkModels.h"
+#import "SHBenchmarkPayloads.h"
+#import "SHBenchmarkRunner.h"
+#import "SHBenchmarkRealm.h"
+
+#define WIDE_OBJECT_COUNT 1000
+#define NESTED_CHAIN_COUNT 100
+#define NESTED_DEPTH 12
+#define FEED_ENTRY_COUNT 5000
+#define DATE_RECORD_COUNT 1000
+#define DATE_STRING_COUNT 10000
+#define COLLECTION_ROW_COUNT 100000
+#define EQUALITY_OBJECT_COUNT 100000
+#define REALM_IMPORT_COUNT 100000
+
+// keeps the compiler from dropping the measured work
+static id _sink;
+
+static NSArray *SHBenchDecode(Class cls, NSArray *payloads, NSDictionary *mappings) {
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:[payloads count]];
+    for (NSDictionary *payload in payloads) {
+        [objects addObject:[cls objectWithDictionary:payload mappings:mappings]];
+    }
+    return objects;
+}
+
+static void SHBenchRunShape(SHBenchmarkRunner *runner,
+                            NSString *shape,
+                            Class cls,
+                            NSArray *payloads,
+                            NSDictionary *mappings,
+                            NSUInteger objectsPerPayload,
+                            NSUInteger fieldCount) {
+    NSUInteger objectCount = [payloads count] * objectsPerPayload;
+
+    [runner runBenchmark:[@"decode/" stringByAppendingString:shape]
+                 objects:objectCount
+         fieldsPerObject:fieldCount
+                   block:^{ _sink = SHBenchDecode(cls, payloads, mappings); }];
+
+    NSArray *objects = SHBenchDecode(cls, payloads, mappings);
+    [runner runBenchmark:[@"update/" stringByAppendingString:shape]
+                 objects:objectCount
+         fieldsPerObject:fieldCount
+                   block:^{
+                       for (NSUInteger i = 0; i < [objects count]; i++) {
+                           [objects[i] updateWithDictionary:payloads[i]
+                                       dateConversionOption:kDateConverstionFromNSStringToNSStringOption
+                                              inputDateType:kInputDateFormatJSON
+                                                   mappings:mappings];
+                       }
+                   }];
+
+    [runner runBenchmark:[@"coding/" stringByAppendingString:shape]
+                 objects:objectCount
+         fieldsPerObject:fieldCount
+                   block:^{
+                       NSData *data = [NSKeyedArchiver archivedDataWithRootObject:objects];
+                       _sink = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+                   }];
+}
+
+static void SHBenchRunDates(SHBenchmarkRunner *runner, kInputDateFormat format) {
+    NSString *name = SHBenchDateFormatName(format);
+    NSArray *payloads = SHBenchDatePayloads(DATE_RECORD_COUNT, format);
+    NSArray *strings = SHBenchDateStrings(DATE_STRING_COUNT, format);
+
+    [runner runBenchmark:[@"decode/dates-" stringByAppendingString:name]
+                 objects:[payloads count]
+         fieldsPerObject:DATE_MODEL_FIELD_COUNT
+                   block:^{
+                       NSMutableArray *objects = [NSMutableArray arrayWithCapacity:[payloads count]];
+                       for (NSDictionary *payload in payloads) {
+                           SHBenchDateModel *object =
+                               (format == kInputDateFormatCustom)
+                                   ? [SHBenchDateModel objectWithDictionary:payload
+                                                       dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                                            inputDateFormat:SHBenchCustomDateFormat
+                                                                   mappings:nil]
+                                   : [SHBenchDateModel objectWithDictionary:payload
+                                                       dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                                              inputDateType:format
+                                                                   mappings:nil];
+                           [objects addObject:object];
+                       }
+                       _sink = objects;
+                   }];
+
+    [runner runBenchmark:[@"parse/dates-" stringByAppendingString:name]
+                 objects:[strings count]
+         fieldsPerObject:1
+                   block:^{
+                       NSTimeInterval sum = 0;
+                       for (NSString *string in strings) {
+                           NSTimeInterval interval = 0;
+                           switch (format) {
+                               case kInputDateFormatDotNetSimple: SHParseDotNetSimpleDate(string, &interval); break;
+                               case kInputDateFormatDotNetWithTimeZone:
+                                   SHParseDotNetDateWithTimeZone(string, &interval);
+                                   break;
+                               case kInputDateFormatCustom:
+                                   interval = [[SHDateFormatterForFormat(SHBenchCustomDateFormat)
+                                       dateFromString:string] timeIntervalSince1970];
+                                   break;
+                               default: SHParseDotNetJSONDate(string, &interval); break;
+                           }
+                           sum += interval;
+                       }
+                       _sink = @(sum);
+                   }];
+}
+
+// the same rows as model objects and as a `SHModelCollection`
+static void SHBenchRunCollection(SHBenchmarkRunner *runner) {
+    NSArray *rows = SHBenchFeedPayload(COLLECTION_ROW_COUNT)[@"entries"];
+
+    [runner runBenchmark:@"decode/rows-objects"
+                 objects:[rows count]
+         fieldsPerObject:3
+                   block:^{ _sink = [SHAnotherModel objectsWithArray:rows]; }];
+    [runner runBenchmark:@"decode/rows-collection"
+                 objects:[rows count]
+         fieldsPerObject:3
+                   block:^{ _sink = [SHModelCollection collectionWithArray:rows modelClass:[SHAnotherModel class]]; }];
+
+    NSArray *objects = [SHAnotherModel objectsWithArray:rows];
+    SHModelCollection *collection = [SHModelCollection collectionWithArray:rows modelClass:[SHAnotherModel class]];
+    [runner runBenchmark:@"sum/rows-objects"
+                 objects:[objects count]
+         fieldsPerObject:1
+                   block:^{
+                       long long sum = 0;
+                       for (SHAnotherModel *object in objects) {
+                           sum += object.modelId;
+                       }
+                       _sink = @(sum);
+                   }];
+    [runner runBenchmark:@"sum/rows-collection"
+                 objects:collection.count
+         fieldsPerObject:1
+                   block:^{ _sink = [collection sumForKey:@"modelId"]; }];
+}
+
+// copying and comparing through the cached ivar layout against archiving and `valueForKey:`
+static void SHBenchRunEquality(SHBenchmarkRunner *runner) {
+    NSArray *rows = SHBenchFeedPayload(EQUALITY_OBJECT_COUNT)[@"entries"];
+    NSArray *objects = [SHAnotherModel objectsWithArray:rows];
+    NSArray *others = [SHAnotherModel objectsWithArray:rows];
+    NSArray *keys = @[ @"modelId", @"modelName", @"modelType" ];
+
+    [runner runBenchmark:@"copy/archiver"
+                 objects:[objects count]
+         fieldsPerObject:[keys count]
+                   block:^{
+                       NSData *data = [NSKeyedArchiver archivedDataWithRootObject:objects];
+                       _sink = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+                   }];
+    [runner runBenchmark:@"copy/plan"
+                 objects:[objects count]
+         fieldsPerObject:[keys count]
+                   block:^{
+                       NSMutableArray *copies = [NSMutableArray arrayWithCapacity:[objects count]];
+                       for (SHAnotherModel *object in objects) {
+                           [copies addObject:[object copy]];
+                       }
+                       _sink = copies;
+                   }];
+
+    [runner runBenchmark:@"equal/kvc"
+                 objects:[objects count]
+         fieldsPerObject:[keys count]
+                   block:^{
+                       NSUInteger equal = 0;
+                       for (NSUInteger i = 0; i < [objects count]; i++) {
+                           BOOL same = YES;
+                           for (NSString *key in keys) {
+                               id value = [objects[i] valueForKey:key];
+                               id otherValue = [others[i] valueForKey:key];
+                               if (value != otherValue && ![value isEqual:otherValue]) {
+                                   same = NO;
+                                   break;
+                               }
+                           }
+                           equal += same;
+                       }
+                       _sink = @(equal);
+                   }];
+    [runner runBenchmark:@"equal/plan"
+                 objects:[objects count]
+         fieldsPerObject:[keys count]
+                   block:^{
+                       NSUInteger equal = 0;
+                       for (NSUInteger i = 0; i < [objects count]; i++) {
+                           equal += [objects[i] isEqual:others[i]];
+                       }
+                       _sink = @(equal);
+                   }];
+}
+
+static void SHBenchPrintUsage(void) {
+    printf("usage: SHModelBenchmarks [-output results.json] [-baseline baseline.json] [-tolerance 0.1]\n"
+           "                         [-duration 0.5] [-filter name]\n");
+}
+
+int main(int argc, const char *argv[]) {
+    @autoreleasepool {
+        // options come from the argument domain, e.g. `-baseline baseline.json`
+        NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+        if ([[[NSProcessInfo processInfo] arguments] containsObject:@"-help"]) {
+            SHBenchPrintUsage();
+            return 0;
+        }
+        NSString *output = [defaults stringForKey:@"output"] ?: @"results.json";
+        NSString *baseline = [defaults stringForKey:@"baseline"];
+        double tolerance = [defaults objectForKey:@"tolerance"] ? [defaults doubleForKey:@"tolerance"] : 0.1;
+        double duration = [defaults objectForKey:@"duration"] ? [defaults doubleForKey:@"duration"] : 0.5;
+
+        // dates are generated and parsed in UTC, so the results do not depend on the time zone of the machine
+        [NSTimeZone setDefaultTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+
+        SHBenchmarkRunner *runner =
+            [[SHBenchmarkRunner alloc] initWithMinimumDuration:duration filter:[defaults stringForKey:@"filter"]];
+
+        SHBenchRunShape(runner, @"wide", [SHBenchWideModel class], SHBenchWidePayloads(WIDE_OBJECT_COUNT), nil, 1,
+                        WIDE_MODEL_FIELD_COUNT);
+        SHBenchRunShape(runner, @"nested", [SHBenchNodeModel class],
+                        SHBenchNestedPayloads(NESTED_CHAIN_COUNT, NESTED_DEPTH), nil, NESTED_DEPTH,
+                        NODE_MODEL_FIELD_COUNT);
+        // the feed and its entries have three fields each
+        SHBenchRunShape(runner, @"mapped-array", [SHBenchFeedModel class], @[ SHBenchFeedPayload(FEED_ENTRY_COUNT) ],
+                        @{ @"entries" : @"SHAnotherModel" }, FEED_ENTRY_COUNT + 1, 3);
+
+        SHBenchRunDates(runner, kInputDateFormatJSON);
+        SHBenchRunDates(runner, kInputDateFormatDotNetSimple);
+        SHBenchRunDates(runner, kInputDateFormatDotNetWithTimeZone);
+        SHBenchRunDates(runner, kInputDateFormatCustom);
+
+        SHBenchRunCollection(runner);
+        SHBenchRunEquality(runner);
+        SHBenchRunRealmImport(runner, SHBenchFeedPayload(REALM_IMPORT_COUNT)[@"entries"]);
+
+        if (![runner writeResultsToPath:output]) {
+            return 2;
+        }
+        printf("results written to %s\n", [output UTF8String]);
+
+        if (baseline && ![SHBenchmarkRunner hasBaselineResultsAtPath:baseline]) {
+            printf("skipping the regression check, %s has no results: record it with `make baseline` on the "
+                   "reference machine\n",
+                   [baseline UTF8String]);
+        } else if (baseline) {
+            NSArray *regressions = [runner regressionsAgainstBaselineAtPath:baseline tolerance:tolerance];
+            if (nil == regressions) {
+                return 2;
+            }
+            for (NSString *regression in regressions) {
+                printf("REGRESSION %s\n", [regression UTF8String]);
+            }
+            if ([regressions count] > 0) {
+                return 1;
+            }
+            printf("no regressions against %s\n", [baseline UTF8String]);
+        }
+    }
+    return 0;
+}
@@ -97,15 +97,13 @@ RLM_ARRAY_TYPE(Car)
     // realm testing
     [[NSFileManager defaultManager] removeItemAtURL:[[[RLMRealm defaultRealm] configuration] fileURL] error:nil];
     RLMRealm *realm = [RLMRealm defaultRealm];
-    [realm transactionWithBlock:^{
-        NSDictionary *d = @{
-            @"nAme" : @"Shan Ul Haq",
-            @"_AGE" : @26,
-            @"cars" : @[ @{@"moDEL" : @"Honda"}, @{@"model" : @"Toyota"} ]
-        };
-        Person *p = [Person objectWithDictionary:d mappings:@{ @"cars" : @"Car" }];
-        [realm addObject:p];
-    }];
+    NSDictionary *d = @{
+        @"nAme" : @"Shan Ul Haq",
+        @"_AGE" : @26,
+        @"cars" : @[ @{@"moDEL" : @"Honda"}, @{@"model" : @"Toyota"} ]
+    };
+    // decoded before the write transaction, all persons are written in one
+    [Person createOrUpdateObjectsWithArray:@[ d ] inRealm:realm mappings:@{ @"cars" : @"Car" }];
 
     // Log all dogs and their owners using the "owners" inverse relationship
     RLMResults *allPersons = [Person allObjects];
@@ -28,4 +28,13 @@ typedef NS_ENUM(int, kInputDateFormat) {
     kInputDateFormatCustom = -1,
 };
 
+/**
+ *  enum for the style of the keys in exported dictionaries and JSON data.
+ */
+typedef NS_ENUM(int, kOutputKeyStyle) {
+    kOutputKeyStyleIvarName = 0,  // the ivar name without leading underscores, e.g. `anotherIntValue`
+    kOutputKeyStyleSnakeCase = 1, // lowercased words joined with `_`, e.g. `another_int_value`
+    kOutputKeyStyleCamelCase = 2, // e.g. `anotherIntValue`, also for an ivar named `_another_int_value`
+};
+
 #endif
@@ -0,0 +1,80 @@
+// SHDateParsing.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+// date format of `kInputDateFormatDotNetSimple`
+extern NSString *const SHDotNetSimpleDateFormat;
+
+// date format of `kInputDateFormatDotNetWithTimeZone`
+extern NSString *const SHDotNetDateWithTimeZoneFormat;
+
+/**
+ *  parses a `yyyy-MM-dd'T'HH:mm:ss` date in the default time zone, e.g. `2014-04-20T13:45:00`. the common cases are
+ *  computed arithmetically, anything else (other digit counts, a non gregorian calendar in the current locale, times
+ *  next to a daylight saving transition) is handed to a formatter from `SHDateFormatterForFormat` so the result is
+ *  always the one NSDateFormatter would give. safe to call from any thread.
+ *
+ *  @param string the date string
+ *  @param outInterval seconds since 1970 on success
+ *
+ *  @return `NO` if the string is not a date in the format
+ */
+BOOL SHParseDotNetSimpleDate(NSString *string, NSTimeInterval *outInterval);
+
+/**
+ *  parses a `yyyy-MM-dd'T'HH:mm:ssZZZZZ` date, e.g. `2014-04-20T13:45:00+08:00` or `2014-04-20T13:45:00Z`. works like
+ *  `SHParseDotNetSimpleDate`. safe to call from any thread.
+ *
+ *  @param string the date string
+ *  @param outInterval seconds since 1970 on success
+ *
+ *  @return `NO` if the string is not a date in the format
+ */
+BOOL SHParseDotNetDateWithTimeZone(NSString *string, NSTimeInterval *outInterval);
+
+/**
+ *  parses a .NET JSON date, e.g. `/Date(1398000000000)/` or `/Date(1398000000000+0800)/`, in a single pass over the
+ *  characters without allocating. accepts exactly the strings matched by
+ *  `^\/date\((-?\d++)(?:([+-])(\d{2})(\d{2}))?\)\/$` (case insensitive, ICU semantics) and gives the same value
+ *  the regular expression based parser gave. safe to call from any thread.
+ *
+ *  @param string the date string
+ *  @param outInterval seconds since 1970 on success
+ *
+ *  @return `NO` if the string is not a .NET JSON date
+ */
+BOOL SHParseDotNetJSONDate(NSString *string, NSTimeInterval *outInterval);
+
+// formats seconds since 1970 as a .NET JSON date in whole milliseconds, e.g. `/Date(1398000000000)/`
+NSString *SHDotNetJSONDateString(NSTimeInterval interval);
+
+/**
+ *  returns a formatter for the date format owned by the calling thread. formatters are created once per thread and
+ *  format and kept in the thread dictionary, so they are never shared between threads. the formatter is set to the
+ *  current default time zone on every call.
+ *
+ *  @param format NSDateFormatter format specifier
+ *
+ *  @return the formatter, nil if `format` is nil
+ */
+NSDateFormatter *SHDateFormatterForFormat(NSString *format);
@@ -0,0 +1,384 @@
+// SHDateParsing.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHDateParsing.h"
+// the parsers scan with `CFStringInlineBuffer`, which Foundation does not pull in with GNUstep
+#import <CoreFoundation/CoreFoundation.h>
+
+NSString *const SHDotNetSimpleDateFormat = @"yyyy-MM-dd'T'HH:mm:ss";
+NSString *const SHDotNetDateWithTimeZoneFormat = @"yyyy-MM-dd'T'HH:mm:ssZZZZZ";
+
+// key of the formatter cache in the thread dictionary
+static NSString *const SHDateFormattersThreadKey = @"me.grevolution.SHModelObject.dateFormatters";
+
+// `yyyy-MM-ddTHH:mm:ss`
+#define CIVIL_DATE_LENGTH 19
+
+// `yyyy-MM-ddTHH:mm:ss+hh:mm`
+#define DATE_WITH_OFFSET_LENGTH 25
+
+// gregorian calendar of NSCalendar switches to the julian calendar before 15 Oct 1582, earlier dates go to the formatter
+#define FIRST_GREGORIAN_YEAR 1583
+
+// largest UTC offset used by real time zones (+14:00), larger offsets go to the formatter
+#define MAX_OFFSET_HOURS 14
+
+#define SECONDS_PER_DAY 86400
+
+// `/date(`
+#define JSON_DATE_PREFIX_LENGTH 6
+
+// integers up to 2^53 are exact doubles, longer digit runs are converted like before with `doubleValue`
+#define MAX_EXACT_MILLISECONDS (1ULL << 53)
+#define MAX_ACCUMULATED_DIGITS 18
+
+NSDateFormatter *SHDateFormatterForFormat(NSString *format) {
+    if (nil == format) {
+        return nil;
+    }
+
+    NSMutableDictionary *threadDictionary = [[NSThread currentThread] threadDictionary];
+    NSMutableDictionary *formatters = threadDictionary[SHDateFormattersThreadKey];
+    if (nil == formatters) {
+        formatters = [NSMutableDictionary dictionary];
+        threadDictionary[SHDateFormattersThreadKey] = formatters;
+    }
+
+    NSDateFormatter *formatter = formatters[format];
+    if (nil == formatter) {
+        formatter = [[NSDateFormatter alloc] init];
+        [formatter setDateFormat:format];
+        formatters[format] = formatter;
+    }
+    // a formatter keeps the default time zone it was created with, follow `+[NSTimeZone setDefaultTimeZone:]` like the
+    // parsers computing the offset themselves do
+    NSTimeZone *timeZone = [NSTimeZone defaultTimeZone];
+    if (![[formatter timeZone] isEqual:timeZone]) {
+        [formatter setTimeZone:timeZone];
+    }
+    return formatter;
+}
+
+#pragma mark - calendar
+
+// 0 not checked yet, 1 gregorian, 2 any other calendar
+static volatile int _currentCalendarState;
+
+// `yyyy` is a year of the calendar of the current locale, only the gregorian calendar is computed here
+static BOOL SHCurrentCalendarIsGregorian(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        [[NSNotificationCenter defaultCenter] addObserverForName:NSCurrentLocaleDidChangeNotification
+                                                          object:nil
+                                                           queue:nil
+                                                      usingBlock:^(NSNotification *note) { _currentCalendarState = 0; }];
+    });
+
+    int state = _currentCalendarState;
+    if (state == 0) {
+        NSCalendar *calendar = [[NSLocale currentLocale] objectForKey:NSLocaleCalendar];
+        state = [[calendar calendarIdentifier] isEqualToString:@"gregorian"] ? 1 : 2;
+        _currentCalendarState = state;
+    }
+    return state == 1;
+}
+
+static inline BOOL SHIsLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static inline int SHDaysInMonth(int year, int month) {
+    static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return (month == 2 && SHIsLeapYear(year)) ? 29 : days[month - 1];
+}
+
+// days since 1970-01-01 of a gregorian date
+static inline int64_t SHDaysFromCivil(int year, int month, int day) {
+    int64_t y = year - (month <= 2 ? 1 : 0);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yearOfEra = y - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+static inline BOOL SHReadDigits(const unichar *characters, NSUInteger count, int *outValue) {
+    int value = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        unichar c = characters[i];
+        if (c < '0' || c > '9') {
+            return NO;
+        }
+        value = value * 10 + (c - '0');
+    }
+    *outValue = value;
+    return YES;
+}
+
+// `yyyy-MM-ddTHH:mm:ss` as seconds since 1970 without any time zone. `NO` for anything that is not exactly in that
+// shape or not a valid date, those are left to the formatter.
+static BOOL SHParseCivilDateTime(const unichar *c, int64_t *outSeconds) {
+    int year, month, day, hour, minute, second;
+    if (!SHReadDigits(c, 4, &year) || c[4] != '-' || !SHReadDigits(c + 5, 2, &month) || c[7] != '-' ||
+        !SHReadDigits(c + 8, 2, &day) || c[10] != 'T' || !SHReadDigits(c + 11, 2, &hour) || c[13] != ':' ||
+        !SHReadDigits(c + 14, 2, &minute) || c[16] != ':' || !SHReadDigits(c + 17, 2, &second)) {
+        return NO;
+    }
+    if (year < FIRST_GREGORIAN_YEAR || month < 1 || month > 12 || day < 1 || day > SHDaysInMonth(year, month) ||
+        hour > 23 || minute > 59 || second > 59) {
+        return NO;
+    }
+
+    *outSeconds = SHDaysFromCivil(year, month, day) * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+    return YES;
+}
+
+static BOOL SHParseWithFormatter(NSString *format, NSString *string, NSTimeInterval *outInterval) {
+    NSDate *date = [SHDateFormatterForFormat(format) dateFromString:string];
+    if (nil == date) {
+        return NO;
+    }
+    *outInterval = [date timeIntervalSince1970];
+    return YES;
+}
+
+#pragma mark - parsers
+
+BOOL SHParseDotNetSimpleDate(NSString *string, NSTimeInterval *outInterval) {
+    if (![string isKindOfClass:[NSString class]]) {
+        return NO;
+    }
+
+    if ([string length] == CIVIL_DATE_LENGTH && SHCurrentCalendarIsGregorian()) {
+        unichar characters[CIVIL_DATE_LENGTH];
+        [string getCharacters:characters range:NSMakeRange(0, CIVIL_DATE_LENGTH)];
+
+        int64_t local = 0;
+        if (SHParseCivilDateTime(characters, &local)) {
+            // the offset is only unambiguous away from daylight saving transitions, two days on either side have the
+            // same offset then. local times next to a transition are left to the formatter.
+            NSTimeZone *timeZone = [NSTimeZone defaultTimeZone];
+            NSInteger before = [timeZone secondsFromGMTForDate:[NSDate dateWithTimeIntervalSince1970:local - 2 * SECONDS_PER_DAY]];
+            NSInteger after = [timeZone secondsFromGMTForDate:[NSDate dateWithTimeIntervalSince1970:local + 2 * SECONDS_PER_DAY]];
+            if (before == after) {
+                *outInterval = (NSTimeInterval)(local - before);
+                return YES;
+            }
+        }
+    }
+    return SHParseWithFormatter(SHDotNetSimpleDateFormat, string, outInterval);
+}
+
+BOOL SHParseDotNetDateWithTimeZone(NSString *string, NSTimeInterval *outInterval) {
+    if (![string isKindOfClass:[NSString class]]) {
+        return NO;
+    }
+
+    NSUInteger length = [string length];
+    if ((length == CIVIL_DATE_LENGTH + 1 || length == DATE_WITH_OFFSET_LENGTH) && SHCurrentCalendarIsGregorian()) {
+        unichar characters[DATE_WITH_OFFSET_LENGTH];
+        [string getCharacters:characters range:NSMakeRange(0, length)];
+
+        int64_t local = 0;
+        if (SHParseCivilDateTime(characters, &local)) {
+            const unichar *zone = characters + CIVIL_DATE_LENGTH;
+            int hours = 0;
+            int minutes = 0;
+            if (length == CIVIL_DATE_LENGTH + 1 && zone[0] == 'Z') {
+                *outInterval = (NSTimeInterval)local;
+                return YES;
+            }
+            if (length == DATE_WITH_OFFSET_LENGTH && (zone[0] == '+' || zone[0] == '-') &&
+                SHReadDigits(zone + 1, 2, &hours) && zone[3] == ':' && SHReadDigits(zone + 4, 2, &minutes) &&
+                hours <= MAX_OFFSET_HOURS && minutes <= 59) {
+                int64_t offset = hours * 3600 + minutes * 60;
+                *outInterval = (NSTimeInterval)(zone[0] == '+' ? local - offset : local + offset);
+                return YES;
+            }
+        }
+    }
+    return SHParseWithFormatter(SHDotNetDateWithTimeZoneFormat, string, outInterval);
+}
+
+#pragma mark - .NET JSON dates
+
+// line terminators `$` of ICU regular expressions allows at the very end of the input
+static inline BOOL SHIsLineTerminator(UniChar c) {
+    return (c >= 0x0A && c <= 0x0D) || c == 0x85 || c == 0x2028 || c == 0x2029;
+}
+
+static NSCharacterSet *SHDecimalDigitCharacterSet(void) {
+    static NSCharacterSet *digits = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{ digits = [NSCharacterSet decimalDigitCharacterSet]; });
+    return digits;
+}
+
+// reads one `\d` at `*index`, any unicode decimal digit like in ICU. `*outValue` is -1 for digits other than 0-9.
+static BOOL SHScanDecimalDigit(CFStringInlineBuffer *buffer, CFIndex length, CFIndex *index, int *outValue) {
+    if (*index >= length) {
+        return NO;
+    }
+
+    UniChar c = CFStringGetCharacterFromInlineBuffer(buffer, *index);
+    if (c >= '0' && c <= '9') {
+        *outValue = c - '0';
+        (*index)++;
+        return YES;
+    }
+    if (c < 0x80) {
+        return NO;
+    }
+
+    UTF32Char codePoint = c;
+    CFIndex width = 1;
+    if (CFStringIsSurrogateHighCharacter(c) && *index + 1 < length) {
+        UniChar low = CFStringGetCharacterFromInlineBuffer(buffer, *index + 1);
+        if (CFStringIsSurrogateLowCharacter(low)) {
+            codePoint = CFStringGetLongCharacterForSurrogatePair(c, low);
+            width = 2;
+        }
+    }
+    if (![SHDecimalDigitCharacterSet() longCharacterIsMember:codePoint]) {
+        return NO;
+    }
+    *outValue = -1;
+    *index += width;
+    return YES;
+}
+
+// the value `doubleValue` gives for the sign followed by the characters in `range`, only used for digits other than 0-9
+static double SHSignedDoubleValue(NSString *string, UniChar sign, NSRange range) {
+    return [[NSString stringWithFormat:@"%C%@", sign, [string substringWithRange:range]] doubleValue];
+}
+
+BOOL SHParseDotNetJSONDate(NSString *string, NSTimeInterval *outInterval) {
+    if (![string isKindOfClass:[NSString class]]) {
+        return NO;
+    }
+
+    CFStringRef characters = (__bridge CFStringRef)string;
+    CFIndex length = CFStringGetLength(characters);
+    CFStringInlineBuffer buffer;
+    CFStringInitInlineBuffer(characters, &buffer, CFRangeMake(0, length));
+
+    // `/date(`, case insensitive
+    static const char prefix[] = "/date(";
+    if (length < JSON_DATE_PREFIX_LENGTH) {
+        return NO;
+    }
+    CFIndex i = 0;
+    for (; i < JSON_DATE_PREFIX_LENGTH; i++) {
+        UniChar c = CFStringGetCharacterFromInlineBuffer(&buffer, i);
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        if (c != (UniChar)prefix[i]) {
+            return NO;
+        }
+    }
+
+    // `-?\d++`, milliseconds
+    CFIndex millisecondsStart = i;
+    if (i < length && CFStringGetCharacterFromInlineBuffer(&buffer, i) == '-') {
+        i++;
+    }
+    CFIndex digitsStart = i;
+    uint64_t milliseconds = 0;
+    BOOL exact = YES;
+    int digit = 0;
+    while (SHScanDecimalDigit(&buffer, length, &i, &digit)) {
+        if (digit < 0 || i - digitsStart > MAX_ACCUMULATED_DIGITS) {
+            exact = NO;
+        } else {
+            milliseconds = milliseconds * 10 + (uint64_t)digit;
+        }
+    }
+    if (i == digitsStart) {
+        return NO;
+    }
+
+    NSTimeInterval seconds;
+    if (exact && milliseconds <= MAX_EXACT_MILLISECONDS) {
+        seconds = (digitsStart > millisecondsStart ? -(double)milliseconds : (double)milliseconds) / 1000.0;
+    } else {
+        NSRange range = NSMakeRange((NSUInteger)millisecondsStart, (NSUInteger)(i - millisecondsStart));
+        seconds = [[string substringWithRange:range] doubleValue] / 1000.0;
+    }
+
+    // `(?:([+-])(\d{2})(\d{2}))?`, time zone offset
+    UniChar sign = (i < length) ? CFStringGetCharacterFromInlineBuffer(&buffer, i) : 0;
+    if (sign == '+' || sign == '-') {
+        i++;
+        CFIndex starts[5];
+        int digits[4];
+        for (int k = 0; k < 4; k++) {
+            starts[k] = i;
+            if (!SHScanDecimalDigit(&buffer, length, &i, &digits[k])) {
+                return NO;
+            }
+        }
+        starts[4] = i;
+
+        double hours, minutes;
+        if (digits[0] >= 0 && digits[1] >= 0 && digits[2] >= 0 && digits[3] >= 0) {
+            hours = digits[0] * 10 + digits[1];
+            minutes = digits[2] * 10 + digits[3];
+            if (sign == '-') {
+                hours = -hours;
+                minutes = -minutes;
+            }
+        } else {
+            hours = SHSignedDoubleValue(string, sign, NSMakeRange((NSUInteger)starts[0], (NSUInteger)(starts[2] - starts[0])));
+            minutes = SHSignedDoubleValue(string, sign, NSMakeRange((NSUInteger)starts[2], (NSUInteger)(starts[4] - starts[2])));
+        }
+        seconds += hours * 60.0 * 60.0;
+        seconds += minutes * 60.0;
+    }
+
+    // `\)\/$`
+    if (length - i < 2 || CFStringGetCharacterFromInlineBuffer(&buffer, i) != ')' ||
+        CFStringGetCharacterFromInlineBuffer(&buffer, i + 1) != '/') {
+        return NO;
+    }
+    i += 2;
+
+    // `$` also matches before a line terminator, or `\r\n`, ending the input
+    CFIndex remaining = length - i;
+    if (remaining == 1 && !SHIsLineTerminator(CFStringGetCharacterFromInlineBuffer(&buffer, i))) {
+        return NO;
+    }
+    if (remaining == 2 && !(CFStringGetCharacterFromInlineBuffer(&buffer, i) == '\r' &&
+                            CFStringGetCharacterFromInlineBuffer(&buffer, i + 1) == '\n')) {
+        return NO;
+    }
+    if (remaining > 2) {
+        return NO;
+    }
+
+    *outInterval = seconds;
+    return YES;
+}
+
+NSString *SHDotNetJSONDateString(NSTimeInterval interval) {
+    return [NSString stringWithFormat:@"/Date(%lld)/", (long long)llround(interval * 1000.0)];
+}
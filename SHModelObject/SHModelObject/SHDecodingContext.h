@@ -0,0 +1,148 @@
+// SHDecodingContext.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "SHConstants.h"
+
+@class SHModelIvarDescriptor;
+
+/**
+ *  The `SHDecodingContext` holds the options a model is decoded with: what to do with date strings, the input date
+ *  format and the mappings of array keys to model classes. a context is immutable and thread-safe, so build it once
+ *  and pass it to every decode, e.g. for all pages of a feed. the mapped classes are looked up once when the context
+ *  is created.
+ *
+ *  the context is handed down to nested models and to the models in mapped arrays, so they use the same date options
+ *  as the object containing them. decoded objects keep their context for later `updateWithDictionary:` calls and for
+ *  exporting dates.
+ *
+ *  @code
+ *  SHDecodingContext *context = [[SHDecodingContext alloc]
+ *      initWithDateConversionOption:kDateConverstionFromNSStringToNSDateOption
+ *                     inputDateType:kInputDateFormatJSON
+ *                          mappings:@{ @"comments" : @"SHComment" }];
+ *  NSArray *posts = [SHPost objectsWithArray:response[@"posts"] context:context];
+ *  @endcode
+ */
+@interface SHDecodingContext : NSObject <NSCopying>
+
+// context with `kDateConverstionFromNSStringToNSStringOption`, `kInputDateFormatJSON` and no mappings, used by
+// `objectWithDictionary:` and by objects created with `init`
++ (instancetype)defaultContext;
+
+/**
+ *  context initializer
+ *
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateType `kInputDateFormat` to determine what what is the input format of the date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return the context
+ */
+- (instancetype)initWithDateConversionOption:(kDateConversionOption)option
+                               inputDateType:(kInputDateFormat)inputDateType
+                                    mappings:(NSDictionary *)mapping;
+
+/**
+ *  context initializer
+ *
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateFormat NSDateFormatter format specifier which will be used to format the input date. every thread
+ *gets its own formatter for it.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return the context
+ */
+- (instancetype)initWithDateConversionOption:(kDateConversionOption)option
+                             inputDateFormat:(NSString *)inputDateFormat
+                                    mappings:(NSDictionary *)mapping;
+
+/**
+ *  context initializer. the formatter is used from every thread decoding with the context, do not change it
+ *  afterwards.
+ *
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateFormatter NSDateFormatter object which will be used to format the input date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return the context
+ */
+- (instancetype)initWithDateConversionOption:(kDateConversionOption)option
+                          inputDateFormatter:(NSDateFormatter *)inputDateFormatter
+                                    mappings:(NSDictionary *)mapping;
+
+@property (nonatomic, readonly) kDateConversionOption dateConversionOption;
+
+// `kInputDateFormatCustom` for contexts created with a date format or a formatter
+@property (nonatomic, readonly) kInputDateFormat inputDateFormat;
+
+// the format passed to `initWithDateConversionOption:inputDateFormat:mappings:`, nil otherwise
+@property (nonatomic, readonly, copy) NSString *dateFormat;
+
+// the formatter passed to `initWithDateConversionOption:inputDateFormatter:mappings:`, nil otherwise
+@property (nonatomic, readonly, strong) NSDateFormatter *inputDateFormatter;
+
+@property (nonatomic, readonly, copy) NSDictionary *mappings;
+
+// formatter for custom dates, `inputDateFormatter` or this thread's formatter for `dateFormat`. nil for other contexts.
+- (NSDateFormatter *)dateFormatter;
+
+// class mapped to the key, Nil if there is no mapping or the class does not exist
+- (Class)mappedClassForKey:(id)key;
+
+/**
+ *  a context with the same options that decodes only some of the fields, e.g. the few fields a list shows. the keys
+ *  are ivar or property names, matched like dictionary keys (`modelName`, `_modelName` and `model_name` are the
+ *  same). dotted paths select fields of nested models and of the models in mapped arrays, `author.name` decodes only
+ *  the `name` of the `author`, `author` alone decodes all of it.
+ *
+ *  values of other fields are skipped before they are converted, so nested models, arrays and dates that are not
+ *  asked for cost nothing. their ivars keep their value, nil or zero for new objects. build the context once and
+ *  reuse it, the paths are parsed here.
+ *
+ *  @param keys set of field names and dotted paths
+ *
+ *  @return the context
+ */
+- (instancetype)contextWithOnlyKeys:(NSSet *)keys;
+
+// the keys passed to `contextWithOnlyKeys:`, nil if all fields are decoded
+@property (nonatomic, readonly, copy) NSSet *onlyKeys;
+
+// the context with the same options that decodes all fields, the receiver when it does. objects keep this context
+// once they are decoded, so a projection only applies to the call it is passed to.
+@property (nonatomic, readonly, strong) SHDecodingContext *unprojectedContext;
+
+/**
+ *  the context for a field of an object decoded with the receiver, used by `SHModelObject`.
+ *
+ *  @param descriptor descriptor of the ivar
+ *
+ *  @return nil if the field is left out, otherwise the context its nested models are decoded with (the receiver
+ *  when all fields are decoded)
+ */
+- (SHDecodingContext *)contextForIvar:(SHModelIvarDescriptor *)descriptor;
+
+@end
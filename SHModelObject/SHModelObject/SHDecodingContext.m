@@ -0,0 +1,192 @@
+// SHDecodingContext.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHDecodingContext.h"
+#import "SHDateParsing.h"
+#import "SHModelClassPlan.h"
+#import "SHKeyNormalizer.h"
+
+@implementation SHDecodingContext {
+    // key to class of the mappings, resolved once with `NSClassFromString`
+    NSDictionary *_mappedClasses;
+    // normalized field name to the context of the field, nil when all fields are decoded. the names are
+    // `SHNormalizedKey`s compared with `isEqual:`, the key of `text` is not the same object as the key of `_text`.
+    // only read after the context is created.
+    NSMapTable *_projection;
+    // the same options without the projection, nil when there is none
+    SHDecodingContext *_unprojectedContext;
+}
+
++ (instancetype)defaultContext {
+    static SHDecodingContext *defaultContext = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        defaultContext =
+            [[SHDecodingContext alloc] initWithDateConversionOption:kDateConverstionFromNSStringToNSStringOption
+                                                      inputDateType:kInputDateFormatJSON
+                                                           mappings:nil];
+    });
+    return defaultContext;
+}
+
+- (instancetype)initWithDateConversionOption:(kDateConversionOption)option
+                               inputDateType:(kInputDateFormat)inputDateType
+                                    mappings:(NSDictionary *)mapping {
+    if ((self = [super init])) {
+        _dateConversionOption = option;
+        _inputDateFormat = inputDateType;
+        [self setUpMappings:mapping];
+    }
+    return self;
+}
+
+- (instancetype)initWithDateConversionOption:(kDateConversionOption)option
+                             inputDateFormat:(NSString *)inputDateFormat
+                                    mappings:(NSDictionary *)mapping {
+    if ((self = [super init])) {
+        _dateConversionOption = option;
+        _inputDateFormat = kInputDateFormatCustom;
+        _dateFormat = [inputDateFormat copy];
+        [self setUpMappings:mapping];
+    }
+    return self;
+}
+
+- (instancetype)initWithDateConversionOption:(kDateConversionOption)option
+                          inputDateFormatter:(NSDateFormatter *)inputDateFormatter
+                                    mappings:(NSDictionary *)mapping {
+    if ((self = [super init])) {
+        _dateConversionOption = option;
+        _inputDateFormat = kInputDateFormatCustom;
+        _inputDateFormatter = inputDateFormatter;
+        [self setUpMappings:mapping];
+    }
+    return self;
+}
+
+- (void)setUpMappings:(NSDictionary *)mapping {
+    if ([mapping count] == 0) {
+        return;
+    }
+    _mappings = [mapping copy];
+    NSMutableDictionary *mappedClasses = [NSMutableDictionary dictionaryWithCapacity:[mapping count]];
+    [_mappings enumerateKeysAndObjectsUsingBlock:^(id key, id className, BOOL *stop) {
+        Class cls = [className isKindOfClass:[NSString class]] ? NSClassFromString(className) : Nil;
+        if (cls) {
+            mappedClasses[key] = cls;
+        }
+    }];
+    _mappedClasses = [mappedClasses copy];
+}
+
+- (instancetype)contextWithOnlyKeys:(NSSet *)keys {
+    // fields named without a path are decoded with all their nested fields
+    SHDecodingContext *unprojected = [self unprojectedContext];
+
+    // first component of every path to the rest of the paths below it, nil when the whole field is wanted
+    NSMapTable *nestedKeys = [NSMapTable strongToStrongObjectsMapTable];
+    NSMutableSet *wholeFields = [NSMutableSet set];
+    for (NSString *path in keys) {
+        if (![path isKindOfClass:[NSString class]]) {
+            continue;
+        }
+        NSRange dot = [path rangeOfString:@"."];
+        NSString *field = (dot.location == NSNotFound) ? path : [path substringToIndex:dot.location];
+        SHNormalizedKey *key = [SHNormalizedKey normalizedKeyForString:field];
+        if (nil == key) {
+            continue;
+        }
+        if (dot.location == NSNotFound) {
+            [wholeFields addObject:key];
+            continue;
+        }
+        NSMutableSet *rest = [nestedKeys objectForKey:key];
+        if (nil == rest) {
+            rest = [NSMutableSet set];
+            [nestedKeys setObject:rest forKey:key];
+        }
+        [rest addObject:[path substringFromIndex:NSMaxRange(dot)]];
+    }
+
+    NSPointerFunctionsOptions keyOptions = NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPersonality;
+    NSMapTable *projection = [[NSMapTable alloc] initWithKeyOptions:keyOptions
+                                                       valueOptions:NSPointerFunctionsStrongMemory
+                                                           capacity:[keys count]];
+    for (SHNormalizedKey *key in wholeFields) {
+        [projection setObject:unprojected forKey:key];
+    }
+    for (SHNormalizedKey *key in nestedKeys) {
+        if (nil == [projection objectForKey:key]) {
+            [projection setObject:[unprojected contextWithOnlyKeys:[nestedKeys objectForKey:key]] forKey:key];
+        }
+    }
+    SHDecodingContext *context = [self contextWithProjection:projection onlyKeys:keys];
+    context->_unprojectedContext = unprojected;
+    return context;
+}
+
+- (SHDecodingContext *)unprojectedContext {
+    return _unprojectedContext ?: self;
+}
+
+// a context with the options of the receiver and another projection
+- (instancetype)contextWithProjection:(NSMapTable *)projection onlyKeys:(NSSet *)keys {
+    SHDecodingContext *context = [[SHDecodingContext alloc] init];
+    context->_dateConversionOption = _dateConversionOption;
+    context->_inputDateFormat = _inputDateFormat;
+    context->_dateFormat = _dateFormat;
+    context->_inputDateFormatter = _inputDateFormatter;
+    context->_mappings = _mappings;
+    context->_mappedClasses = _mappedClasses;
+    context->_projection = projection;
+    context->_onlyKeys = [keys copy];
+    return context;
+}
+
+- (SHDecodingContext *)contextForIvar:(SHModelIvarDescriptor *)descriptor {
+    if (nil == _projection) {
+        return self;
+    }
+    SHNormalizedKey *key = descriptor.normalizedKey;
+    return key ? [_projection objectForKey:key] : nil;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    // immutable
+    return self;
+}
+
+- (NSDateFormatter *)dateFormatter {
+    return _inputDateFormatter ?: SHDateFormatterForFormat(_dateFormat);
+}
+
+- (Class)mappedClassForKey:(id)key {
+    return key ? _mappedClasses[key] : Nil;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p option: %d, date format: %d, mappings: %@, only keys: %@>",
+                                      NSStringFromClass([self class]), self, (int)_dateConversionOption,
+                                      (int)_inputDateFormat, _mappings, _onlyKeys];
+}
+
+@end
@@ -0,0 +1,98 @@
+// SHDecodingSession.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  The `SHDecodingSession` shares repeated values between the objects decoded while it is current, e.g. the same
+ *  author on every comment of a feed:
+ *
+ *  - objects of classes with a `+primaryKey` are kept in an identity map. a dictionary whose primary key was decoded
+ *    before resolves to the object decoded first, it is not decoded again and later values in it are ignored.
+ *  - strings of fields declared with `SHModelSchemaInternedKey` are interned, equal strings are stored once.
+ *
+ *  sessions apply to the `objectWithDictionary:` and `objectsWithArray:` variants and the values nested in them,
+ *  including arrays created in parallel. they keep every shared object and string until they are released or
+ *  `removeAllObjects` is called, so use one per payload or screen rather than one for the app. all methods are
+ *  thread-safe.
+ *
+ *  @code
+ *  SHDecodingSession *session = [[SHDecodingSession alloc] init];
+ *  __block NSArray *comments = nil;
+ *  [session performDecoding:^{
+ *      comments = [SHComment objectsWithArray:response[@"comments"]];
+ *  }];
+ *  @endcode
+ */
+@interface SHDecodingSession : NSObject
+
+// the session of the calling thread, nil outside of `performDecoding:`
++ (instancetype)currentSession;
+
+/**
+ *  makes the receiver the current session of the calling thread while `block` runs. sessions can be nested, the
+ *  previous one is current again afterwards.
+ *
+ *  @param block block decoding the objects
+ */
+- (void)performDecoding:(void (^)(void))block;
+
+/**
+ *  the object decoded for a primary key
+ *
+ *  @param cls class of the object
+ *  @param primaryKey value of the primary key
+ *
+ *  @return the object, nil if none was added for the key
+ */
+- (id)objectOfClass:(Class)cls primaryKey:(id)primaryKey;
+
+/**
+ *  adds an object to the identity map. when another thread added an object for the same key first, that object is
+ *  kept and returned.
+ *
+ *  @param object the decoded object
+ *  @param primaryKey value of the primary key
+ *
+ *  @return the object kept for the key
+ */
+- (id)addObject:(id)object primaryKey:(id)primaryKey;
+
+/**
+ *  interns a string
+ *
+ *  @param string the string
+ *
+ *  @return the string equal to `string` that was interned first
+ */
+- (NSString *)internedString:(NSString *)string;
+
+// number of objects in the identity map
+@property (nonatomic, readonly) NSUInteger objectCount;
+
+// number of interned strings
+@property (nonatomic, readonly) NSUInteger internedStringCount;
+
+// releases all shared objects and strings
+- (void)removeAllObjects;
+
+@end
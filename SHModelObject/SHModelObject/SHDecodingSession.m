@@ -0,0 +1,149 @@
+// SHDecodingSession.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHDecodingSession.h"
+#import <pthread.h>
+
+static pthread_key_t _currentSessionKey;
+
+@implementation SHDecodingSession {
+    pthread_mutex_t _lock;
+    // class to dictionary of primary key to object
+    NSMapTable *_objects;
+    NSUInteger _objectCount;
+    NSMutableSet *_strings;
+}
+
++ (void)initialize {
+    if (self == [SHDecodingSession class]) {
+        pthread_key_create(&_currentSessionKey, NULL);
+    }
+}
+
++ (instancetype)currentSession {
+    // the session is retained by `performDecoding:` while it is current
+    return (__bridge SHDecodingSession *)pthread_getspecific(_currentSessionKey);
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        pthread_mutex_init(&_lock, NULL);
+        _objects = [[NSMapTable alloc]
+            initWithKeyOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)
+                  valueOptions:NSPointerFunctionsStrongMemory
+                      capacity:8];
+        _strings = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    pthread_mutex_destroy(&_lock);
+}
+
+- (void)performDecoding:(void (^)(void))block {
+    void *previous = pthread_getspecific(_currentSessionKey);
+    pthread_setspecific(_currentSessionKey, (__bridge void *)self);
+    @try {
+        block();
+    }
+    @finally {
+        pthread_setspecific(_currentSessionKey, previous);
+    }
+}
+
+- (id)objectOfClass:(Class)cls primaryKey:(id)primaryKey {
+    pthread_mutex_lock(&_lock);
+    id object = [[_objects objectForKey:cls] objectForKey:primaryKey];
+    pthread_mutex_unlock(&_lock);
+    return object;
+}
+
+- (id)addObject:(id)object primaryKey:(id)primaryKey {
+    if (nil == object || nil == primaryKey) {
+        return object;
+    }
+    Class cls = [object class];
+    pthread_mutex_lock(&_lock);
+    NSMutableDictionary *objects = [_objects objectForKey:cls];
+    if (nil == objects) {
+        objects = [NSMutableDictionary dictionary];
+        [_objects setObject:objects forKey:cls];
+    }
+    id existing = objects[primaryKey];
+    if (nil == existing) {
+        objects[primaryKey] = object;
+        _objectCount++;
+    }
+    pthread_mutex_unlock(&_lock);
+    return existing ?: object;
+}
+
+- (NSString *)internedString:(NSString *)string {
+    if (nil == string) {
+        return nil;
+    }
+    pthread_mutex_lock(&_lock);
+    NSString *interned = [_strings member:string];
+    if (nil == interned) {
+        // mutable strings must not change inside the table
+        interned = [string copy];
+        [_strings addObject:interned];
+    }
+    pthread_mutex_unlock(&_lock);
+    return interned;
+}
+
+- (NSUInteger)objectCount {
+    pthread_mutex_lock(&_lock);
+    NSUInteger count = _objectCount;
+    pthread_mutex_unlock(&_lock);
+    return count;
+}
+
+- (NSUInteger)internedStringCount {
+    pthread_mutex_lock(&_lock);
+    NSUInteger count = [_strings count];
+    pthread_mutex_unlock(&_lock);
+    return count;
+}
+
+- (void)removeAllObjects {
+    pthread_mutex_lock(&_lock);
+    NSMapTable *objects = _objects;
+    NSMutableSet *strings = _strings;
+    _objects = [[NSMapTable alloc]
+        initWithKeyOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)
+              valueOptions:NSPointerFunctionsStrongMemory
+                  capacity:8];
+    _objectCount = 0;
+    _strings = [NSMutableSet set];
+    pthread_mutex_unlock(&_lock);
+    // `objects` and `strings` are released after unlocking, deallocating the objects can take a while
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p objects: %lu, strings: %lu>", NSStringFromClass([self class]), self,
+                                      (unsigned long)[self objectCount], (unsigned long)[self internedStringCount]];
+}
+
+@end
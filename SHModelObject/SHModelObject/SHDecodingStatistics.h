@@ -0,0 +1,115 @@
+// SHDecodingStatistics.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  The `SHDecodingStatistics` is a snapshot of the decoding statistics of one model class. statistics are collected
+ *  for `updateWithDictionary:` (and so for every `objectWithDictionary:` and `objectsWithArray:` variant) and
+ *  `serializeValue:withKey:` once they are enabled with `setEnabled:`. disabled, decoding only checks one flag per
+ *  object and key.
+ *
+ *  times are measured with the monotonic clock. the nested decoding time of a class includes the time its nested
+ *  models and mapped arrays spent decoding, those are counted for their own classes as well.
+ */
+@interface SHDecodingStatistics : NSObject
+
+// the model class
+@property (nonatomic, readonly) Class modelClass;
+
+// objects decoded from a dictionary
+@property (nonatomic, readonly) uint64_t objectsDecoded;
+
+// keys that matched an ivar
+@property (nonatomic, readonly) uint64_t keysMatched;
+
+// keys without a matching ivar, skipped
+@property (nonatomic, readonly) uint64_t keysDropped;
+
+// values that do not fit the type of their ivar, these fail an `NSAssert` in debug builds
+@property (nonatomic, readonly) uint64_t typeMismatches;
+
+// time spent finding the ivar for a key
+@property (nonatomic, readonly) uint64_t keyMatchingNanoseconds;
+
+// time spent converting date strings to `NSDate` or `NSTimeInterval`
+@property (nonatomic, readonly) uint64_t dateConversionNanoseconds;
+
+// time spent decoding nested models and mapped arrays of models
+@property (nonatomic, readonly) uint64_t nestedDecodingNanoseconds;
+
+// `NO` by default
++ (BOOL)isEnabled;
+
++ (void)setEnabled:(BOOL)enabled;
+
+/**
+ *  the statistics collected since the last `reset` or `flush`
+ *
+ *  @return dictionary of class name to `SHDecodingStatistics`, classes without decoded objects are left out
+ */
++ (NSDictionary *)snapshot;
+
+// clears the statistics of all classes
++ (void)reset;
+
+/**
+ *  sets the block `flush` passes the statistics to, e.g. to export them to a metrics system
+ *
+ *  @param sink block called with a dictionary of class name to `SHDecodingStatistics`, nil to remove it
+ */
++ (void)setSink:(void (^)(NSDictionary *statistics))sink;
+
+/**
+ *  takes the statistics collected since the last `reset` or `flush` and passes them to the sink. the statistics are
+ *  cleared at the same time, every decoded object is passed to the sink once even while other threads decode.
+ */
++ (void)flush;
+
+@end
+
+/**
+ *  counters of one class, updated atomically by the decoding code. times are in ticks of `SHDecodingTimestamp`.
+ */
+typedef struct {
+    volatile int64_t objectsDecoded;
+    volatile int64_t keysMatched;
+    volatile int64_t keysDropped;
+    volatile int64_t typeMismatches;
+    volatile int64_t keyMatchingTicks;
+    volatile int64_t dateConversionTicks;
+    volatile int64_t nestedDecodingTicks;
+} SHDecodingCounters;
+
+// set by `setEnabled:`, read without a barrier by the decoding code
+extern volatile BOOL SHDecodingStatisticsEnabled;
+
+// the counters of the class, created on first use and never freed. NULL when statistics are disabled.
+SHDecodingCounters *SHDecodingCountersForClass(Class cls);
+
+// monotonic clock in ticks, see `SHDecodingCounters`
+uint64_t SHDecodingTimestamp(void);
+
+// adds to a counter from any thread
+static inline void SHDecodingCounterAdd(volatile int64_t *counter, int64_t amount) {
+    __sync_fetch_and_add(counter, amount);
+}
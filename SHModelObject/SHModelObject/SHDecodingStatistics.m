@@ -0,0 +1,167 @@
+// SHDecodingStatistics.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHDecodingStatistics.h"
+#import <pthread.h>
+#ifdef __APPLE__
+#import <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+volatile BOOL SHDecodingStatisticsEnabled = NO;
+
+// class to `SHDecodingCounters`, the C API as the values are not objects
+static NSMapTable *_counters;
+static pthread_rwlock_t _countersLock = PTHREAD_RWLOCK_INITIALIZER;
+static void (^_sink)(NSDictionary *statistics);
+static pthread_mutex_t _sinkLock = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t SHDecodingTimestamp(void) {
+#ifdef __APPLE__
+    return mach_absolute_time();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * NSEC_PER_SEC + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static uint64_t SHNanosecondsFromTicks(int64_t ticks) {
+#ifdef __APPLE__
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return (uint64_t)ticks * timebase.numer / timebase.denom;
+#else
+    return (uint64_t)ticks;
+#endif
+}
+
+SHDecodingCounters *SHDecodingCountersForClass(Class cls) {
+    if (!SHDecodingStatisticsEnabled || Nil == cls) {
+        return NULL;
+    }
+
+    pthread_rwlock_rdlock(&_countersLock);
+    SHDecodingCounters *counters = _counters ? NSMapGet(_counters, (__bridge void *)cls) : NULL;
+    pthread_rwlock_unlock(&_countersLock);
+    if (counters) {
+        return counters;
+    }
+
+    pthread_rwlock_wrlock(&_countersLock);
+    if (nil == _counters) {
+        _counters = NSCreateMapTable(NSNonOwnedPointerMapKeyCallBacks, NSNonOwnedPointerMapValueCallBacks, 64);
+    }
+    counters = NSMapGet(_counters, (__bridge void *)cls);
+    if (NULL == counters) {
+        counters = calloc(1, sizeof(SHDecodingCounters));
+        NSMapInsert(_counters, (__bridge void *)cls, counters);
+    }
+    pthread_rwlock_unlock(&_countersLock);
+    return counters;
+}
+
+// reads a counter, clearing it when `take` is set
+static int64_t SHDecodingCounterRead(volatile int64_t *counter, BOOL take) {
+    return take ? __sync_fetch_and_and(counter, 0) : __sync_fetch_and_add(counter, 0);
+}
+
+@implementation SHDecodingStatistics
+
++ (BOOL)isEnabled {
+    return SHDecodingStatisticsEnabled;
+}
+
++ (void)setEnabled:(BOOL)enabled {
+    SHDecodingStatisticsEnabled = enabled;
+}
+
++ (NSDictionary *)snapshot {
+    return [self statisticsClearingCounters:NO];
+}
+
++ (void)reset {
+    [self statisticsClearingCounters:YES];
+}
+
++ (void)setSink:(void (^)(NSDictionary *statistics))sink {
+    pthread_mutex_lock(&_sinkLock);
+    _sink = [sink copy];
+    pthread_mutex_unlock(&_sinkLock);
+}
+
++ (void)flush {
+    NSDictionary *statistics = [self statisticsClearingCounters:YES];
+    pthread_mutex_lock(&_sinkLock);
+    void (^sink)(NSDictionary *) = _sink;
+    pthread_mutex_unlock(&_sinkLock);
+    if (sink) {
+        sink(statistics);
+    }
+}
+
++ (NSDictionary *)statisticsClearingCounters:(BOOL)clear {
+    NSMutableDictionary *statistics = [NSMutableDictionary dictionary];
+    pthread_rwlock_rdlock(&_countersLock);
+    if (nil == _counters) {
+        pthread_rwlock_unlock(&_countersLock);
+        return statistics;
+    }
+    NSMapEnumerator enumerator = NSEnumerateMapTable(_counters);
+    void *key = NULL;
+    void *value = NULL;
+    while (NSNextMapEnumeratorPair(&enumerator, &key, &value)) {
+        SHDecodingCounters *counters = value;
+        SHDecodingStatistics *snapshot = [[SHDecodingStatistics alloc] init];
+        snapshot->_modelClass = (__bridge Class)key;
+        snapshot->_objectsDecoded = SHDecodingCounterRead(&counters->objectsDecoded, clear);
+        snapshot->_keysMatched = SHDecodingCounterRead(&counters->keysMatched, clear);
+        snapshot->_keysDropped = SHDecodingCounterRead(&counters->keysDropped, clear);
+        snapshot->_typeMismatches = SHDecodingCounterRead(&counters->typeMismatches, clear);
+        snapshot->_keyMatchingNanoseconds =
+            SHNanosecondsFromTicks(SHDecodingCounterRead(&counters->keyMatchingTicks, clear));
+        snapshot->_dateConversionNanoseconds =
+            SHNanosecondsFromTicks(SHDecodingCounterRead(&counters->dateConversionTicks, clear));
+        snapshot->_nestedDecodingNanoseconds =
+            SHNanosecondsFromTicks(SHDecodingCounterRead(&counters->nestedDecodingTicks, clear));
+        if (snapshot->_objectsDecoded > 0 || snapshot->_typeMismatches > 0) {
+            statistics[NSStringFromClass(snapshot->_modelClass)] = snapshot;
+        }
+    }
+    NSEndMapTableEnumeration(&enumerator);
+    pthread_rwlock_unlock(&_countersLock);
+    return statistics;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p %@ objects: %llu, matched: %llu, dropped: %llu, mismatches: %llu, "
+                                      @"key matching: %lluns, dates: %lluns, nested: %lluns>",
+                                      NSStringFromClass([self class]), self, NSStringFromClass(_modelClass),
+                                      _objectsDecoded, _keysMatched, _keysDropped, _typeMismatches,
+                                      _keyMatchingNanoseconds, _dateConversionNanoseconds,
+                                      _nestedDecodingNanoseconds];
+}
+
+@end
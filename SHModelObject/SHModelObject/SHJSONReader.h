@@ -0,0 +1,132 @@
+// SHJSONReader.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  type of the next JSON value in the reader
+ */
+typedef NS_ENUM(NSInteger, SHJSONValueType) {
+    SHJSONValueTypeInvalid = 0,
+    SHJSONValueTypeObject,
+    SHJSONValueTypeArray,
+    SHJSONValueTypeString,
+    SHJSONValueTypeNumber,
+    SHJSONValueTypeTrue,
+    SHJSONValueTypeFalse,
+    SHJSONValueTypeNull,
+};
+
+/**
+ *  pull reader over UTF-8 encoded JSON bytes. the reader does not copy the bytes and does not allocate unless a value
+ *  is explicitly materialized with `SHJSONReaderReadValue` or `SHJSONStringCreate`.
+ */
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *cursor;
+    const uint8_t *end;
+    NSUInteger depth;
+    BOOL failed;
+} SHJSONReader;
+
+/**
+ *  a string inside the JSON bytes, still escaped.
+ */
+typedef struct {
+    const uint8_t *bytes;
+    NSUInteger length;
+    BOOL hasEscapes;
+    BOOL isASCII;
+} SHJSONStringRef;
+
+/**
+ *  a parsed JSON number. integers that fit into `long long` are kept exact, so are larger integers that fit into
+ *  `unsigned long long` (ids, hashes), everything else is a double.
+ */
+typedef struct {
+    BOOL isInteger;
+    // `YES` for integers above `LLONG_MAX`, their value is `unsignedIntegerValue` and `integerValue` is clamped
+    BOOL isUnsigned;
+    long long integerValue;
+    unsigned long long unsignedIntegerValue;
+    double doubleValue;
+} SHJSONNumber;
+
+// the number boxed with its exact value
+NSNumber *SHJSONNumberObject(const SHJSONNumber *number);
+
+void SHJSONReaderInit(SHJSONReader *reader, const void *bytes, NSUInteger length);
+
+// skips whitespace and returns the type of the next value without consuming it
+SHJSONValueType SHJSONReaderPeek(SHJSONReader *reader);
+
+// consumes the `{` of an object
+BOOL SHJSONReaderBeginObject(SHJSONReader *reader);
+
+/**
+ *  moves to the next member of the current object and reads its key. `first` must be `YES` for the first call on an
+ *  object and is updated by the reader.
+ *
+ *  @return `YES` if a key was read and the reader is at its value, `NO` at the end of the object or on error (check
+ *  `reader->failed`)
+ */
+BOOL SHJSONReaderNextMember(SHJSONReader *reader, BOOL *first, SHJSONStringRef *key);
+
+// consumes the `[` of an array
+BOOL SHJSONReaderBeginArray(SHJSONReader *reader);
+
+/**
+ *  moves to the next element of the current array.
+ *
+ *  @return `YES` if the reader is at the next element, `NO` at the end of the array or on error
+ */
+BOOL SHJSONReaderNextElement(SHJSONReader *reader, BOOL *first);
+
+// reads a string without unescaping it
+BOOL SHJSONReaderReadStringRef(SHJSONReader *reader, SHJSONStringRef *string);
+
+// reads a number
+BOOL SHJSONReaderReadNumber(SHJSONReader *reader, SHJSONNumber *number);
+
+// reads `true`, `false` or `null`
+BOOL SHJSONReaderReadLiteral(SHJSONReader *reader, SHJSONValueType type);
+
+// skips the next value, including nested objects and arrays, without allocating
+BOOL SHJSONReaderSkipValue(SHJSONReader *reader);
+
+// `YES` if only whitespace is left
+BOOL SHJSONReaderAtEnd(SHJSONReader *reader);
+
+/**
+ *  reads the next value into Foundation objects the way NSJSONSerialization does (NSDictionary, NSArray, NSString,
+ *  NSNumber, NSNull).
+ *
+ *  @return the value or nil on error
+ */
+id SHJSONReaderReadValue(SHJSONReader *reader);
+
+/**
+ *  creates the unescaped string.
+ *
+ *  @return the string or nil if the bytes are not valid
+ */
+NSString *SHJSONStringCreate(const SHJSONStringRef *string);
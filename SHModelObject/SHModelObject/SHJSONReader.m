@@ -0,0 +1,634 @@
+// SHJSONReader.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHJSONReader.h"
+#include <locale.h>
+#include <stdlib.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+// same nesting limit as NSJSONSerialization
+#define MAX_DEPTH 512
+
+// numbers longer than this are copied to the heap before handing them to strtod
+#define NUMBER_STACK_BUFFER_LENGTH 64
+
+static inline BOOL SHJSONFail(SHJSONReader *reader) {
+    reader->failed = YES;
+    return NO;
+}
+
+static inline void SHJSONSkipWhitespace(SHJSONReader *reader) {
+    const uint8_t *c = reader->cursor;
+    const uint8_t *end = reader->end;
+    while (c < end && (*c == ' ' || *c == '\n' || *c == '\r' || *c == '\t')) {
+        c++;
+    }
+    reader->cursor = c;
+}
+
+static inline BOOL SHJSONConsume(SHJSONReader *reader, uint8_t expected) {
+    SHJSONSkipWhitespace(reader);
+    if (reader->cursor < reader->end && *reader->cursor == expected) {
+        reader->cursor++;
+        return YES;
+    }
+    return SHJSONFail(reader);
+}
+
+static inline int SHJSONHexValue(uint8_t c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static inline int SHJSONReadHex4(const uint8_t *c) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = SHJSONHexValue(c[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+// JSON numbers always use `.`, strtod has to run in the C locale
+static locale_t SHJSONCLocale(void) {
+    static locale_t locale;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        locale = newlocale(LC_ALL_MASK, "C", NULL);
+    });
+    return locale;
+}
+
+void SHJSONReaderInit(SHJSONReader *reader, const void *bytes, NSUInteger length) {
+    reader->start = bytes;
+    reader->cursor = bytes;
+    reader->end = (const uint8_t *)bytes + length;
+    reader->depth = 0;
+    reader->failed = NO;
+
+    // skip the UTF-8 byte order mark, NSJSONSerialization accepts it as well
+    if (length >= 3 && reader->cursor[0] == 0xEF && reader->cursor[1] == 0xBB && reader->cursor[2] == 0xBF) {
+        reader->cursor += 3;
+    }
+}
+
+SHJSONValueType SHJSONReaderPeek(SHJSONReader *reader) {
+    if (reader->failed) {
+        return SHJSONValueTypeInvalid;
+    }
+    SHJSONSkipWhitespace(reader);
+    if (reader->cursor >= reader->end) {
+        return SHJSONValueTypeInvalid;
+    }
+    switch (*reader->cursor) {
+        case '{':
+            return SHJSONValueTypeObject;
+        case '[':
+            return SHJSONValueTypeArray;
+        case '"':
+            return SHJSONValueTypeString;
+        case 't':
+            return SHJSONValueTypeTrue;
+        case 'f':
+            return SHJSONValueTypeFalse;
+        case 'n':
+            return SHJSONValueTypeNull;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            return SHJSONValueTypeNumber;
+        default:
+            return SHJSONValueTypeInvalid;
+    }
+}
+
+BOOL SHJSONReaderBeginObject(SHJSONReader *reader) {
+    if (reader->depth >= MAX_DEPTH || !SHJSONConsume(reader, '{')) {
+        return SHJSONFail(reader);
+    }
+    reader->depth++;
+    return YES;
+}
+
+BOOL SHJSONReaderBeginArray(SHJSONReader *reader) {
+    if (reader->depth >= MAX_DEPTH || !SHJSONConsume(reader, '[')) {
+        return SHJSONFail(reader);
+    }
+    reader->depth++;
+    return YES;
+}
+
+// handles the `,` or the closing bracket between members and elements
+static inline BOOL SHJSONNextItem(SHJSONReader *reader, BOOL *first, uint8_t closing) {
+    if (reader->failed) {
+        return NO;
+    }
+    SHJSONSkipWhitespace(reader);
+    if (reader->cursor >= reader->end) {
+        return SHJSONFail(reader);
+    }
+    if (*reader->cursor == closing) {
+        reader->cursor++;
+        reader->depth--;
+        return NO;
+    }
+    if (*first) {
+        *first = NO;
+        return YES;
+    }
+    if (*reader->cursor != ',') {
+        return SHJSONFail(reader);
+    }
+    reader->cursor++;
+    return YES;
+}
+
+BOOL SHJSONReaderNextMember(SHJSONReader *reader, BOOL *first, SHJSONStringRef *key) {
+    BOOL wasFirst = *first;
+    if (!SHJSONNextItem(reader, first, '}')) {
+        return NO;
+    }
+    if (!wasFirst) {
+        SHJSONSkipWhitespace(reader);
+        if (reader->cursor < reader->end && *reader->cursor == '}') {
+            return SHJSONFail(reader);
+        }
+    }
+    if (!SHJSONReaderReadStringRef(reader, key)) {
+        return NO;
+    }
+    return SHJSONConsume(reader, ':');
+}
+
+BOOL SHJSONReaderNextElement(SHJSONReader *reader, BOOL *first) {
+    BOOL wasFirst = *first;
+    if (!SHJSONNextItem(reader, first, ']')) {
+        return NO;
+    }
+    if (!wasFirst) {
+        SHJSONSkipWhitespace(reader);
+        if (reader->cursor < reader->end && *reader->cursor == ']') {
+            return SHJSONFail(reader);
+        }
+    }
+    return YES;
+}
+
+BOOL SHJSONReaderReadStringRef(SHJSONReader *reader, SHJSONStringRef *string) {
+    if (!SHJSONConsume(reader, '"')) {
+        return NO;
+    }
+
+    const uint8_t *c = reader->cursor;
+    const uint8_t *end = reader->end;
+    BOOL hasEscapes = NO;
+    BOOL isASCII = YES;
+    while (c < end && *c != '"') {
+        if (*c == '\\') {
+            hasEscapes = YES;
+            if (c + 1 >= end) {
+                return SHJSONFail(reader);
+            }
+            switch (c[1]) {
+                case '"':
+                case '\\':
+                case '/':
+                case 'b':
+                case 'f':
+                case 'n':
+                case 'r':
+                case 't':
+                    c += 2;
+                    break;
+                case 'u':
+                    if (c + 6 > end || SHJSONReadHex4(c + 2) < 0) {
+                        return SHJSONFail(reader);
+                    }
+                    c += 6;
+                    break;
+                default:
+                    return SHJSONFail(reader);
+            }
+            continue;
+        }
+        if (*c < 0x20) {
+            return SHJSONFail(reader);
+        }
+        if (*c >= 0x80) {
+            isASCII = NO;
+        }
+        c++;
+    }
+    if (c >= end) {
+        return SHJSONFail(reader);
+    }
+
+    string->bytes = reader->cursor;
+    string->length = (NSUInteger)(c - reader->cursor);
+    string->hasEscapes = hasEscapes;
+    string->isASCII = isASCII;
+    reader->cursor = c + 1;
+    return YES;
+}
+
+BOOL SHJSONReaderReadNumber(SHJSONReader *reader, SHJSONNumber *number) {
+    SHJSONSkipWhitespace(reader);
+    const uint8_t *start = reader->cursor;
+    const uint8_t *c = start;
+    const uint8_t *end = reader->end;
+
+    BOOL negative = NO;
+    if (c < end && *c == '-') {
+        negative = YES;
+        c++;
+    }
+    if (c >= end || *c < '0' || *c > '9') {
+        return SHJSONFail(reader);
+    }
+
+    // integer part, accumulated as a negative value so that LLONG_MIN fits
+    BOOL fitsInteger = YES;
+    long long value = 0;
+    if (*c == '0') {
+        c++;
+    } else {
+        while (c < end && *c >= '0' && *c <= '9') {
+            int digit = *c - '0';
+            if (value < (LLONG_MIN + digit) / 10) {
+                fitsInteger = NO;
+            } else {
+                value = value * 10 - digit;
+            }
+            c++;
+        }
+    }
+    const uint8_t *integerEnd = c;
+
+    BOOL isInteger = YES;
+    if (c < end && *c == '.') {
+        isInteger = NO;
+        c++;
+        if (c >= end || *c < '0' || *c > '9') {
+            return SHJSONFail(reader);
+        }
+        while (c < end && *c >= '0' && *c <= '9') {
+            c++;
+        }
+    }
+    if (c < end && (*c == 'e' || *c == 'E')) {
+        isInteger = NO;
+        c++;
+        if (c < end && (*c == '+' || *c == '-')) {
+            c++;
+        }
+        if (c >= end || *c < '0' || *c > '9') {
+            return SHJSONFail(reader);
+        }
+        while (c < end && *c >= '0' && *c <= '9') {
+            c++;
+        }
+    }
+    reader->cursor = c;
+
+    number->isUnsigned = NO;
+    if (isInteger && fitsInteger && (negative || value != LLONG_MIN)) {
+        number->isInteger = YES;
+        number->integerValue = negative ? value : -value;
+        number->doubleValue = (double)number->integerValue;
+        return YES;
+    }
+
+    // positive integers above LLONG_MAX stay exact while they fit into unsigned long long
+    if (isInteger && !negative) {
+        unsigned long long unsignedValue = 0;
+        BOOL fitsUnsigned = YES;
+        for (const uint8_t *digit = start; digit < integerEnd && fitsUnsigned; digit++) {
+            unsigned int digitValue = *digit - '0';
+            if (unsignedValue > (ULLONG_MAX - digitValue) / 10) {
+                fitsUnsigned = NO;
+            } else {
+                unsignedValue = unsignedValue * 10 + digitValue;
+            }
+        }
+        if (fitsUnsigned) {
+            number->isInteger = NO;
+            number->isUnsigned = YES;
+            number->unsignedIntegerValue = unsignedValue;
+            number->integerValue = LLONG_MAX;
+            number->doubleValue = (double)unsignedValue;
+            return YES;
+        }
+    }
+
+    NSUInteger length = (NSUInteger)(c - start);
+    char stackBuffer[NUMBER_STACK_BUFFER_LENGTH];
+    char *buffer = (length < NUMBER_STACK_BUFFER_LENGTH) ? stackBuffer : malloc(length + 1);
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    number->isInteger = NO;
+    number->doubleValue = strtod_l(buffer, NULL, SHJSONCLocale());
+    // out of range doubles are clamped, the cast alone is undefined
+    if (number->doubleValue >= 9223372036854775807.0) {
+        number->integerValue = LLONG_MAX;
+    } else if (number->doubleValue <= -9223372036854775808.0) {
+        number->integerValue = LLONG_MIN;
+    } else {
+        number->integerValue = (long long)number->doubleValue;
+    }
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+    return YES;
+}
+
+NSNumber *SHJSONNumberObject(const SHJSONNumber *number) {
+    if (number->isInteger) {
+        return @(number->integerValue);
+    }
+    return number->isUnsigned ? @(number->unsignedIntegerValue) : @(number->doubleValue);
+}
+
+BOOL SHJSONReaderReadLiteral(SHJSONReader *reader, SHJSONValueType type) {
+    const char *literal;
+    NSUInteger length;
+    switch (type) {
+        case SHJSONValueTypeTrue:
+            literal = "true";
+            length = 4;
+            break;
+        case SHJSONValueTypeFalse:
+            literal = "false";
+            length = 5;
+            break;
+        case SHJSONValueTypeNull:
+            literal = "null";
+            length = 4;
+            break;
+        default:
+            return SHJSONFail(reader);
+    }
+
+    SHJSONSkipWhitespace(reader);
+    if ((NSUInteger)(reader->end - reader->cursor) < length || memcmp(reader->cursor, literal, length) != 0) {
+        return SHJSONFail(reader);
+    }
+    reader->cursor += length;
+    return YES;
+}
+
+BOOL SHJSONReaderSkipValue(SHJSONReader *reader) {
+    SHJSONValueType type = SHJSONReaderPeek(reader);
+    switch (type) {
+        case SHJSONValueTypeObject: {
+            if (!SHJSONReaderBeginObject(reader)) {
+                return NO;
+            }
+            BOOL first = YES;
+            SHJSONStringRef key;
+            while (SHJSONReaderNextMember(reader, &first, &key)) {
+                if (!SHJSONReaderSkipValue(reader)) {
+                    return NO;
+                }
+            }
+            return !reader->failed;
+        }
+        case SHJSONValueTypeArray: {
+            if (!SHJSONReaderBeginArray(reader)) {
+                return NO;
+            }
+            BOOL first = YES;
+            while (SHJSONReaderNextElement(reader, &first)) {
+                if (!SHJSONReaderSkipValue(reader)) {
+                    return NO;
+                }
+            }
+            return !reader->failed;
+        }
+        case SHJSONValueTypeString: {
+            SHJSONStringRef string;
+            return SHJSONReaderReadStringRef(reader, &string);
+        }
+        case SHJSONValueTypeNumber: {
+            // only validates the grammar, the value itself is not needed
+            SHJSONNumber number;
+            return SHJSONReaderReadNumber(reader, &number);
+        }
+        case SHJSONValueTypeTrue:
+        case SHJSONValueTypeFalse:
+        case SHJSONValueTypeNull:
+            return SHJSONReaderReadLiteral(reader, type);
+        default:
+            return SHJSONFail(reader);
+    }
+}
+
+BOOL SHJSONReaderAtEnd(SHJSONReader *reader) {
+    SHJSONSkipWhitespace(reader);
+    return !reader->failed && reader->cursor == reader->end;
+}
+
+#pragma mark - materializing values
+
+// appends the UTF-8 encoding of `codePoint`, returns the number of bytes written
+static inline NSUInteger SHJSONAppendUTF8(uint8_t *out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out[0] = (uint8_t)codePoint;
+        return 1;
+    }
+    if (codePoint < 0x800) {
+        out[0] = (uint8_t)(0xC0 | (codePoint >> 6));
+        out[1] = (uint8_t)(0x80 | (codePoint & 0x3F));
+        return 2;
+    }
+    if (codePoint < 0x10000) {
+        out[0] = (uint8_t)(0xE0 | (codePoint >> 12));
+        out[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+        out[2] = (uint8_t)(0x80 | (codePoint & 0x3F));
+        return 3;
+    }
+    out[0] = (uint8_t)(0xF0 | (codePoint >> 18));
+    out[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3F));
+    out[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3F));
+    out[3] = (uint8_t)(0x80 | (codePoint & 0x3F));
+    return 4;
+}
+
+NSString *SHJSONStringCreate(const SHJSONStringRef *string) {
+    if (!string->hasEscapes) {
+        return [[NSString alloc] initWithBytes:string->bytes
+                                        length:string->length
+                                      encoding:(string->isASCII ? NSASCIIStringEncoding : NSUTF8StringEncoding)];
+    }
+
+    // unescaped UTF-8 is never longer than the escaped bytes, `\uXXXX` (6 bytes) expands to at most 3 bytes and a
+    // surrogate pair (12 bytes) to 4 bytes
+    uint8_t *buffer = malloc(MAX(string->length, 1));
+    NSUInteger length = 0;
+    const uint8_t *c = string->bytes;
+    const uint8_t *end = string->bytes + string->length;
+    while (c < end) {
+        if (*c != '\\') {
+            buffer[length++] = *c++;
+            continue;
+        }
+        switch (c[1]) {
+            case 'b':
+                buffer[length++] = '\b';
+                break;
+            case 'f':
+                buffer[length++] = '\f';
+                break;
+            case 'n':
+                buffer[length++] = '\n';
+                break;
+            case 'r':
+                buffer[length++] = '\r';
+                break;
+            case 't':
+                buffer[length++] = '\t';
+                break;
+            case 'u': {
+                uint32_t codePoint = (uint32_t)SHJSONReadHex4(c + 2);
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF && c + 12 <= end && c[6] == '\\' && c[7] == 'u') {
+                    int low = SHJSONReadHex4(c + 8);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + ((uint32_t)low - 0xDC00);
+                        c += 6;
+                    }
+                }
+                if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+                    // unpaired surrogate
+                    codePoint = 0xFFFD;
+                }
+                length += SHJSONAppendUTF8(buffer + length, codePoint);
+                c += 6;
+                continue;
+            }
+            default:
+                // `"`, `\` and `/`
+                buffer[length++] = c[1];
+                break;
+        }
+        c += 2;
+    }
+
+    NSString *result = [[NSString alloc] initWithBytesNoCopy:buffer
+                                                      length:length
+                                                    encoding:NSUTF8StringEncoding
+                                                freeWhenDone:YES];
+    if (nil == result) {
+        free(buffer);
+    }
+    return result;
+}
+
+id SHJSONReaderReadValue(SHJSONReader *reader) {
+    SHJSONValueType type = SHJSONReaderPeek(reader);
+    switch (type) {
+        case SHJSONValueTypeObject: {
+            if (!SHJSONReaderBeginObject(reader)) {
+                return nil;
+            }
+            NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+            BOOL first = YES;
+            SHJSONStringRef keyRef;
+            while (SHJSONReaderNextMember(reader, &first, &keyRef)) {
+                NSString *key = SHJSONStringCreate(&keyRef);
+                id value = SHJSONReaderReadValue(reader);
+                if (nil == key || nil == value) {
+                    reader->failed = YES;
+                    return nil;
+                }
+                dictionary[key] = value;
+            }
+            return reader->failed ? nil : dictionary;
+        }
+        case SHJSONValueTypeArray: {
+            if (!SHJSONReaderBeginArray(reader)) {
+                return nil;
+            }
+            NSMutableArray *array = [NSMutableArray array];
+            BOOL first = YES;
+            while (SHJSONReaderNextElement(reader, &first)) {
+                id value = SHJSONReaderReadValue(reader);
+                if (nil == value) {
+                    reader->failed = YES;
+                    return nil;
+                }
+                [array addObject:value];
+            }
+            return reader->failed ? nil : array;
+        }
+        case SHJSONValueTypeString: {
+            SHJSONStringRef string;
+            if (!SHJSONReaderReadStringRef(reader, &string)) {
+                return nil;
+            }
+            NSString *result = SHJSONStringCreate(&string);
+            if (nil == result) {
+                reader->failed = YES;
+            }
+            return result;
+        }
+        case SHJSONValueTypeNumber: {
+            SHJSONNumber number;
+            if (!SHJSONReaderReadNumber(reader, &number)) {
+                return nil;
+            }
+            return SHJSONNumberObject(&number);
+        }
+        case SHJSONValueTypeTrue:
+        case SHJSONValueTypeFalse:
+        case SHJSONValueTypeNull:
+            if (!SHJSONReaderReadLiteral(reader, type)) {
+                return nil;
+            }
+            if (type == SHJSONValueTypeNull) {
+                return [NSNull null];
+            }
+            return (type == SHJSONValueTypeTrue) ? @YES : @NO;
+        default:
+            SHJSONFail(reader);
+            return nil;
+    }
+}
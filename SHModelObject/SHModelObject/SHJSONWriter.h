@@ -0,0 +1,79 @@
+// SHJSONWriter.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  writer producing UTF-8 encoded JSON into one growable buffer, the counterpart of `SHJSONReader`. values are
+ *  appended in order, the caller writes the separators.
+ */
+typedef struct {
+    uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger capacity;
+} SHJSONWriter;
+
+void SHJSONWriterInit(SHJSONWriter *writer, NSUInteger capacity);
+
+// appends raw bytes, e.g. `{` or `,`
+void SHJSONWriterAppendBytes(SHJSONWriter *writer, const void *bytes, NSUInteger length);
+
+void SHJSONWriterAppendByte(SHJSONWriter *writer, uint8_t byte);
+
+// writes a quoted and escaped string
+void SHJSONWriterWriteString(SHJSONWriter *writer, NSString *string);
+
+void SHJSONWriterWriteLongLong(SHJSONWriter *writer, long long value);
+
+void SHJSONWriterWriteUnsignedLongLong(SHJSONWriter *writer, unsigned long long value);
+
+/**
+ *  writes the shortest decimal that reads back as the same double.
+ *
+ *  @return `NO` for NaN and infinity, JSON has no numbers for them
+ */
+BOOL SHJSONWriterWriteDouble(SHJSONWriter *writer, double value);
+
+// like `SHJSONWriterWriteDouble`, the shortest decimal that reads back as the same float
+BOOL SHJSONWriterWriteFloat(SHJSONWriter *writer, float value);
+
+void SHJSONWriterWriteBool(SHJSONWriter *writer, BOOL value);
+
+void SHJSONWriterWriteNull(SHJSONWriter *writer);
+
+/**
+ *  writes a number with the type it was created with: booleans as `true` / `false`, integers exact and floating point
+ *  numbers as the shortest decimal.
+ *
+ *  @return `NO` for NaN and infinity
+ */
+BOOL SHJSONWriterWriteNumber(SHJSONWriter *writer, NSNumber *number);
+
+/**
+ *  hands the buffer over, the writer is empty afterwards.
+ *
+ *  @return the written bytes
+ */
+NSData *SHJSONWriterCopyData(SHJSONWriter *writer);
+
+// frees the buffer without creating data, e.g. after an error
+void SHJSONWriterDiscard(SHJSONWriter *writer);
@@ -0,0 +1,211 @@
+// SHJSONWriter.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHJSONWriter.h"
+
+static inline uint8_t *SHJSONWriterReserve(SHJSONWriter *writer, NSUInteger count) {
+    if (writer->length + count > writer->capacity) {
+        NSUInteger capacity = MAX(writer->capacity * 2, writer->length + count);
+        writer->bytes = realloc(writer->bytes, capacity);
+        writer->capacity = capacity;
+    }
+    uint8_t *bytes = writer->bytes + writer->length;
+    writer->length += count;
+    return bytes;
+}
+
+void SHJSONWriterInit(SHJSONWriter *writer, NSUInteger capacity) {
+    writer->capacity = MAX(capacity, 16);
+    writer->bytes = malloc(writer->capacity);
+    writer->length = 0;
+}
+
+void SHJSONWriterAppendBytes(SHJSONWriter *writer, const void *bytes, NSUInteger length) {
+    memcpy(SHJSONWriterReserve(writer, length), bytes, length);
+}
+
+void SHJSONWriterAppendByte(SHJSONWriter *writer, uint8_t byte) {
+    *SHJSONWriterReserve(writer, 1) = byte;
+}
+
+static inline BOOL SHJSONNeedsEscape(uint8_t byte) {
+    return byte < 0x20 || byte == '"' || byte == '\\';
+}
+
+// `bytes` must not point into the writer's buffer
+static void SHJSONWriterAppendEscaped(SHJSONWriter *writer, const uint8_t *bytes, NSUInteger length) {
+    static const char hex[] = "0123456789abcdef";
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t byte = bytes[i];
+        if (!SHJSONNeedsEscape(byte)) {
+            SHJSONWriterAppendByte(writer, byte);
+            continue;
+        }
+        switch (byte) {
+            case '"': SHJSONWriterAppendBytes(writer, "\\\"", 2); break;
+            case '\\': SHJSONWriterAppendBytes(writer, "\\\\", 2); break;
+            case '\n': SHJSONWriterAppendBytes(writer, "\\n", 2); break;
+            case '\r': SHJSONWriterAppendBytes(writer, "\\r", 2); break;
+            case '\t': SHJSONWriterAppendBytes(writer, "\\t", 2); break;
+            case '\b': SHJSONWriterAppendBytes(writer, "\\b", 2); break;
+            case '\f': SHJSONWriterAppendBytes(writer, "\\f", 2); break;
+            default: {
+                uint8_t escape[6] = { '\\', 'u', '0', '0', hex[byte >> 4], hex[byte & 0xF] };
+                SHJSONWriterAppendBytes(writer, escape, sizeof(escape));
+            } break;
+        }
+    }
+}
+
+void SHJSONWriterWriteString(SHJSONWriter *writer, NSString *string) {
+    // converted straight into the buffer, escaping needs a second pass only when an escaped character was written
+    NSUInteger maxLength = [string maxLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    NSUInteger start = writer->length;
+    uint8_t *bytes = SHJSONWriterReserve(writer, maxLength + 2);
+    bytes[0] = '"';
+    NSUInteger usedLength = 0;
+    [string getBytes:bytes + 1
+             maxLength:maxLength
+            usedLength:&usedLength
+              encoding:NSUTF8StringEncoding
+               options:NSStringEncodingConversionAllowLossy
+                 range:NSMakeRange(0, [string length])
+        remainingRange:NULL];
+
+    BOOL needsEscape = NO;
+    for (NSUInteger i = 0; i < usedLength && !needsEscape; i++) {
+        needsEscape = SHJSONNeedsEscape(bytes[1 + i]);
+    }
+    if (!needsEscape) {
+        bytes[1 + usedLength] = '"';
+        writer->length = start + usedLength + 2;
+        return;
+    }
+
+    uint8_t *unescaped = malloc(MAX(usedLength, 1));
+    memcpy(unescaped, bytes + 1, usedLength);
+    writer->length = start + 1;
+    SHJSONWriterAppendEscaped(writer, unescaped, usedLength);
+    SHJSONWriterAppendByte(writer, '"');
+    free(unescaped);
+}
+
+void SHJSONWriterWriteUnsignedLongLong(SHJSONWriter *writer, unsigned long long value) {
+    char buffer[24];
+    NSUInteger position = sizeof(buffer);
+    do {
+        buffer[--position] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    SHJSONWriterAppendBytes(writer, buffer + position, sizeof(buffer) - position);
+}
+
+void SHJSONWriterWriteLongLong(SHJSONWriter *writer, long long value) {
+    if (value < 0) {
+        SHJSONWriterAppendByte(writer, '-');
+        // negated as unsigned, so LLONG_MIN does not overflow
+        SHJSONWriterWriteUnsignedLongLong(writer, 0ULL - (unsigned long long)value);
+    } else {
+        SHJSONWriterWriteUnsignedLongLong(writer, (unsigned long long)value);
+    }
+}
+
+BOOL SHJSONWriterWriteDouble(SHJSONWriter *writer, double value) {
+    if (!isfinite(value)) {
+        return NO;
+    }
+    char buffer[32];
+    int length = 0;
+    for (int precision = 15; precision <= 17; precision++) {
+        length = snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        if (strtod(buffer, NULL) == value) {
+            break;
+        }
+    }
+    SHJSONWriterAppendBytes(writer, buffer, (NSUInteger)length);
+    return YES;
+}
+
+BOOL SHJSONWriterWriteFloat(SHJSONWriter *writer, float value) {
+    if (!isfinite(value)) {
+        return NO;
+    }
+    char buffer[32];
+    int length = 0;
+    for (int precision = 6; precision <= 9; precision++) {
+        length = snprintf(buffer, sizeof(buffer), "%.*g", precision, (double)value);
+        if (strtof(buffer, NULL) == value) {
+            break;
+        }
+    }
+    SHJSONWriterAppendBytes(writer, buffer, (NSUInteger)length);
+    return YES;
+}
+
+void SHJSONWriterWriteBool(SHJSONWriter *writer, BOOL value) {
+    if (value) {
+        SHJSONWriterAppendBytes(writer, "true", 4);
+    } else {
+        SHJSONWriterAppendBytes(writer, "false", 5);
+    }
+}
+
+void SHJSONWriterWriteNull(SHJSONWriter *writer) {
+    SHJSONWriterAppendBytes(writer, "null", 4);
+}
+
+static inline BOOL SHJSONIsBooleanNumber(NSNumber *number) {
+#ifdef __APPLE__
+    return CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID();
+#else
+    // booleans are plain char numbers on other platforms
+    return NO;
+#endif
+}
+
+BOOL SHJSONWriterWriteNumber(SHJSONWriter *writer, NSNumber *number) {
+    if (SHJSONIsBooleanNumber(number)) {
+        SHJSONWriterWriteBool(writer, [number boolValue]);
+        return YES;
+    }
+    switch ([number objCType][0]) {
+        case 'f': return SHJSONWriterWriteFloat(writer, [number floatValue]);
+        case 'd': return SHJSONWriterWriteDouble(writer, [number doubleValue]);
+        case 'Q': SHJSONWriterWriteUnsignedLongLong(writer, [number unsignedLongLongValue]); return YES;
+        default: SHJSONWriterWriteLongLong(writer, [number longLongValue]); return YES;
+    }
+}
+
+NSData *SHJSONWriterCopyData(SHJSONWriter *writer) {
+    NSData *data = [NSData dataWithBytesNoCopy:writer->bytes length:writer->length freeWhenDone:YES];
+    writer->bytes = NULL;
+    writer->length = 0;
+    writer->capacity = 0;
+    return data;
+}
+
+void SHJSONWriterDiscard(SHJSONWriter *writer) {
+    free(writer->bytes);
+    writer->bytes = NULL;
+    writer->length = 0;
+    writer->capacity = 0;
+}
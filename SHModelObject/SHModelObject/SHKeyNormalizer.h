@@ -0,0 +1,92 @@
+// SHKeyNormalizer.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "SHConstants.h"
+
+// size of the on-stack buffer used for normalizing keys, longer keys use a heap buffer.
+#define SH_KEY_STACK_BUFFER_LENGTH 128
+
+/**
+ *  normalizes the characters of a dictionary key or ivar name for comparision in a single pass: `-`, `_` and ` `
+ *  are stripped and the characters are lowercased. the hash of the normalized characters is computed at the same
+ *  time. whitespace at the start of the key or right after a stripped character is dropped too, exactly like the
+ *  NSScanner based comparision this replaces.
+ *
+ *  only ASCII keys are handled here. for anything else the function returns `NO` and the caller should use
+ *  `+[SHNormalizedKey normalizedKeyForString:]` which falls back to `-[NSString lowercaseString]`.
+ *
+ *  @param characters characters of the key
+ *  @param length number of characters
+ *  @param outCharacters buffer of at least `length` characters receiving the normalized key
+ *  @param outLength receives the length of the normalized key
+ *  @param outHash receives the hash of the normalized key
+ *
+ *  @return `YES` if the key was normalized, `NO` if the key is not valid or contains non-ASCII characters
+ */
+BOOL SHNormalizeASCIICharacters(const unichar *characters, NSUInteger length, unichar *outCharacters,
+                                NSUInteger *outLength, NSUInteger *outHash);
+
+/**
+ *  hash of normalized key characters, the same hash `SHNormalizeASCIICharacters` computes.
+ */
+NSUInteger SHNormalizedKeyHash(const unichar *characters, NSUInteger length);
+
+/**
+ *  builds the key an ivar is exported with. the name is split into words at `-`, `_`, ` ` and case changes
+ *  (`URLString` is `URL` and `String`), so the key matches the ivar again when it is decoded.
+ *
+ *  @param ivarName ivar name, e.g. `_anotherIntValue`
+ *  @param style the key style
+ *
+ *  @return the key
+ */
+NSString *SHOutputKeyForIvarName(NSString *ivarName, kOutputKeyStyle style);
+
+/**
+ *  The `SHNormalizedKey` is the normalized form of a dictionary key or ivar name. keys are interned: normalizing the
+ *  same string again is a single hash lookup and no allocation.
+ */
+@interface SHNormalizedKey : NSObject
+
+/**
+ *  returns the normalized key for a string. the result is cached so the next call for an equal string is O(1).
+ *
+ *  @param string dictionary key or ivar name
+ *
+ *  @return normalized key or nil if the string is not a valid key (nil, empty, only whitespace or `(null)`)
+ */
++ (instancetype)normalizedKeyForString:(NSString *)string;
+
+// the normalized key as a string
+@property (nonatomic, readonly) NSString *string;
+
+// the normalized characters, valid as long as the receiver is alive
+@property (nonatomic, readonly) const unichar *characters;
+
+// number of normalized characters
+@property (nonatomic, readonly) NSUInteger length;
+
+// hash of the normalized characters
+@property (nonatomic, readonly) NSUInteger keyHash;
+
+@end
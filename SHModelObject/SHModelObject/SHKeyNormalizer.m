@@ -0,0 +1,297 @@
+// SHKeyNormalizer.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHKeyNormalizer.h"
+#import <pthread.h>
+
+// maximum number of distinct strings kept in the interning table
+#define INTERNED_KEYS_LIMIT 8192
+
+// FNV-1a
+#define HASH_SEED ((NSUInteger)2166136261u)
+#define HASH_STEP(hash, c) (((hash) ^ (NSUInteger)(c)) * (NSUInteger)16777619u)
+
+// characters stripped from the key and the ivar name for comparision
+static inline BOOL SHIsStripCharacter(unichar c) {
+    return c == '-' || c == '_' || c == ' ';
+}
+
+// ASCII part of `+[NSCharacterSet whitespaceCharacterSet]`
+static inline BOOL SHIsASCIIWhitespace(unichar c) {
+    return c == ' ' || c == '\t';
+}
+
+// ASCII part of `+[NSCharacterSet whitespaceAndNewlineCharacterSet]`, what NSScanner skips by default
+static inline BOOL SHIsASCIIWhitespaceOrNewline(unichar c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline BOOL SHIsNullString(const unichar *c, NSUInteger length) {
+    return length == 6 && c[0] == '(' && c[1] == 'n' && c[2] == 'u' && c[3] == 'l' && c[4] == 'l' && c[5] == ')';
+}
+
+NSUInteger SHNormalizedKeyHash(const unichar *characters, NSUInteger length) {
+    NSUInteger hash = HASH_SEED;
+    for (NSUInteger i = 0; i < length; i++) {
+        hash = HASH_STEP(hash, characters[i]);
+    }
+    return hash;
+}
+
+BOOL SHNormalizeASCIICharacters(const unichar *characters, NSUInteger length, unichar *outCharacters,
+                                NSUInteger *outLength, NSUInteger *outHash) {
+    if (length == 0 || SHIsNullString(characters, length)) {
+        return NO;
+    }
+
+    NSUInteger hash = HASH_SEED;
+    NSUInteger count = 0;
+    BOOL atScanStart = YES;
+    BOOL onlyWhitespace = YES;
+    for (NSUInteger i = 0; i < length; i++) {
+        unichar c = characters[i];
+        if (c >= 0x80) {
+            return NO;
+        }
+        if (!SHIsASCIIWhitespace(c)) {
+            onlyWhitespace = NO;
+        }
+        if (SHIsStripCharacter(c)) {
+            atScanStart = YES;
+            continue;
+        }
+        if (atScanStart && SHIsASCIIWhitespaceOrNewline(c)) {
+            continue;
+        }
+        atScanStart = NO;
+        if (c >= 'A' && c <= 'Z') {
+            c += ('a' - 'A');
+        }
+        outCharacters[count++] = c;
+        hash = HASH_STEP(hash, c);
+    }
+    if (onlyWhitespace) {
+        return NO;
+    }
+
+    *outLength = count;
+    *outHash = hash;
+    return YES;
+}
+
+// unicode variant of SHNormalizeASCIICharacters, only used for keys with non-ASCII characters.
+static NSString *SHNormalizeUnicodeString(NSString *string, const unichar *characters, NSUInteger length) {
+    if (length == 0 || [string isEqualToString:@"(null)"]) {
+        return nil;
+    }
+    if ([[string stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]] length] == 0) {
+        return nil;
+    }
+
+    NSCharacterSet *skipped = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+    unichar *stripped = malloc(sizeof(unichar) * length);
+    NSUInteger count = 0;
+    BOOL atScanStart = YES;
+    for (NSUInteger i = 0; i < length; i++) {
+        unichar c = characters[i];
+        if (SHIsStripCharacter(c)) {
+            atScanStart = YES;
+            continue;
+        }
+        if (atScanStart && [skipped characterIsMember:c]) {
+            continue;
+        }
+        atScanStart = NO;
+        stripped[count++] = c;
+    }
+    NSString *result = [[NSString alloc] initWithCharactersNoCopy:stripped length:count freeWhenDone:YES];
+    return [result lowercaseString];
+}
+
+#pragma mark - output keys
+
+// words of an ivar name, split at strip characters and where the case changes
+static NSArray *SHWordsOfIvarName(NSString *name) {
+    NSCharacterSet *uppercase = [NSCharacterSet uppercaseLetterCharacterSet];
+    NSCharacterSet *lowercase = [NSCharacterSet lowercaseLetterCharacterSet];
+    NSMutableArray *words = [NSMutableArray array];
+    NSMutableString *word = [NSMutableString string];
+    NSUInteger length = [name length];
+    for (NSUInteger i = 0; i < length; i++) {
+        unichar c = [name characterAtIndex:i];
+        if (SHIsStripCharacter(c)) {
+            if ([word length] > 0) {
+                [words addObject:[word copy]];
+                [word setString:@""];
+            }
+            continue;
+        }
+
+        // `intValue` -> `int` `Value`, `URLString` -> `URL` `String`
+        if ([uppercase characterIsMember:c] && [word length] > 0) {
+            unichar previous = [word characterAtIndex:[word length] - 1];
+            unichar next = (i + 1 < length) ? [name characterAtIndex:i + 1] : 0;
+            if (![uppercase characterIsMember:previous] || [lowercase characterIsMember:next]) {
+                [words addObject:[word copy]];
+                [word setString:@""];
+            }
+        }
+        [word appendFormat:@"%C", c];
+    }
+    if ([word length] > 0) {
+        [words addObject:[word copy]];
+    }
+    return words;
+}
+
+NSString *SHOutputKeyForIvarName(NSString *ivarName, kOutputKeyStyle style) {
+    NSUInteger start = 0;
+    while (start < [ivarName length] && [ivarName characterAtIndex:start] == '_') {
+        start++;
+    }
+    NSString *name = [ivarName substringFromIndex:start];
+    NSArray *words = SHWordsOfIvarName(name);
+    if ([words count] == 0) {
+        return ivarName;
+    }
+
+    switch (style) {
+        case kOutputKeyStyleSnakeCase: {
+            return [[words componentsJoinedByString:@"_"] lowercaseString];
+        }
+        case kOutputKeyStyleCamelCase: {
+            NSMutableString *key = [[words[0] lowercaseString] mutableCopy];
+            for (NSUInteger i = 1; i < [words count]; i++) {
+                [key appendString:[words[i] capitalizedString]];
+            }
+            return key;
+        }
+        default: {
+            return name;
+        }
+    }
+}
+
+@implementation SHNormalizedKey {
+    unichar *_characterStorage;
+}
+
+static NSMutableDictionary *_internedKeys;
+static pthread_rwlock_t _internedKeysLock = PTHREAD_RWLOCK_INITIALIZER;
+
++ (instancetype)normalizedKeyForString:(NSString *)string {
+    if (![string isKindOfClass:[NSString class]]) {
+        return nil;
+    }
+
+    pthread_rwlock_rdlock(&_internedKeysLock);
+    id interned = _internedKeys[string];
+    pthread_rwlock_unlock(&_internedKeysLock);
+    if (interned) {
+        return (interned == [NSNull null]) ? nil : interned;
+    }
+
+    SHNormalizedKey *key = [self keyByNormalizingString:string];
+
+    pthread_rwlock_wrlock(&_internedKeysLock);
+    if (nil == _internedKeys) {
+        _internedKeys = [NSMutableDictionary dictionary];
+    }
+    if ([_internedKeys count] < INTERNED_KEYS_LIMIT) {
+        _internedKeys[string] = key ?: [NSNull null];
+    }
+    pthread_rwlock_unlock(&_internedKeysLock);
+
+    return key;
+}
+
++ (instancetype)keyByNormalizingString:(NSString *)string {
+    NSUInteger length = [string length];
+    unichar stackBuffer[SH_KEY_STACK_BUFFER_LENGTH];
+    unichar *characters = (length <= SH_KEY_STACK_BUFFER_LENGTH) ? stackBuffer : malloc(sizeof(unichar) * length);
+    [string getCharacters:characters range:NSMakeRange(0, length)];
+
+    SHNormalizedKey *key = nil;
+    unichar *normalized = malloc(sizeof(unichar) * MAX(length, 1));
+    NSUInteger normalizedLength = 0;
+    NSUInteger hash = 0;
+    if (SHNormalizeASCIICharacters(characters, length, normalized, &normalizedLength, &hash)) {
+        key = [[self alloc] initWithCharacters:normalized length:normalizedLength hash:hash];
+    } else {
+        free(normalized);
+        NSString *unicode = SHNormalizeUnicodeString(string, characters, length);
+        if (unicode) {
+            normalizedLength = [unicode length];
+            normalized = malloc(sizeof(unichar) * MAX(normalizedLength, 1));
+            [unicode getCharacters:normalized range:NSMakeRange(0, normalizedLength)];
+            key = [[self alloc] initWithCharacters:normalized
+                                            length:normalizedLength
+                                              hash:SHNormalizedKeyHash(normalized, normalizedLength)];
+        }
+    }
+
+    if (characters != stackBuffer) {
+        free(characters);
+    }
+    return key;
+}
+
+// takes ownership of `characters`
+- (instancetype)initWithCharacters:(unichar *)characters length:(NSUInteger)length hash:(NSUInteger)hash {
+    if ((self = [super init])) {
+        _characterStorage = characters;
+        _length = length;
+        _keyHash = hash;
+        _string = [[NSString alloc] initWithCharacters:characters length:length];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_characterStorage);
+}
+
+- (const unichar *)characters {
+    return _characterStorage;
+}
+
+- (BOOL)isEqual:(id)object {
+    if (self == object) {
+        return YES;
+    }
+    if (![object isKindOfClass:[SHNormalizedKey class]]) {
+        return NO;
+    }
+    SHNormalizedKey *other = object;
+    return other->_keyHash == _keyHash && other->_length == _length &&
+           memcmp(other->_characterStorage, _characterStorage, sizeof(unichar) * _length) == 0;
+}
+
+- (NSUInteger)hash {
+    return _keyHash;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p %@>", NSStringFromClass([self class]), self, _string];
+}
+
+@end
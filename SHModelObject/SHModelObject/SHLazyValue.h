@@ -0,0 +1,68 @@
+// SHLazyValue.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  The `SHLazyValue` stands in for a nested model or a mapped array of models that was not decoded yet. it keeps the
+ *  source (a dictionary, an array or a range of JSON data) and decodes it when the first message reaches it, every
+ *  message is forwarded to the decoded value from then on. the value is decoded once, also when several threads use
+ *  it at the same time.
+ *
+ *  a value that fails to decode is nil, messages to it then raise like unrecognized selectors. check values that may
+ *  fail with `SHLazyValueResolve` first.
+ *
+ *  models opt in with `+decodesNestedObjectsLazily`.
+ */
+@interface SHLazyValue : NSProxy
+
+/**
+ *  lazy value initializer
+ *
+ *  @param block decodes the value, called at most once
+ *
+ *  @return the lazy value
+ */
+- (instancetype)initWithBlock:(id (^)(void))block;
+
+// number of lazy values created since the last `resetCounters`
++ (NSUInteger)createdCount;
+
+// number of lazy values that were decoded since the last `resetCounters`
++ (NSUInteger)forcedCount;
+
++ (void)resetCounters;
+
+@end
+
+/**
+ *  the decoded value for a lazy value, decoding it now if needed. any other value is returned as it is. use this
+ *  before reading the ivars of a value with the runtime, messages to a lazy value do not need it.
+ *
+ *  @param value a value read from an ivar
+ *
+ *  @return the decoded value
+ */
+id SHLazyValueResolve(id value);
+
+// `YES` if the value is a lazy value that was not decoded yet
+BOOL SHLazyValueIsPending(id value);
@@ -0,0 +1,150 @@
+// SHLazyValue.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHLazyValue.h"
+#import <objc/runtime.h>
+#import <pthread.h>
+
+// counted with the `__sync` builtins, which are full barriers on every platform (libkern is not there with GNUstep)
+static volatile int64_t _createdCount = 0;
+static volatile int64_t _forcedCount = 0;
+
+@implementation SHLazyValue {
+    pthread_mutex_t _lock;
+    id (^_block)(void);
+    id _value;
+    volatile BOOL _forced;
+}
+
+- (instancetype)initWithBlock:(id (^)(void))block {
+    pthread_mutex_init(&_lock, NULL);
+    _block = [block copy];
+    __sync_add_and_fetch(&_createdCount, 1);
+    return self;
+}
+
+- (void)dealloc {
+    pthread_mutex_destroy(&_lock);
+}
+
++ (NSUInteger)createdCount {
+    return (NSUInteger)__sync_add_and_fetch(&_createdCount, 0);
+}
+
++ (NSUInteger)forcedCount {
+    return (NSUInteger)__sync_add_and_fetch(&_forcedCount, 0);
+}
+
++ (void)resetCounters {
+    _createdCount = 0;
+    _forcedCount = 0;
+    __sync_synchronize();
+}
+
+// decodes the value on first use, the block and with it the source are released afterwards. a function and not a
+// method, so no method of the decoded value is hidden.
+static id SHLazyValueForce(SHLazyValue *lazyValue) {
+    if (!lazyValue->_forced) {
+        pthread_mutex_lock(&lazyValue->_lock);
+        if (!lazyValue->_forced) {
+            lazyValue->_value = lazyValue->_block();
+            lazyValue->_block = nil;
+            __sync_synchronize();
+            lazyValue->_forced = YES;
+            __sync_add_and_fetch(&_forcedCount, 1);
+        }
+        pthread_mutex_unlock(&lazyValue->_lock);
+    }
+    // pairs with the barrier before `_forced` is set
+    __sync_synchronize();
+    return lazyValue->_value;
+}
+
+static BOOL SHLazyValueIsForced(SHLazyValue *lazyValue) {
+    return lazyValue->_forced;
+}
+
+#pragma mark - forwarding
+
+- (id)forwardingTargetForSelector:(SEL)selector {
+    return SHLazyValueForce(self);
+}
+
+// only reached when the decoded value is nil. the signature of the selector is not known, so the message cannot be
+// dropped safely and fails like an unrecognized selector
+- (NSMethodSignature *)methodSignatureForSelector:(SEL)selector {
+    return nil;
+}
+
+- (void)forwardInvocation:(NSInvocation *)invocation {
+}
+
+// NSProxy answers these itself, they have to describe the decoded value
+
+- (Class)class {
+    return [SHLazyValueForce(self) class];
+}
+
+- (BOOL)isKindOfClass:(Class)aClass {
+    return [SHLazyValueForce(self) isKindOfClass:aClass];
+}
+
+- (BOOL)isMemberOfClass:(Class)aClass {
+    return [SHLazyValueForce(self) isMemberOfClass:aClass];
+}
+
+- (BOOL)conformsToProtocol:(Protocol *)aProtocol {
+    return [SHLazyValueForce(self) conformsToProtocol:aProtocol];
+}
+
+- (BOOL)respondsToSelector:(SEL)aSelector {
+    return [SHLazyValueForce(self) respondsToSelector:aSelector];
+}
+
+- (BOOL)isEqual:(id)object {
+    return [SHLazyValueForce(self) isEqual:SHLazyValueResolve(object)];
+}
+
+- (NSUInteger)hash {
+    return [SHLazyValueForce(self) hash];
+}
+
+- (NSString *)description {
+    return [SHLazyValueForce(self) description];
+}
+
+- (NSString *)debugDescription {
+    return [SHLazyValueForce(self) debugDescription];
+}
+
+@end
+
+id SHLazyValueResolve(id value) {
+    if (value && object_getClass(value) == [SHLazyValue class]) {
+        return SHLazyValueForce(value);
+    }
+    return value;
+}
+
+BOOL SHLazyValueIsPending(id value) {
+    return value && object_getClass(value) == [SHLazyValue class] && !SHLazyValueIsForced(value);
+}
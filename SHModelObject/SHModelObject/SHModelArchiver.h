@@ -0,0 +1,147 @@
+// SHModelArchiver.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+// version of the archive format, stored in the header of every archive
+extern const uint8_t SHModelArchiveFormatVersion;
+
+/**
+ *  The `SHModelArchiver` writes `SHModelObject` graphs in a compact binary format and reads them back, as a
+ *  replacement for NSKeyedArchiver / NSKeyedUnarchiver.
+ *
+ *  an archive starts with a header and the schema of every model class in it (class name, `archiveVersion` and the
+ *  name and type of each ivar), written once. the values follow: primitive ivars as raw little-endian values, strings
+ *  as length-prefixed UTF-8 (UTF-16 for strings with unpaired surrogates, which have no UTF-8 form), nested models,
+ *  arrays and dictionaries recursively. numbers, dates, data and `NSNull` are
+ *  supported as values, any other `NSCoding` object is stored as a keyed archive.
+ *
+ *  ivars are matched by name when decoding, ivars added to a class since the archive was written keep their default
+ *  value and archived ivars the class no longer has are skipped. primitive types are converted when an ivar changed
+ *  its type. models archived with a different `archiveVersion` than their class has now are rejected.
+ *
+ *  the object graph must be a tree, a model referenced twice is written twice.
+ */
+@interface SHModelArchiver : NSObject
+
+/**
+ *  archives a model, or an array or dictionary of models
+ *
+ *  @param rootObject the object to archive
+ *
+ *  @return the archive, nil if the graph is too deep
+ */
++ (NSData *)archivedDataWithRootObject:(id)rootObject;
+
+/**
+ *  archives a model, or an array or dictionary of models, to a file. the file is written atomically.
+ *
+ *  @param rootObject the object to archive
+ *  @param path file path
+ *
+ *  @return `YES` if the archive was written
+ */
++ (BOOL)archiveRootObject:(id)rootObject toFile:(NSString *)path;
+
+/**
+ *  decodes an archive written by `archivedDataWithRootObject:`
+ *
+ *  @param data the archive
+ *
+ *  @return the root object, nil if the data is not a valid archive or a model was archived with a different version
+ */
++ (id)unarchiveObjectWithData:(NSData *)data;
+
+/**
+ *  decodes an archive written by `archiveRootObject:toFile:`. the file is mapped, not read into memory.
+ *
+ *  @param path file path
+ *
+ *  @return the root object, nil if the file is missing or not a valid archive
+ */
++ (id)unarchiveObjectWithFile:(NSString *)path;
+
+@end
+
+/**
+ *  The `SHModelArchiveWriter` is the encoder behind `SHModelArchiver`. it collects the schema of every model class it
+ *  meets, so several encoded values can share one schema table. writers are not thread-safe.
+ */
+@interface SHModelArchiveWriter : NSObject
+
+/**
+ *  writer initializer for adding values to existing ones. schemas of the table are reused for classes that did not
+ *  change since, so the values already encoded with them stay readable with the new `schemaData`.
+ *
+ *  @param schemaData schema table from `schemaData` of an earlier writer
+ *
+ *  @return the writer, nil if the schema table is not valid
+ */
+- (instancetype)initWithSchemaData:(NSData *)schemaData;
+
+/**
+ *  encodes one value, adding the schemas of its model classes to the schema table
+ *
+ *  @param object the value, nil is allowed
+ *
+ *  @return the encoded value, nil if the graph is too deep
+ */
+- (NSData *)dataWithObject:(id)object;
+
+// schema table of all model classes encoded so far, needed to decode the values
+- (NSData *)schemaData;
+
+@end
+
+/**
+ *  The `SHModelArchiveReader` decodes values written by `SHModelArchiveWriter`. the classes of the schema table are
+ *  resolved once when the reader is created. decoding does not change the reader, one reader can decode on several
+ *  threads at once.
+ */
+@interface SHModelArchiveReader : NSObject
+
+/**
+ *  reader initializer
+ *
+ *  @param bytes schema table from `schemaData`
+ *  @param length length of the schema table
+ *
+ *  @return the reader, nil if the schema table is not valid
+ */
+- (instancetype)initWithSchemaBytes:(const void *)bytes length:(NSUInteger)length;
+
+/**
+ *  decodes one value. the bytes are only read during the call, they are not copied or retained.
+ *
+ *  @param bytes the encoded value
+ *  @param length number of bytes available
+ *  @param outLength number of bytes the value took, can be NULL
+ *  @param outError `YES` if the bytes are not a valid value
+ *
+ *  @return the value, nil for an archived nil or on error
+ */
+- (id)decodeObjectFromBytes:(const void *)bytes
+                     length:(NSUInteger)length
+              decodedLength:(NSUInteger *)outLength
+                      error:(BOOL *)outError;
+
+@end
@@ -0,0 +1,919 @@
+// SHModelArchiver.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHModelArchiver.h"
+#import "SHModelObject.h"
+#import "SHModelClassPlan.h"
+#import "SHLazyValue.h"
+
+const uint8_t SHModelArchiveFormatVersion = 1;
+
+// `SHMA`, the first bytes of every archive
+static const uint8_t SHModelArchiveMagic[] = { 'S', 'H', 'M', 'A' };
+
+// deepest nesting of models and collections, written or read
+#define MAX_DEPTH 512
+
+// longest unsigned LEB128 of a 64 bit value
+#define MAX_VARINT_LENGTH 10
+
+/**
+ *  the tag byte in front of every object value. primitive ivars are written without a tag, their type is in the
+ *  schema.
+ */
+typedef NS_ENUM(uint8_t, SHArchiveTag) {
+    SHArchiveTagNil = 0,
+    SHArchiveTagModel,           // schema index, then the ivars in schema order
+    SHArchiveTagString,          // byte length, UTF-8 bytes
+    SHArchiveTagInteger,         // zigzag varint
+    SHArchiveTagUnsignedInteger, // varint, for values above INT64_MAX
+    SHArchiveTagDouble,          // 8 bytes
+    SHArchiveTagBool,            // 1 byte
+    SHArchiveTagDate,            // 8 bytes, seconds since 1970
+    SHArchiveTagData,            // length, bytes
+    SHArchiveTagArray,           // count, values
+    SHArchiveTagDictionary,      // count, key and value pairs
+    SHArchiveTagNull,
+    SHArchiveTagKeyedArchive,    // length, NSKeyedArchiver data of any other NSCoding object
+    SHArchiveTagUTF16String,     // count, little-endian UTF-16 code units of strings without a UTF-8 form
+};
+
+// archived type of an ivar, the objective-c type encoding with `long` widened to 64 bits
+static char SHArchiveTypeForIvar(SHModelIvarDescriptor *descriptor) {
+    switch (descriptor.type) {
+        case SHIvarTypeObject: return '@';
+        case SHIvarTypeChar: return 'c';
+        case SHIvarTypeUnsignedChar: return 'C';
+        case SHIvarTypeBool: return 'B';
+        case SHIvarTypeShort: return 's';
+        case SHIvarTypeUnsignedShort: return 'S';
+        case SHIvarTypeInt: return 'i';
+        case SHIvarTypeUnsignedInt: return 'I';
+        case SHIvarTypeLong:
+        case SHIvarTypeLongLong: return 'q';
+        case SHIvarTypeUnsignedLong:
+        case SHIvarTypeUnsignedLongLong: return 'Q';
+        case SHIvarTypeFloat: return 'f';
+        case SHIvarTypeDouble: return 'd';
+        default: return 0;
+    }
+}
+
+// size in the archive of a primitive of the archived type, 0 for objects and unknown types
+static NSUInteger SHArchiveSizeOfType(char type) {
+    switch (type) {
+        case 'c':
+        case 'C':
+        case 'B': return 1;
+        case 's':
+        case 'S': return 2;
+        case 'i':
+        case 'I':
+        case 'f': return 4;
+        case 'q':
+        case 'Q':
+        case 'd': return 8;
+        default: return 0;
+    }
+}
+
+static inline BOOL SHArchiveTypeIsSigned(char type) {
+    return type == 'c' || type == 's' || type == 'i' || type == 'q';
+}
+
+static inline BOOL SHIsBooleanNumber(NSNumber *number) {
+#ifdef __APPLE__
+    return CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID();
+#else
+    // booleans are plain char numbers on other platforms
+    return NO;
+#endif
+}
+
+#pragma mark - output
+
+typedef struct {
+    uint8_t *bytes;
+    NSUInteger length;
+    NSUInteger capacity;
+} SHArchiveOutput;
+
+static inline uint8_t *SHOutputReserve(SHArchiveOutput *output, NSUInteger count) {
+    if (output->length + count > output->capacity) {
+        NSUInteger capacity = MAX(output->capacity * 2, output->length + count);
+        output->bytes = realloc(output->bytes, capacity);
+        output->capacity = capacity;
+    }
+    uint8_t *bytes = output->bytes + output->length;
+    output->length += count;
+    return bytes;
+}
+
+static inline void SHOutputWriteByte(SHArchiveOutput *output, uint8_t byte) {
+    *SHOutputReserve(output, 1) = byte;
+}
+
+static inline void SHOutputWriteVarint(SHArchiveOutput *output, uint64_t value) {
+    uint8_t buffer[MAX_VARINT_LENGTH];
+    NSUInteger length = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        buffer[length++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    memcpy(SHOutputReserve(output, length), buffer, length);
+}
+
+// `size` bytes of `value`, little-endian
+static inline void SHOutputWriteFixed(SHArchiveOutput *output, uint64_t value, NSUInteger size) {
+    uint8_t *bytes = SHOutputReserve(output, size);
+    for (NSUInteger i = 0; i < size; i++) {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static inline void SHOutputWriteDouble(SHArchiveOutput *output, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    SHOutputWriteFixed(output, bits, sizeof(bits));
+}
+
+// writes nothing and returns `NO` when the string has no UTF-8 form, e.g. because of a lone surrogate
+static BOOL SHOutputWriteString(SHArchiveOutput *output, NSString *string) {
+    NSUInteger length = [string lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    if (0 == length && [string length] > 0) {
+        return NO;
+    }
+    SHOutputWriteVarint(output, length);
+    uint8_t *bytes = SHOutputReserve(output, length);
+    [string getBytes:bytes
+             maxLength:length
+            usedLength:NULL
+              encoding:NSUTF8StringEncoding
+               options:0
+                 range:NSMakeRange(0, [string length])
+        remainingRange:NULL];
+    return YES;
+}
+
+// any string, unpaired surrogates included
+static void SHOutputWriteUTF16String(SHArchiveOutput *output, NSString *string) {
+    NSUInteger count = [string length];
+    SHOutputWriteVarint(output, count);
+    uint8_t *bytes = SHOutputReserve(output, count * 2);
+    unichar characters[256];
+    for (NSUInteger start = 0; start < count; start += 256) {
+        NSRange range = NSMakeRange(start, MIN(count - start, (NSUInteger)256));
+        [string getCharacters:characters range:range];
+        for (NSUInteger i = 0; i < range.length; i++) {
+            *bytes++ = (uint8_t)characters[i];
+            *bytes++ = (uint8_t)(characters[i] >> 8);
+        }
+    }
+}
+
+static void SHOutputWriteBytes(SHArchiveOutput *output, const void *bytes, NSUInteger length) {
+    SHOutputWriteVarint(output, length);
+    memcpy(SHOutputReserve(output, length), bytes, length);
+}
+
+#pragma mark - input
+
+typedef struct {
+    const uint8_t *cursor;
+    const uint8_t *end;
+    BOOL failed;
+} SHArchiveInput;
+
+static inline BOOL SHInputHas(SHArchiveInput *input, NSUInteger count) {
+    if (input->failed || (NSUInteger)(input->end - input->cursor) < count) {
+        input->failed = YES;
+        return NO;
+    }
+    return YES;
+}
+
+static inline uint8_t SHInputReadByte(SHArchiveInput *input) {
+    if (!SHInputHas(input, 1)) {
+        return 0;
+    }
+    return *input->cursor++;
+}
+
+static inline uint64_t SHInputReadVarint(SHArchiveInput *input) {
+    uint64_t value = 0;
+    for (NSUInteger shift = 0; shift < 7 * MAX_VARINT_LENGTH; shift += 7) {
+        if (!SHInputHas(input, 1)) {
+            return 0;
+        }
+        uint8_t byte = *input->cursor++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    input->failed = YES;
+    return 0;
+}
+
+static inline uint64_t SHInputReadFixed(SHArchiveInput *input, NSUInteger size) {
+    if (!SHInputHas(input, size)) {
+        return 0;
+    }
+    uint64_t value = 0;
+    for (NSUInteger i = 0; i < size; i++) {
+        value |= (uint64_t)input->cursor[i] << (8 * i);
+    }
+    input->cursor += size;
+    return value;
+}
+
+static inline double SHInputReadDouble(SHArchiveInput *input) {
+    uint64_t bits = SHInputReadFixed(input, sizeof(bits));
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// pointer to the next `length` bytes, with the length read first
+static inline const uint8_t *SHInputReadBytes(SHArchiveInput *input, NSUInteger *outLength) {
+    uint64_t length = SHInputReadVarint(input);
+    if (length > NSUIntegerMax || !SHInputHas(input, (NSUInteger)length)) {
+        input->failed = YES;
+        return NULL;
+    }
+    const uint8_t *bytes = input->cursor;
+    input->cursor += length;
+    *outLength = (NSUInteger)length;
+    return bytes;
+}
+
+static NSString *SHInputReadString(SHArchiveInput *input) {
+    NSUInteger length = 0;
+    const uint8_t *bytes = SHInputReadBytes(input, &length);
+    if (NULL == bytes) {
+        return nil;
+    }
+    NSString *string = [[NSString alloc] initWithBytes:bytes length:length encoding:NSUTF8StringEncoding];
+    if (nil == string) {
+        input->failed = YES;
+    }
+    return string;
+}
+
+static NSString *SHInputReadUTF16String(SHArchiveInput *input) {
+    uint64_t count = SHInputReadVarint(input);
+    if (input->failed || count > (uint64_t)(input->end - input->cursor) / 2) {
+        input->failed = YES;
+        return nil;
+    }
+    unichar *characters = malloc(MAX((NSUInteger)count, 1) * sizeof(unichar));
+    for (NSUInteger i = 0; i < count; i++) {
+        characters[i] = (unichar)(input->cursor[2 * i] | (input->cursor[2 * i + 1] << 8));
+    }
+    input->cursor += 2 * count;
+    return [[NSString alloc] initWithCharactersNoCopy:characters length:(NSUInteger)count freeWhenDone:YES];
+}
+
+#pragma mark - schemas
+
+// schema of a model class as written, the ivars the writer encodes
+@interface SHArchiveWriterSchema : NSObject {
+  @public
+    // nil for schemas from `initWithSchemaData:` no class has been encoded with yet
+    Class _modelClass;
+    NSUInteger _index;
+    NSUInteger _version;
+    NSUInteger _count;
+    __unsafe_unretained SHModelIvarDescriptor **_fields;
+    char *_types;
+}
+@property (nonatomic, copy) NSString *className;
+@property (nonatomic, strong) NSArray *names;
+@property (nonatomic, strong) NSArray *descriptors;
+@end
+
+@implementation SHArchiveWriterSchema
+
+- (void)dealloc {
+    free(_fields);
+    free(_types);
+}
+
+- (BOOL)isEqualToSchema:(SHArchiveWriterSchema *)schema {
+    return [_className isEqualToString:schema.className] && _version == schema->_version &&
+           [_names isEqualToArray:schema.names] && memcmp(_types, schema->_types, _count) == 0;
+}
+
+@end
+
+// schema of a model class as read, bound to the ivars of the class as it is now
+@interface SHArchiveReaderSchema : NSObject {
+  @public
+    Class _modelClass;
+    BOOL _rejected;
+    NSUInteger _count;
+    char *_types;
+    // matching ivar for every archived field, NULL for fields the class does not have anymore
+    __unsafe_unretained SHModelIvarDescriptor **_fields;
+    SHIvarType *_fieldTypes;
+    // `YES` for ivars of a mutable collection class, decoded values are copied mutably
+    BOOL *_mutable;
+}
+@property (nonatomic, strong) NSArray *descriptors;
+@end
+
+@implementation SHArchiveReaderSchema
+
+- (void)dealloc {
+    free(_types);
+    free(_fields);
+    free(_fieldTypes);
+    free(_mutable);
+}
+
+@end
+
+static BOOL SHClassIsMutableCollection(Class cls) {
+    return [cls isSubclassOfClass:[NSMutableArray class]] || [cls isSubclassOfClass:[NSMutableDictionary class]] ||
+           [cls isSubclassOfClass:[NSMutableString class]] || [cls isSubclassOfClass:[NSMutableData class]];
+}
+
+#pragma mark - SHModelArchiveWriter
+
+@implementation SHModelArchiveWriter {
+    SHArchiveOutput _output;
+    NSMapTable *_schemas;
+    NSMutableArray *_schemaList;
+}
+
+- (instancetype)init {
+    if ((self = [super init])) {
+        _schemas = [NSMapTable strongToStrongObjectsMapTable];
+        _schemaList = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (instancetype)initWithSchemaData:(NSData *)schemaData {
+    if ((self = [self init])) {
+        SHArchiveInput input = { [schemaData bytes], (const uint8_t *)[schemaData bytes] + [schemaData length], NO };
+        uint64_t count = SHInputReadVarint(&input);
+        for (uint64_t i = 0; i < count && !input.failed; i++) {
+            SHArchiveWriterSchema *schema = [[SHArchiveWriterSchema alloc] init];
+            schema.className = SHInputReadString(&input);
+            schema->_version = (NSUInteger)SHInputReadVarint(&input);
+            uint64_t fieldCount = SHInputReadVarint(&input);
+            if (input.failed || fieldCount > (uint64_t)(input.end - input.cursor) / 2) {
+                return nil;
+            }
+
+            schema->_index = [_schemaList count];
+            schema->_count = (NSUInteger)fieldCount;
+            schema->_types = calloc(MAX(schema->_count, 1), sizeof(char));
+            NSMutableArray *names = [NSMutableArray arrayWithCapacity:schema->_count];
+            for (NSUInteger j = 0; j < schema->_count && !input.failed; j++) {
+                [names addObject:SHInputReadString(&input) ?: @""];
+                schema->_types[j] = (char)SHInputReadByte(&input);
+            }
+            schema.names = names;
+            [_schemaList addObject:schema];
+        }
+        if (input.failed) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_output.bytes);
+}
+
+- (SHArchiveWriterSchema *)schemaForClass:(Class)cls {
+    SHArchiveWriterSchema *schema = [_schemas objectForKey:cls];
+    if (schema) {
+        return schema;
+    }
+
+    NSMutableArray *descriptors = [NSMutableArray array];
+    SHModelClassPlan *plan = [SHModelClassPlan planForClass:cls rootClass:[SHModelObject class]];
+    for (SHModelIvarDescriptor *descriptor in plan.ivars) {
+        // structs, pointers and the like are not archived
+        if (SHArchiveTypeForIvar(descriptor)) {
+            [descriptors addObject:descriptor];
+        }
+    }
+
+    schema = [[SHArchiveWriterSchema alloc] init];
+    schema.className = NSStringFromClass(cls);
+    schema.names = [descriptors valueForKey:@"name"];
+    schema.descriptors = descriptors;
+    schema->_modelClass = cls;
+    schema->_version = [cls archiveVersion];
+    schema->_index = [_schemaList count];
+    schema->_count = [descriptors count];
+    schema->_fields =
+        (__unsafe_unretained SHModelIvarDescriptor **)calloc(MAX(schema->_count, 1), sizeof(SHModelIvarDescriptor *));
+    schema->_types = calloc(MAX(schema->_count, 1), sizeof(char));
+    for (NSUInteger i = 0; i < schema->_count; i++) {
+        schema->_fields[i] = descriptors[i];
+        schema->_types[i] = SHArchiveTypeForIvar(descriptors[i]);
+    }
+
+    // a schema from `initWithSchemaData:` is reused if the class did not change since
+    for (SHArchiveWriterSchema *existing in _schemaList) {
+        if (nil == existing->_modelClass && [existing isEqualToSchema:schema]) {
+            schema->_index = existing->_index;
+            [_schemaList replaceObjectAtIndex:existing->_index withObject:schema];
+            [_schemas setObject:schema forKey:cls];
+            return schema;
+        }
+    }
+
+    [_schemas setObject:schema forKey:cls];
+    [_schemaList addObject:schema];
+    return schema;
+}
+
+- (NSData *)dataWithObject:(id)object {
+    _output.length = 0;
+    if (![self writeObject:object depth:0]) {
+        return nil;
+    }
+    return [NSData dataWithBytes:_output.bytes length:_output.length];
+}
+
+- (NSData *)schemaData {
+    SHArchiveOutput output = { NULL, 0, 0 };
+    SHOutputWriteVarint(&output, [_schemaList count]);
+    // class and ivar names come from the runtime as UTF-8 C strings, they always have a UTF-8 form
+    for (SHArchiveWriterSchema *schema in _schemaList) {
+        SHOutputWriteString(&output, schema.className);
+        SHOutputWriteVarint(&output, schema->_version);
+        SHOutputWriteVarint(&output, schema->_count);
+        for (NSUInteger i = 0; i < schema->_count; i++) {
+            SHOutputWriteString(&output, schema.names[i]);
+            SHOutputWriteByte(&output, (uint8_t)schema->_types[i]);
+        }
+    }
+    return [NSData dataWithBytesNoCopy:output.bytes length:output.length freeWhenDone:YES];
+}
+
+- (BOOL)writeObject:(id)object depth:(NSUInteger)depth {
+    if (depth > MAX_DEPTH) {
+        NSLog(@"%@ is nested deeper than %d levels, not archiving.", NSStringFromClass([object class]), MAX_DEPTH);
+        return NO;
+    }
+
+    // lazy values are archived decoded, their ivars are read below
+    object = SHLazyValueResolve(object);
+    SHArchiveOutput *output = &_output;
+    if (nil == object) {
+        SHOutputWriteByte(output, SHArchiveTagNil);
+    } else if ([object isKindOfClass:[SHModelObject class]]) {
+        SHArchiveWriterSchema *schema = [self schemaForClass:[object class]];
+        SHOutputWriteByte(output, SHArchiveTagModel);
+        SHOutputWriteVarint(output, schema->_index);
+
+        const uint8_t *base = (const uint8_t *)(__bridge void *)object;
+        for (NSUInteger i = 0; i < schema->_count; i++) {
+            SHModelIvarDescriptor *descriptor = schema->_fields[i];
+            const uint8_t *ivar = base + descriptor.offset;
+            switch (descriptor.type) {
+                case SHIvarTypeObject: {
+                    if (![self writeObject:object_getIvar(object, descriptor.ivar) depth:depth + 1]) {
+                        return NO;
+                    }
+                } break;
+                case SHIvarTypeChar: SHOutputWriteFixed(output, (uint64_t)*(const char *)ivar, 1); break;
+                case SHIvarTypeUnsignedChar: SHOutputWriteFixed(output, *(const unsigned char *)ivar, 1); break;
+                case SHIvarTypeBool: SHOutputWriteFixed(output, *(const bool *)ivar ? 1 : 0, 1); break;
+                case SHIvarTypeShort: SHOutputWriteFixed(output, (uint64_t)*(const short *)ivar, 2); break;
+                case SHIvarTypeUnsignedShort: SHOutputWriteFixed(output, *(const unsigned short *)ivar, 2); break;
+                case SHIvarTypeInt: SHOutputWriteFixed(output, (uint64_t)*(const int *)ivar, 4); break;
+                case SHIvarTypeUnsignedInt: SHOutputWriteFixed(output, *(const unsigned int *)ivar, 4); break;
+                case SHIvarTypeLong: SHOutputWriteFixed(output, (uint64_t)*(const long *)ivar, 8); break;
+                case SHIvarTypeUnsignedLong: SHOutputWriteFixed(output, *(const unsigned long *)ivar, 8); break;
+                case SHIvarTypeLongLong: SHOutputWriteFixed(output, (uint64_t)*(const long long *)ivar, 8); break;
+                case SHIvarTypeUnsignedLongLong:
+                    SHOutputWriteFixed(output, *(const unsigned long long *)ivar, 8);
+                    break;
+                case SHIvarTypeFloat: {
+                    uint32_t bits;
+                    memcpy(&bits, ivar, sizeof(bits));
+                    SHOutputWriteFixed(output, bits, sizeof(bits));
+                } break;
+                case SHIvarTypeDouble: SHOutputWriteDouble(output, *(const double *)ivar); break;
+                default: break;
+            }
+        }
+    } else if ([object isKindOfClass:[NSString class]]) {
+        NSUInteger start = output->length;
+        SHOutputWriteByte(output, SHArchiveTagString);
+        if (!SHOutputWriteString(output, object)) {
+            output->length = start;
+            SHOutputWriteByte(output, SHArchiveTagUTF16String);
+            SHOutputWriteUTF16String(output, object);
+        }
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        const char *type = [object objCType];
+        if (SHIsBooleanNumber(object)) {
+            SHOutputWriteByte(output, SHArchiveTagBool);
+            SHOutputWriteByte(output, [object boolValue] ? 1 : 0);
+        } else if (type[0] == 'f' || type[0] == 'd') {
+            SHOutputWriteByte(output, SHArchiveTagDouble);
+            SHOutputWriteDouble(output, [object doubleValue]);
+        } else if ((type[0] == 'Q' || type[0] == 'L') && [object unsignedLongLongValue] > INT64_MAX) {
+            SHOutputWriteByte(output, SHArchiveTagUnsignedInteger);
+            SHOutputWriteVarint(output, [object unsignedLongLongValue]);
+        } else {
+            int64_t value = [object longLongValue];
+            SHOutputWriteByte(output, SHArchiveTagInteger);
+            SHOutputWriteVarint(output, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+        }
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        SHOutputWriteByte(output, SHArchiveTagArray);
+        SHOutputWriteVarint(output, [object count]);
+        for (id item in object) {
+            if (![self writeObject:item depth:depth + 1]) {
+                return NO;
+            }
+        }
+    } else if ([object isKindOfClass:[NSDictionary class]]) {
+        SHOutputWriteByte(output, SHArchiveTagDictionary);
+        SHOutputWriteVarint(output, [object count]);
+        for (id key in object) {
+            if (![self writeObject:key depth:depth + 1] || ![self writeObject:object[key] depth:depth + 1]) {
+                return NO;
+            }
+        }
+    } else if ([object isKindOfClass:[NSDate class]]) {
+        SHOutputWriteByte(output, SHArchiveTagDate);
+        SHOutputWriteDouble(output, [object timeIntervalSince1970]);
+    } else if ([object isKindOfClass:[NSData class]]) {
+        SHOutputWriteByte(output, SHArchiveTagData);
+        SHOutputWriteBytes(output, [object bytes], [object length]);
+    } else if ([object isKindOfClass:[NSNull class]]) {
+        SHOutputWriteByte(output, SHArchiveTagNull);
+    } else if ([object conformsToProtocol:@protocol(NSCoding)]) {
+        NSData *archive = [NSKeyedArchiver archivedDataWithRootObject:object];
+        SHOutputWriteByte(output, SHArchiveTagKeyedArchive);
+        SHOutputWriteBytes(output, [archive bytes], [archive length]);
+    } else {
+        NSLog(@"object %@ does not conform to NSCoding, archiving nil.", [object description]);
+        SHOutputWriteByte(output, SHArchiveTagNil);
+    }
+    return YES;
+}
+
+@end
+
+#pragma mark - SHModelArchiveReader
+
+// stores a primitive archived for an ivar that is now an object, or that has to go through KVC
+static void SHArchiveStoreNumber(id object, SHModelIvarDescriptor *descriptor, SHIvarType type, NSNumber *number) {
+    if (type != SHIvarTypeObject || nil == descriptor.objectClass ||
+        [descriptor.objectClass isSubclassOfClass:[NSNumber class]]) {
+        SHModelSetIvarValue(object, descriptor, number);
+    }
+}
+
+@implementation SHModelArchiveReader {
+    NSArray *_schemas;
+}
+
+- (instancetype)initWithSchemaBytes:(const void *)bytes length:(NSUInteger)length {
+    if ((self = [super init])) {
+        SHArchiveInput input = { bytes, (const uint8_t *)bytes + length, NO };
+        uint64_t count = SHInputReadVarint(&input);
+        NSMutableArray *schemas = [NSMutableArray array];
+        for (uint64_t i = 0; i < count && !input.failed; i++) {
+            SHArchiveReaderSchema *schema = [self readSchema:&input];
+            if (schema) {
+                [schemas addObject:schema];
+            }
+        }
+        if (input.failed) {
+            return nil;
+        }
+        _schemas = schemas;
+    }
+    return self;
+}
+
+- (SHArchiveReaderSchema *)readSchema:(SHArchiveInput *)input {
+    NSString *className = SHInputReadString(input);
+    uint64_t version = SHInputReadVarint(input);
+    uint64_t count = SHInputReadVarint(input);
+    // every field takes at least two bytes
+    if (input->failed || count > (uint64_t)(input->end - input->cursor) / 2) {
+        input->failed = YES;
+        return nil;
+    }
+
+    SHArchiveReaderSchema *schema = [[SHArchiveReaderSchema alloc] init];
+    schema->_count = (NSUInteger)count;
+    schema->_types = calloc(MAX(schema->_count, 1), sizeof(char));
+    schema->_fields = 
+        (__unsafe_unretained SHModelIvarDescriptor **)calloc(MAX(schema->_count, 1), sizeof(SHModelIvarDescriptor *));
+    schema->_fieldTypes = calloc(MAX(schema->_count, 1), sizeof(SHIvarType));
+    schema->_mutable = calloc(MAX(schema->_count, 1), sizeof(BOOL));
+
+    Class cls = NSClassFromString(className);
+    if (cls && ![cls isSubclassOfClass:[SHModelObject class]]) {
+        cls = nil;
+    }
+    if (nil == cls) {
+        NSLog(@"class %@ of the archive is not a SHModelObject subclass, decoding its objects as nil.", className);
+    } else if (version != [cls archiveVersion]) {
+        NSLog(@"%@ was archived with version %llu but is version %lu now, rejecting the archive.", className,
+              (unsigned long long)version, (unsigned long)[cls archiveVersion]);
+        schema->_rejected = YES;
+    }
+    schema->_modelClass = cls;
+
+    NSMutableDictionary *ivarsByName = [NSMutableDictionary dictionary];
+    if (cls) {
+        SHModelClassPlan *plan = [SHModelClassPlan planForClass:cls rootClass:[SHModelObject class]];
+        for (SHModelIvarDescriptor *descriptor in plan.ivars) {
+            ivarsByName[descriptor.name] = descriptor;
+        }
+    }
+
+    NSMutableArray *descriptors = [NSMutableArray array];
+    for (NSUInteger i = 0; i < schema->_count; i++) {
+        NSString *name = SHInputReadString(input);
+        char type = (char)SHInputReadByte(input);
+        if (input->failed || (type != '@' && SHArchiveSizeOfType(type) == 0)) {
+            input->failed = YES;
+            return nil;
+        }
+        schema->_types[i] = type;
+
+        SHModelIvarDescriptor *descriptor = ivarsByName[name];
+        if (descriptor && SHArchiveTypeForIvar(descriptor)) {
+            [descriptors addObject:descriptor];
+            schema->_fields[i] = descriptor;
+            schema->_fieldTypes[i] = descriptor.type;
+            schema->_mutable[i] = SHClassIsMutableCollection(descriptor.objectClass);
+        }
+    }
+    schema.descriptors = descriptors;
+    return schema;
+}
+
+- (id)decodeObjectFromBytes:(const void *)bytes
+                     length:(NSUInteger)length
+              decodedLength:(NSUInteger *)outLength
+                      error:(BOOL *)outError {
+    SHArchiveInput input = { bytes, (const uint8_t *)bytes + length, NO };
+    id object = [self readObject:&input depth:0];
+    if (outLength) {
+        *outLength = (NSUInteger)(input.cursor - (const uint8_t *)bytes);
+    }
+    if (outError) {
+        *outError = input.failed;
+    }
+    return input.failed ? nil : object;
+}
+
+- (id)readObject:(SHArchiveInput *)input depth:(NSUInteger)depth {
+    if (depth > MAX_DEPTH) {
+        input->failed = YES;
+        return nil;
+    }
+
+    SHArchiveTag tag = SHInputReadByte(input);
+    if (input->failed) {
+        return nil;
+    }
+    switch (tag) {
+        case SHArchiveTagNil: return nil;
+        case SHArchiveTagModel: return [self readModel:input depth:depth];
+        case SHArchiveTagString: return SHInputReadString(input);
+        case SHArchiveTagUTF16String: return SHInputReadUTF16String(input);
+        case SHArchiveTagInteger: {
+            uint64_t zigzag = SHInputReadVarint(input);
+            return @((long long)(zigzag >> 1) ^ -(long long)(zigzag & 1));
+        }
+        case SHArchiveTagUnsignedInteger: return @(SHInputReadVarint(input));
+        case SHArchiveTagDouble: return @(SHInputReadDouble(input));
+        case SHArchiveTagBool: return @(SHInputReadByte(input) != 0);
+        case SHArchiveTagDate: {
+            NSTimeInterval interval = SHInputReadDouble(input);
+            return input->failed ? nil : [NSDate dateWithTimeIntervalSince1970:interval];
+        }
+        case SHArchiveTagData: {
+            NSUInteger length = 0;
+            const uint8_t *bytes = SHInputReadBytes(input, &length);
+            return bytes ? [NSData dataWithBytes:bytes length:length] : nil;
+        }
+        case SHArchiveTagArray: {
+            uint64_t count = SHInputReadVarint(input);
+            // every value takes at least one byte
+            if (!SHInputHas(input, (NSUInteger)MIN(count, (uint64_t)NSUIntegerMax))) {
+                return nil;
+            }
+            NSMutableArray *array = [NSMutableArray arrayWithCapacity:(NSUInteger)count];
+            for (uint64_t i = 0; i < count && !input->failed; i++) {
+                id item = [self readObject:input depth:depth + 1];
+                if (item) {
+                    [array addObject:item];
+                }
+            }
+            return input->failed ? nil : [array copy];
+        }
+        case SHArchiveTagDictionary: {
+            uint64_t count = SHInputReadVarint(input);
+            if (!SHInputHas(input, (NSUInteger)MIN(count, (uint64_t)NSUIntegerMax / 2) * 2)) {
+                return nil;
+            }
+            NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:(NSUInteger)count];
+            for (uint64_t i = 0; i < count && !input->failed; i++) {
+                id key = [self readObject:input depth:depth + 1];
+                id value = [self readObject:input depth:depth + 1];
+                if (key && value) {
+                    dictionary[key] = value;
+                }
+            }
+            return input->failed ? nil : [dictionary copy];
+        }
+        case SHArchiveTagNull: return [NSNull null];
+        case SHArchiveTagKeyedArchive: {
+            NSUInteger length = 0;
+            const uint8_t *bytes = SHInputReadBytes(input, &length);
+            if (NULL == bytes) {
+                return nil;
+            }
+            @try {
+                return [NSKeyedUnarchiver unarchiveObjectWithData:[NSData dataWithBytes:bytes length:length]];
+            } @catch (NSException *exception) {
+                input->failed = YES;
+                return nil;
+            }
+        }
+        default: {
+            input->failed = YES;
+            return nil;
+        }
+    }
+}
+
+- (id)readModel:(SHArchiveInput *)input depth:(NSUInteger)depth {
+    uint64_t index = SHInputReadVarint(input);
+    if (input->failed || index >= [_schemas count]) {
+        input->failed = YES;
+        return nil;
+    }
+
+    SHArchiveReaderSchema *schema = _schemas[(NSUInteger)index];
+    if (schema->_rejected) {
+        input->failed = YES;
+        return nil;
+    }
+
+    // objects of classes that are gone are read and dropped
+    id object = schema->_modelClass ? [[schema->_modelClass alloc] init] : nil;
+    for (NSUInteger i = 0; i < schema->_count && !input->failed; i++) {
+        char type = schema->_types[i];
+        SHModelIvarDescriptor *descriptor = schema->_fields[i];
+
+        if (type == '@') {
+            id value = [self readObject:input depth:depth + 1];
+            if (nil == value || nil == descriptor || nil == object) {
+                continue;
+            }
+            if (schema->_mutable[i] && [value conformsToProtocol:@protocol(NSMutableCopying)]) {
+                value = [value mutableCopy];
+            }
+            if (schema->_fieldTypes[i] == SHIvarTypeObject) {
+                // values of an ivar that changed its class are dropped
+                Class objectClass = descriptor.objectClass;
+                if (nil == objectClass || [value isKindOfClass:objectClass]) {
+                    SHModelSetIvarValue(object, descriptor, value);
+                }
+            } else if ([value isKindOfClass:[NSNumber class]]) {
+                SHModelSetIvarValue(object, descriptor, value);
+            }
+            continue;
+        }
+
+        NSUInteger size = SHArchiveSizeOfType(type);
+        uint64_t bits = SHInputReadFixed(input, size);
+        if (nil == descriptor || nil == object || input->failed) {
+            continue;
+        }
+
+        if (type == 'f' || type == 'd') {
+            double value;
+            if (type == 'f') {
+                uint32_t floatBits = (uint32_t)bits;
+                float floatValue;
+                memcpy(&floatValue, &floatBits, sizeof(floatValue));
+                value = floatValue;
+            } else {
+                memcpy(&value, &bits, sizeof(value));
+            }
+            if (!SHModelSetIvarDouble(object, descriptor, value)) {
+                SHArchiveStoreNumber(object, descriptor, schema->_fieldTypes[i], @(value));
+            }
+        } else {
+            long long value = (long long)bits;
+            if (SHArchiveTypeIsSigned(type) && size < 8) {
+                // sign extend
+                uint64_t sign = 1ULL << (size * 8 - 1);
+                value = (long long)((bits ^ sign) - sign);
+            }
+            if (!SHModelSetIvarLongLong(object, descriptor, value)) {
+                NSNumber *number = (type == 'Q') ? @((unsigned long long)value) : @(value);
+                SHArchiveStoreNumber(object, descriptor, schema->_fieldTypes[i], number);
+            }
+        }
+    }
+    return input->failed ? nil : object;
+}
+
+@end
+
+#pragma mark - SHModelArchiver
+
+@implementation SHModelArchiver
+
++ (NSData *)archivedDataWithRootObject:(id)rootObject {
+    SHModelArchiveWriter *writer = [[SHModelArchiveWriter alloc] init];
+    NSData *value = [writer dataWithObject:rootObject];
+    if (nil == value) {
+        return nil;
+    }
+    NSData *schemaData = [writer schemaData];
+
+    SHArchiveOutput output = { NULL, 0, 0 };
+    memcpy(SHOutputReserve(&output, sizeof(SHModelArchiveMagic)), SHModelArchiveMagic, sizeof(SHModelArchiveMagic));
+    SHOutputWriteByte(&output, SHModelArchiveFormatVersion);
+    SHOutputWriteBytes(&output, [schemaData bytes], [schemaData length]);
+    memcpy(SHOutputReserve(&output, [value length]), [value bytes], [value length]);
+    return [NSData dataWithBytesNoCopy:output.bytes length:output.length freeWhenDone:YES];
+}
+
++ (BOOL)archiveRootObject:(id)rootObject toFile:(NSString *)path {
+    return [[self archivedDataWithRootObject:rootObject] writeToFile:path atomically:YES];
+}
+
++ (id)unarchiveObjectWithData:(NSData *)data {
+    SHArchiveInput input = { [data bytes], (const uint8_t *)[data bytes] + [data length], NO };
+    if (!SHInputHas(&input, sizeof(SHModelArchiveMagic) + 1) ||
+        memcmp(input.cursor, SHModelArchiveMagic, sizeof(SHModelArchiveMagic)) != 0) {
+        return nil;
+    }
+    input.cursor += sizeof(SHModelArchiveMagic);
+
+    uint8_t version = SHInputReadByte(&input);
+    if (version > SHModelArchiveFormatVersion) {
+        NSLog(@"archive format version %u is newer than the supported version %u.", version,
+              SHModelArchiveFormatVersion);
+        return nil;
+    }
+
+    NSUInteger schemaLength = 0;
+    const uint8_t *schemaBytes = SHInputReadBytes(&input, &schemaLength);
+    if (NULL == schemaBytes) {
+        return nil;
+    }
+    SHModelArchiveReader *reader = [[SHModelArchiveReader alloc] initWithSchemaBytes:schemaBytes length:schemaLength];
+
+    NSUInteger length = (NSUInteger)(input.end - input.cursor);
+    NSUInteger decodedLength = 0;
+    BOOL error = NO;
+    id object = [reader decodeObjectFromBytes:input.cursor length:length decodedLength:&decodedLength error:&error];
+    if (nil == reader || error || decodedLength != length) {
+        return nil;
+    }
+    return object;
+}
+
++ (id)unarchiveObjectWithFile:(NSString *)path {
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    return data ? [self unarchiveObjectWithData:data] : nil;
+}
+
+@end
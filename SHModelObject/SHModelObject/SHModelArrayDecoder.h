@@ -0,0 +1,134 @@
+// SHModelArrayDecoder.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "SHConstants.h"
+
+@class SHDecodingContext;
+
+/**
+ *  The `SHModelArrayDecoder` decodes a top level JSON array of objects into model objects while the data arrives. the
+ *  bytes of one element are buffered until the element is complete, decoded with `objectWithJSONData:` and handed to
+ *  the handlers, so memory stays proportional to one element instead of the whole payload.
+ *
+ *  elements that are not JSON objects are logged and skipped, like in mapped arrays. a decoder is not thread-safe and
+ *  decodes a single array.
+ */
+@interface SHModelArrayDecoder : NSObject
+
+/**
+ *  decoder initializer
+ *
+ *  @param modelClass `SHModelObject` subclass of the elements
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateType `kInputDateFormat` to determine what what is the input format of the date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return the decoder
+ */
+- (instancetype)initWithModelClass:(Class)modelClass
+              dateConversionOption:(kDateConversionOption)option
+                     inputDateType:(kInputDateFormat)inputDateType
+                          mappings:(NSDictionary *)mapping;
+
+/**
+ *  decoder initializer
+ *
+ *  @param modelClass `SHModelObject` subclass of the elements
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateFormat NSDateFormatter format specifier which will be used to format the input date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return the decoder
+ */
+- (instancetype)initWithModelClass:(Class)modelClass
+              dateConversionOption:(kDateConversionOption)option
+                   inputDateFormat:(NSString *)inputDateFormat
+                          mappings:(NSDictionary *)mapping;
+
+/**
+ *  decoder initializer
+ *
+ *  @param modelClass `SHModelObject` subclass of the elements
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateFormatter NSDateFormatter object which will be used to format the input date. elements are decoded
+ *  on the thread calling `appendData:`, the formatter must not be used on other threads meanwhile.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return the decoder
+ */
+- (instancetype)initWithModelClass:(Class)modelClass
+              dateConversionOption:(kDateConversionOption)option
+                inputDateFormatter:(NSDateFormatter *)inputDateFormatter
+                          mappings:(NSDictionary *)mapping;
+
+/**
+ *  decoder initializer
+ *
+ *  @param modelClass `SHModelObject` subclass of the elements
+ *  @param context `SHDecodingContext` the elements are decoded with, nil for the default context
+ *
+ *  @return the decoder
+ */
+- (instancetype)initWithModelClass:(Class)modelClass context:(SHDecodingContext *)context;
+
+// called with every decoded object, in array order
+@property (nonatomic, copy) void (^objectHandler)(id object);
+
+// called with `batchSize` decoded objects at a time, the last batch may be smaller
+@property (nonatomic, copy) void (^batchHandler)(NSArray *objects);
+
+// number of objects passed to `batchHandler`, 0 (the default) passes everything in a single batch at the end
+@property (nonatomic) NSUInteger batchSize;
+
+// number of objects decoded so far
+@property (nonatomic, readonly) NSUInteger objectCount;
+
+/**
+ *  decodes the next chunk of the JSON array. chunks can be split anywhere, even inside a UTF-8 sequence.
+ *
+ *  @param data next chunk of bytes
+ *
+ *  @return `NO` if the data is not a valid JSON array
+ */
+- (BOOL)appendData:(NSData *)data;
+
+/**
+ *  ends decoding, hands the remaining objects to `batchHandler`
+ *
+ *  @return `NO` if the array is incomplete or any chunk was invalid
+ */
+- (BOOL)finish;
+
+/**
+ *  reads the stream to its end and decodes it. the stream is opened if needed and closed at the end.
+ *
+ *  @param stream stream of the JSON array
+ *
+ *  @return `NO` if the stream failed or its content is not a valid JSON array
+ */
+- (BOOL)decodeStream:(NSInputStream *)stream;
+
+@end
@@ -0,0 +1,304 @@
+// SHModelArrayDecoder.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHModelArrayDecoder.h"
+#import "SHModelObject.h"
+#import "SHJSONReader.h"
+
+// size of the reads from an input stream
+#define STREAM_BUFFER_LENGTH (64 * 1024)
+
+typedef NS_ENUM(NSInteger, SHArrayScanState) {
+    SHArrayScanStateBeforeArray = 0,    // expecting `[`
+    SHArrayScanStateBeforeFirstElement, // after `[`, expecting an element or `]`
+    SHArrayScanStateBeforeElement,      // after `,`, expecting an element
+    SHArrayScanStateInElement,          // inside an element, looking for its end
+    SHArrayScanStateAfterElement,       // expecting `,` or `]`
+    SHArrayScanStateDone,               // after `]`, only whitespace allowed
+    SHArrayScanStateFailed,
+};
+
+static inline BOOL SHIsJSONWhitespace(uint8_t c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static const uint8_t SHUTF8ByteOrderMark[] = { 0xEF, 0xBB, 0xBF };
+
+@implementation SHModelArrayDecoder {
+    Class _modelClass;
+    // shared by all elements
+    SHDecodingContext *_context;
+
+    SHArrayScanState _state;
+    NSUInteger _receivedLength;
+    NSUInteger _byteOrderMarkLength;
+
+    // element scanning state, kept across chunks
+    NSUInteger _depth;
+    BOOL _inString;
+    BOOL _escaped;
+    BOOL _isScalar;
+
+    // bytes of an element that started in an earlier chunk
+    NSMutableData *_elementBuffer;
+    NSMutableArray *_batch;
+}
+
+- (instancetype)initWithModelClass:(Class)modelClass
+              dateConversionOption:(kDateConversionOption)option
+                     inputDateType:(kInputDateFormat)inputDateType
+                          mappings:(NSDictionary *)mapping {
+    return [self initWithModelClass:modelClass
+                            context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                              inputDateType:inputDateType
+                                                                                   mappings:mapping]];
+}
+
+- (instancetype)initWithModelClass:(Class)modelClass
+              dateConversionOption:(kDateConversionOption)option
+                   inputDateFormat:(NSString *)inputDateFormat
+                          mappings:(NSDictionary *)mapping {
+    return [self initWithModelClass:modelClass
+                            context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                            inputDateFormat:inputDateFormat
+                                                                                   mappings:mapping]];
+}
+
+- (instancetype)initWithModelClass:(Class)modelClass
+              dateConversionOption:(kDateConversionOption)option
+                inputDateFormatter:(NSDateFormatter *)inputDateFormatter
+                          mappings:(NSDictionary *)mapping {
+    return [self initWithModelClass:modelClass
+                            context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                         inputDateFormatter:inputDateFormatter
+                                                                                   mappings:mapping]];
+}
+
+- (instancetype)initWithModelClass:(Class)modelClass context:(SHDecodingContext *)context {
+    NSAssert([modelClass isSubclassOfClass:[SHModelObject class]], @"%@ is not a subclass of SHModelObject", modelClass);
+    if ((self = [super init])) {
+        _modelClass = modelClass;
+        _context = context;
+        _elementBuffer = [NSMutableData data];
+        _batch = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (BOOL)appendData:(NSData *)data {
+    return [self appendBytes:[data bytes] length:[data length]];
+}
+
+- (BOOL)appendBytes:(const uint8_t *)bytes length:(NSUInteger)length {
+    NSUInteger elementStart = 0;
+    NSUInteger i = 0;
+    while (i < length && _state != SHArrayScanStateFailed) {
+        uint8_t c = bytes[i];
+        switch (_state) {
+            case SHArrayScanStateBeforeArray: {
+                // a UTF-8 byte order mark is only allowed as the very first bytes
+                BOOL inByteOrderMark = (_receivedLength + i == _byteOrderMarkLength);
+                if (inByteOrderMark && _byteOrderMarkLength < sizeof(SHUTF8ByteOrderMark) &&
+                    c == SHUTF8ByteOrderMark[_byteOrderMarkLength]) {
+                    _byteOrderMarkLength++;
+                } else if (inByteOrderMark && _byteOrderMarkLength > 0 &&
+                           _byteOrderMarkLength < sizeof(SHUTF8ByteOrderMark)) {
+                    _state = SHArrayScanStateFailed;
+                } else if (c == '[') {
+                    _state = SHArrayScanStateBeforeFirstElement;
+                } else if (!SHIsJSONWhitespace(c)) {
+                    _state = SHArrayScanStateFailed;
+                }
+                i++;
+            } break;
+            case SHArrayScanStateBeforeFirstElement:
+            case SHArrayScanStateBeforeElement: {
+                if (SHIsJSONWhitespace(c)) {
+                    i++;
+                } else if (c == ']') {
+                    // `[]` is fine, `[1,]` is not
+                    _state = (_state == SHArrayScanStateBeforeFirstElement) ? SHArrayScanStateDone : SHArrayScanStateFailed;
+                    i++;
+                } else if (c == ',') {
+                    _state = SHArrayScanStateFailed;
+                } else {
+                    // the element byte itself is scanned in the next iteration
+                    _state = SHArrayScanStateInElement;
+                    _depth = 0;
+                    _inString = NO;
+                    _escaped = NO;
+                    _isScalar = (c != '{' && c != '[' && c != '"');
+                    elementStart = i;
+                }
+            } break;
+            case SHArrayScanStateInElement: {
+                BOOL ended = NO;
+                if (_isScalar) {
+                    if (SHIsJSONWhitespace(c) || c == ',' || c == ']') {
+                        // the delimiter is not part of the element
+                        ended = YES;
+                    } else {
+                        i++;
+                    }
+                } else if (_inString) {
+                    if (_escaped) {
+                        _escaped = NO;
+                    } else if (c == '\\') {
+                        _escaped = YES;
+                    } else if (c == '"') {
+                        _inString = NO;
+                        ended = (_depth == 0);
+                    }
+                    i++;
+                } else {
+                    if (c == '"') {
+                        _inString = YES;
+                    } else if (c == '{' || c == '[') {
+                        _depth++;
+                    } else if (c == '}' || c == ']') {
+                        _depth--;
+                        ended = (_depth == 0);
+                    }
+                    i++;
+                }
+
+                if (ended) {
+                    if (![self decodeElementBytes:bytes + elementStart length:i - elementStart]) {
+                        _state = SHArrayScanStateFailed;
+                    } else {
+                        _state = SHArrayScanStateAfterElement;
+                    }
+                }
+            } break;
+            case SHArrayScanStateAfterElement: {
+                if (c == ',') {
+                    _state = SHArrayScanStateBeforeElement;
+                } else if (c == ']') {
+                    _state = SHArrayScanStateDone;
+                } else if (!SHIsJSONWhitespace(c)) {
+                    _state = SHArrayScanStateFailed;
+                }
+                i++;
+            } break;
+            case SHArrayScanStateDone: {
+                if (!SHIsJSONWhitespace(c)) {
+                    _state = SHArrayScanStateFailed;
+                }
+                i++;
+            } break;
+            case SHArrayScanStateFailed:
+                break;
+        }
+    }
+
+    // keep the beginning of an unfinished element for the next chunk
+    if (_state == SHArrayScanStateInElement) {
+        [_elementBuffer appendBytes:bytes + elementStart length:length - elementStart];
+    }
+    _receivedLength += length;
+    return _state != SHArrayScanStateFailed;
+}
+
+- (BOOL)decodeElementBytes:(const uint8_t *)bytes length:(NSUInteger)length {
+    if ([_elementBuffer length] > 0) {
+        [_elementBuffer appendBytes:bytes length:length];
+        BOOL success = [self decodeElement:_elementBuffer];
+        [_elementBuffer setLength:0];
+        return success;
+    }
+
+    // the whole element is inside the chunk, decode it in place
+    NSData *element = [[NSData alloc] initWithBytesNoCopy:(void *)bytes length:length freeWhenDone:NO];
+    return [self decodeElement:element];
+}
+
+- (BOOL)decodeElement:(NSData *)element {
+    @autoreleasepool {
+        if (((const uint8_t *)[element bytes])[0] != '{') {
+            SHJSONReader reader;
+            SHJSONReaderInit(&reader, [element bytes], [element length]);
+            id item = SHJSONReaderReadValue(&reader);
+            if (nil == item || !SHJSONReaderAtEnd(&reader)) {
+                return NO;
+            }
+            NSLog(@"object %@ is not a NSDictionary object, skipping.", [item description]);
+            return YES;
+        }
+
+        id object = [_modelClass objectWithJSONData:element context:_context];
+        if (nil == object) {
+            return NO;
+        }
+
+        _objectCount++;
+        if (_objectHandler) {
+            _objectHandler(object);
+        }
+        if (_batchHandler) {
+            [_batch addObject:object];
+            if (_batchSize > 0 && [_batch count] >= _batchSize) {
+                [self flushBatch];
+            }
+        }
+    }
+    return YES;
+}
+
+- (void)flushBatch {
+    if ([_batch count] == 0) {
+        return;
+    }
+    NSArray *batch = [_batch copy];
+    [_batch removeAllObjects];
+    _batchHandler(batch);
+}
+
+- (BOOL)finish {
+    if (_batchHandler) {
+        [self flushBatch];
+    }
+    return _state == SHArrayScanStateDone;
+}
+
+- (BOOL)decodeStream:(NSInputStream *)stream {
+    if ([stream streamStatus] == NSStreamStatusNotOpen) {
+        [stream open];
+    }
+
+    uint8_t *buffer = malloc(STREAM_BUFFER_LENGTH);
+    BOOL success = YES;
+    while (success) {
+        NSInteger length = [stream read:buffer maxLength:STREAM_BUFFER_LENGTH];
+        if (length <= 0) {
+            // 0 is the end of the stream, a negative length an error
+            success = (length == 0);
+            break;
+        }
+        success = [self appendBytes:buffer length:(NSUInteger)length];
+    }
+    free(buffer);
+    [stream close];
+
+    return [self finish] && success;
+}
+
+@end
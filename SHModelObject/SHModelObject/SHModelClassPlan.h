@@ -0,0 +1,359 @@
+// SHModelClassPlan.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import <objc/runtime.h>
+#import "SHConstants.h"
+#import "SHModelSerialization.h"
+
+@class SHNormalizedKey;
+@class SHModelIvarDescriptor;
+
+/**
+ *  type of an instance variable, parsed once from its objective-c type encoding.
+ */
+typedef NS_ENUM(NSInteger, SHIvarType) {
+    SHIvarTypeUnknown = 0,
+    SHIvarTypeObject,
+    SHIvarTypeChar,
+    SHIvarTypeUnsignedChar,
+    SHIvarTypeBool,
+    SHIvarTypeShort,
+    SHIvarTypeUnsignedShort,
+    SHIvarTypeInt,
+    SHIvarTypeUnsignedInt,
+    SHIvarTypeLong,
+    SHIvarTypeUnsignedLong,
+    SHIvarTypeLongLong,
+    SHIvarTypeUnsignedLongLong,
+    SHIvarTypeFloat,
+    SHIvarTypeDouble,
+};
+
+/**
+ *  kind of a decoded value, the converters of an ivar are chosen per kind.
+ */
+typedef NS_ENUM(NSInteger, SHValueKind) {
+    SHValueKindOther = 0,
+    SHValueKindString,
+    SHValueKindNumber,
+    SHValueKindDictionary,
+    SHValueKindArray,
+    SHValueKindCount,
+};
+
+/**
+ *  converts a decoded value to the value stored in an ivar.
+ *
+ *  @param object the model object
+ *  @param descriptor descriptor of the ivar
+ *  @param value the decoded value
+ *  @param key the dictionary key of the value, nil when decoding JSON data
+ *
+ *  @return the value to store, nil to store nothing
+ */
+typedef id (*SHValueConverter)(id object, SHModelIvarDescriptor *descriptor, id value, id key);
+
+/**
+ *  adopted by root classes that convert values through the converters of their plan. the plan asks for the
+ *  converter of every ivar and value kind once, when it is built.
+ */
+@protocol SHModelValueConverting <NSObject>
+
+/**
+ *  the converter for values of `kind` stored in the ivar
+ *
+ *  @param descriptor descriptor of the ivar, complete with its schema
+ *  @param kind kind of the decoded value
+ *
+ *  @return the converter, NULL to store values of `kind` as they are
+ */
++ (SHValueConverter)valueConverterForIvar:(SHModelIvarDescriptor *)descriptor kind:(SHValueKind)kind;
+
+@end
+
+/**
+ *  The `SHModelIvarDescriptor` describes a single instance variable of a model class. descriptors are created once
+ *  per class by `SHModelClassPlan` and are immutable afterwards.
+ */
+@interface SHModelIvarDescriptor : NSObject
+
+// the runtime ivar
+@property (nonatomic, readonly) Ivar ivar;
+
+// name of the ivar as declared, e.g. `_stringValue`
+@property (nonatomic, readonly) NSString *name;
+
+// class declaring the ivar, the model class itself or one of its superclasses
+@property (nonatomic, readonly) Class declaringClass;
+
+// name of the ivar without `-`, `_` and ` ` and lowercased, e.g. `stringvalue`
+@property (nonatomic, readonly) NSString *normalizedName;
+
+// interned normalized name, nil if the ivar name is not a valid key
+@property (nonatomic, readonly) SHNormalizedKey *normalizedKey;
+
+// offset of the ivar inside the instance
+@property (nonatomic, readonly) ptrdiff_t offset;
+
+// raw objective-c type encoding, e.g. `@"NSString"` or `i`
+@property (nonatomic, readonly) NSString *typeEncoding;
+
+// parsed type of the ivar
+@property (nonatomic, readonly) SHIvarType type;
+
+// class name for object ivars, e.g. `NSString`. nil for `id` and primitive ivars
+@property (nonatomic, readonly) NSString *className;
+
+// resolved class for object ivars, or the `SHModelSchemaClassKey` of the schema. nil for `id`, primitive ivars or
+// classes not linked in.
+@property (nonatomic, readonly) Class objectClass;
+
+// `YES` if `objectClass` is a subclass of the root class of the plan (e.g. a nested `SHModelObject`)
+@property (nonatomic, readonly) BOOL isModelClass;
+
+// class of the elements of an array ivar, from `SHModelSchemaElementClassKey`. Nil if the schema declares none.
+@property (nonatomic, readonly) Class elementClass;
+
+// format of date strings for the ivar from `SHModelSchemaDateFormatKey`, 0 if the schema declares none
+@property (nonatomic, readonly) kInputDateFormat inputDateFormat;
+
+// the custom date format string when `inputDateFormat` is `kInputDateFormatCustom`
+@property (nonatomic, readonly) NSString *dateFormat;
+
+// transformer from `SHModelSchemaTransformerKey`, or the one registered for `objectClass` with
+// `SHModelSetValueTransformerForClass`. nil if there is none.
+@property (nonatomic, readonly) NSValueTransformer *valueTransformer;
+
+// `YES` if the schema declares the ivar with `SHModelSchemaInternedKey`
+@property (nonatomic, readonly) BOOL interned;
+
+// position of the ivar in `SHModelClassPlan.ivars`
+@property (nonatomic, readonly) NSUInteger index;
+
+// `YES` if the model class declares a KVC setter for the ivar name itself (`set_name:` or `_set_name:`) or does not
+// allow direct ivar access. values for such ivars are always set through `setValue:forKey:`. a setter of the
+// property backed by the ivar (`setName:` for `_name`) is sent directly instead, see `SHModelSetIvarValue`.
+@property (nonatomic, readonly) BOOL usesKeyValueCoding;
+
+@end
+
+/**
+ *  sets the value of an ivar. `NSNumber` values for primitive ivars are unboxed once with the accessor matching the
+ *  ivar type and written straight to the ivar offset, objects are stored with the ivar's ARC ownership (strong or
+ *  weak). when the class declares the setter of the property backed by the ivar (`setName:` for `_name`), the setter
+ *  is sent with the unboxed value instead. the value goes through `setValue:forKey:` when the class declares a KVC
+ *  setter for the ivar name, when the object is observed through KVO or when no direct store exists for the
+ *  combination of value and type.
+ *
+ *  @param object the model object
+ *  @param descriptor descriptor of the ivar from the object's plan
+ *  @param value value to store, must not be nil
+ */
+void SHModelSetIvarValue(id object, SHModelIvarDescriptor *descriptor, id value);
+
+/**
+ *  stores an integer straight into a primitive ivar, converted like a C cast (the same result as unboxing an
+ *  `NSNumber` holding the integer). used by decoders that parse numbers without boxing them.
+ *
+ *  @param object the model object
+ *  @param descriptor descriptor of the ivar from the object's plan
+ *  @param value the integer
+ *
+ *  @return `NO` if the ivar is not primitive or must be set through its setter or `setValue:forKey:`, the caller has
+ *  to box the value and use `SHModelSetIvarValue` then
+ */
+BOOL SHModelSetIvarLongLong(id object, SHModelIvarDescriptor *descriptor, long long value);
+
+// like `SHModelSetIvarLongLong`, for `float` and `double` ivars only
+BOOL SHModelSetIvarDouble(id object, SHModelIvarDescriptor *descriptor, double value);
+
+/**
+ *  checks if an ivar already holds a value, before storing it. `NSNumber` values for primitive ivars are unboxed
+ *  like `SHModelSetIvarValue` does and compared to the ivar without boxing it, objects are compared with `isEqual:`.
+ *
+ *  @param object the model object
+ *  @param descriptor descriptor of the ivar from the object's plan
+ *  @param value the value that would be stored
+ *
+ *  @return `YES` if storing the value would not change the ivar. always `NO` for ivars set through
+ *  `setValue:forKey:`, their setter may store something else than the value. ivars with a property setter are
+ *  compared as stored.
+ */
+BOOL SHModelIvarHasValue(id object, SHModelIvarDescriptor *descriptor, id value);
+
+/**
+ *  resets an ivar to nil or zero, written straight to the ivar without custom setters or KVO notifications. used
+ *  to recycle objects, see `-[SHModelObject prepareForReuse]`. ivars of types the plan does not parse (structs,
+ *  pointers) are zeroed with the size of their type encoding.
+ *
+ *  @param object the model object
+ *  @param descriptor descriptor of the ivar from the object's plan
+ */
+void SHModelClearIvar(id object, SHModelIvarDescriptor *descriptor);
+
+/**
+ *  stores an object in an object ivar with the ARC ownership of the ivar, written straight to the ivar without custom
+ *  setters or KVO notifications. used to copy objects, see `-[SHModelObject copyWithZone:]`.
+ *
+ *  @param object the model object
+ *  @param descriptor descriptor of an object ivar from the object's plan
+ *  @param value value to store, nil to clear the ivar
+ */
+void SHModelStoreIvarObject(id object, SHModelIvarDescriptor *descriptor, id value);
+
+/**
+ *  converts a decoded value with the converter the root class chose for the ivar and the kind of the value, see
+ *  `SHModelValueConverting`.
+ *
+ *  @param object the model object
+ *  @param descriptor descriptor of the ivar from the object's plan
+ *  @param value the decoded value
+ *  @param key the dictionary key of the value
+ *
+ *  @return the value to store
+ */
+id SHModelConvertValue(id object, SHModelIvarDescriptor *descriptor, id value, id key);
+
+/**
+ *  registers a transformer for all ivars of a class (and its subclasses) that have no transformer in their schema,
+ *  e.g. to decode `NSURL` ivars from strings. the registry is read when the plan of a model class is built, register
+ *  transformers before decoding.
+ *
+ *  @param transformer the transformer, nil to remove it
+ *  @param cls class of the ivars
+ */
+void SHModelSetValueTransformerForClass(NSValueTransformer *transformer, Class cls);
+
+// value of a primitive ivar as an `NSNumber` (`bool` ivars as a boolean number), nil for object ivars
+NSNumber *SHModelIvarNumber(id object, SHModelIvarDescriptor *descriptor);
+
+/**
+ *  The `SHModelClassPlan` is the cached decoding plan for a model class. it holds a descriptor for every instance
+ *  variable of the class and its superclasses (up to, but not including, the root class) and maps the normalized
+ *  dictionary keys to those descriptors so that finding the ivar for a key is a single hash lookup.
+ *
+ *  the `+modelSchema` of the class (see `SHModelSerialization`) is applied while the plan is built: schema keys are
+ *  added to the key map and the class, element class and date format of the fields are stored in their descriptors.
+ *
+ *  plans are built once per class and shared. all methods are thread-safe.
+ */
+@interface SHModelClassPlan : NSObject
+
+/**
+ *  returns the cached plan for the class, building it on first use.
+ *
+ *  @param cls the model class
+ *  @param rootClass the base class (`SHModelObject` or `SHRealmObject`). its ivars and the ivars of its superclasses
+ *  are not part of the plan.
+ *
+ *  @return the plan for `cls`
+ */
++ (instancetype)planForClass:(Class)cls rootClass:(Class)rootClass;
+
+// the plan for the class if it was built already, nil otherwise
++ (instancetype)cachedPlanForClass:(Class)cls;
+
+// the class this plan was built for
+@property (nonatomic, readonly) Class modelClass;
+
+// the root class passed when building the plan
+@property (nonatomic, readonly) Class rootClass;
+
+// array of `SHModelIvarDescriptor`, superclass ivars first
+@property (nonatomic, readonly) NSArray *ivars;
+
+// array of ivar names in the same order as `ivars`
+@property (nonatomic, readonly) NSArray *ivarNames;
+
+// the ivar named by `+primaryKey` of the class, nil if the class has none
+@property (nonatomic, readonly) SHModelIvarDescriptor *primaryKeyIvar;
+
+// descriptors of the object ivars, in the same order as `ivars`
+@property (nonatomic, readonly) NSArray *objectIvars;
+
+/**
+ *  compares the primitive ivars of two instances of the class. integers, characters and pointers that follow each
+ *  other without padding are compared as one block of raw memory, `float` and `double` values are compared by value
+ *  (`0.0` equals `-0.0`, a NaN equals nothing). structs and arrays are compared field by field without their
+ *  padding, unions and structs with bit fields as raw memory. bit field ivars are left out. the layout is found once
+ *  when the plan is built.
+ *
+ *  @param object an instance of the class
+ *  @param other another instance of the class
+ *
+ *  @return `YES` if all primitive ivars hold equal values
+ */
+- (BOOL)primitiveIvarsOfObject:(id)object equalToObject:(id)other;
+
+// hash of the primitive ivars, equal for objects with equal primitive ivars
+- (NSUInteger)primitiveIvarsHashOfObject:(id)object;
+
+// copies the primitive ivars as raw memory, without custom setters or KVO notifications
+- (void)copyPrimitiveIvarsFromObject:(id)source toObject:(id)object;
+
+/**
+ *  finds the value of the primary key ivar in a dictionary. the `+primaryKey` is looked up first, then the keys of
+ *  the dictionary are matched like `ivarForKey:`.
+ *
+ *  @param dictionary dictionary the object is decoded from
+ *
+ *  @return the value, nil if the class has no primary key or the dictionary holds no string or number for it
+ */
+- (id)primaryKeyValueInDictionary:(NSDictionary *)dictionary;
+
+/**
+ *  keys the ivars are exported with, see `SHOutputKeyForIvarName`. built once with the plan.
+ *
+ *  @param style the key style
+ *
+ *  @return array of keys in the same order as `ivars`
+ */
+- (NSArray *)outputKeysWithStyle:(kOutputKeyStyle)style;
+
+/**
+ *  finds the ivar that matches the dictionary key. the key is matched ignoring `-`, `_`, ` ` and the case. if more
+ *  than one ivar matches the same key, the ivar declared in the most derived class wins.
+ *
+ *  keys are normalized through the `SHNormalizedKey` interning table, so a key seen before, known or unknown, costs
+ *  one lookup in that table and one probe in the plan.
+ *
+ *  @param key dictionary key
+ *
+ *  @return descriptor of the matching ivar or nil
+ */
+- (SHModelIvarDescriptor *)ivarForKey:(id)key;
+
+/**
+ *  finds the ivar for an already normalized key, see `SHNormalizeASCIICharacters`. this does not allocate.
+ *
+ *  @param characters normalized characters
+ *  @param length number of normalized characters
+ *  @param hash hash of the normalized characters
+ *
+ *  @return descriptor of the matching ivar or nil
+ */
+- (SHModelIvarDescriptor *)ivarForNormalizedCharacters:(const unichar *)characters
+                                                length:(NSUInteger)length
+                                                  hash:(NSUInteger)hash;
+
+@end
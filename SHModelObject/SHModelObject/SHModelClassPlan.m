@@ -0,0 +1,1135 @@
+// SHModelClassPlan.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHModelClassPlan.h"
+#import "SHKeyNormalizer.h"
+#import <objc/message.h>
+#import <pthread.h>
+
+NSString *const SHModelSchemaKeysKey = @"keys";
+NSString *const SHModelSchemaClassKey = @"class";
+NSString *const SHModelSchemaElementClassKey = @"elementClass";
+NSString *const SHModelSchemaDateFormatKey = @"dateFormat";
+NSString *const SHModelSchemaInternedKey = @"interned";
+NSString *const SHModelSchemaTransformerKey = @"transformer";
+
+// class to `NSValueTransformer`, see `SHModelSetValueTransformerForClass`
+static NSMapTable *_transformers;
+static pthread_rwlock_t _transformersLock = PTHREAD_RWLOCK_INITIALIZER;
+
+void SHModelSetValueTransformerForClass(NSValueTransformer *transformer, Class cls) {
+    pthread_rwlock_wrlock(&_transformersLock);
+    if (nil == _transformers) {
+        _transformers = [[NSMapTable alloc]
+            initWithKeyOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)
+                  valueOptions:NSPointerFunctionsStrongMemory
+                      capacity:8];
+    }
+    if (transformer) {
+        [_transformers setObject:transformer forKey:cls];
+    } else {
+        [_transformers removeObjectForKey:cls];
+    }
+    pthread_rwlock_unlock(&_transformersLock);
+}
+
+// the transformer registered for the class or its closest superclass
+static NSValueTransformer *SHValueTransformerForClass(Class cls) {
+    NSValueTransformer *transformer = nil;
+    pthread_rwlock_rdlock(&_transformersLock);
+    for (Class current = cls; current != Nil && nil == transformer; current = class_getSuperclass(current)) {
+        transformer = [_transformers objectForKey:current];
+    }
+    pthread_rwlock_unlock(&_transformersLock);
+    return transformer;
+}
+
+// writes an unboxed NSNumber to the ivar at `offset`
+typedef void (*SHIvarStore)(id object, ptrdiff_t offset, NSNumber *value);
+
+#define SH_DEFINE_STORE(name, type, accessor)                                                                         \
+    static void name(id object, ptrdiff_t offset, NSNumber *value) {                                                \
+        *(type *)((uint8_t *)(__bridge void *)object + offset) = [value accessor];                                    \
+    }
+
+// the same accessors KVC uses to unbox a value for each type
+SH_DEFINE_STORE(SHStoreChar, char, charValue)
+SH_DEFINE_STORE(SHStoreUnsignedChar, unsigned char, unsignedCharValue)
+SH_DEFINE_STORE(SHStoreBool, bool, boolValue)
+SH_DEFINE_STORE(SHStoreShort, short, shortValue)
+SH_DEFINE_STORE(SHStoreUnsignedShort, unsigned short, unsignedShortValue)
+SH_DEFINE_STORE(SHStoreInt, int, intValue)
+SH_DEFINE_STORE(SHStoreUnsignedInt, unsigned int, unsignedIntValue)
+SH_DEFINE_STORE(SHStoreLong, long, longValue)
+SH_DEFINE_STORE(SHStoreUnsignedLong, unsigned long, unsignedLongValue)
+SH_DEFINE_STORE(SHStoreLongLong, long long, longLongValue)
+SH_DEFINE_STORE(SHStoreUnsignedLongLong, unsigned long long, unsignedLongLongValue)
+SH_DEFINE_STORE(SHStoreFloat, float, floatValue)
+SH_DEFINE_STORE(SHStoreDouble, double, doubleValue)
+
+static SHIvarStore SHIvarStoreForType(SHIvarType type) {
+    switch (type) {
+        case SHIvarTypeChar: return SHStoreChar;
+        case SHIvarTypeUnsignedChar: return SHStoreUnsignedChar;
+        case SHIvarTypeBool: return SHStoreBool;
+        case SHIvarTypeShort: return SHStoreShort;
+        case SHIvarTypeUnsignedShort: return SHStoreUnsignedShort;
+        case SHIvarTypeInt: return SHStoreInt;
+        case SHIvarTypeUnsignedInt: return SHStoreUnsignedInt;
+        case SHIvarTypeLong: return SHStoreLong;
+        case SHIvarTypeUnsignedLong: return SHStoreUnsignedLong;
+        case SHIvarTypeLongLong: return SHStoreLongLong;
+        case SHIvarTypeUnsignedLongLong: return SHStoreUnsignedLongLong;
+        case SHIvarTypeFloat: return SHStoreFloat;
+        case SHIvarTypeDouble: return SHStoreDouble;
+        default: return NULL;
+    }
+}
+
+// compares the ivar at `offset` with an NSNumber unboxed like the matching store does
+typedef BOOL (*SHIvarCompare)(id object, ptrdiff_t offset, NSNumber *value);
+
+#define SH_DEFINE_COMPARE(name, type, accessor)                                                                       \
+    static BOOL name(id object, ptrdiff_t offset, NSNumber *value) {                                                \
+        return *(type *)((uint8_t *)(__bridge void *)object + offset) == [value accessor];                            \
+    }
+
+SH_DEFINE_COMPARE(SHCompareChar, char, charValue)
+SH_DEFINE_COMPARE(SHCompareUnsignedChar, unsigned char, unsignedCharValue)
+SH_DEFINE_COMPARE(SHCompareBool, bool, boolValue)
+SH_DEFINE_COMPARE(SHCompareShort, short, shortValue)
+SH_DEFINE_COMPARE(SHCompareUnsignedShort, unsigned short, unsignedShortValue)
+SH_DEFINE_COMPARE(SHCompareInt, int, intValue)
+SH_DEFINE_COMPARE(SHCompareUnsignedInt, unsigned int, unsignedIntValue)
+SH_DEFINE_COMPARE(SHCompareLong, long, longValue)
+SH_DEFINE_COMPARE(SHCompareUnsignedLong, unsigned long, unsignedLongValue)
+SH_DEFINE_COMPARE(SHCompareLongLong, long long, longLongValue)
+SH_DEFINE_COMPARE(SHCompareUnsignedLongLong, unsigned long long, unsignedLongLongValue)
+SH_DEFINE_COMPARE(SHCompareFloat, float, floatValue)
+SH_DEFINE_COMPARE(SHCompareDouble, double, doubleValue)
+
+static SHIvarCompare SHIvarCompareForType(SHIvarType type) {
+    switch (type) {
+        case SHIvarTypeChar: return SHCompareChar;
+        case SHIvarTypeUnsignedChar: return SHCompareUnsignedChar;
+        case SHIvarTypeBool: return SHCompareBool;
+        case SHIvarTypeShort: return SHCompareShort;
+        case SHIvarTypeUnsignedShort: return SHCompareUnsignedShort;
+        case SHIvarTypeInt: return SHCompareInt;
+        case SHIvarTypeUnsignedInt: return SHCompareUnsignedInt;
+        case SHIvarTypeLong: return SHCompareLong;
+        case SHIvarTypeUnsignedLong: return SHCompareUnsignedLong;
+        case SHIvarTypeLongLong: return SHCompareLongLong;
+        case SHIvarTypeUnsignedLongLong: return SHCompareUnsignedLongLong;
+        case SHIvarTypeFloat: return SHCompareFloat;
+        case SHIvarTypeDouble: return SHCompareDouble;
+        default: return NULL;
+    }
+}
+
+// sends a property setter with an NSNumber unboxed like the matching store does
+typedef void (*SHIvarSend)(id object, SEL setter, NSNumber *value);
+
+#define SH_DEFINE_SEND(name, type, accessor)                                                                          \
+    static void name(id object, SEL setter, NSNumber *value) {                                                      \
+        ((void (*)(id, SEL, type))objc_msgSend)(object, setter, [value accessor]);                                    \
+    }
+
+SH_DEFINE_SEND(SHSendChar, char, charValue)
+SH_DEFINE_SEND(SHSendUnsignedChar, unsigned char, unsignedCharValue)
+SH_DEFINE_SEND(SHSendBool, bool, boolValue)
+SH_DEFINE_SEND(SHSendShort, short, shortValue)
+SH_DEFINE_SEND(SHSendUnsignedShort, unsigned short, unsignedShortValue)
+SH_DEFINE_SEND(SHSendInt, int, intValue)
+SH_DEFINE_SEND(SHSendUnsignedInt, unsigned int, unsignedIntValue)
+SH_DEFINE_SEND(SHSendLong, long, longValue)
+SH_DEFINE_SEND(SHSendUnsignedLong, unsigned long, unsignedLongValue)
+SH_DEFINE_SEND(SHSendLongLong, long long, longLongValue)
+SH_DEFINE_SEND(SHSendUnsignedLongLong, unsigned long long, unsignedLongLongValue)
+SH_DEFINE_SEND(SHSendFloat, float, floatValue)
+SH_DEFINE_SEND(SHSendDouble, double, doubleValue)
+
+static SHIvarSend SHIvarSendForType(SHIvarType type) {
+    switch (type) {
+        case SHIvarTypeChar: return SHSendChar;
+        case SHIvarTypeUnsignedChar: return SHSendUnsignedChar;
+        case SHIvarTypeBool: return SHSendBool;
+        case SHIvarTypeShort: return SHSendShort;
+        case SHIvarTypeUnsignedShort: return SHSendUnsignedShort;
+        case SHIvarTypeInt: return SHSendInt;
+        case SHIvarTypeUnsignedInt: return SHSendUnsignedInt;
+        case SHIvarTypeLong: return SHSendLong;
+        case SHIvarTypeUnsignedLong: return SHSendUnsignedLong;
+        case SHIvarTypeLongLong: return SHSendLongLong;
+        case SHIvarTypeUnsignedLongLong: return SHSendUnsignedLongLong;
+        case SHIvarTypeFloat: return SHSendFloat;
+        case SHIvarTypeDouble: return SHSendDouble;
+        default: return NULL;
+    }
+}
+
+// stores an object with the ARC ownership of the ivar (strong or weak).
+static inline BOOL SHStoreObject(id object, Ivar ivar, id value) {
+#ifdef __APPLE__
+    // before iOS 10 / OS X 10.12 object_setIvar always assigns unretained, use KVC there.
+    if (NULL == &object_setIvarWithStrongDefault) {
+        return NO;
+    }
+    object_setIvarWithStrongDefault(object, ivar, value);
+#else
+    // the GNUstep runtime honors the ownership of ARC ivars in object_setIvar
+    object_setIvar(object, ivar, value);
+#endif
+    return YES;
+}
+
+// `stringValue` -> `setStringValue:`, like KVC builds setter names
+static SEL SHSetterForKey(NSString *key, NSString *prefix) {
+    NSString *capitalized =
+        [[[key substringToIndex:1] uppercaseString] stringByAppendingString:[key substringFromIndex:1]];
+    return NSSelectorFromString([NSString stringWithFormat:@"%@%@:", prefix, capitalized]);
+}
+
+// the name of the property backed by the ivar: `_stringValue` -> `stringValue`, `time1` -> `time1`
+static NSString *SHPropertyNameForIvarName(NSString *ivarName) {
+    return ([ivarName hasPrefix:@"_"] && ivarName.length > 1) ? [ivarName substringFromIndex:1] : ivarName;
+}
+
+// `set<Name>:` of the property backed by the ivar when the class declares it with an argument of the ivar's type,
+// NULL otherwise
+static SEL SHPropertySetterForIvar(Class cls, NSString *ivarName, const char *encoding) {
+    SEL setter = SHSetterForKey(SHPropertyNameForIvarName(ivarName), @"set");
+    Method method = class_getInstanceMethod(cls, setter);
+    if (NULL == method || method_getNumberOfArguments(method) != 3) {
+        return NULL;
+    }
+    char argumentType[8] = {0};
+    method_getArgumentType(method, 2, argumentType, sizeof(argumentType));
+    return argumentType[0] == encoding[0] ? setter : NULL;
+}
+
+// `set_stringValue:` or `_set_stringValue:`, the setters KVC looks up for the ivar name itself
+static BOOL SHClassDeclaresIvarSetter(Class cls, NSString *ivarName) {
+    return [cls instancesRespondToSelector:SHSetterForKey(ivarName, @"set")] ||
+           [cls instancesRespondToSelector:SHSetterForKey(ivarName, @"_set")];
+}
+
+typedef struct {
+    NSUInteger hash;
+    NSUInteger length;
+    const unichar *characters;
+    __unsafe_unretained SHNormalizedKey *key;
+    __unsafe_unretained SHModelIvarDescriptor *descriptor;
+} SHPlanTableEntry;
+
+// primitive ivars that follow each other without padding, copied as one block of memory
+typedef struct {
+    ptrdiff_t offset;
+    size_t length;
+} SHIvarSpan;
+
+// how a part of the primitive ivars is compared and hashed
+typedef NS_ENUM(uint8_t, SHIvarFieldKind) {
+    // integers, characters, `BOOL`s and pointers that follow each other without padding, compared as raw memory
+    SHIvarFieldBytes,
+    // floating point values are compared by value, `0.0` equals `-0.0` and a NaN equals nothing
+    SHIvarFieldFloat,
+    SHIvarFieldDouble,
+    SHIvarFieldLongDouble,
+};
+
+typedef struct {
+    ptrdiff_t offset;
+    size_t length;
+    SHIvarFieldKind kind;
+} SHIvarField;
+
+static inline void SHAppendField(NSMutableData *fields, ptrdiff_t offset, size_t length, SHIvarFieldKind kind) {
+    if (fields && length > 0) {
+        SHIvarField field = {offset, length, kind};
+        [fields appendBytes:&field length:sizeof(field)];
+    }
+}
+
+static inline size_t SHAlignedOffset(size_t offset, size_t alignment) {
+    return alignment > 1 ? (offset + alignment - 1) / alignment * alignment : offset;
+}
+
+// skips the quoted name ivar encodings give struct fields and objects (`"x"d`, `@"NSString"`) and type qualifiers
+static const char *SHSkipTypePrefix(const char *type) {
+    if (*type == '"') {
+        const char *end = strchr(type + 1, '"');
+        type = end ? end + 1 : type + strlen(type);
+    }
+    while (*type && strchr("rnNoORVA", *type)) {
+        type++;
+    }
+    return type;
+}
+
+// the end of the type encoding at `type`, with its nested types
+static const char *SHSkipType(const char *type) {
+    type = SHSkipTypePrefix(type);
+    switch (*type) {
+        case '\0': return type;
+        case '^': return SHSkipType(type + 1);
+        case '@':
+            type++;
+            return (*type == '?') ? type + 1 : SHSkipTypePrefix(type);
+        case 'b':
+            type++;
+            while (*type >= '0' && *type <= '9') {
+                type++;
+            }
+            return type;
+        case '[':
+        case '{':
+        case '(': {
+            char open = *type;
+            char close = (open == '[') ? ']' : (open == '{') ? '}' : ')';
+            NSUInteger depth = 0;
+            do {
+                if (*type == '"') {
+                    type = SHSkipTypePrefix(type);
+                    continue;
+                }
+                if (*type == open) {
+                    depth++;
+                } else if (*type == close) {
+                    depth--;
+                }
+                type++;
+            } while (*type && depth > 0);
+            return type;
+        }
+        default: return type + 1;
+    }
+}
+
+/**
+ *  walks the type encoding at `*type`, finds its size and alignment and appends the parts of a value of the type at
+ *  `offset` that are compared, leaving out the padding of structs. `fields` can be nil to only measure the type.
+ *  `*type` is moved past the type.
+ *
+ *  @return `NO` for types whose layout cannot be followed (bit fields, opaque structs), the caller compares the
+ *  whole value as raw memory then
+ */
+static BOOL SHWalkType(const char **type, ptrdiff_t offset, NSMutableData *fields, size_t *size, size_t *alignment) {
+    const char *cursor = SHSkipTypePrefix(*type);
+    SHIvarFieldKind kind = SHIvarFieldBytes;
+    size_t length = 0;
+    size_t align = 0;
+    switch (*cursor++) {
+        case 'c': case 'C': case 'B': length = align = 1; break;
+        case 's': case 'S': length = align = sizeof(short); break;
+        case 'i': case 'I': length = align = sizeof(int); break;
+        case 'l': case 'L': length = align = sizeof(long); break;
+        case 'q': case 'Q': length = align = sizeof(long long); break;
+        case 'f': length = align = sizeof(float); kind = SHIvarFieldFloat; break;
+        case 'd': length = align = sizeof(double); kind = SHIvarFieldDouble; break;
+        case 'D':
+            // only the bytes of the value, not the padding after it
+            length = sizeof(long double);
+            align = __alignof__(long double);
+            kind = SHIvarFieldLongDouble;
+            break;
+        case '*': case '#': case ':': length = align = sizeof(void *); break;
+        case '@':
+            length = align = sizeof(id);
+            if (*cursor == '?') {
+                cursor++;
+            } else if (*cursor == '"') {
+                cursor = SHSkipTypePrefix(cursor);
+            }
+            break;
+        case '^':
+            // pointers are compared by address, the pointee is skipped
+            cursor = SHSkipType(cursor);
+            length = align = sizeof(void *);
+            break;
+        case '[': {
+            char *end = NULL;
+            unsigned long count = strtoul(cursor, &end, 10);
+            cursor = end;
+            const char *elementType = cursor;
+            size_t elementSize = 0;
+            size_t elementAlignment = 0;
+            if (!SHWalkType(&cursor, 0, nil, &elementSize, &elementAlignment) || *cursor != ']') {
+                return NO;
+            }
+            cursor++;
+            for (unsigned long i = 0; i < count && fields; i++) {
+                const char *element = elementType;
+                SHWalkType(&element, offset + (ptrdiff_t)(i * elementSize), fields, &elementSize, &elementAlignment);
+            }
+            *type = cursor;
+            *size = count * elementSize;
+            *alignment = elementAlignment;
+            return YES;
+        }
+        case '{': {
+            const char *equals = cursor;
+            while (*equals && *equals != '=' && *equals != '}') {
+                equals++;
+            }
+            if (*equals != '=') {
+                return NO;
+            }
+            cursor = equals + 1;
+            size_t structSize = 0;
+            size_t structAlignment = 1;
+            while (*cursor && *cursor != '}') {
+                cursor = SHSkipTypePrefix(cursor);
+                if (*cursor == 'b') {
+                    return NO;
+                }
+                // measured first, the offset of a field depends on its alignment
+                const char *fieldType = cursor;
+                size_t fieldSize = 0;
+                size_t fieldAlignment = 0;
+                if (!SHWalkType(&cursor, 0, nil, &fieldSize, &fieldAlignment)) {
+                    return NO;
+                }
+                structSize = SHAlignedOffset(structSize, fieldAlignment);
+                if (fields) {
+                    SHWalkType(&fieldType, offset + (ptrdiff_t)structSize, fields, &fieldSize, &fieldAlignment);
+                }
+                structSize += fieldSize;
+                structAlignment = MAX(structAlignment, fieldAlignment);
+            }
+            if (*cursor != '}') {
+                return NO;
+            }
+            *type = cursor + 1;
+            *size = SHAlignedOffset(structSize, structAlignment);
+            *alignment = structAlignment;
+            return YES;
+        }
+        case '(': {
+            // which member of a union is set is not known, the union is compared as raw memory
+            const char *equals = cursor;
+            while (*equals && *equals != '=' && *equals != ')') {
+                equals++;
+            }
+            if (*equals != '=') {
+                return NO;
+            }
+            cursor = equals + 1;
+            size_t unionSize = 0;
+            size_t unionAlignment = 1;
+            while (*cursor && *cursor != ')') {
+                size_t memberSize = 0;
+                size_t memberAlignment = 0;
+                if (!SHWalkType(&cursor, 0, nil, &memberSize, &memberAlignment)) {
+                    return NO;
+                }
+                unionSize = MAX(unionSize, memberSize);
+                unionAlignment = MAX(unionAlignment, memberAlignment);
+            }
+            if (*cursor != ')') {
+                return NO;
+            }
+            *type = cursor + 1;
+            *size = SHAlignedOffset(unionSize, unionAlignment);
+            *alignment = unionAlignment;
+            SHAppendField(fields, offset, *size, SHIvarFieldBytes);
+            return YES;
+        }
+        default: return NO;
+    }
+    *type = cursor;
+    *size = (kind == SHIvarFieldLongDouble) ? SHAlignedOffset(length, align) : length;
+    *alignment = align;
+    SHAppendField(fields, offset, length, kind);
+    return YES;
+}
+
+static SHIvarType SHIvarTypeFromEncoding(const char *encoding) {
+    switch (encoding[0]) {
+        case '@': return SHIvarTypeObject;
+        case 'c': return SHIvarTypeChar;
+        case 'C': return SHIvarTypeUnsignedChar;
+        case 'B': return SHIvarTypeBool;
+        case 's': return SHIvarTypeShort;
+        case 'S': return SHIvarTypeUnsignedShort;
+        case 'i': return SHIvarTypeInt;
+        case 'I': return SHIvarTypeUnsignedInt;
+        case 'l': return SHIvarTypeLong;
+        case 'L': return SHIvarTypeUnsignedLong;
+        case 'q': return SHIvarTypeLongLong;
+        case 'Q': return SHIvarTypeUnsignedLongLong;
+        case 'f': return SHIvarTypeFloat;
+        case 'd': return SHIvarTypeDouble;
+        default: return SHIvarTypeUnknown;
+    }
+}
+
+// `@"NSString"` -> `NSString`, `@"RLMArray<Car>"` -> `RLMArray`, `@` and `@"<Protocol>"` -> nil
+static NSString *SHClassNameFromEncoding(const char *encoding) {
+    if (encoding[0] != '@' || encoding[1] != '"') {
+        return nil;
+    }
+    const char *start = encoding + 2;
+    size_t length = strcspn(start, "\"<");
+    if (length == 0) {
+        return nil;
+    }
+    return [[NSString alloc] initWithBytes:start length:length encoding:NSUTF8StringEncoding];
+}
+
+#pragma mark - SHModelIvarDescriptor
+
+@implementation SHModelIvarDescriptor {
+    SHIvarStore _store;
+    SHIvarCompare _compare;
+    // converters chosen by the root class, indexed by `SHValueKind`
+    SHValueConverter _converters[SHValueKindCount];
+    // `set<Name>:` of the property backed by the ivar, sent instead of storing to the ivar
+    SEL _setter;
+    SHIvarSend _send;
+    // key for `setValue:forKey:`, the property name when the class declares its setter
+    NSString *_keyValueCodingKey;
+}
+
+- (instancetype)initWithIvar:(Ivar)ivar
+                  modelClass:(Class)modelClass
+              declaringClass:(Class)declaringClass
+                   rootClass:(Class)rootClass
+                       index:(NSUInteger)index {
+    if ((self = [super init])) {
+        const char *encoding = ivar_getTypeEncoding(ivar) ?: "";
+
+        _ivar = ivar;
+        _declaringClass = declaringClass;
+        _name = [NSString stringWithCString:ivar_getName(ivar) encoding:NSUTF8StringEncoding];
+        _normalizedKey = [SHNormalizedKey normalizedKeyForString:_name];
+        _normalizedName = _normalizedKey.string;
+        _offset = ivar_getOffset(ivar);
+        _typeEncoding = [NSString stringWithCString:encoding encoding:NSUTF8StringEncoding];
+        _type = SHIvarTypeFromEncoding(encoding);
+        _className = SHClassNameFromEncoding(encoding);
+        _objectClass = _className ? NSClassFromString(_className) : nil;
+        _isModelClass = (_objectClass != nil && [_objectClass isSubclassOfClass:rootClass]);
+        _index = index;
+        _store = SHIvarStoreForType(_type);
+        _compare = SHIvarCompareForType(_type);
+        _setter = SHPropertySetterForIvar(modelClass, _name, encoding);
+        _send = SHIvarSendForType(_type);
+        _keyValueCodingKey = _setter ? SHPropertyNameForIvarName(_name) : _name;
+        _usesKeyValueCoding = ![modelClass accessInstanceVariablesDirectly] ||
+                              (NULL == _setter && SHClassDeclaresIvarSetter(modelClass, _name));
+    }
+    return self;
+}
+
+// applies the schema entry of the ivar, called by the plan before it is shared
+- (void)applySchemaField:(NSDictionary *)field rootClass:(Class)rootClass {
+    id objectClass = field[SHModelSchemaClassKey];
+    if (objectClass) {
+        NSAssert(class_isMetaClass(object_getClass(objectClass)), @"schema class for %@ is not a class: %@", _name,
+                 objectClass);
+        NSAssert(_type == SHIvarTypeObject, @"schema class for %@ needs an object ivar, not %@", _name, _typeEncoding);
+        _objectClass = objectClass;
+        _isModelClass = [_objectClass isSubclassOfClass:rootClass];
+    }
+
+    id elementClass = field[SHModelSchemaElementClassKey];
+    if (elementClass) {
+        NSAssert(class_isMetaClass(object_getClass(elementClass)), @"element class for %@ is not a class: %@", _name,
+                 elementClass);
+        if ([elementClass isSubclassOfClass:rootClass]) {
+            _elementClass = elementClass;
+        } else {
+            NSLog(@"element class %@ for %@ is not a model class, ignoring it.", elementClass, _name);
+        }
+    }
+
+    id dateFormat = field[SHModelSchemaDateFormatKey];
+    if ([dateFormat isKindOfClass:[NSString class]]) {
+        _inputDateFormat = kInputDateFormatCustom;
+        _dateFormat = [dateFormat copy];
+    } else if ([dateFormat isKindOfClass:[NSNumber class]]) {
+        _inputDateFormat = [dateFormat intValue];
+        NSAssert(_inputDateFormat != kInputDateFormatCustom, @"custom date format for %@ needs a format string", _name);
+    }
+
+    id transformer = field[SHModelSchemaTransformerKey];
+    if ([transformer isKindOfClass:[NSString class]]) {
+        _valueTransformer = [NSValueTransformer valueTransformerForName:transformer];
+        if (nil == _valueTransformer) {
+            NSLog(@"no value transformer is registered as %@ for %@, ignoring it.", transformer, _name);
+        }
+    } else if (transformer) {
+        NSAssert([transformer isKindOfClass:[NSValueTransformer class]], @"transformer for %@ is not a "
+                                                                         @"NSValueTransformer: %@", _name, transformer);
+        _valueTransformer = transformer;
+    }
+
+    _interned = [field[SHModelSchemaInternedKey] boolValue];
+    if (_interned && _type != SHIvarTypeObject) {
+        NSLog(@"interned field %@ is not an object ivar, ignoring it.", _name);
+        _interned = NO;
+    }
+}
+
+// picks the converters for every kind of value once the schema is applied, called by the plan before it is shared
+- (void)resolveConvertersWithRootClass:(Class)rootClass {
+    if (nil == _valueTransformer && _objectClass) {
+        _valueTransformer = SHValueTransformerForClass(_objectClass);
+    }
+    if (![rootClass conformsToProtocol:@protocol(SHModelValueConverting)]) {
+        return;
+    }
+    for (SHValueKind kind = SHValueKindOther; kind < SHValueKindCount; kind++) {
+        _converters[kind] = [(Class<SHModelValueConverting>)rootClass valueConverterForIvar:self kind:kind];
+    }
+}
+
+id SHModelConvertValue(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    SHValueKind kind = SHValueKindOther;
+    if ([value isKindOfClass:[NSString class]]) {
+        kind = SHValueKindString;
+    } else if ([value isKindOfClass:[NSNumber class]]) {
+        kind = SHValueKindNumber;
+    } else if ([value isKindOfClass:[NSDictionary class]]) {
+        kind = SHValueKindDictionary;
+    } else if ([value isKindOfClass:[NSArray class]]) {
+        kind = SHValueKindArray;
+    }
+    SHValueConverter converter = descriptor->_converters[kind];
+    return converter ? converter(object, descriptor, value, key) : value;
+}
+
+void SHModelSetIvarValue(id object, SHModelIvarDescriptor *descriptor, id value) {
+    if (descriptor->_setter) {
+        // KVO observes the setter itself, no need to check for observers
+        if (descriptor->_type == SHIvarTypeObject) {
+            ((void (*)(id, SEL, id))objc_msgSend)(object, descriptor->_setter, value);
+            return;
+        }
+        if (descriptor->_send && [value isKindOfClass:[NSNumber class]]) {
+            descriptor->_send(object, descriptor->_setter, value);
+            return;
+        }
+    } else if (!descriptor->_usesKeyValueCoding && nil == [object observationInfo]) {
+        // observed objects must get their KVO notifications
+        if (descriptor->_type == SHIvarTypeObject) {
+            if (SHStoreObject(object, descriptor->_ivar, value)) {
+                return;
+            }
+        } else if (descriptor->_store && [value isKindOfClass:[NSNumber class]]) {
+            descriptor->_store(object, descriptor->_offset, value);
+            return;
+        }
+    }
+    [object setValue:value forKey:descriptor->_keyValueCodingKey];
+}
+
+BOOL SHModelIvarHasValue(id object, SHModelIvarDescriptor *descriptor, id value) {
+    // what a KVC setter stores is not known. ivars with a property setter are compared as stored, the setter is not
+    // sent again for the value the ivar already holds
+    if (descriptor->_usesKeyValueCoding) {
+        return NO;
+    }
+    if (descriptor->_type == SHIvarTypeObject) {
+        id current = object_getIvar(object, descriptor->_ivar);
+        return current == value || (nil != value && [current isEqual:value]);
+    }
+    if (descriptor->_compare && [value isKindOfClass:[NSNumber class]]) {
+        return descriptor->_compare(object, descriptor->_offset, value);
+    }
+    return NO;
+}
+
+void SHModelClearIvar(id object, SHModelIvarDescriptor *descriptor) {
+    if (descriptor->_type == SHIvarTypeObject) {
+        if (!SHStoreObject(object, descriptor->_ivar, nil)) {
+            [object setValue:nil forKey:descriptor->_name];
+        }
+        return;
+    }
+    NSUInteger size = 0;
+    NSGetSizeAndAlignment(ivar_getTypeEncoding(descriptor->_ivar), &size, NULL);
+    memset((uint8_t *)(__bridge void *)object + descriptor->_offset, 0, size);
+}
+
+void SHModelStoreIvarObject(id object, SHModelIvarDescriptor *descriptor, id value) {
+    if (!SHStoreObject(object, descriptor->_ivar, value)) {
+        [object setValue:value forKey:descriptor->_name];
+    }
+}
+
+// reads the ivar at `offset` as `type`
+#define SH_LOAD_SCALAR(object, offset, type) (*(const type *)((const uint8_t *)(__bridge void *)(object) + (offset)))
+
+NSNumber *SHModelIvarNumber(id object, SHModelIvarDescriptor *descriptor) {
+    ptrdiff_t offset = descriptor->_offset;
+    switch (descriptor->_type) {
+        case SHIvarTypeChar: return @(SH_LOAD_SCALAR(object, offset, char));
+        case SHIvarTypeUnsignedChar: return @(SH_LOAD_SCALAR(object, offset, unsigned char));
+        case SHIvarTypeBool: return SH_LOAD_SCALAR(object, offset, bool) ? @YES : @NO;
+        case SHIvarTypeShort: return @(SH_LOAD_SCALAR(object, offset, short));
+        case SHIvarTypeUnsignedShort: return @(SH_LOAD_SCALAR(object, offset, unsigned short));
+        case SHIvarTypeInt: return @(SH_LOAD_SCALAR(object, offset, int));
+        case SHIvarTypeUnsignedInt: return @(SH_LOAD_SCALAR(object, offset, unsigned int));
+        case SHIvarTypeLong: return @(SH_LOAD_SCALAR(object, offset, long));
+        case SHIvarTypeUnsignedLong: return @(SH_LOAD_SCALAR(object, offset, unsigned long));
+        case SHIvarTypeLongLong: return @(SH_LOAD_SCALAR(object, offset, long long));
+        case SHIvarTypeUnsignedLongLong: return @(SH_LOAD_SCALAR(object, offset, unsigned long long));
+        case SHIvarTypeFloat: return @(SH_LOAD_SCALAR(object, offset, float));
+        case SHIvarTypeDouble: return @(SH_LOAD_SCALAR(object, offset, double));
+        default: return nil;
+    }
+}
+
+// writes `value` converted to the C type of the ivar
+#define SH_STORE_SCALAR(object, offset, type, value)                                                                 \
+    (*(type *)((uint8_t *)(__bridge void *)(object) + (offset)) = (type)(value))
+
+static inline BOOL SHCanStoreScalar(id object, SHModelIvarDescriptor *descriptor) {
+    return NULL == descriptor->_setter && !descriptor->_usesKeyValueCoding && nil == [object observationInfo];
+}
+
+BOOL SHModelSetIvarLongLong(id object, SHModelIvarDescriptor *descriptor, long long value) {
+    if (!SHCanStoreScalar(object, descriptor)) {
+        return NO;
+    }
+    ptrdiff_t offset = descriptor->_offset;
+    switch (descriptor->_type) {
+        case SHIvarTypeChar: SH_STORE_SCALAR(object, offset, char, value); return YES;
+        case SHIvarTypeUnsignedChar: SH_STORE_SCALAR(object, offset, unsigned char, value); return YES;
+        case SHIvarTypeBool: SH_STORE_SCALAR(object, offset, bool, value); return YES;
+        case SHIvarTypeShort: SH_STORE_SCALAR(object, offset, short, value); return YES;
+        case SHIvarTypeUnsignedShort: SH_STORE_SCALAR(object, offset, unsigned short, value); return YES;
+        case SHIvarTypeInt: SH_STORE_SCALAR(object, offset, int, value); return YES;
+        case SHIvarTypeUnsignedInt: SH_STORE_SCALAR(object, offset, unsigned int, value); return YES;
+        case SHIvarTypeLong: SH_STORE_SCALAR(object, offset, long, value); return YES;
+        case SHIvarTypeUnsignedLong: SH_STORE_SCALAR(object, offset, unsigned long, value); return YES;
+        case SHIvarTypeLongLong: SH_STORE_SCALAR(object, offset, long long, value); return YES;
+        case SHIvarTypeUnsignedLongLong: SH_STORE_SCALAR(object, offset, unsigned long long, value); return YES;
+        case SHIvarTypeFloat: SH_STORE_SCALAR(object, offset, float, value); return YES;
+        case SHIvarTypeDouble: SH_STORE_SCALAR(object, offset, double, value); return YES;
+        default: return NO;
+    }
+}
+
+BOOL SHModelSetIvarDouble(id object, SHModelIvarDescriptor *descriptor, double value) {
+    if (!SHCanStoreScalar(object, descriptor)) {
+        return NO;
+    }
+    switch (descriptor->_type) {
+        case SHIvarTypeFloat: SH_STORE_SCALAR(object, descriptor->_offset, float, value); return YES;
+        case SHIvarTypeDouble: SH_STORE_SCALAR(object, descriptor->_offset, double, value); return YES;
+        default: return NO;
+    }
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p %@ %@>", NSStringFromClass([self class]), self, _name, _typeEncoding];
+}
+
+@end
+
+#pragma mark - SHModelClassPlan
+
+@implementation SHModelClassPlan {
+    // arrays of output keys, indexed by `kOutputKeyStyle`
+    NSArray *_outputKeys;
+    // keys from the schema, the table does not retain them
+    NSMutableArray *_schemaKeys;
+    // `+primaryKey` of the class, nil if it has none or no ivar matches it
+    NSString *_primaryKey;
+    // open addressing table from normalized key to descriptor, immutable once the plan is built
+    SHPlanTableEntry *_table;
+    NSUInteger _tableMask;
+    // blocks of primitive ivars ordered by offset, see `copyPrimitiveIvarsFromObject:toObject:`
+    SHIvarSpan *_primitiveSpans;
+    NSUInteger _primitiveSpanCount;
+    // the parts of the primitive ivars that are compared, without padding, see `primitiveIvarsOfObject:equalToObject:`
+    SHIvarField *_comparedFields;
+    NSUInteger _comparedFieldCount;
+}
+
+static NSMapTable *_plans;
+static pthread_rwlock_t _plansLock = PTHREAD_RWLOCK_INITIALIZER;
+
++ (instancetype)planForClass:(Class)cls rootClass:(Class)rootClass {
+    if (cls == nil) {
+        return nil;
+    }
+
+    pthread_rwlock_rdlock(&_plansLock);
+    SHModelClassPlan *plan = [_plans objectForKey:cls];
+    pthread_rwlock_unlock(&_plansLock);
+    if (plan) {
+        return plan;
+    }
+
+    // build outside the lock, another thread may win the race in which case its plan is used.
+    SHModelClassPlan *newPlan = [[self alloc] initWithClass:cls rootClass:rootClass];
+
+    pthread_rwlock_wrlock(&_plansLock);
+    if (nil == _plans) {
+        _plans = [[NSMapTable alloc]
+            initWithKeyOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)
+                  valueOptions:NSPointerFunctionsStrongMemory
+                      capacity:64];
+    }
+    plan = [_plans objectForKey:cls];
+    if (nil == plan) {
+        plan = newPlan;
+        [_plans setObject:plan forKey:cls];
+    }
+    pthread_rwlock_unlock(&_plansLock);
+
+    return plan;
+}
+
++ (instancetype)cachedPlanForClass:(Class)cls {
+    pthread_rwlock_rdlock(&_plansLock);
+    SHModelClassPlan *plan = [_plans objectForKey:cls];
+    pthread_rwlock_unlock(&_plansLock);
+    return plan;
+}
+
+- (instancetype)initWithClass:(Class)cls rootClass:(Class)rootClass {
+    if ((self = [super init])) {
+        _modelClass = cls;
+        _rootClass = rootClass;
+
+        // superclasses first, so that subclass ivars override them in the key map
+        NSMutableArray *hierarchy = [NSMutableArray array];
+        for (Class current = cls; current != nil && current != rootClass; current = class_getSuperclass(current)) {
+            [hierarchy insertObject:current atIndex:0];
+        }
+
+        NSMutableArray *ivars = [NSMutableArray array];
+        NSMutableArray *ivarNames = [NSMutableArray array];
+        for (Class current in hierarchy) {
+            unsigned int outCount = 0;
+            Ivar *ivarList = class_copyIvarList(current, &outCount);
+            for (unsigned int i = 0; i < outCount; i++) {
+                if (NULL == ivar_getName(ivarList[i])) {
+                    continue;
+                }
+                SHModelIvarDescriptor *descriptor = [[SHModelIvarDescriptor alloc] initWithIvar:ivarList[i]
+                                                                                     modelClass:cls
+                                                                                 declaringClass:current
+                                                                                      rootClass:rootClass
+                                                                                          index:[ivars count]];
+                [ivars addObject:descriptor];
+                [ivarNames addObject:descriptor.name];
+            }
+            free(ivarList);
+        }
+        _ivars = [ivars copy];
+        _ivarNames = [ivarNames copy];
+        [self buildIvarLayout];
+
+        NSMutableArray *outputKeys = [NSMutableArray array];
+        for (kOutputKeyStyle style = kOutputKeyStyleIvarName; style <= kOutputKeyStyleCamelCase; style++) {
+            NSMutableArray *keys = [NSMutableArray arrayWithCapacity:[_ivarNames count]];
+            for (NSString *name in _ivarNames) {
+                [keys addObject:SHOutputKeyForIvarName(name, style)];
+            }
+            [outputKeys addObject:[keys copy]];
+        }
+        _outputKeys = [outputKeys copy];
+
+        NSDictionary *schema = nil;
+        if ([cls respondsToSelector:@selector(modelSchema)]) {
+            schema = [(Class<SHModelSerialization>)cls modelSchema];
+        }
+        NSUInteger keyCount = [_ivars count];
+        for (NSDictionary *field in [schema objectEnumerator]) {
+            keyCount += [field[SHModelSchemaKeysKey] count];
+        }
+
+        NSUInteger capacity = 8;
+        while (capacity < keyCount * 2) {
+            capacity <<= 1;
+        }
+        _tableMask = capacity - 1;
+        _table = calloc(capacity, sizeof(SHPlanTableEntry));
+
+        // superclass ivars come first and are replaced by subclass ivars with the same key. within one class the first
+        // declared ivar wins.
+        Class declaringClass = Nil;
+        NSMutableSet *keysInClass = [NSMutableSet set];
+        for (SHModelIvarDescriptor *descriptor in _ivars) {
+            SHNormalizedKey *key = descriptor.normalizedKey;
+            if (nil == key) {
+                continue;
+            }
+            if (descriptor.declaringClass != declaringClass) {
+                declaringClass = descriptor.declaringClass;
+                [keysInClass removeAllObjects];
+            }
+            if ([keysInClass containsObject:key]) {
+                continue;
+            }
+            [keysInClass addObject:key];
+            [self setDescriptor:descriptor forKey:key];
+        }
+
+        _schemaKeys = [NSMutableArray array];
+        [schema enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSDictionary *field, BOOL *stop) {
+            SHModelIvarDescriptor *descriptor = [self ivarForKey:name];
+            if (nil == descriptor) {
+                NSLog(@"%@ has no ivar for the schema field %@, ignoring it.", NSStringFromClass(cls), name);
+                return;
+            }
+            [descriptor applySchemaField:field rootClass:rootClass];
+
+            // schema keys are declared explicitly, they win over ivar names matching the same key
+            for (NSString *alias in field[SHModelSchemaKeysKey]) {
+                SHNormalizedKey *key = [SHNormalizedKey normalizedKeyForString:alias];
+                if (key) {
+                    [_schemaKeys addObject:key];
+                    [self setDescriptor:descriptor forKey:key];
+                }
+            }
+        }];
+
+        for (SHModelIvarDescriptor *descriptor in _ivars) {
+            [descriptor resolveConvertersWithRootClass:rootClass];
+        }
+
+        if ([cls respondsToSelector:@selector(primaryKey)]) {
+            _primaryKey = [[(Class<SHModelSerialization>)cls primaryKey] copy];
+        }
+        if (_primaryKey) {
+            _primaryKeyIvar = [self ivarForKey:_primaryKey];
+            if (nil == _primaryKeyIvar) {
+                NSLog(@"%@ has no ivar for the primary key %@, ignoring it.", NSStringFromClass(cls), _primaryKey);
+                _primaryKey = nil;
+            }
+        }
+    }
+    return self;
+}
+
+// splits the ivars into object ivars and blocks of primitive ivars
+- (void)buildIvarLayout {
+    NSMutableArray *objectIvars = [NSMutableArray array];
+    NSMutableArray *primitiveIvars = [NSMutableArray array];
+    for (SHModelIvarDescriptor *descriptor in _ivars) {
+        const char *encoding = ivar_getTypeEncoding(descriptor.ivar);
+        if (descriptor.type == SHIvarTypeObject) {
+            [objectIvars addObject:descriptor];
+        } else if (encoding && encoding[0] != '\0' && encoding[0] != 'b') {
+            // the offset of a bit field is the offset of the bytes it shares with other bit fields
+            [primitiveIvars addObject:descriptor];
+        }
+    }
+    _objectIvars = [objectIvars copy];
+    [primitiveIvars sortUsingComparator:^NSComparisonResult(SHModelIvarDescriptor *one, SHModelIvarDescriptor *other) {
+        if (one.offset == other.offset) {
+            return NSOrderedSame;
+        }
+        return (one.offset < other.offset) ? NSOrderedAscending : NSOrderedDescending;
+    }];
+
+    _primitiveSpans = calloc(MAX([primitiveIvars count], (NSUInteger)1), sizeof(SHIvarSpan));
+    _primitiveSpanCount = 0;
+    NSMutableData *fields = [NSMutableData data];
+    for (SHModelIvarDescriptor *descriptor in primitiveIvars) {
+        NSUInteger size = 0;
+        NSGetSizeAndAlignment(ivar_getTypeEncoding(descriptor.ivar), &size, NULL);
+        if (size == 0) {
+            continue;
+        }
+        SHIvarSpan *last = _primitiveSpanCount > 0 ? &_primitiveSpans[_primitiveSpanCount - 1] : NULL;
+        if (last && last->offset + (ptrdiff_t)last->length == descriptor.offset) {
+            last->length += size;
+        } else {
+            _primitiveSpans[_primitiveSpanCount++] = (SHIvarSpan){descriptor.offset, size};
+        }
+
+        NSUInteger fieldsLength = [fields length];
+        const char *type = ivar_getTypeEncoding(descriptor.ivar);
+        size_t walkedSize = 0;
+        size_t walkedAlignment = 0;
+        if (!SHWalkType(&type, descriptor.offset, fields, &walkedSize, &walkedAlignment)) {
+            [fields setLength:fieldsLength];
+            SHAppendField(fields, descriptor.offset, size, SHIvarFieldBytes);
+        }
+    }
+
+    // raw memory that follows each other is compared as one block
+    const SHIvarField *walked = [fields bytes];
+    NSUInteger walkedCount = [fields length] / sizeof(SHIvarField);
+    _comparedFields = calloc(MAX(walkedCount, (NSUInteger)1), sizeof(SHIvarField));
+    _comparedFieldCount = 0;
+    for (NSUInteger i = 0; i < walkedCount; i++) {
+        SHIvarField *last = _comparedFieldCount > 0 ? &_comparedFields[_comparedFieldCount - 1] : NULL;
+        if (last && last->kind == SHIvarFieldBytes && walked[i].kind == SHIvarFieldBytes &&
+            last->offset + (ptrdiff_t)last->length == walked[i].offset) {
+            last->length += walked[i].length;
+        } else {
+            _comparedFields[_comparedFieldCount++] = walked[i];
+        }
+    }
+}
+
+#define SH_LOAD_FIELD(bytes, field, type) (*(const type *)((bytes) + (field).offset))
+
+- (BOOL)primitiveIvarsOfObject:(id)object equalToObject:(id)other {
+    const uint8_t *bytes = (const uint8_t *)(__bridge void *)object;
+    const uint8_t *otherBytes = (const uint8_t *)(__bridge void *)other;
+    for (NSUInteger i = 0; i < _comparedFieldCount; i++) {
+        SHIvarField field = _comparedFields[i];
+        BOOL equal = NO;
+        switch (field.kind) {
+            case SHIvarFieldBytes:
+                equal = memcmp(bytes + field.offset, otherBytes + field.offset, field.length) == 0;
+                break;
+            case SHIvarFieldFloat:
+                equal = SH_LOAD_FIELD(bytes, field, float) == SH_LOAD_FIELD(otherBytes, field, float);
+                break;
+            case SHIvarFieldDouble:
+                equal = SH_LOAD_FIELD(bytes, field, double) == SH_LOAD_FIELD(otherBytes, field, double);
+                break;
+            case SHIvarFieldLongDouble:
+                equal = SH_LOAD_FIELD(bytes, field, long double) == SH_LOAD_FIELD(otherBytes, field, long double);
+                break;
+        }
+        if (!equal) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+static inline uint64_t SHHashBytes(uint64_t hash, const uint8_t *bytes, size_t length) {
+    // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+- (NSUInteger)primitiveIvarsHashOfObject:(id)object {
+    const uint8_t *bytes = (const uint8_t *)(__bridge void *)object;
+    uint64_t hash = 14695981039346656037ULL;
+    for (NSUInteger i = 0; i < _comparedFieldCount; i++) {
+        SHIvarField field = _comparedFields[i];
+        if (field.kind == SHIvarFieldBytes) {
+            hash = SHHashBytes(hash, bytes + field.offset, field.length);
+            continue;
+        }
+        // equal values hash the same: `-0.0` is hashed as `0.0`
+        double value = (field.kind == SHIvarFieldFloat)    ? SH_LOAD_FIELD(bytes, field, float)
+                       : (field.kind == SHIvarFieldDouble) ? SH_LOAD_FIELD(bytes, field, double)
+                                                           : (double)SH_LOAD_FIELD(bytes, field, long double);
+        if (value == 0) {
+            value = 0;
+        }
+        hash = SHHashBytes(hash, (const uint8_t *)&value, sizeof(value));
+    }
+    return (NSUInteger)hash;
+}
+
+- (void)copyPrimitiveIvarsFromObject:(id)source toObject:(id)object {
+    const uint8_t *sourceBytes = (const uint8_t *)(__bridge void *)source;
+    uint8_t *bytes = (uint8_t *)(__bridge void *)object;
+    for (NSUInteger i = 0; i < _primitiveSpanCount; i++) {
+        memcpy(bytes + _primitiveSpans[i].offset, sourceBytes + _primitiveSpans[i].offset, _primitiveSpans[i].length);
+    }
+}
+
+- (id)primaryKeyValueInDictionary:(NSDictionary *)dictionary {
+    if (nil == _primaryKeyIvar) {
+        return nil;
+    }
+    id value = dictionary[_primaryKey];
+    if (nil == value) {
+        for (id key in dictionary) {
+            if ([self ivarForKey:key] == _primaryKeyIvar) {
+                value = dictionary[key];
+                break;
+            }
+        }
+    }
+    return ([value isKindOfClass:[NSString class]] || [value isKindOfClass:[NSNumber class]]) ? value : nil;
+}
+
+- (void)setDescriptor:(SHModelIvarDescriptor *)descriptor forKey:(SHNormalizedKey *)key {
+    SHPlanTableEntry *entry = [self entryForCharacters:key.characters length:key.length hash:key.keyHash];
+    entry->hash = key.keyHash;
+    entry->length = key.length;
+    entry->characters = key.characters;
+    entry->key = key;
+    entry->descriptor = descriptor;
+}
+
+- (NSArray *)outputKeysWithStyle:(kOutputKeyStyle)style {
+    if (style < kOutputKeyStyleIvarName || style > kOutputKeyStyleCamelCase) {
+        style = kOutputKeyStyleIvarName;
+    }
+    return _outputKeys[style];
+}
+
+- (void)dealloc {
+    free(_table);
+    free(_primitiveSpans);
+    free(_comparedFields);
+}
+
+// returns the entry for the key, or the empty slot where it should be inserted
+- (SHPlanTableEntry *)entryForCharacters:(const unichar *)characters length:(NSUInteger)length hash:(NSUInteger)hash {
+    NSUInteger slot = hash & _tableMask;
+    while (YES) {
+        SHPlanTableEntry *entry = &_table[slot];
+        if (nil == entry->key) {
+            return entry;
+        }
+        if (entry->hash == hash && entry->length == length &&
+            memcmp(entry->characters, characters, sizeof(unichar) * length) == 0) {
+            return entry;
+        }
+        slot = (slot + 1) & _tableMask;
+    }
+}
+
+- (SHModelIvarDescriptor *)ivarForKey:(id)key {
+    SHNormalizedKey *normalizedKey = [SHNormalizedKey normalizedKeyForString:key];
+    if (nil == normalizedKey) {
+        return nil;
+    }
+    return [self ivarForNormalizedCharacters:normalizedKey.characters
+                                      length:normalizedKey.length
+                                        hash:normalizedKey.keyHash];
+}
+
+- (SHModelIvarDescriptor *)ivarForNormalizedCharacters:(const unichar *)characters
+                                                length:(NSUInteger)length
+                                                  hash:(NSUInteger)hash {
+    return [self entryForCharacters:characters length:length hash:hash]->descriptor;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p %@ %@>", NSStringFromClass([self class]), self,
+                                      NSStringFromClass(_modelClass), _ivarNames];
+}
+
+@end
@@ -0,0 +1,193 @@
+// SHModelCollection.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class SHDecodingContext;
+@class SHModelCollection;
+
+/**
+ *  The `SHModelRow` is a lightweight view of one row of a `SHModelCollection`. it holds the collection and an index,
+ *  no values, and reads them from the columns when asked. rows answer `valueForKey:` and subscripts with the keys of
+ *  the model class.
+ */
+@interface SHModelRow : NSObject
+
+@property (nonatomic, readonly) SHModelCollection *collection;
+
+@property (nonatomic, readonly) NSUInteger index;
+
+// value of the field, numbers boxed. nil if the field is nil or the class has no such field.
+- (id)objectForKeyedSubscript:(NSString *)key;
+
+// value of a numeric field without boxing it, 0 for other fields
+- (long long)longLongValueForKey:(NSString *)key;
+- (double)doubleValueForKey:(NSString *)key;
+
+// a new model object with the values of the row
+- (id)modelObject;
+
+@end
+
+/**
+ *  The `SHModelCollection` stores many objects of one `SHModelObject` subclass as columns instead of one object per
+ *  row. primitive fields are kept in contiguous C arrays (integers and `BOOL`s as `long long`, `float`s and `double`s
+ *  as `double`), `NSString` fields as indexes into a table of unique strings and other objects in an array of
+ *  references. a row of primitive and string fields costs 8 or 4 bytes per field, no object.
+ *
+ *  dictionaries are decoded with the options of the context into one reused model object and copied into the
+ *  columns, so keys, schemas and converters work like they do for model objects. the aggregates run over the columns
+ *  in tight loops the compiler can vectorize.
+ *
+ *  collections are immutable, all methods are thread-safe. `unsigned long long` values above `LLONG_MAX` are kept
+ *  exactly, but sums, ranges and sorting treat them as negative.
+ *
+ *  @code
+ *  SHModelCollection *trades = [SHModelCollection collectionWithArray:response[@"trades"] modelClass:[SHTrade class]];
+ *  NSNumber *volume = [trades sumForKey:@"volume"];
+ *  SHModelCollection *large = [trades collectionWithIndexes:[trades indexesForKey:@"volume" from:1000 to:INFINITY]];
+ *  @endcode
+ */
+@interface SHModelCollection : NSObject
+
+/**
+ *  decodes every dictionary of the array into a row, with the default context. items that are not dictionaries are
+ *  skipped.
+ *
+ *  @param array array of dictionaries
+ *  @param modelClass `SHModelObject` subclass of the rows
+ *
+ *  @return the collection, nil if `array` is not an array
+ */
++ (instancetype)collectionWithArray:(NSArray *)array modelClass:(Class)modelClass;
+
+/**
+ *  see `collectionWithArray:modelClass:`
+ *
+ *  @param array array of dictionaries
+ *  @param modelClass `SHModelObject` subclass of the rows
+ *  @param context `SHDecodingContext` with the date options and mappings, nil for the default context
+ *
+ *  @return the collection, nil if `array` is not an array
+ */
++ (instancetype)collectionWithArray:(NSArray *)array
+                         modelClass:(Class)modelClass
+                            context:(SHDecodingContext *)context;
+
+/**
+ *  copies the values of model objects into a collection
+ *
+ *  @param objects array of instances of one `SHModelObject` subclass, objects of other classes are skipped
+ *
+ *  @return the collection, nil if `objects` is empty
+ */
++ (instancetype)collectionWithObjects:(NSArray *)objects;
+
+@property (nonatomic, readonly) Class modelClass;
+
+// the context dictionaries were decoded with, also used for the model objects created from rows
+@property (nonatomic, readonly) SHDecodingContext *context;
+
+@property (nonatomic, readonly) NSUInteger count;
+
+// number of unique strings in the string table
+@property (nonatomic, readonly) NSUInteger uniqueStringCount;
+
+#pragma mark - Rows
+
+- (SHModelRow *)rowAtIndex:(NSUInteger)index;
+- (SHModelRow *)objectAtIndexedSubscript:(NSUInteger)index;
+
+/**
+ *  calls the block for every row. the row passed is a cursor that moves on to the next row after the block returns,
+ *  use `rowAtIndex:` to keep a row.
+ *
+ *  @param block block called with every row, set `stop` to `YES` to stop
+ */
+- (void)enumerateRowsUsingBlock:(void (^)(SHModelRow *row, BOOL *stop))block;
+
+// value of a field in a row, like `-[SHModelRow objectForKeyedSubscript:]`
+- (id)valueAtIndex:(NSUInteger)index forKey:(NSString *)key;
+
+// value of a numeric field in a row without boxing it, 0 for other fields
+- (long long)longLongValueAtIndex:(NSUInteger)index forKey:(NSString *)key;
+- (double)doubleValueAtIndex:(NSUInteger)index forKey:(NSString *)key;
+
+#pragma mark - Model objects
+
+// a new model object with the values of a row
+- (id)objectAtIndex:(NSUInteger)index;
+
+// a new model object for every row
+- (NSArray *)allObjects;
+
+#pragma mark - Aggregates
+
+// `YES` if the field is stored in a numeric column and can be aggregated
+- (BOOL)isNumericKey:(NSString *)key;
+
+/**
+ *  sum of a numeric field over all rows. integer fields are summed as `long long`, floating point fields as `double`.
+ *
+ *  @param key key of the field
+ *
+ *  @return the sum, nil if the field is not numeric
+ */
+- (NSNumber *)sumForKey:(NSString *)key;
+
+// smallest value of a numeric field, NaN values are ignored. nil if the field is not numeric or there are no rows.
+- (NSNumber *)minimumForKey:(NSString *)key;
+
+// largest value of a numeric field, NaN values are ignored. nil if the field is not numeric or there are no rows.
+- (NSNumber *)maximumForKey:(NSString *)key;
+
+/**
+ *  filters the rows on a numeric field
+ *
+ *  @param key key of the field
+ *  @param minimum smallest value to include, `-INFINITY` for no lower bound
+ *  @param maximum largest value to include, `INFINITY` for no upper bound
+ *
+ *  @return indexes of the rows with values in the closed range, nil if the field is not numeric
+ */
+- (NSIndexSet *)indexesForKey:(NSString *)key from:(double)minimum to:(double)maximum;
+
+/**
+ *  the rows at the indexes as a new collection, sharing the string table
+ *
+ *  @param indexes indexes of the rows
+ *
+ *  @return the collection
+ */
+- (SHModelCollection *)collectionWithIndexes:(NSIndexSet *)indexes;
+
+/**
+ *  the rows sorted on a numeric field as a new collection. the sort is stable and NaN values go last.
+ *
+ *  @param key key of the field
+ *  @param ascending `YES` to put the smallest value first
+ *
+ *  @return the collection, nil if the field is not numeric
+ */
+- (SHModelCollection *)collectionSortedByKey:(NSString *)key ascending:(BOOL)ascending;
+
+@end
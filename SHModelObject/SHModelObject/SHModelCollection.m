@@ -0,0 +1,687 @@
+// SHModelCollection.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHModelCollection.h"
+#import "SHModelObject.h"
+#import "SHModelClassPlan.h"
+#import <math.h>
+
+typedef NS_ENUM(NSInteger, SHColumnKind) {
+    SHColumnKindNone = 0, // ivars of types the plan does not parse, not stored
+    SHColumnKindInteger,  // `long long` values
+    SHColumnKindDouble,   // `double` values
+    SHColumnKindString,   // `uint32_t` indexes into the string table
+    SHColumnKindObject,   // strong references
+};
+
+// string index of nil
+#define SH_NO_STRING UINT32_MAX
+
+typedef struct {
+    SHColumnKind kind;
+    void *values;
+} SHModelColumn;
+
+typedef struct {
+    long long value;
+    NSUInteger row;
+} SHIntegerSortKey;
+
+typedef struct {
+    double value;
+    NSUInteger row;
+} SHDoubleSortKey;
+
+static SHColumnKind SHColumnKindForIvar(SHModelIvarDescriptor *descriptor) {
+    switch (descriptor.type) {
+        case SHIvarTypeUnknown: return SHColumnKindNone;
+        case SHIvarTypeObject: {
+            return [descriptor.objectClass isSubclassOfClass:[NSString class]] ? SHColumnKindString
+                                                                               : SHColumnKindObject;
+        }
+        case SHIvarTypeFloat:
+        case SHIvarTypeDouble: return SHColumnKindDouble;
+        default: return SHColumnKindInteger;
+    }
+}
+
+static size_t SHColumnElementSize(SHColumnKind kind) {
+    switch (kind) {
+        case SHColumnKindInteger: return sizeof(long long);
+        case SHColumnKindDouble: return sizeof(double);
+        case SHColumnKindString: return sizeof(uint32_t);
+        case SHColumnKindObject: return sizeof(id);
+        default: return 0;
+    }
+}
+
+// value of an integer ivar, unsigned values above `LLONG_MAX` wrap around like a C cast
+static long long SHIntegerIvarValue(const uint8_t *ivar, SHIvarType type) {
+    switch (type) {
+        case SHIvarTypeChar: return *(const char *)ivar;
+        case SHIvarTypeUnsignedChar: return *(const unsigned char *)ivar;
+        case SHIvarTypeBool: return *(const bool *)ivar;
+        case SHIvarTypeShort: return *(const short *)ivar;
+        case SHIvarTypeUnsignedShort: return *(const unsigned short *)ivar;
+        case SHIvarTypeInt: return *(const int *)ivar;
+        case SHIvarTypeUnsignedInt: return *(const unsigned int *)ivar;
+        case SHIvarTypeLong: return *(const long *)ivar;
+        case SHIvarTypeUnsignedLong: return (long long)*(const unsigned long *)ivar;
+        case SHIvarTypeLongLong: return *(const long long *)ivar;
+        case SHIvarTypeUnsignedLongLong: return (long long)*(const unsigned long long *)ivar;
+        default: return 0;
+    }
+}
+
+#pragma mark - Column loops
+
+// the loops below have no branches in their bodies, so the compiler can run them in SIMD registers
+
+static long long SHSumIntegers(const long long *values, NSUInteger count) {
+    // unsigned, so an overflow wraps instead of being undefined
+    unsigned long long sum = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        sum += (unsigned long long)values[i];
+    }
+    return (long long)sum;
+}
+
+static double SHSumDoubles(const double *values, NSUInteger count) {
+    // four independent sums, floating point additions cannot be reordered by the compiler on its own
+    double sums[4] = { 0, 0, 0, 0 };
+    NSUInteger i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sums[0] += values[i];
+        sums[1] += values[i + 1];
+        sums[2] += values[i + 2];
+        sums[3] += values[i + 3];
+    }
+    for (; i < count; i++) {
+        sums[0] += values[i];
+    }
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+static void SHIntegerRange(const long long *values, NSUInteger count, long long *minimum, long long *maximum) {
+    long long min = LLONG_MAX;
+    long long max = LLONG_MIN;
+    for (NSUInteger i = 0; i < count; i++) {
+        min = (values[i] < min) ? values[i] : min;
+        max = (values[i] > max) ? values[i] : max;
+    }
+    *minimum = min;
+    *maximum = max;
+}
+
+// NaN compares false and is skipped
+static void SHDoubleRange(const double *values, NSUInteger count, double *minimum, double *maximum) {
+    double min = INFINITY;
+    double max = -INFINITY;
+    for (NSUInteger i = 0; i < count; i++) {
+        min = (values[i] < min) ? values[i] : min;
+        max = (values[i] > max) ? values[i] : max;
+    }
+    if (min > max) {
+        // no value was compared, they are all NaN
+        min = NAN;
+        max = NAN;
+    }
+    *minimum = min;
+    *maximum = max;
+}
+
+static int SHCompareIntegerSortKeys(const void *a, const void *b) {
+    const SHIntegerSortKey *first = a;
+    const SHIntegerSortKey *second = b;
+    if (first->value != second->value) {
+        return (first->value < second->value) ? -1 : 1;
+    }
+    // equal values keep their order
+    return (first->row < second->row) ? -1 : (first->row > second->row);
+}
+
+static int SHCompareDoubleSortKeys(const void *a, const void *b) {
+    const SHDoubleSortKey *first = a;
+    const SHDoubleSortKey *second = b;
+    if (first->value < second->value) {
+        return -1;
+    }
+    if (first->value > second->value) {
+        return 1;
+    }
+    BOOL firstIsNaN = (isnan(first->value) != 0);
+    if (firstIsNaN != (isnan(second->value) != 0)) {
+        return firstIsNaN ? 1 : -1;
+    }
+    return (first->row < second->row) ? -1 : (first->row > second->row);
+}
+
+#pragma mark - SHModelRow
+
+@interface SHModelRow ()
+
+@property (nonatomic, readwrite) NSUInteger index;
+
+@end
+
+@implementation SHModelRow
+
+- (instancetype)initWithCollection:(SHModelCollection *)collection index:(NSUInteger)index {
+    if ((self = [super init])) {
+        _collection = collection;
+        _index = index;
+    }
+    return self;
+}
+
+- (id)objectForKeyedSubscript:(NSString *)key {
+    return [_collection valueAtIndex:_index forKey:key];
+}
+
+- (id)valueForKey:(NSString *)key {
+    return [_collection valueAtIndex:_index forKey:key];
+}
+
+- (long long)longLongValueForKey:(NSString *)key {
+    return [_collection longLongValueAtIndex:_index forKey:key];
+}
+
+- (double)doubleValueForKey:(NSString *)key {
+    return [_collection doubleValueAtIndex:_index forKey:key];
+}
+
+- (id)modelObject {
+    return [_collection objectAtIndex:_index];
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p %lu of %@>", NSStringFromClass([self class]), self,
+                                      (unsigned long)_index, NSStringFromClass([_collection modelClass])];
+}
+
+@end
+
+#pragma mark - SHModelCollection
+
+@implementation SHModelCollection {
+    SHModelClassPlan *_plan;
+    // one column per ivar, in the order of `_plan.ivars`
+    SHModelColumn *_columns;
+    NSUInteger _columnCount;
+    // unique strings, shared with the collections created from this one
+    NSArray *_strings;
+}
+
+- (instancetype)initWithModelClass:(Class)modelClass
+                           context:(SHDecodingContext *)context
+                          capacity:(NSUInteger)capacity {
+    NSAssert([modelClass isSubclassOfClass:[SHModelObject class]], @"%@ is not a subclass of SHModelObject",
+             modelClass);
+    if ((self = [super init])) {
+        _modelClass = modelClass;
+        _context = context ?: [SHDecodingContext defaultContext];
+        _plan = [SHModelClassPlan planForClass:modelClass rootClass:[SHModelObject class]];
+        NSArray *ivars = _plan.ivars;
+        _columnCount = [ivars count];
+        _columns = (SHModelColumn *)calloc(MAX(_columnCount, 1), sizeof(SHModelColumn));
+        for (NSUInteger i = 0; i < _columnCount; i++) {
+            SHColumnKind kind = SHColumnKindForIvar(ivars[i]);
+            _columns[i].kind = kind;
+            if (kind != SHColumnKindNone) {
+                // zeroed, so the references of object columns start out as nil
+                _columns[i].values = calloc(MAX(capacity, 1), SHColumnElementSize(kind));
+            }
+        }
+        _strings = @[];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    for (NSUInteger i = 0; i < _columnCount; i++) {
+        if (_columns[i].kind == SHColumnKindObject) {
+            __strong id *objects = (__strong id *)_columns[i].values;
+            for (NSUInteger row = 0; row < _count; row++) {
+                objects[row] = nil;
+            }
+        }
+        free(_columns[i].values);
+    }
+    free(_columns);
+}
+
++ (instancetype)collectionWithArray:(NSArray *)array modelClass:(Class)modelClass {
+    return [self collectionWithArray:array modelClass:modelClass context:nil];
+}
+
++ (instancetype)collectionWithArray:(NSArray *)array
+                         modelClass:(Class)modelClass
+                            context:(SHDecodingContext *)context {
+    if (nil == array || ![array isKindOfClass:[NSArray class]]) {
+        return nil;
+    }
+
+    SHModelCollection *collection =
+        [[self alloc] initWithModelClass:modelClass context:context capacity:[array count]];
+    NSMutableArray *strings = [NSMutableArray array];
+    NSMapTable *stringIndexes = [NSMapTable strongToStrongObjectsMapTable];
+    // every dictionary is decoded into the same object, its values are copied into the columns
+    SHModelObject *decoded = [[modelClass alloc] init];
+    for (id item in array) {
+        if (![item isKindOfClass:[NSDictionary class]]) {
+            NSLog(@"object %@ is not a NSDictionary object, skipping.", [item description]);
+            continue;
+        }
+        @autoreleasepool {
+            [decoded prepareForReuse];
+            [decoded updateWithDictionary:item context:collection.context];
+            [collection appendRowFromObject:decoded strings:strings stringIndexes:stringIndexes];
+        }
+    }
+    collection->_strings = [strings copy];
+    return collection;
+}
+
++ (instancetype)collectionWithObjects:(NSArray *)objects {
+    SHModelObject *first = [objects firstObject];
+    if (nil == first) {
+        return nil;
+    }
+
+    Class modelClass = [first class];
+    SHModelCollection *collection = [[self alloc] initWithModelClass:modelClass
+                                                             context:first.decodingContext
+                                                            capacity:[objects count]];
+    NSMutableArray *strings = [NSMutableArray array];
+    NSMapTable *stringIndexes = [NSMapTable strongToStrongObjectsMapTable];
+    for (id object in objects) {
+        if ([object class] != modelClass) {
+            NSLog(@"object %@ is not a %@, skipping.", [object description], NSStringFromClass(modelClass));
+            continue;
+        }
+        [collection appendRowFromObject:object strings:strings stringIndexes:stringIndexes];
+    }
+    collection->_strings = [strings copy];
+    return collection;
+}
+
+// copies the ivars of the object into a new row, primitives straight from the ivar offsets
+- (void)appendRowFromObject:(id)object strings:(NSMutableArray *)strings stringIndexes:(NSMapTable *)stringIndexes {
+    const uint8_t *base = (const uint8_t *)(__bridge void *)object;
+    NSArray *ivars = _plan.ivars;
+    NSUInteger row = _count;
+    for (NSUInteger i = 0; i < _columnCount; i++) {
+        SHModelIvarDescriptor *descriptor = ivars[i];
+        const uint8_t *ivar = base + descriptor.offset;
+        switch (_columns[i].kind) {
+            case SHColumnKindInteger: {
+                ((long long *)_columns[i].values)[row] = SHIntegerIvarValue(ivar, descriptor.type);
+            } break;
+            case SHColumnKindDouble: {
+                ((double *)_columns[i].values)[row] =
+                    (descriptor.type == SHIvarTypeFloat) ? *(const float *)ivar : *(const double *)ivar;
+            } break;
+            case SHColumnKindString: {
+                id value = object_getIvar(object, descriptor.ivar);
+                uint32_t index = SH_NO_STRING;
+                if (value) {
+                    NSNumber *known = [stringIndexes objectForKey:value];
+                    if (known) {
+                        index = [known unsignedIntValue];
+                    } else {
+                        NSAssert([strings count] < SH_NO_STRING, @"too many unique strings");
+                        index = (uint32_t)[strings count];
+                        [strings addObject:value];
+                        [stringIndexes setObject:@(index) forKey:value];
+                    }
+                }
+                ((uint32_t *)_columns[i].values)[row] = index;
+            } break;
+            case SHColumnKindObject: {
+                ((__strong id *)_columns[i].values)[row] = object_getIvar(object, descriptor.ivar);
+            } break;
+            default: break;
+        }
+    }
+    _count++;
+}
+
+- (NSUInteger)uniqueStringCount {
+    return [_strings count];
+}
+
+// column of the field, NULL if the class has no field for the key
+- (SHModelColumn *)columnForKey:(NSString *)key descriptor:(SHModelIvarDescriptor **)descriptor {
+    SHModelIvarDescriptor *ivar = [_plan ivarForKey:key];
+    if (nil == ivar) {
+        return NULL;
+    }
+    if (descriptor) {
+        *descriptor = ivar;
+    }
+    return &_columns[ivar.index];
+}
+
+#pragma mark - Rows
+
+- (SHModelRow *)rowAtIndex:(NSUInteger)index {
+    NSAssert(index < _count, @"index %lu beyond bounds of %lu rows", (unsigned long)index, (unsigned long)_count);
+    return [[SHModelRow alloc] initWithCollection:self index:index];
+}
+
+- (SHModelRow *)objectAtIndexedSubscript:(NSUInteger)index {
+    return [self rowAtIndex:index];
+}
+
+- (void)enumerateRowsUsingBlock:(void (^)(SHModelRow *row, BOOL *stop))block {
+    SHModelRow *cursor = [[SHModelRow alloc] initWithCollection:self index:0];
+    BOOL stop = NO;
+    for (NSUInteger i = 0; i < _count && !stop; i++) {
+        cursor.index = i;
+        block(cursor, &stop);
+    }
+}
+
+- (id)valueAtIndex:(NSUInteger)index forKey:(NSString *)key {
+    SHModelIvarDescriptor *descriptor = nil;
+    SHModelColumn *column = [self columnForKey:key descriptor:&descriptor];
+    if (NULL == column || index >= _count) {
+        return nil;
+    }
+    switch (column->kind) {
+        case SHColumnKindInteger: {
+            long long value = ((const long long *)column->values)[index];
+            switch (descriptor.type) {
+                case SHIvarTypeBool: return @(value != 0);
+                case SHIvarTypeUnsignedLong:
+                case SHIvarTypeUnsignedLongLong: return @((unsigned long long)value);
+                default: return @(value);
+            }
+        }
+        case SHColumnKindDouble: return @(((const double *)column->values)[index]);
+        default: return [self objectInColumn:column atIndex:index];
+    }
+}
+
+// value of a string or object column, nil for other columns
+- (id)objectInColumn:(SHModelColumn *)column atIndex:(NSUInteger)index {
+    switch (column->kind) {
+        case SHColumnKindString: {
+            uint32_t stringIndex = ((const uint32_t *)column->values)[index];
+            return (stringIndex == SH_NO_STRING) ? nil : _strings[stringIndex];
+        }
+        case SHColumnKindObject: return ((__strong id *)column->values)[index];
+        default: return nil;
+    }
+}
+
+- (long long)longLongValueAtIndex:(NSUInteger)index forKey:(NSString *)key {
+    SHModelColumn *column = [self columnForKey:key descriptor:NULL];
+    if (NULL == column || index >= _count) {
+        return 0;
+    }
+    switch (column->kind) {
+        case SHColumnKindInteger: return ((const long long *)column->values)[index];
+        case SHColumnKindDouble: return (long long)((const double *)column->values)[index];
+        default: return 0;
+    }
+}
+
+- (double)doubleValueAtIndex:(NSUInteger)index forKey:(NSString *)key {
+    SHModelColumn *column = [self columnForKey:key descriptor:NULL];
+    if (NULL == column || index >= _count) {
+        return 0;
+    }
+    switch (column->kind) {
+        case SHColumnKindInteger: return (double)((const long long *)column->values)[index];
+        case SHColumnKindDouble: return ((const double *)column->values)[index];
+        default: return 0;
+    }
+}
+
+#pragma mark - Model objects
+
+- (id)objectAtIndex:(NSUInteger)index {
+    NSAssert(index < _count, @"index %lu beyond bounds of %lu rows", (unsigned long)index, (unsigned long)_count);
+    SHModelObject *object = [[_modelClass alloc] initWithDictionary:nil context:_context];
+    NSArray *ivars = _plan.ivars;
+    for (NSUInteger i = 0; i < _columnCount; i++) {
+        SHModelIvarDescriptor *descriptor = ivars[i];
+        switch (_columns[i].kind) {
+            case SHColumnKindInteger: {
+                long long value = ((const long long *)_columns[i].values)[index];
+                if (!SHModelSetIvarLongLong(object, descriptor, value)) {
+                    SHModelSetIvarValue(object, descriptor, @(value));
+                }
+            } break;
+            case SHColumnKindDouble: {
+                double value = ((const double *)_columns[i].values)[index];
+                if (!SHModelSetIvarDouble(object, descriptor, value)) {
+                    SHModelSetIvarValue(object, descriptor, @(value));
+                }
+            } break;
+            case SHColumnKindString:
+            case SHColumnKindObject: {
+                id value = [self objectInColumn:&_columns[i] atIndex:index];
+                if (value) {
+                    SHModelSetIvarValue(object, descriptor, value);
+                }
+            } break;
+            default: break;
+        }
+    }
+    return object;
+}
+
+- (NSArray *)allObjects {
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:_count];
+    for (NSUInteger i = 0; i < _count; i++) {
+        [objects addObject:[self objectAtIndex:i]];
+    }
+    return objects;
+}
+
+#pragma mark - Aggregates
+
+- (SHModelColumn *)numericColumnForKey:(NSString *)key {
+    SHModelColumn *column = [self columnForKey:key descriptor:NULL];
+    if (NULL == column || (column->kind != SHColumnKindInteger && column->kind != SHColumnKindDouble)) {
+        return NULL;
+    }
+    return column;
+}
+
+- (BOOL)isNumericKey:(NSString *)key {
+    return NULL != [self numericColumnForKey:key];
+}
+
+- (NSNumber *)sumForKey:(NSString *)key {
+    SHModelColumn *column = [self numericColumnForKey:key];
+    if (NULL == column) {
+        return nil;
+    }
+    if (column->kind == SHColumnKindInteger) {
+        return @(SHSumIntegers((const long long *)column->values, _count));
+    }
+    return @(SHSumDoubles((const double *)column->values, _count));
+}
+
+- (NSNumber *)minimumForKey:(NSString *)key {
+    return [self rangeForKey:key minimum:YES];
+}
+
+- (NSNumber *)maximumForKey:(NSString *)key {
+    return [self rangeForKey:key minimum:NO];
+}
+
+- (NSNumber *)rangeForKey:(NSString *)key minimum:(BOOL)minimum {
+    SHModelColumn *column = [self numericColumnForKey:key];
+    if (NULL == column || 0 == _count) {
+        return nil;
+    }
+    if (column->kind == SHColumnKindInteger) {
+        long long min = 0;
+        long long max = 0;
+        SHIntegerRange((const long long *)column->values, _count, &min, &max);
+        return @(minimum ? min : max);
+    }
+    double min = 0;
+    double max = 0;
+    SHDoubleRange((const double *)column->values, _count, &min, &max);
+    return @(minimum ? min : max);
+}
+
+- (NSIndexSet *)indexesForKey:(NSString *)key from:(double)minimum to:(double)maximum {
+    SHModelColumn *column = [self numericColumnForKey:key];
+    if (NULL == column) {
+        return nil;
+    }
+
+    // one byte per row, filled without branches and turned into ranges afterwards
+    uint8_t *matches = (uint8_t *)malloc(MAX(_count, 1));
+    if (column->kind == SHColumnKindInteger) {
+        const long long *values = (const long long *)column->values;
+        for (NSUInteger i = 0; i < _count; i++) {
+            double value = (double)values[i];
+            matches[i] = (uint8_t)((value >= minimum) & (value <= maximum));
+        }
+    } else {
+        const double *values = (const double *)column->values;
+        for (NSUInteger i = 0; i < _count; i++) {
+            matches[i] = (uint8_t)((values[i] >= minimum) & (values[i] <= maximum));
+        }
+    }
+
+    NSMutableIndexSet *indexes = [NSMutableIndexSet indexSet];
+    NSUInteger i = 0;
+    while (i < _count) {
+        if (!matches[i]) {
+            i++;
+            continue;
+        }
+        NSUInteger start = i;
+        while (i < _count && matches[i]) {
+            i++;
+        }
+        [indexes addIndexesInRange:NSMakeRange(start, i - start)];
+    }
+    free(matches);
+    return indexes;
+}
+
+- (SHModelCollection *)collectionWithIndexes:(NSIndexSet *)indexes {
+    NSUInteger count = [indexes count];
+    NSUInteger *rows = (NSUInteger *)malloc(MAX(count, 1) * sizeof(NSUInteger));
+    [indexes getIndexes:rows maxCount:count inIndexRange:NULL];
+    NSUInteger valid = 0;
+    for (NSUInteger i = 0; i < count; i++) {
+        if (rows[i] < _count) {
+            rows[valid++] = rows[i];
+        }
+    }
+    SHModelCollection *collection = [self collectionWithRows:rows count:valid];
+    free(rows);
+    return collection;
+}
+
+- (SHModelCollection *)collectionSortedByKey:(NSString *)key ascending:(BOOL)ascending {
+    SHModelColumn *column = [self numericColumnForKey:key];
+    if (NULL == column) {
+        return nil;
+    }
+
+    NSUInteger *rows = (NSUInteger *)malloc(MAX(_count, 1) * sizeof(NSUInteger));
+    // descending orders sort inverted values ascending, so equal values keep their order too
+    if (column->kind == SHColumnKindInteger) {
+        const long long *values = (const long long *)column->values;
+        SHIntegerSortKey *keys = (SHIntegerSortKey *)malloc(MAX(_count, 1) * sizeof(SHIntegerSortKey));
+        for (NSUInteger i = 0; i < _count; i++) {
+            // `~` reverses the order of all values, unlike `-` it cannot overflow
+            keys[i].value = ascending ? values[i] : ~values[i];
+            keys[i].row = i;
+        }
+        qsort(keys, _count, sizeof(SHIntegerSortKey), SHCompareIntegerSortKeys);
+        for (NSUInteger i = 0; i < _count; i++) {
+            rows[i] = keys[i].row;
+        }
+        free(keys);
+    } else {
+        const double *values = (const double *)column->values;
+        SHDoubleSortKey *keys = (SHDoubleSortKey *)malloc(MAX(_count, 1) * sizeof(SHDoubleSortKey));
+        for (NSUInteger i = 0; i < _count; i++) {
+            keys[i].value = ascending ? values[i] : -values[i];
+            keys[i].row = i;
+        }
+        qsort(keys, _count, sizeof(SHDoubleSortKey), SHCompareDoubleSortKeys);
+        for (NSUInteger i = 0; i < _count; i++) {
+            rows[i] = keys[i].row;
+        }
+        free(keys);
+    }
+
+    SHModelCollection *collection = [self collectionWithRows:rows count:_count];
+    free(rows);
+    return collection;
+}
+
+// a new collection with the rows in the given order, the string table is shared
+- (SHModelCollection *)collectionWithRows:(const NSUInteger *)rows count:(NSUInteger)count {
+    SHModelCollection *collection =
+        [[SHModelCollection alloc] initWithModelClass:_modelClass context:_context capacity:count];
+    collection->_strings = _strings;
+    for (NSUInteger i = 0; i < _columnCount; i++) {
+        void *target = collection->_columns[i].values;
+        void *source = _columns[i].values;
+        switch (_columns[i].kind) {
+            case SHColumnKindInteger: {
+                for (NSUInteger j = 0; j < count; j++) {
+                    ((long long *)target)[j] = ((long long *)source)[rows[j]];
+                }
+            } break;
+            case SHColumnKindDouble: {
+                for (NSUInteger j = 0; j < count; j++) {
+                    ((double *)target)[j] = ((double *)source)[rows[j]];
+                }
+            } break;
+            case SHColumnKindString: {
+                for (NSUInteger j = 0; j < count; j++) {
+                    ((uint32_t *)target)[j] = ((uint32_t *)source)[rows[j]];
+                }
+            } break;
+            case SHColumnKindObject: {
+                for (NSUInteger j = 0; j < count; j++) {
+                    ((__strong id *)target)[j] = ((__strong id *)source)[rows[j]];
+                }
+            } break;
+            default: break;
+        }
+    }
+    collection->_count = count;
+    return collection;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p %lu %@ rows>", NSStringFromClass([self class]), self,
+                                      (unsigned long)_count, NSStringFromClass(_modelClass)];
+}
+
+@end
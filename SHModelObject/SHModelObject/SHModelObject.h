@@ -23,13 +23,14 @@
 #import <Foundation/Foundation.h>
 #import "SHModelSerialization.h"
 #import "SHConstants.h"
+#import "SHDecodingContext.h"
 
 /**
  *  The `SHModelObject` is a base class that uses objective-c runtime to populate a modal class instance variables
  *  by passing a NSDictionary to it. The NSDictionary key is compared with the instance variable name and the value is
  *  populated to the variable.
  */
-@interface SHModelObject : NSObject <SHModelSerialization, NSCoding>
+@interface SHModelObject : NSObject <SHModelSerialization, NSCoding, NSCopying>
 
 /**
  *  class initializer
@@ -89,6 +90,16 @@
                 inputDateFormatter:(NSDateFormatter *)inputDateFormatter
                           mappings:(NSDictionary *)mapping;
 
+/**
+ *  class initializer, the other initializers create a context from their options and call it.
+ *
+ *  @param dictionary dictionary containing key/value pairs for the object
+ *  @param context `SHDecodingContext` with the date options and mappings, nil for the default context
+ *
+ *  @return object of type instancetype populated with the values from `dictionary`
+ */
+- (instancetype)initWithDictionary:(NSDictionary *)dictionary context:(SHDecodingContext *)context;
+
 /**
  *  static variant of class initializer with nil check for the dictionary passed
  *
@@ -159,6 +170,143 @@
                   inputDateFormatter:(NSDateFormatter *)inputDateFormatter
                             mappings:(NSDictionary *)mapping;
 
+/**
+ *  static variant of class initializer with nil check for the dictionary passed. nested models and the models in
+ *  mapped arrays are decoded with the same context.
+ *
+ *  @param dictionary dictionary containing key/value pairs for the object
+ *  @param context `SHDecodingContext` with the date options and mappings, nil for the default context
+ *
+ *  @return object of type instancetype populated with the values from `dictionary`
+ */
++ (instancetype)objectWithDictionary:(NSDictionary *)dictionary context:(SHDecodingContext *)context;
+
+/**
+ *  decodes only the fields in `keys`, with the options of the default context. other values are skipped and their
+ *  ivars stay nil or zero. dotted paths like `author.name` select fields of nested models and of the models in
+ *  mapped arrays, see `-[SHDecodingContext contextWithOnlyKeys:]`. the paths are parsed on every call, keep a
+ *  projected context when decoding many objects.
+ *
+ *  the projection only applies to this call, later updates of the object decode all fields. objects decoded with
+ *  only some fields are not shared through the identity map of a `SHDecodingSession`.
+ *
+ *  @param dictionary dictionary containing key/value pairs for the object
+ *  @param keys set of ivar or property names and dotted paths
+ *
+ *  @return object of type instancetype populated with the values of `keys` from `dictionary`
+ */
++ (instancetype)objectWithDictionary:(NSDictionary *)dictionary onlyKeys:(NSSet *)keys;
+
+/**
+ *  creates an object for every dictionary in `array`, like calling `objectWithDictionary:` for each of them. when the
+ *  class returns `YES` from `decodesArraysInParallel`, arrays longer than `parallelBatchThreshold` are split into
+ *  chunks of `batchGrainSize` dictionaries which are created on all cores. the order of `array` is kept, items that are
+ *  not dictionaries are skipped.
+ *
+ *  @param array array of dictionaries
+ *
+ *  @return array of objects of the receiving class, nil if `array` is not an array
+ */
++ (NSArray *)objectsWithArray:(NSArray *)array;
+
+/**
+ *  array variant of `objectWithDictionary:mappings:`, see `objectsWithArray:`
+ *
+ *  @param array array of dictionaries
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return array of objects of the receiving class, nil if `array` is not an array
+ */
++ (NSArray *)objectsWithArray:(NSArray *)array mappings:(NSDictionary *)mapping;
+
+/**
+ *  array variant of `objectWithDictionary:dateConversionOption:inputDateType:mappings:`, see `objectsWithArray:`
+ *
+ *  @param array array of dictionaries
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateType `kInputDateFormat` to determine what what is the input format of the date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return array of objects of the receiving class, nil if `array` is not an array
+ */
++ (NSArray *)objectsWithArray:(NSArray *)array
+         dateConversionOption:(kDateConversionOption)option
+                inputDateType:(kInputDateFormat)inputDateType
+                     mappings:(NSDictionary *)mapping;
+
+/**
+ *  array variant of `objectWithDictionary:dateConversionOption:inputDateFormat:mappings:`, see `objectsWithArray:`
+ *
+ *  @param array array of dictionaries
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateFormat NSDateFormatter format specifier which will be used to format the input date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return array of objects of the receiving class, nil if `array` is not an array
+ */
++ (NSArray *)objectsWithArray:(NSArray *)array
+         dateConversionOption:(kDateConversionOption)option
+              inputDateFormat:(NSString *)inputDateFormat
+                     mappings:(NSDictionary *)mapping;
+
+/**
+ *  array variant of `objectWithDictionary:dateConversionOption:inputDateFormatter:mappings:`, see
+ *  `objectsWithArray:`. the formatter is used from several threads at once.
+ *
+ *  @param array array of dictionaries
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateFormatter NSDateFormatter object which will be used to format the input date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return array of objects of the receiving class, nil if `array` is not an array
+ */
++ (NSArray *)objectsWithArray:(NSArray *)array
+         dateConversionOption:(kDateConversionOption)option
+           inputDateFormatter:(NSDateFormatter *)inputDateFormatter
+                     mappings:(NSDictionary *)mapping;
+
+/**
+ *  array variant of `objectWithDictionary:context:`, see `objectsWithArray:`. all objects share the context, the
+ *  variants with options create one context for the whole array.
+ *
+ *  @param array array of dictionaries
+ *  @param context `SHDecodingContext` with the date options and mappings, nil for the default context
+ *
+ *  @return array of objects of the receiving class, nil if `array` is not an array
+ */
++ (NSArray *)objectsWithArray:(NSArray *)array context:(SHDecodingContext *)context;
+
+/**
+ *  array variant of `objectWithDictionary:onlyKeys:`, the paths are parsed once for the whole array.
+ *
+ *  @param array array of dictionaries
+ *  @param keys set of ivar or property names and dotted paths
+ *
+ *  @return array of objects of the receiving class, nil if `array` is not an array
+ */
++ (NSArray *)objectsWithArray:(NSArray *)array onlyKeys:(NSSet *)keys;
+
+/**
+ *  return `YES` to create the objects of large arrays on all cores, see `objectsWithArray:`. the class and everything
+ *  it decodes (setters, value transformers, nested models) must then be safe to run on several threads at once.
+ *  classes overriding `serializeValue:withKey:` are always created on the calling thread. `NO` by default.
+ *
+ *  @return `YES` to decode arrays of this class in parallel
+ */
++ (BOOL)decodesArraysInParallel;
+
+// arrays with fewer dictionaries are created on the calling thread. 1024 by default. also used for mapped arrays
+// inside a dictionary. shared by all classes, can be changed from any thread.
++ (NSUInteger)parallelBatchThreshold;
++ (void)setParallelBatchThreshold:(NSUInteger)threshold;
+
+// number of dictionaries created by one parallel work item. 256 by default.
++ (NSUInteger)batchGrainSize;
++ (void)setBatchGrainSize:(NSUInteger)grainSize;
+
 /**
  *  update the instance with new dictionary values
  *
@@ -217,6 +365,262 @@
                   inputDateFormatter:(NSDateFormatter *)inputDateFormatter
                             mappings:(NSDictionary *)mapping;
 
+/**
+ *  update the instance with new dictionary values. the instance keeps the context for later updates and exports.
+ *
+ *  @param dictionary dictionary containing key/value pairs for the object
+ *  @param context `SHDecodingContext` with the date options and mappings, nil for the default context
+ *
+ *  @return object of type instancetype populated with the values from `dictionary`
+ */
+- (instancetype)updateWithDictionary:(NSDictionary *)dictionary context:(SHDecodingContext *)context;
+
+// the context the instance was decoded with, `+[SHDecodingContext defaultContext]` for objects created with `init`
+@property (nonatomic, readonly) SHDecodingContext *decodingContext;
+
+/**
+ *  static variant of class initializer that decodes UTF-8 encoded JSON data straight into the instance variables,
+ *  without creating the intermediate NSDictionary. keys that do not match an ivar are skipped without allocating and
+ *  numbers are written straight into primitive ivars. subclasses that override `serializeValue:withKey:` still get
+ *  every key and value.
+ *
+ *  @param data JSON data, the top level value must be an object
+ *
+ *  @return object of type instancetype populated with the values from `data`, nil if `data` is not a valid JSON object
+ */
++ (instancetype)objectWithJSONData:(NSData *)data;
+
+/**
+ *  JSON data variant of `objectWithDictionary:mappings:`
+ *
+ *  @param data JSON data, the top level value must be an object
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return object of type instancetype populated with the values from `data`, nil if `data` is not a valid JSON object
+ */
++ (instancetype)objectWithJSONData:(NSData *)data mappings:(NSDictionary *)mapping;
+
+/**
+ *  JSON data variant of `objectWithDictionary:dateConversionOption:inputDateType:mappings:`
+ *
+ *  @param data JSON data, the top level value must be an object
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateType `kInputDateFormat` to determine what what is the input format of the date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return object of type instancetype populated with the values from `data`, nil if `data` is not a valid JSON object
+ */
++ (instancetype)objectWithJSONData:(NSData *)data
+              dateConversionOption:(kDateConversionOption)option
+                     inputDateType:(kInputDateFormat)inputDateType
+                          mappings:(NSDictionary *)mapping;
+
+/**
+ *  JSON data variant of `objectWithDictionary:dateConversionOption:inputDateFormat:mappings:`
+ *
+ *  @param data JSON data, the top level value must be an object
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateFormat NSDateFormatter format specifier which will be used to format the input date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return object of type instancetype populated with the values from `data`, nil if `data` is not a valid JSON object
+ */
++ (instancetype)objectWithJSONData:(NSData *)data
+              dateConversionOption:(kDateConversionOption)option
+                   inputDateFormat:(NSString *)inputDateFormat
+                          mappings:(NSDictionary *)mapping;
+
+/**
+ *  JSON data variant of `objectWithDictionary:dateConversionOption:inputDateFormatter:mappings:`
+ *
+ *  @param data JSON data, the top level value must be an object
+ *  @param option `kDateConverstionOption` to determine what to do when the value from dictionary is a DOT.NET Date
+ *type.
+ *  @param inputDateFormatter NSDateFormatter object which will be used to format the input date.
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return object of type instancetype populated with the values from `data`, nil if `data` is not a valid JSON object
+ */
++ (instancetype)objectWithJSONData:(NSData *)data
+              dateConversionOption:(kDateConversionOption)option
+                inputDateFormatter:(NSDateFormatter *)inputDateFormatter
+                          mappings:(NSDictionary *)mapping;
+
+/**
+ *  JSON data variant of `objectWithDictionary:context:`
+ *
+ *  @param data JSON data, the top level value must be an object
+ *  @param context `SHDecodingContext` with the date options and mappings, nil for the default context
+ *
+ *  @return object of type instancetype populated with the values from `data`, nil if `data` is not a valid JSON object
+ */
++ (instancetype)objectWithJSONData:(NSData *)data context:(SHDecodingContext *)context;
+
+/**
+ *  update the instance with the values from JSON data, using the options the instance was created with.
+ *
+ *  @param data JSON data, the top level value must be an object
+ *
+ *  @return the instance, nil if `data` is not a valid JSON object. values read before the error are kept.
+ */
+- (instancetype)updateWithJSONData:(NSData *)data;
+
+/**
+ *  update the instance with new dictionary values, storing only the values that differ from the current ones. the
+ *  options the instance was created with are used. primitive ivars are compared without boxing them, objects with
+ *  `isEqual:`, so unchanged keys cost a comparison and send no KVO notification.
+ *
+ *  keys missing in the dictionary are left untouched, so the dictionary can be a patch. nested models and mapped
+ *  arrays of the same length are patched in place the same way, their key counts as changed when any of their
+ *  values changed. objects sharing them see the change too: objects with the same primary key from the identity map
+ *  of a `SHDecodingSession`, and copies made with `copy`. update a `deepCopy` to keep the original as it is.
+ *
+ *  classes that override `serializeValue:withKey:` hand every value to the override, which is not known to compare
+ *  it, so every key of `dictionary` is reported as changed. so is the key of a lazy value that was not decoded yet,
+ *  see `decodesNestedObjectsLazily`: it is replaced without comparing, which would decode it.
+ *
+ *  @param dictionary dictionary containing key/value pairs for the object
+ *
+ *  @return the keys of `dictionary` whose values changed the instance
+ */
+- (NSSet *)changedKeysByUpdatingWithDictionary:(NSDictionary *)dictionary;
+
+/**
+ *  dictionary with the values of all instance variables, the reverse of `objectWithDictionary:`. nested models and
+ *  models inside arrays and dictionaries are converted too, nil values are left out. dates are written as strings in
+ *  the input date format of the instance (.NET JSON dates by default). time intervals stay numbers, they are not
+ *  known apart from other `double` values.
+ *
+ *  @return the dictionary, keys are the ivar names without leading underscores
+ */
+- (NSDictionary *)dictionaryRepresentation;
+
+/**
+ *  see `dictionaryRepresentation`
+ *
+ *  @param keyStyle `kOutputKeyStyle` of the keys
+ *
+ *  @return the dictionary
+ */
+- (NSDictionary *)dictionaryRepresentationWithKeyStyle:(kOutputKeyStyle)keyStyle;
+
+/**
+ *  UTF-8 encoded JSON with the values `dictionaryRepresentation` would contain. the ivars are written straight into
+ *  one buffer, no dictionary is created.
+ *
+ *  @return the JSON data, nil if a value cannot be written as JSON (e.g. NaN or an NSData)
+ */
+- (NSData *)JSONDataRepresentation;
+
+/**
+ *  see `JSONDataRepresentation`
+ *
+ *  @param keyStyle `kOutputKeyStyle` of the keys
+ *
+ *  @return the JSON data, nil if a value cannot be written as JSON
+ */
+- (NSData *)JSONDataRepresentationWithKeyStyle:(kOutputKeyStyle)keyStyle;
+
+/**
+ *  version of the class in `SHModelArchiver` archives, 0 by default. ivars can be added and removed without changing
+ *  it. override it and return a new number when the meaning of archived values changes, archives written with
+ *  another version are rejected then.
+ *
+ *  @return the archive version of the class
+ */
++ (NSUInteger)archiveVersion;
+
+/**
+ *  return `YES` to decode nested models and mapped arrays of models only when they are used. the ivar holds a
+ *  `SHLazyValue` with the source dictionary or array (or a copy of its JSON bytes) until the first message reaches
+ *  it, so objects whose nested values are never read only pay for their own fields. `NO` by default.
+ *
+ *  lazy values forward every message and answer `isKindOfClass:` like the decoded value. read ivars with the runtime
+ *  only after `SHLazyValueResolve`. `SHLazyValue` counts how many lazy values were created and forced. a lazy value
+ *  created inside `-[SHDecodingSession performDecoding:]` keeps the session and is decoded with it, through its
+ *  identity map and interned strings, whenever it is forced.
+ *
+ *  @return `YES` to decode nested objects lazily
+ */
++ (BOOL)decodesNestedObjectsLazily;
+
+/**
+ *  registers a transformer for ivars of a class, e.g. to decode `NSURL` ivars from strings. values that already have
+ *  the class are stored as they are, exporting uses the reverse transformation if the transformer has one. a
+ *  `SHModelSchemaTransformerKey` in the schema of a field wins over it.
+ *
+ *  transformers are chosen once per model class, register them before the first object of the class is decoded.
+ *
+ *  @param transformer the transformer, nil to remove it
+ *  @param cls class of the ivars, also used for ivars of its subclasses
+ */
++ (void)setValueTransformer:(NSValueTransformer *)transformer forClass:(Class)cls;
+
+/**
+ *  clears the instance so it can be filled again with `updateWithDictionary:`, used by `SHModelObjectPool`. every
+ *  ivar of the class is set to nil or zero straight through the cached ivar layout, without setters or KVO
+ *  notifications, and the date conversion options and mappings are set back to their defaults.
+ *
+ *  subclasses keeping state outside their ivars (caches, observers) override it and call super.
+ */
+- (void)prepareForReuse;
+
+/**
+ *  objects are equal when they have the same class and the same values, so they can be deduplicated in sets and
+ *  diffed without `valueForKey:`. primitive ivars are compared through the cached ivar layout, integers as raw
+ *  memory and floating point values by value (`0.0` equals `-0.0`, a NaN equals nothing), structs without their
+ *  padding. object ivars are compared with `isEqual:`, which compares nested models the same way.
+ *  lazy values are decoded first. models referring to each other in a cycle (a parent and its children) are fine: a
+ *  pair of objects reached again while it is being compared counts as equal, an object reached again while it is
+ *  being hashed adds nothing to the hash.
+ *
+ *  `hash` uses only the `+primaryKey` ivar when the class declares one, otherwise every ivar. like any value that
+ *  can change, do not change an object while it is in a set or a dictionary key.
+ *
+ *  @param object the other object
+ *
+ *  @return `YES` if the object has the same class and equal ivars
+ */
+- (BOOL)isEqual:(id)object;
+
+/**
+ *  a copy with the same ivars and decoding context. primitive ivars are copied as raw memory, object ivars are
+ *  shared with the receiver (nested models and arrays too, see `deepCopy`). custom setters are not called.
+ *
+ *  @param zone ignored
+ *
+ *  @return the copy
+ */
+- (id)copyWithZone:(NSZone *)zone;
+
+/**
+ *  like `copy`, but nested models and the arrays and dictionaries holding them are copied too, down to the last
+ *  level. other objects (strings, numbers, dates) are shared. a model reached twice is copied once, so cycles and
+ *  shared children keep their shape in the copy.
+ *
+ *  @return the copy
+ */
+- (instancetype)deepCopy;
+
+/**
+ *  builds the decoding plans of the classes on a background queue, so the first decode of each class does not pay for
+ *  the runtime introspection of its ivars and its `+modelSchema`. the classes of nested models and of the element
+ *  classes in the schema are prewarmed too. call it early at launch with the classes of the first screen.
+ *
+ *  @param classes array of `SHModelObject` subclasses
+ */
++ (void)prewarmClasses:(NSArray *)classes;
+
+/**
+ *  like `prewarmClasses:`
+ *
+ *  @param classes array of `SHModelObject` subclasses
+ *  @param completion called on the background queue once all plans are built, may be nil
+ */
++ (void)prewarmClasses:(NSArray *)classes completion:(void (^)(void))completion;
+
 @end
 
 @interface NSString (Additions)
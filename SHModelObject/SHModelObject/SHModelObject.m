@@ -22,63 +22,74 @@
 
 #import "SHModelObject.h"
 #import <objc/runtime.h>
+#import <pthread.h>
+#import "SHModelClassPlan.h"
+#import "SHKeyNormalizer.h"
+#import "SHDateParsing.h"
+#import "SHJSONReader.h"
+#import "SHLazyValue.h"
+#import "SHJSONWriter.h"
+#import "SHDecodingStatistics.h"
+#import "SHDecodingSession.h"
+#import "SHDecodingContext.h"
 
-/**
- *  trims a given NSString
- *
- *  @param val the NSString to be trimmed
- *
- *  @return trimmed NSString
- */
-#define TRIM_STRING(val) [val stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]]
-
-/**
- *  checks if a NSString is valid
- *
- *  @param val a NSString to be checked
- *
- *  @return `YES` or `NO` based on the validity of the NSString
- */
-#define IS_VALID_STRING(val)                                                                                           \
-    (val != nil) && [val length] != 0 && ([TRIM_STRING(val) length] != 0) && ![val isEqualToString:@"(null)"]
-
-// pattern to strip from the dictionary key and ivarname for comparision
-#define PATTERN_TO_STRIP @"-_ "
-
-static NSDateFormatter *_simpleDateFormatter;
-static NSDateFormatter *_timezoneDateFormatter;
-static NSDateFormatter *_customFormatter;
+// deepest nesting of models and collections when exporting, deeper graphs are cycles
+#define MAX_EXPORT_DEPTH 512
+
+@interface SHModelObject () <SHModelValueConverting>
+
+// `deepCopy` sharing the copies made so far, models reached twice are copied once
+- (instancetype)deepCopyWithCopies:(NSMapTable *)copies;
+
+@end
 
 @implementation SHModelObject {
-    Ivar *_ivars;
-    unsigned int _outCount;
-    kDateConversionOption _converstionOption;
-    kInputDateFormat _inputDateFormat;
-    NSDictionary *_mappings;
-    NSString *_customInputDateFormatString;
+    SHModelClassPlan *_plan;
+    // date options and mappings, handed down to nested models. nil means the default context.
+    SHDecodingContext *_context;
+    // statistics of the class while `updateWithDictionary:` runs, NULL when they are disabled
+    SHDecodingCounters *_counters;
 }
 
 #pragma mark - Factory methods for object creation
-//
-+ (instancetype)objectWithDictionary:(NSDictionary *)dictionary {
-    if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
-        return nil;
-    }
 
-    if ([dictionary isKindOfClass:[NSNull class]]) {
-        return nil;
+// context for the options of the legacy variants, the shared default context when they match it
+static SHDecodingContext *SHContextWithOptions(kDateConversionOption option,
+                                               kInputDateFormat inputDateType,
+                                               NSDictionary *mapping) {
+    if (option == kDateConverstionFromNSStringToNSStringOption && inputDateType == kInputDateFormatJSON &&
+        [mapping count] == 0) {
+        return [SHDecodingContext defaultContext];
     }
-    return [[[self class] alloc] initWithDictionary:dictionary];
+    return [[SHDecodingContext alloc] initWithDateConversionOption:option inputDateType:inputDateType mappings:mapping];
 }
 
-+ (instancetype)objectWithDictionary:(NSDictionary *)dictionary mappings:(NSDictionary *)mapping {
-    if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
-        return nil;
-    }
+// `YES` if the projection of the context leaves the field out, see `-[SHDecodingContext contextWithOnlyKeys:]`
+static inline BOOL SHContextSkipsIvar(SHDecodingContext *context, SHModelIvarDescriptor *descriptor) {
+    return context.onlyKeys && nil == [context contextForIvar:descriptor];
+}
 
-    if ([dictionary isKindOfClass:[NSNull class]]) {
-        return nil;
+// lazy values are forced after `performDecoding:` returned, they decode under the session current when created
+static SHLazyValue *SHLazyValueWithCurrentSession(id (^decode)(void)) {
+    SHDecodingSession *session = [SHDecodingSession currentSession];
+    if (nil == session) {
+        return [[SHLazyValue alloc] initWithBlock:decode];
     }
+    return [[SHLazyValue alloc] initWithBlock:^id {
+        __block id value = nil;
+        [session performDecoding:^{
+            value = decode();
+        }];
+        return value;
+    }];
+}
+
+//
++ (instancetype)objectWithDictionary:(NSDictionary *)dictionary {
+    return [self objectWithDictionary:dictionary context:[SHDecodingContext defaultContext]];
+}
+
++ (instancetype)objectWithDictionary:(NSDictionary *)dictionary mappings:(NSDictionary *)mapping {
     return [self objectWithDictionary:dictionary
                  dateConversionOption:kDateConverstionFromNSStringToNSDateOption
                         inputDateType:kInputDateFormatJSON
@@ -92,60 +103,252 @@ static NSDateFormatter *_customFormatter;
     if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
         return nil;
     }
+    return [self objectWithDictionary:dictionary context:SHContextWithOptions(option, inputDateType, mapping)];
+}
 
-    if ([dictionary isKindOfClass:[NSNull class]]) {
++ (instancetype)objectWithDictionary:(NSDictionary *)dictionary
+                dateConversionOption:(kDateConversionOption)option
+                     inputDateFormat:(NSString *)inputDateFormat
+                            mappings:(NSDictionary *)mapping {
+    if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
         return nil;
     }
-    return [[[self class] alloc] initWithDictionary:dictionary
-                               dateConversionOption:option
-                                      inputDateType:inputDateType
-                                           mappings:mapping];
+    return [self objectWithDictionary:dictionary
+                              context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                              inputDateFormat:inputDateFormat
+                                                                                     mappings:mapping]];
 }
 
 + (instancetype)objectWithDictionary:(NSDictionary *)dictionary
                 dateConversionOption:(kDateConversionOption)option
-                     inputDateFormat:(NSString *)inputDateFormat
+                  inputDateFormatter:(NSDateFormatter *)inputDateFormatter
                             mappings:(NSDictionary *)mapping {
     if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
         return nil;
     }
+    return [self objectWithDictionary:dictionary
+                              context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                           inputDateFormatter:inputDateFormatter
+                                                                                     mappings:mapping]];
+}
 
-    if ([dictionary isKindOfClass:[NSNull class]]) {
++ (instancetype)objectWithDictionary:(NSDictionary *)dictionary onlyKeys:(NSSet *)keys {
+    if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
         return nil;
     }
-    return [[[self class] alloc] initWithDictionary:dictionary
-                               dateConversionOption:option
-                                    inputDateFormat:inputDateFormat
-                                           mappings:mapping];
+    return [self objectWithDictionary:dictionary context:[[SHDecodingContext defaultContext] contextWithOnlyKeys:keys]];
 }
 
-+ (instancetype)objectWithDictionary:(NSDictionary *)dictionary
-                dateConversionOption:(kDateConversionOption)option
-                  inputDateFormatter:(NSDateFormatter *)inputDateFormatter
-                            mappings:(NSDictionary *)mapping {
++ (instancetype)objectWithDictionary:(NSDictionary *)dictionary context:(SHDecodingContext *)context {
     if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
         return nil;
     }
 
-    if ([dictionary isKindOfClass:[NSNull class]]) {
+    // objects with only some fields are never shared, the identity map only holds complete objects
+    if (context.onlyKeys) {
+        return [[[self class] alloc] initWithDictionary:dictionary context:context];
+    }
+
+    id primaryKey = nil;
+    id shared = [self sharedObjectForDictionary:dictionary primaryKey:&primaryKey];
+    if (shared) {
+        return shared;
+    }
+    id object = [[[self class] alloc] initWithDictionary:dictionary context:context];
+    return [self shareObject:object primaryKey:primaryKey];
+}
+
+// the object of the current `SHDecodingSession` with the primary key of `dictionary`, see `+primaryKey`
++ (id)sharedObjectForDictionary:(NSDictionary *)dictionary primaryKey:(id *)primaryKey {
+    SHDecodingSession *session = [SHDecodingSession currentSession];
+    if (nil == session) {
+        return nil;
+    }
+    SHModelClassPlan *plan = [SHModelClassPlan planForClass:self rootClass:[SHModelObject class]];
+    *primaryKey = [plan primaryKeyValueInDictionary:dictionary];
+    return *primaryKey ? [session objectOfClass:self primaryKey:*primaryKey] : nil;
+}
+
+// adds a new object to the identity map of the current session, returns the object kept for the key
++ (id)shareObject:(id)object primaryKey:(id)primaryKey {
+    if (nil == primaryKey) {
+        return object;
+    }
+    return [[SHDecodingSession currentSession] addObject:object primaryKey:primaryKey] ?: object;
+}
+
+// like `shareObject:primaryKey:` for an object decoded from JSON data, whose primary key is known only afterwards
+- (instancetype)sharedObject {
+    SHDecodingSession *session = [SHDecodingSession currentSession];
+    SHModelIvarDescriptor *descriptor = session ? [[self classPlan] primaryKeyIvar] : nil;
+    if (nil == descriptor) {
+        return self;
+    }
+    id primaryKey = (descriptor.type == SHIvarTypeObject) ? object_getIvar(self, descriptor.ivar)
+                                                          : SHModelIvarNumber(self, descriptor);
+    return [session addObject:self primaryKey:primaryKey];
+}
+
+#pragma mark - Factory methods for arrays of objects
+
+// arrays shorter than this are always created on the calling thread. both values can be changed while other threads
+// decode, so they are only read and written atomically
+static NSUInteger _parallelBatchThreshold = 1024;
+
+// number of objects created by one parallel work item
+static NSUInteger _batchGrainSize = 256;
+
++ (NSUInteger)parallelBatchThreshold {
+    return __atomic_load_n(&_parallelBatchThreshold, __ATOMIC_RELAXED);
+}
+
++ (void)setParallelBatchThreshold:(NSUInteger)threshold {
+    __atomic_store_n(&_parallelBatchThreshold, threshold, __ATOMIC_RELAXED);
+}
+
++ (NSUInteger)batchGrainSize {
+    return __atomic_load_n(&_batchGrainSize, __ATOMIC_RELAXED);
+}
+
++ (void)setBatchGrainSize:(NSUInteger)grainSize {
+    __atomic_store_n(&_batchGrainSize, MAX(grainSize, 1), __ATOMIC_RELAXED);
+}
+
++ (BOOL)decodesArraysInParallel {
+    return NO;
+}
+
+// a `serializeValue:withKey:` override is not known to be thread safe, such classes are always created serially
+static BOOL SHClassOverridesSerializeValue(Class cls) {
+    SEL serializeSelector = @selector(serializeValue:withKey:);
+    return [cls instanceMethodForSelector:serializeSelector] !=
+           [SHModelObject instanceMethodForSelector:serializeSelector];
+}
+
++ (BOOL)createsArraysInParallel {
+    return [self decodesArraysInParallel] && !SHClassOverridesSerializeValue(self);
+}
+
++ (NSArray *)objectsWithArray:(NSArray *)array {
+    return [self objectsWithArray:array context:[SHDecodingContext defaultContext]];
+}
+
++ (NSArray *)objectsWithArray:(NSArray *)array mappings:(NSDictionary *)mapping {
+    return [self objectsWithArray:array
+             dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                    inputDateType:kInputDateFormatJSON
+                         mappings:mapping];
+}
+
+// the variants with options create one context for all objects of the array
++ (NSArray *)objectsWithArray:(NSArray *)array
+         dateConversionOption:(kDateConversionOption)option
+                inputDateType:(kInputDateFormat)inputDateType
+                     mappings:(NSDictionary *)mapping {
+    if (nil == array || ![array isKindOfClass:[NSArray class]]) {
+        return nil;
+    }
+    return [self objectsWithArray:array context:SHContextWithOptions(option, inputDateType, mapping)];
+}
+
++ (NSArray *)objectsWithArray:(NSArray *)array
+         dateConversionOption:(kDateConversionOption)option
+              inputDateFormat:(NSString *)inputDateFormat
+                     mappings:(NSDictionary *)mapping {
+    if (nil == array || ![array isKindOfClass:[NSArray class]]) {
+        return nil;
+    }
+    return [self objectsWithArray:array
+                          context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                          inputDateFormat:inputDateFormat
+                                                                                 mappings:mapping]];
+}
+
++ (NSArray *)objectsWithArray:(NSArray *)array
+         dateConversionOption:(kDateConversionOption)option
+           inputDateFormatter:(NSDateFormatter *)inputDateFormatter
+                     mappings:(NSDictionary *)mapping {
+    if (nil == array || ![array isKindOfClass:[NSArray class]]) {
+        return nil;
+    }
+    return [self objectsWithArray:array
+                          context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                       inputDateFormatter:inputDateFormatter
+                                                                                 mappings:mapping]];
+}
+
++ (NSArray *)objectsWithArray:(NSArray *)array onlyKeys:(NSSet *)keys {
+    return [self objectsWithArray:array context:[[SHDecodingContext defaultContext] contextWithOnlyKeys:keys]];
+}
+
++ (NSArray *)objectsWithArray:(NSArray *)array context:(SHDecodingContext *)context {
+    return [self objectsWithArray:array
+                       usingBlock:^id(NSDictionary *item) { return [self objectWithDictionary:item context:context]; }];
+}
+
+// creates an object for every dictionary in the array with `block`, in parallel for large arrays of classes that opt
+// in with `decodesArraysInParallel`. the order is kept, items that are not dictionaries are skipped.
++ (NSArray *)objectsWithArray:(NSArray *)array usingBlock:(id (^)(NSDictionary *item))block {
+    if (nil == array || ![array isKindOfClass:[NSArray class]]) {
         return nil;
     }
-    return [[[self class] alloc] initWithDictionary:dictionary
-                               dateConversionOption:option
-                                 inputDateFormatter:inputDateFormatter
-                                           mappings:mapping];
+
+    NSArray *items = [array copy];
+    NSUInteger count = [items count];
+    __strong id *objects = (__strong id *)calloc(MAX(count, 1), sizeof(id));
+
+    void (^createObjects)(NSUInteger, NSUInteger) = ^(NSUInteger start, NSUInteger end) {
+        for (NSUInteger i = start; i < end; i++) {
+            id item = items[i];
+            if ([item isKindOfClass:[NSDictionary class]]) {
+                objects[i] = block(item);
+            } else {
+                SHDecodingCounters *counters = SHDecodingStatisticsEnabled ? SHDecodingCountersForClass(self) : NULL;
+                if (counters) {
+                    SHDecodingCounterAdd(&counters->typeMismatches, 1);
+                }
+                NSLog(@"object %@ is not a NSDictionary object, skipping.", [item description]);
+            }
+        }
+    };
+
+    NSUInteger grainSize = [SHModelObject batchGrainSize];
+    if (count < [SHModelObject parallelBatchThreshold] || count <= grainSize || ![self createsArraysInParallel]) {
+        createObjects(0, count);
+    } else {
+        // every work item fills its own range of `objects`, so no locking is needed
+        size_t chunks = (count + grainSize - 1) / grainSize;
+        // the workers share the session of the calling thread
+        SHDecodingSession *session = [SHDecodingSession currentSession];
+        dispatch_apply(chunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+            @autoreleasepool {
+                void (^createChunk)(void) = ^{
+                    createObjects(chunk * grainSize, MIN((chunk + 1) * grainSize, count));
+                };
+                if (session) {
+                    [session performDecoding:createChunk];
+                } else {
+                    createChunk();
+                }
+            }
+        });
+    }
+
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        if (objects[i]) {
+            [result addObject:objects[i]];
+            objects[i] = nil;
+        }
+    }
+    free(objects);
+    return result;
 }
 
 //
 - (instancetype)initWithDictionary:(NSDictionary *)dictionary;
 {
-    if ((self = [super init])) {
-        return [self updateWithDictionary:dictionary
-                     dateConversionOption:kDateConverstionFromNSStringToNSStringOption
-                            inputDateType:kInputDateFormatJSON
-                                 mappings:nil];
-    }
-    return self;
+    return [self initWithDictionary:dictionary context:[SHDecodingContext defaultContext]];
 }
 
 //
@@ -153,65 +356,283 @@ static NSDateFormatter *_customFormatter;
               dateConversionOption:(kDateConversionOption)option
                      inputDateType:(kInputDateFormat)inputDateType
                           mappings:(NSDictionary *)mapping {
-    if ((self = [super init])) {
-        return [self updateWithDictionary:dictionary
-                     dateConversionOption:option
-                            inputDateType:inputDateType
-                                 mappings:mapping];
-    }
-    return self;
+    return [self initWithDictionary:dictionary context:SHContextWithOptions(option, inputDateType, mapping)];
 }
 
 - (instancetype)initWithDictionary:(NSDictionary *)dictionary
               dateConversionOption:(kDateConversionOption)option
                    inputDateFormat:(NSString *)inputDateFormat
                           mappings:(NSDictionary *)mapping {
-    if ((self = [super init])) {
-        return [self updateWithDictionary:dictionary
-                     dateConversionOption:option
-                          inputDateFormat:inputDateFormat
-                                 mappings:mapping];
-    }
-    return self;
+    return [self initWithDictionary:dictionary
+                            context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                            inputDateFormat:inputDateFormat
+                                                                                   mappings:mapping]];
 }
 
 - (instancetype)initWithDictionary:(NSDictionary *)dictionary
               dateConversionOption:(kDateConversionOption)option
                 inputDateFormatter:(NSDateFormatter *)inputDateFormatter
                           mappings:(NSDictionary *)mapping {
+    return [self initWithDictionary:dictionary
+                            context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                         inputDateFormatter:inputDateFormatter
+                                                                                   mappings:mapping]];
+}
+
+- (instancetype)initWithDictionary:(NSDictionary *)dictionary context:(SHDecodingContext *)context {
     if ((self = [super init])) {
-        return [self updateWithDictionary:dictionary
-                     dateConversionOption:option
-                       inputDateFormatter:inputDateFormatter
-                                 mappings:mapping];
+        return [self updateWithDictionary:dictionary context:context];
     }
     return self;
 }
 
-// NSCoding
-- (NSArray *)propertyNames {
-    NSMutableArray *array = [NSMutableArray array];
++ (NSUInteger)archiveVersion {
+    return 0;
+}
+
++ (BOOL)decodesNestedObjectsLazily {
+    return NO;
+}
 
-    // List of ivars
-    id class = objc_getClass([NSStringFromClass([self class]) UTF8String]);
-    _ivars = class_copyIvarList(class, &_outCount);
++ (void)setValueTransformer:(NSValueTransformer *)transformer forClass:(Class)cls {
+    SHModelSetValueTransformerForClass(transformer, cls);
+}
 
-    // If it match our ivar name, then set it
-    for (unsigned int i = 0; i < _outCount; i++) {
-        Ivar ivar = _ivars[i];
-        NSString *ivarName = [NSString stringWithCString:ivar_getName(ivar) encoding:NSUTF8StringEncoding];
-        [array addObject:ivarName];
+- (void)prepareForReuse {
+    for (SHModelIvarDescriptor *descriptor in [[self classPlan] ivars]) {
+        SHModelClearIvar(self, descriptor);
+    }
+    _context = nil;
+}
+
+- (SHDecodingContext *)decodingContext {
+    return _context ?: [SHDecodingContext defaultContext];
+}
+
+#pragma mark - Equality and copying
+
+// an object `hash` visits, or a pair of objects `isEqual:` compares (`other` is NULL for `hash`)
+typedef struct {
+    const void *object;
+    const void *other;
+} SHVisit;
+
+// the visits in progress on a thread, nested models push theirs on top
+typedef struct {
+    SHVisit *visits;
+    NSUInteger count;
+    NSUInteger capacity;
+} SHVisitStack;
+
+static pthread_key_t _visitStackKey;
+
+static void SHVisitStackFree(void *stack) {
+    free(((SHVisitStack *)stack)->visits);
+    free(stack);
+}
+
+static SHVisitStack *SHCurrentVisitStack(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        pthread_key_create(&_visitStackKey, SHVisitStackFree);
+    });
+    SHVisitStack *stack = pthread_getspecific(_visitStackKey);
+    if (NULL == stack) {
+        stack = calloc(1, sizeof(SHVisitStack));
+        pthread_setspecific(_visitStackKey, stack);
+    }
+    return stack;
+}
+
+// pushes a visit, `NO` if it is in progress already: the models refer to each other in a cycle
+static BOOL SHVisitStackPush(SHVisitStack *stack, id object, id other) {
+    const void *objectPointer = (__bridge const void *)object;
+    const void *otherPointer = (__bridge const void *)other;
+    for (NSUInteger i = 0; i < stack->count; i++) {
+        if (stack->visits[i].object == objectPointer && stack->visits[i].other == otherPointer) {
+            return NO;
+        }
+    }
+    if (stack->count == stack->capacity) {
+        stack->capacity = MAX(stack->capacity * 2, 16);
+        stack->visits = realloc(stack->visits, stack->capacity * sizeof(SHVisit));
+    }
+    stack->visits[stack->count++] = (SHVisit){ objectPointer, otherPointer };
+    return YES;
+}
+
+- (BOOL)isEqual:(id)object {
+    if (object == self) {
+        return YES;
+    }
+    if (nil == object || [object class] != [self class]) {
+        return NO;
+    }
+
+    SHModelClassPlan *plan = [self classPlan];
+    if (![plan primitiveIvarsOfObject:self equalToObject:object]) {
+        return NO;
+    }
+    if ([plan.objectIvars count] == 0) {
+        return YES;
+    }
+    // a pair compared further up the cycle is not compared again, the comparison in progress decides
+    SHVisitStack *stack = SHCurrentVisitStack();
+    if (!SHVisitStackPush(stack, self, object)) {
+        return YES;
+    }
+    BOOL equal = YES;
+    for (SHModelIvarDescriptor *descriptor in plan.objectIvars) {
+        id value = SHLazyValueResolve(object_getIvar(self, descriptor.ivar));
+        id otherValue = SHLazyValueResolve(object_getIvar(object, descriptor.ivar));
+        if (value != otherValue && ![value isEqual:otherValue]) {
+            equal = NO;
+            break;
+        }
+    }
+    stack->count--;
+    return equal;
+}
+
+- (NSUInteger)hash {
+    SHModelClassPlan *plan = [self classPlan];
+    // equal objects have the same primary key, it is enough to spread them
+    SHModelIvarDescriptor *primaryKey = plan.primaryKeyIvar;
+    if (primaryKey) {
+        return (primaryKey.type == SHIvarTypeObject) ? [SHLazyValueResolve(object_getIvar(self, primaryKey.ivar)) hash]
+                                                     : [SHModelIvarNumber(self, primaryKey) hash];
+    }
+
+    NSUInteger hash = [plan primitiveIvarsHashOfObject:self];
+    if ([plan.objectIvars count] == 0) {
+        return hash;
+    }
+    // an object hashed further up the cycle adds nothing
+    SHVisitStack *stack = SHCurrentVisitStack();
+    if (!SHVisitStackPush(stack, self, nil)) {
+        return 0;
+    }
+    for (SHModelIvarDescriptor *descriptor in plan.objectIvars) {
+        hash = hash * 31 + [SHLazyValueResolve(object_getIvar(self, descriptor.ivar)) hash];
+    }
+    stack->count--;
+    return hash;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    SHModelObject *copy = [[[self class] allocWithZone:zone] init];
+    SHModelClassPlan *plan = [self classPlan];
+    [plan copyPrimitiveIvarsFromObject:self toObject:copy];
+    for (SHModelIvarDescriptor *descriptor in plan.objectIvars) {
+        // pending lazy values are shared too, the value is decoded once for both objects
+        id value = object_getIvar(self, descriptor.ivar);
+        if (value) {
+            SHModelStoreIvarObject(copy, descriptor, value);
+        }
+    }
+    copy->_context = _context;
+    return copy;
+}
+
+// models, and arrays and dictionaries that may hold models, are copied. other values are shared.
+static id SHDeepCopiedValue(id value, NSMapTable *copies) {
+    value = SHLazyValueResolve(value);
+    if ([value isKindOfClass:[SHModelObject class]]) {
+        return [value deepCopyWithCopies:copies];
+    }
+    if ([value isKindOfClass:[NSArray class]]) {
+        NSMutableArray *array = [NSMutableArray arrayWithCapacity:[value count]];
+        for (id item in value) {
+            [array addObject:SHDeepCopiedValue(item, copies)];
+        }
+        return [value isKindOfClass:[NSMutableArray class]] ? array : [array copy];
+    }
+    if ([value isKindOfClass:[NSDictionary class]]) {
+        NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:[value count]];
+        [value enumerateKeysAndObjectsUsingBlock:^(id key, id item, BOOL *stop) {
+            dictionary[key] = SHDeepCopiedValue(item, copies);
+        }];
+        return [value isKindOfClass:[NSMutableDictionary class]] ? dictionary : [dictionary copy];
+    }
+    return value;
+}
+
+- (instancetype)deepCopy {
+    // originals to their copies, by pointer: equal models are still copied apart
+    NSMapTable *copies = [[NSMapTable alloc]
+        initWithKeyOptions:(NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality)
+              valueOptions:NSPointerFunctionsStrongMemory
+                  capacity:8];
+    return [self deepCopyWithCopies:copies];
+}
+
+- (instancetype)deepCopyWithCopies:(NSMapTable *)copies {
+    SHModelObject *copy = [copies objectForKey:self];
+    if (copy) {
+        return copy;
+    }
+    copy = [self copy];
+    [copies setObject:copy forKey:self];
+    for (SHModelIvarDescriptor *descriptor in [[self classPlan] objectIvars]) {
+        id value = object_getIvar(copy, descriptor.ivar);
+        id copiedValue = SHDeepCopiedValue(value, copies);
+        if (copiedValue != value) {
+            SHModelStoreIvarObject(copy, descriptor, copiedValue);
+        }
+    }
+    return copy;
+}
+
++ (void)prewarmClasses:(NSArray *)classes {
+    [self prewarmClasses:classes completion:nil];
+}
+
++ (void)prewarmClasses:(NSArray *)classes completion:(void (^)(void))completion {
+    NSArray *pending = [classes copy];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+        @autoreleasepool {
+            NSMutableSet *prewarmed = [NSMutableSet set];
+            for (Class cls in pending) {
+                [SHModelObject prewarmClass:cls prewarmed:prewarmed];
+            }
+        }
+        if (completion) {
+            completion();
+        }
+    });
+}
+
+// builds the plan of the class and of the model classes it refers to
++ (void)prewarmClass:(Class)cls prewarmed:(NSMutableSet *)prewarmed {
+    if (![cls isSubclassOfClass:[SHModelObject class]] || [prewarmed containsObject:cls]) {
+        return;
+    }
+    [prewarmed addObject:cls];
+
+    SHModelClassPlan *plan = [SHModelClassPlan planForClass:cls rootClass:[SHModelObject class]];
+    for (SHModelIvarDescriptor *descriptor in plan.ivars) {
+        if (descriptor.isModelClass) {
+            [self prewarmClass:descriptor.objectClass prewarmed:prewarmed];
+        }
+        if (descriptor.elementClass) {
+            [self prewarmClass:descriptor.elementClass prewarmed:prewarmed];
+        }
     }
+}
 
-    free(_ivars);
-    _ivars = NULL;
-    return array;
+// NSCoding
+- (NSArray *)propertyNames {
+    return [[self classPlan] ivarNames];
 }
 
 - (id)initWithCoder:(NSCoder *)aDecoder {
     if ((self = [self init])) {
         // Loop through the properties
         for (NSString *key in [self propertyNames]) {
+            // archives of older versions of the class lack the keys of ivars added since, they keep their default
+            if (![aDecoder containsValueForKey:key]) {
+                continue;
+            }
             // Decode the property, and use the KVC setValueForKey: method to set it
             id value = [aDecoder decodeObjectForKey:key];
             [self setValue:value forKey:key];
@@ -224,16 +645,16 @@ static NSDateFormatter *_customFormatter;
     // Loop through the properties
     for (NSString *key in [self propertyNames]) {
         // Use the KVC valueForKey: method to get the property and then encode it
-        id value = [self valueForKey:key];
+        id value = SHLazyValueResolve([self valueForKey:key]);
         [aCoder encodeObject:value forKey:key];
     }
 }
 
 //
 - (instancetype)updateWithDictionary:(NSDictionary *)dictionary {
-    // List of ivars
-    id class = objc_getClass([NSStringFromClass([self class]) UTF8String]);
-    _ivars = class_copyIvarList(class, &_outCount);
+    // cached list of ivars
+    _plan = [self classPlan];
+    _counters = SHDecodingStatisticsEnabled ? SHDecodingCountersForClass([self class]) : NULL;
 
     // For each top-level property in the dictionary
     NSEnumerator *enumerator = [dictionary keyEnumerator];
@@ -243,9 +664,10 @@ static NSDateFormatter *_customFormatter;
         [self serializeValue:value withKey:key];
     }
 
-    free(_ivars);
-    _ivars = NULL;
-
+    if (_counters) {
+        SHDecodingCounterAdd(&_counters->objectsDecoded, 1);
+        _counters = NULL;
+    }
     return self;
 }
 
@@ -254,49 +676,681 @@ static NSDateFormatter *_customFormatter;
                 dateConversionOption:(kDateConversionOption)option
                        inputDateType:(kInputDateFormat)inputDateType
                             mappings:(NSDictionary *)mapping {
-    _converstionOption = option;
-    _inputDateFormat = inputDateType;
-    _mappings = mapping;
-
-    if (nil == _simpleDateFormatter) {
-        _simpleDateFormatter = [[NSDateFormatter alloc] init];
-        [_simpleDateFormatter setDateFormat:@"yyyy-MM-dd'T'HH:mm:ss"];
-    }
-
-    if (nil == _timezoneDateFormatter) {
-        _timezoneDateFormatter = [[NSDateFormatter alloc] init];
-        [_timezoneDateFormatter setDateFormat:@"yyyy-MM-dd'T'HH:mm:ssZZZZZ"];
-    }
-
-    return [self updateWithDictionary:dictionary];
+    return [self updateWithDictionary:dictionary context:SHContextWithOptions(option, inputDateType, mapping)];
 }
 
 - (instancetype)updateWithDictionary:(NSDictionary *)dictionary
                 dateConversionOption:(kDateConversionOption)option
                      inputDateFormat:(NSString *)inputDateFormat
                             mappings:(NSDictionary *)mapping {
-    _converstionOption = option;
-    _inputDateFormat = kInputDateFormatCustom;
-    _customInputDateFormatString = inputDateFormat;
-    if (_customInputDateFormatString && !_customFormatter) {
-        _customFormatter = [[NSDateFormatter alloc] init];
-        [_customFormatter setDateFormat:_customInputDateFormatString];
-    }
-    _mappings = mapping;
-
-    return [self updateWithDictionary:dictionary];
+    return [self updateWithDictionary:dictionary
+                              context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                              inputDateFormat:inputDateFormat
+                                                                                     mappings:mapping]];
 }
 
 - (instancetype)updateWithDictionary:(NSDictionary *)dictionary
                 dateConversionOption:(kDateConversionOption)option
                   inputDateFormatter:(NSDateFormatter *)inputDateFormatter
                             mappings:(NSDictionary *)mapping {
-    _converstionOption = option;
-    _inputDateFormat = kInputDateFormatCustom;
-    _customFormatter = inputDateFormatter;
-    _mappings = mapping;
+    return [self updateWithDictionary:dictionary
+                              context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                           inputDateFormatter:inputDateFormatter
+                                                                                     mappings:mapping]];
+}
+
+- (instancetype)updateWithDictionary:(NSDictionary *)dictionary context:(SHDecodingContext *)context {
+    _context = context;
+    [self updateWithDictionary:dictionary];
+    // the projection only applies to this update, later updates decode all fields
+    _context = context.unprojectedContext;
+    return self;
+}
+
+#pragma mark - Change-aware updates
+
+- (NSSet *)changedKeysByUpdatingWithDictionary:(NSDictionary *)dictionary {
+    NSMutableSet *changedKeys = [NSMutableSet set];
+    if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
+        return changedKeys;
+    }
+
+    _plan = [self classPlan];
+    // what a custom `serializeValue:withKey:` does with a value is not known, every key counts as changed
+    BOOL overridesSerializeValue = [self overridesSerializeValue];
+    for (id key in dictionary) {
+        id value = dictionary[key];
+        if ([key isKindOfClass:[NSNull class]] || [value isKindOfClass:[NSNull class]]) {
+            continue;
+        }
+
+        if (overridesSerializeValue) {
+            [self serializeValue:value withKey:key];
+            [changedKeys addObject:key];
+            continue;
+        }
+
+        SHModelIvarDescriptor *descriptor = [_plan ivarForKey:key];
+        if (descriptor && !SHContextSkipsIvar(_context, descriptor) &&
+            [self updateIvar:descriptor withValue:value key:key]) {
+            [changedKeys addObject:key];
+        }
+    }
+    return changedKeys;
+}
+
+// stores the converted value only when it differs from the ivar, returns `YES` if the ivar changed
+- (BOOL)updateIvar:(SHModelIvarDescriptor *)descriptor withValue:(id)value key:(id)key {
+    BOOL pending = NO;
+    if (descriptor.type == SHIvarTypeObject) {
+        id current = object_getIvar(self, descriptor.ivar);
+        // a lazy value is replaced without decoding it, comparing would force it
+        pending = SHLazyValueIsPending(current);
+        if (current && !pending) {
+            if (descriptor.isModelClass && [value isKindOfClass:[NSDictionary class]] &&
+                [current isKindOfClass:descriptor.objectClass]) {
+                // nested models are patched in place
+                return [[current changedKeysByUpdatingWithDictionary:value] count] > 0;
+            }
+            if ([value isKindOfClass:[NSArray class]] && [current isKindOfClass:[NSArray class]]) {
+                id changed = [self updateModelArray:current withArray:value ivar:descriptor key:key];
+                if (changed) {
+                    return [changed boolValue];
+                }
+            }
+        }
+    }
+
+    id converted = [self convertedValue:value forIvar:descriptor withKey:key];
+    if (nil == converted && descriptor.type != SHIvarTypeObject) {
+        return NO;
+    }
+    if (!pending && SHModelIvarHasValue(self, descriptor, converted)) {
+        return NO;
+    }
+    SHModelSetIvarValue(self, descriptor, converted);
+    return YES;
+}
+
+// patches the models of a mapped array in place when the array still has the same length, nil if it has to be
+// replaced
+- (NSNumber *)updateModelArray:(NSArray *)models
+                     withArray:(NSArray *)array
+                          ivar:(SHModelIvarDescriptor *)descriptor
+                           key:(id)key {
+    Class objectClass = [self elementClassForIvar:descriptor key:key];
+    if (![self isSHModelObject:objectClass] || [models count] != [array count]) {
+        return nil;
+    }
+    for (NSUInteger i = 0; i < [array count]; i++) {
+        if (![array[i] isKindOfClass:[NSDictionary class]] || ![models[i] isKindOfClass:objectClass]) {
+            return nil;
+        }
+    }
+
+    BOOL changed = NO;
+    for (NSUInteger i = 0; i < [array count]; i++) {
+        if ([[models[i] changedKeysByUpdatingWithDictionary:array[i]] count] > 0) {
+            changed = YES;
+        }
+    }
+    return @(changed);
+}
+
+#pragma mark - Exporting
+
+- (NSDictionary *)dictionaryRepresentation {
+    return [self dictionaryRepresentationWithKeyStyle:kOutputKeyStyleIvarName];
+}
+
+- (NSDictionary *)dictionaryRepresentationWithKeyStyle:(kOutputKeyStyle)keyStyle {
+    return [self dictionaryRepresentationWithKeyStyle:keyStyle depth:0];
+}
+
+- (NSDictionary *)dictionaryRepresentationWithKeyStyle:(kOutputKeyStyle)keyStyle depth:(NSUInteger)depth {
+    SHModelClassPlan *plan = [self classPlan];
+    NSArray *ivars = plan.ivars;
+    NSArray *keys = [plan outputKeysWithStyle:keyStyle];
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:[ivars count]];
+    for (NSUInteger i = 0; i < [ivars count]; i++) {
+        SHModelIvarDescriptor *descriptor = ivars[i];
+        id value = [self exportedSchemaDateForIvar:descriptor];
+        if (nil == value) {
+            if (descriptor.type == SHIvarTypeObject) {
+                id ivarValue = [self reverseTransformedValue:object_getIvar(self, descriptor.ivar) forIvar:descriptor];
+                value = [self exportedValue:ivarValue keyStyle:keyStyle depth:depth + 1];
+            } else {
+                value = SHModelIvarNumber(self, descriptor);
+            }
+        }
+        if (value) {
+            dictionary[keys[i]] = value;
+        }
+    }
+    return dictionary;
+}
 
-    return [self updateWithDictionary:dictionary];
+// the value with models converted to dictionaries and dates to strings
+- (id)exportedValue:(id)value keyStyle:(kOutputKeyStyle)keyStyle depth:(NSUInteger)depth {
+    value = SHLazyValueResolve(value);
+    if (nil == value) {
+        return nil;
+    }
+    if (depth > MAX_EXPORT_DEPTH) {
+        NSLog(@"%@ is nested deeper than %d levels, leaving it out.", NSStringFromClass([value class]), MAX_EXPORT_DEPTH);
+        return nil;
+    }
+
+    if ([value isKindOfClass:[SHModelObject class]]) {
+        return [value dictionaryRepresentationWithKeyStyle:keyStyle depth:depth];
+    } else if ([value isKindOfClass:[NSDate class]]) {
+        return [self exportedDate:value ivar:nil];
+    } else if ([value isKindOfClass:[NSArray class]]) {
+        NSMutableArray *array = [NSMutableArray arrayWithCapacity:[value count]];
+        for (id item in value) {
+            id exported = [self exportedValue:item keyStyle:keyStyle depth:depth + 1];
+            if (exported) {
+                [array addObject:exported];
+            }
+        }
+        return array;
+    } else if ([value isKindOfClass:[NSDictionary class]]) {
+        NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:[value count]];
+        [value enumerateKeysAndObjectsUsingBlock:^(id key, id item, BOOL *stop) {
+            id exported = [self exportedValue:item keyStyle:keyStyle depth:depth + 1];
+            if (exported) {
+                dictionary[key] = exported;
+            }
+        }];
+        return dictionary;
+    }
+    return value;
+}
+
+// the value of an object ivar as it was decoded, when the transformer of the ivar can be reversed
+- (id)reverseTransformedValue:(id)value forIvar:(SHModelIvarDescriptor *)descriptor {
+    value = SHLazyValueResolve(value);
+    NSValueTransformer *transformer = descriptor.valueTransformer;
+    if (nil == value || nil == transformer || ![[transformer class] allowsReverseTransformation]) {
+        return value;
+    }
+    return [transformer reverseTransformedValue:value];
+}
+
+// the date of an ivar with a date format in the schema, also for `NSTimeInterval` ivars. nil for other ivars.
+- (NSString *)exportedSchemaDateForIvar:(SHModelIvarDescriptor *)descriptor {
+    if (0 == descriptor.inputDateFormat) {
+        return nil;
+    }
+    NSDate *date = nil;
+    if (descriptor.type == SHIvarTypeDouble) {
+        date = [NSDate dateWithTimeIntervalSince1970:[SHModelIvarNumber(self, descriptor) doubleValue]];
+    } else if (descriptor.type == SHIvarTypeObject) {
+        id value = SHLazyValueResolve(object_getIvar(self, descriptor.ivar));
+        if ([value isKindOfClass:[NSDate class]]) {
+            date = value;
+        }
+    }
+    return date ? [self exportedDate:date ivar:descriptor] : nil;
+}
+
+// the date in the input date format (of the ivar's schema, if any), so decoding the export gives the same date again
+- (NSString *)exportedDate:(NSDate *)date ivar:(SHModelIvarDescriptor *)descriptor {
+    kInputDateFormat inputDateFormat = descriptor.inputDateFormat ?: _context.inputDateFormat;
+    switch (inputDateFormat) {
+        case kInputDateFormatDotNetSimple: {
+            return [SHDateFormatterForFormat(SHDotNetSimpleDateFormat) stringFromDate:date];
+        }
+        case kInputDateFormatDotNetWithTimeZone: {
+            return [SHDateFormatterForFormat(SHDotNetDateWithTimeZoneFormat) stringFromDate:date];
+        }
+        case kInputDateFormatCustom: {
+            NSDateFormatter *formatter = [self customDateFormatterForIvar:descriptor];
+            if (formatter) {
+                return [formatter stringFromDate:date];
+            }
+        } break;
+        default: break;
+    }
+    return SHDotNetJSONDateString([date timeIntervalSince1970]);
+}
+
+- (NSData *)JSONDataRepresentation {
+    return [self JSONDataRepresentationWithKeyStyle:kOutputKeyStyleIvarName];
+}
+
+- (NSData *)JSONDataRepresentationWithKeyStyle:(kOutputKeyStyle)keyStyle {
+    SHJSONWriter writer;
+    SHJSONWriterInit(&writer, 256);
+    if (![self writeJSONObject:&writer keyStyle:keyStyle depth:0]) {
+        SHJSONWriterDiscard(&writer);
+        return nil;
+    }
+    return SHJSONWriterCopyData(&writer);
+}
+
+// writes the ivars as one JSON object, primitives without boxing them
+- (BOOL)writeJSONObject:(SHJSONWriter *)writer keyStyle:(kOutputKeyStyle)keyStyle depth:(NSUInteger)depth {
+    SHModelClassPlan *plan = [self classPlan];
+    NSArray *ivars = plan.ivars;
+    NSArray *keys = [plan outputKeysWithStyle:keyStyle];
+    const uint8_t *base = (const uint8_t *)(__bridge void *)self;
+
+    SHJSONWriterAppendByte(writer, '{');
+    BOOL first = YES;
+    for (NSUInteger i = 0; i < [ivars count]; i++) {
+        SHModelIvarDescriptor *descriptor = ivars[i];
+        NSString *date = [self exportedSchemaDateForIvar:descriptor];
+        id value = nil;
+        if (descriptor.type == SHIvarTypeObject) {
+            value = [self reverseTransformedValue:object_getIvar(self, descriptor.ivar) forIvar:descriptor];
+            if (nil == value) {
+                continue;
+            }
+        } else if (descriptor.type == SHIvarTypeUnknown) {
+            continue;
+        }
+
+        if (!first) {
+            SHJSONWriterAppendByte(writer, ',');
+        }
+        first = NO;
+        SHJSONWriterWriteString(writer, keys[i]);
+        SHJSONWriterAppendByte(writer, ':');
+        if (date) {
+            SHJSONWriterWriteString(writer, date);
+            continue;
+        }
+
+        const uint8_t *ivar = base + descriptor.offset;
+        BOOL success = YES;
+        switch (descriptor.type) {
+            case SHIvarTypeObject: {
+                success = [self writeJSONValue:value writer:writer keyStyle:keyStyle depth:depth + 1];
+            } break;
+            case SHIvarTypeChar: SHJSONWriterWriteLongLong(writer, *(const char *)ivar); break;
+            case SHIvarTypeUnsignedChar: SHJSONWriterWriteUnsignedLongLong(writer, *(const unsigned char *)ivar); break;
+            case SHIvarTypeBool: SHJSONWriterWriteBool(writer, *(const bool *)ivar); break;
+            case SHIvarTypeShort: SHJSONWriterWriteLongLong(writer, *(const short *)ivar); break;
+            case SHIvarTypeUnsignedShort:
+                SHJSONWriterWriteUnsignedLongLong(writer, *(const unsigned short *)ivar);
+                break;
+            case SHIvarTypeInt: SHJSONWriterWriteLongLong(writer, *(const int *)ivar); break;
+            case SHIvarTypeUnsignedInt: SHJSONWriterWriteUnsignedLongLong(writer, *(const unsigned int *)ivar); break;
+            case SHIvarTypeLong: SHJSONWriterWriteLongLong(writer, *(const long *)ivar); break;
+            case SHIvarTypeUnsignedLong: SHJSONWriterWriteUnsignedLongLong(writer, *(const unsigned long *)ivar); break;
+            case SHIvarTypeLongLong: SHJSONWriterWriteLongLong(writer, *(const long long *)ivar); break;
+            case SHIvarTypeUnsignedLongLong:
+                SHJSONWriterWriteUnsignedLongLong(writer, *(const unsigned long long *)ivar);
+                break;
+            case SHIvarTypeFloat: success = SHJSONWriterWriteFloat(writer, *(const float *)ivar); break;
+            case SHIvarTypeDouble: success = SHJSONWriterWriteDouble(writer, *(const double *)ivar); break;
+            default: break;
+        }
+        if (!success) {
+            NSLog(@"%@ of %@ cannot be written as JSON.", descriptor.name, NSStringFromClass([self class]));
+            return NO;
+        }
+    }
+    SHJSONWriterAppendByte(writer, '}');
+    return YES;
+}
+
+- (BOOL)writeJSONValue:(id)value
+                writer:(SHJSONWriter *)writer
+              keyStyle:(kOutputKeyStyle)keyStyle
+                 depth:(NSUInteger)depth {
+    value = SHLazyValueResolve(value);
+    if (depth > MAX_EXPORT_DEPTH) {
+        NSLog(@"%@ is nested deeper than %d levels, not writing it.", NSStringFromClass([value class]), MAX_EXPORT_DEPTH);
+        return NO;
+    }
+
+    if (nil == value || [value isKindOfClass:[NSNull class]]) {
+        SHJSONWriterWriteNull(writer);
+    } else if ([value isKindOfClass:[NSString class]]) {
+        SHJSONWriterWriteString(writer, value);
+    } else if ([value isKindOfClass:[NSNumber class]]) {
+        return SHJSONWriterWriteNumber(writer, value);
+    } else if ([value isKindOfClass:[SHModelObject class]]) {
+        return [value writeJSONObject:writer keyStyle:keyStyle depth:depth];
+    } else if ([value isKindOfClass:[NSDate class]]) {
+        SHJSONWriterWriteString(writer, [self exportedDate:value ivar:nil]);
+    } else if ([value isKindOfClass:[NSArray class]]) {
+        SHJSONWriterAppendByte(writer, '[');
+        BOOL first = YES;
+        for (id item in value) {
+            if (!first) {
+                SHJSONWriterAppendByte(writer, ',');
+            }
+            first = NO;
+            if (![self writeJSONValue:item writer:writer keyStyle:keyStyle depth:depth + 1]) {
+                return NO;
+            }
+        }
+        SHJSONWriterAppendByte(writer, ']');
+    } else if ([value isKindOfClass:[NSDictionary class]]) {
+        SHJSONWriterAppendByte(writer, '{');
+        BOOL first = YES;
+        for (id key in value) {
+            if (![key isKindOfClass:[NSString class]]) {
+                NSLog(@"dictionary key %@ is not a string, it cannot be written as JSON.", key);
+                return NO;
+            }
+            if (!first) {
+                SHJSONWriterAppendByte(writer, ',');
+            }
+            first = NO;
+            SHJSONWriterWriteString(writer, key);
+            SHJSONWriterAppendByte(writer, ':');
+            if (![self writeJSONValue:value[key] writer:writer keyStyle:keyStyle depth:depth + 1]) {
+                return NO;
+            }
+        }
+        SHJSONWriterAppendByte(writer, '}');
+    } else {
+        NSLog(@"%@ cannot be written as JSON.", NSStringFromClass([value class]));
+        return NO;
+    }
+    return YES;
+}
+
+#pragma mark - Decoding from JSON data
+
++ (instancetype)objectWithJSONData:(NSData *)data {
+    return [self objectWithJSONData:data context:[SHDecodingContext defaultContext]];
+}
+
++ (instancetype)objectWithJSONData:(NSData *)data mappings:(NSDictionary *)mapping {
+    return [self objectWithJSONData:data
+               dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                      inputDateType:kInputDateFormatJSON
+                           mappings:mapping];
+}
+
++ (instancetype)objectWithJSONData:(NSData *)data
+              dateConversionOption:(kDateConversionOption)option
+                     inputDateType:(kInputDateFormat)inputDateType
+                          mappings:(NSDictionary *)mapping {
+    if (nil == data || ![data isKindOfClass:[NSData class]]) {
+        return nil;
+    }
+    return [self objectWithJSONData:data context:SHContextWithOptions(option, inputDateType, mapping)];
+}
+
++ (instancetype)objectWithJSONData:(NSData *)data
+              dateConversionOption:(kDateConversionOption)option
+                   inputDateFormat:(NSString *)inputDateFormat
+                          mappings:(NSDictionary *)mapping {
+    if (nil == data || ![data isKindOfClass:[NSData class]]) {
+        return nil;
+    }
+    return [self objectWithJSONData:data
+                            context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                            inputDateFormat:inputDateFormat
+                                                                                   mappings:mapping]];
+}
+
++ (instancetype)objectWithJSONData:(NSData *)data
+              dateConversionOption:(kDateConversionOption)option
+                inputDateFormatter:(NSDateFormatter *)inputDateFormatter
+                          mappings:(NSDictionary *)mapping {
+    if (nil == data || ![data isKindOfClass:[NSData class]]) {
+        return nil;
+    }
+    return [self objectWithJSONData:data
+                            context:[[SHDecodingContext alloc] initWithDateConversionOption:option
+                                                                         inputDateFormatter:inputDateFormatter
+                                                                                   mappings:mapping]];
+}
+
++ (instancetype)objectWithJSONData:(NSData *)data context:(SHDecodingContext *)context {
+    if (nil == data || ![data isKindOfClass:[NSData class]]) {
+        return nil;
+    }
+
+    SHModelObject *object = [[[self class] alloc] init];
+    object->_context = context;
+    BOOL success = [object readJSONData:data];
+    object->_context = context.unprojectedContext;
+    return success ? object : nil;
+}
+
+- (instancetype)updateWithJSONData:(NSData *)data {
+    if (nil == data || ![data isKindOfClass:[NSData class]]) {
+        return nil;
+    }
+    return [self readJSONData:data] ? self : nil;
+}
+
+// a new object decoded from the JSON object at the reader, shared through the identity map of the current session
+// unless only some fields are decoded. nil on error
++ (id)objectFromJSONReader:(SHJSONReader *)reader context:(SHDecodingContext *)context {
+    SHModelObject *object = [[self alloc] init];
+    object->_context = context;
+    if (![object readJSONObject:reader]) {
+        return nil;
+    }
+    object->_context = context.unprojectedContext;
+    return context.onlyKeys ? object : [object sharedObject];
+}
+
+- (BOOL)readJSONData:(NSData *)data {
+    SHJSONReader reader;
+    SHJSONReaderInit(&reader, [data bytes], [data length]);
+    return [self readJSONObject:&reader] && SHJSONReaderAtEnd(&reader);
+}
+
+// reads one JSON object from the reader into the ivars, the reader is left right after the closing `}`
+- (BOOL)readJSONObject:(SHJSONReader *)reader {
+    _plan = [self classPlan];
+    if (SHJSONReaderPeek(reader) != SHJSONValueTypeObject || !SHJSONReaderBeginObject(reader)) {
+        reader->failed = YES;
+        return NO;
+    }
+
+    // subclasses overriding `serializeValue:withKey:` get every key and value, materialized like NSJSONSerialization
+    // would have done
+    BOOL overridesSerializeValue = [self overridesSerializeValue];
+
+    BOOL first = YES;
+    SHJSONStringRef keyRef;
+    while (SHJSONReaderNextMember(reader, &first, &keyRef)) {
+        if (overridesSerializeValue) {
+            NSString *key = SHJSONStringCreate(&keyRef);
+            id value = SHJSONReaderReadValue(reader);
+            if (nil == key || nil == value) {
+                reader->failed = YES;
+                return NO;
+            }
+            [self serializeValue:value withKey:key];
+            continue;
+        }
+
+        SHModelIvarDescriptor *descriptor = [self ivarForJSONKey:&keyRef];
+        if (descriptor && SHContextSkipsIvar(_context, descriptor)) {
+            descriptor = nil;
+        }
+        BOOL success = descriptor ? [self readJSONValue:reader ivar:descriptor key:&keyRef] : SHJSONReaderSkipValue(reader);
+        if (!success) {
+            reader->failed = YES;
+            return NO;
+        }
+    }
+    return !reader->failed;
+}
+
+- (BOOL)overridesSerializeValue {
+    return SHClassOverridesSerializeValue([self class]);
+}
+
+// plain ASCII keys are normalized on the stack and never become an NSString
+- (SHModelIvarDescriptor *)ivarForJSONKey:(const SHJSONStringRef *)key {
+    if (key->isASCII && !key->hasEscapes && key->length <= SH_KEY_STACK_BUFFER_LENGTH) {
+        unichar characters[SH_KEY_STACK_BUFFER_LENGTH];
+        unichar normalized[SH_KEY_STACK_BUFFER_LENGTH];
+        for (NSUInteger i = 0; i < key->length; i++) {
+            characters[i] = key->bytes[i];
+        }
+        NSUInteger length = 0;
+        NSUInteger hash = 0;
+        if (!SHNormalizeASCIICharacters(characters, key->length, normalized, &length, &hash)) {
+            return nil;
+        }
+        return [_plan ivarForNormalizedCharacters:normalized length:length hash:hash];
+    }
+
+    NSString *string = SHJSONStringCreate(key);
+    return string ? [_plan ivarForKey:string] : nil;
+}
+
+- (BOOL)readJSONValue:(SHJSONReader *)reader ivar:(SHModelIvarDescriptor *)descriptor key:(const SHJSONStringRef *)keyRef {
+    SHJSONValueType type = SHJSONReaderPeek(reader);
+    switch (type) {
+        case SHJSONValueTypeNull: {
+            // like NSNull in a dictionary, the ivar is left untouched
+            return SHJSONReaderReadLiteral(reader, type);
+        }
+        case SHJSONValueTypeNumber: {
+            SHJSONNumber number;
+            if (!SHJSONReaderReadNumber(reader, &number)) {
+                return NO;
+            }
+            // integers above LLONG_MAX are boxed, the box keeps them exact for unsigned long long ivars
+            BOOL stored = NO;
+            if (number.isInteger) {
+                stored = SHModelSetIvarLongLong(self, descriptor, number.integerValue);
+            } else if (!number.isUnsigned) {
+                stored = SHModelSetIvarDouble(self, descriptor, number.doubleValue);
+            }
+            if (!stored) {
+                [self assignValue:SHJSONNumberObject(&number) toIvar:descriptor withKey:nil];
+            }
+            return YES;
+        }
+        case SHJSONValueTypeTrue:
+        case SHJSONValueTypeFalse: {
+            if (!SHJSONReaderReadLiteral(reader, type)) {
+                return NO;
+            }
+            BOOL flag = (type == SHJSONValueTypeTrue);
+            if (!SHModelSetIvarLongLong(self, descriptor, flag)) {
+                [self assignValue:(flag ? @YES : @NO) toIvar:descriptor withKey:nil];
+            }
+            return YES;
+        }
+        case SHJSONValueTypeObject: {
+            if (descriptor.isModelClass) {
+                if ([[self class] decodesNestedObjectsLazily]) {
+                    Class objectClass = descriptor.objectClass;
+                    SHDecodingContext *context = [_context contextForIvar:descriptor];
+                    NSData *json = [self JSONDataBySkippingValue:reader];
+                    if (nil == json) {
+                        return NO;
+                    }
+                    // decoded like the eager path below, through the identity map of the current session
+                    SHModelSetIvarValue(self, descriptor, SHLazyValueWithCurrentSession(^id {
+                        SHJSONReader nestedReader;
+                        SHJSONReaderInit(&nestedReader, [json bytes], [json length]);
+                        return [objectClass objectFromJSONReader:&nestedReader context:context];
+                    }));
+                    return YES;
+                }
+
+                // nested models are decoded with the context the object containing them has for the field
+                id nested = [descriptor.objectClass objectFromJSONReader:reader
+                                                                 context:[_context contextForIvar:descriptor]];
+                if (nil == nested) {
+                    return NO;
+                }
+                SHModelSetIvarValue(self, descriptor, nested);
+                return YES;
+            }
+        } break;
+        case SHJSONValueTypeArray: {
+            Class objectClass = descriptor.elementClass;
+            if (Nil == objectClass && _context.mappings) {
+                objectClass = [self elementClassForIvar:descriptor key:SHJSONStringCreate(keyRef)];
+            }
+            if ([self isSHModelObject:objectClass]) {
+                return [self readJSONArray:reader ofClass:objectClass ivar:descriptor];
+            }
+        } break;
+        default:
+            break;
+    }
+
+    id value = SHJSONReaderReadValue(reader);
+    if (nil == value) {
+        return NO;
+    }
+    [self assignValue:value toIvar:descriptor withKey:nil];
+    return YES;
+}
+
+// array with a mapping to a model class, the elements are decoded straight into model objects
+- (BOOL)readJSONArray:(SHJSONReader *)reader ofClass:(Class)objectClass ivar:(SHModelIvarDescriptor *)descriptor {
+    if (descriptor.objectClass && ![descriptor.objectClass isSubclassOfClass:[NSArray class]]) {
+        NSAssert(false, @"the types do not match : %@ vs %@", descriptor.typeEncoding, @"NSArray or NSMutableArray");
+    }
+
+    SHDecodingContext *context = [_context contextForIvar:descriptor];
+    if ([[self class] decodesNestedObjectsLazily]) {
+        NSData *json = [self JSONDataBySkippingValue:reader];
+        if (nil == json) {
+            return NO;
+        }
+        SHModelSetIvarValue(self, descriptor, SHLazyValueWithCurrentSession(^id {
+            SHJSONReader arrayReader;
+            SHJSONReaderInit(&arrayReader, [json bytes], [json length]);
+            return [SHModelObject modelArrayFromJSONReader:&arrayReader ofClass:objectClass context:context];
+        }));
+        return YES;
+    }
+
+    NSMutableArray *valueArray = [SHModelObject modelArrayFromJSONReader:reader ofClass:objectClass context:context];
+    if (nil == valueArray) {
+        return NO;
+    }
+    SHModelSetIvarValue(self, descriptor, valueArray);
+    return YES;
+}
+
+// decodes the elements of a mapped array with the context of the object containing it, nil on error
++ (NSMutableArray *)modelArrayFromJSONReader:(SHJSONReader *)reader
+                                     ofClass:(Class)objectClass
+                                     context:(SHDecodingContext *)context {
+    if (!SHJSONReaderBeginArray(reader)) {
+        return nil;
+    }
+    NSMutableArray *valueArray = [NSMutableArray array];
+    BOOL first = YES;
+    while (SHJSONReaderNextElement(reader, &first)) {
+        if (SHJSONReaderPeek(reader) == SHJSONValueTypeObject) {
+            id itemObject = [objectClass objectFromJSONReader:reader context:context];
+            if (nil == itemObject) {
+                return nil;
+            }
+            [valueArray addObject:itemObject];
+        } else {
+            id item = SHJSONReaderReadValue(reader);
+            if (nil == item) {
+                return nil;
+            }
+            NSLog(@"object %@ is not a NSDictionary object, skipping.", [item description]);
+        }
+    }
+    return reader->failed ? nil : valueArray;
+}
+
+// skips the next value and returns a copy of its bytes, so a lazy value does not keep the whole payload alive
+- (NSData *)JSONDataBySkippingValue:(SHJSONReader *)reader {
+    SHJSONReaderPeek(reader);
+    const uint8_t *start = reader->cursor;
+    if (!SHJSONReaderSkipValue(reader)) {
+        return nil;
+    }
+    return [NSData dataWithBytes:start length:(NSUInteger)(reader->cursor - start)];
 }
 
 #pragma mark - SHModalSerialization protocol methods
@@ -313,116 +1367,48 @@ static NSDateFormatter *_customFormatter;
     }
 
     // If it match our ivar name, then set it
-    for (unsigned int i = 0; i < _outCount; i++) {
-        Ivar ivar = _ivars[i];
-        NSString *ivarName = [NSString stringWithCString:ivar_getName(ivar) encoding:NSUTF8StringEncoding];
-        NSString *ivarType = [NSString stringWithCString:ivar_getTypeEncoding(ivar) encoding:NSUTF8StringEncoding];
+    if (nil == _plan) {
+        _plan = [self classPlan];
+    }
+    SHDecodingCounters *counters = _counters;
+    uint64_t start = counters ? SHDecodingTimestamp() : 0;
+    SHModelIvarDescriptor *descriptor = [_plan ivarForKey:key];
+    if (counters) {
+        SHDecodingCounterAdd(&counters->keyMatchingTicks, (int64_t)(SHDecodingTimestamp() - start));
+        SHDecodingCounterAdd(descriptor ? &counters->keysMatched : &counters->keysDropped, 1);
+    }
+    // fields left out by the projection of the context are skipped before their value is converted
+    if (descriptor && !SHContextSkipsIvar(_context, descriptor)) {
+        [self assignValue:value toIvar:descriptor withKey:key];
+    }
+}
 
-        if ([self matchesPattern:key ivar:ivarName] == NO) {
-            continue;
-        }
+// converts the value for the ivar (dates, nested models, mapped arrays) and stores it
+- (void)assignValue:(id)value toIvar:(SHModelIvarDescriptor *)descriptor withKey:(id)key {
+    id converted = [self convertedValue:value forIvar:descriptor withKey:key];
+    // primitive ivars keep their value when a value cannot be converted
+    if (converted || descriptor.type == SHIvarTypeObject) {
+        SHModelSetIvarValue(self, descriptor, converted);
+    }
+}
 
-        // it will be NSString, NSNumber, NSArray, NSDictionary or NSNull
-        if ([value isKindOfClass:[NSString class]]) {
-
-            /*
-             converting the .NET JSON Date representation to either NSDate, NSTimeInterval or keeping it as
-             NSString. if somebody wants a different conversion, please simplye override the method and parse the
-             value and set for yourself and make sure you call [super serializeValue: key:] for all other values so
-             that they are parsed correctly.
-             */
-            switch (_converstionOption) {
-                case kDateConverstionFromNSStringToNSDateOption: {
-                    if ([ivarType contains:@"NSDate"]) {
-                        switch (_inputDateFormat) {
-                            case kInputDateFormatJSON: {
-                                value = (NSDate *)[self dateFromDotNetJSONString:value];
-                            } break;
-                            case kInputDateFormatDotNetSimple: {
-                                value = (NSDate *)[_simpleDateFormatter dateFromString:value];
-                            } break;
-                            case kInputDateFormatDotNetWithTimeZone: {
-                                value = (NSDate *)[_timezoneDateFormatter dateFromString:value];
-                            } break;
-                            case kInputDateFormatCustom: {
-                                value = (NSDate *)[_customFormatter dateFromString:value];
-                            } break;
-                            default: { value = (NSDate *)[self dateFromDotNetJSONString:value]; } break;
-                        }
-                    }
-                } break;
-                case kDateConverstionFromNSStringToNSTimeIntervalOption: {
-                    if (![ivarType contains:@"@"]) {
-                        switch (_inputDateFormat) {
-                            case kInputDateFormatJSON: {
-                                value = @([[self dateFromDotNetJSONString:value] timeIntervalSince1970]);
-                            } break;
-                            case kInputDateFormatDotNetSimple: {
-                                value = @([[_simpleDateFormatter dateFromString:value] timeIntervalSince1970]);
-                            } break;
-                            case kInputDateFormatDotNetWithTimeZone: {
-                                value = @([[_timezoneDateFormatter dateFromString:value] timeIntervalSince1970]);
-                            } break;
-                            case kInputDateFormatCustom: {
-                                value = @([[_customFormatter dateFromString:value] timeIntervalSince1970]);
-                            } break;
-                            default: {
-                                value = @([[self dateFromDotNetJSONString:value] timeIntervalSince1970]);
-                            } break;
-                        }
-                    }
-                } break;
-                case kDateConverstionFromNSStringToNSStringOption: {
-                    if (![ivarType contains:NSStringFromClass([NSString class])]) {
-                        NSAssert(false, @"the types do not match : %@ vs %@", ivarType, @"NSString");
-                    }
-                }
-            }
-        } else if ([value isKindOfClass:[NSNumber class]] && ![ivarType contains:@"NSNumber"]) {
-            // special case, where NSNumber can be stored into the primitive types. just need to chceck that iVar is not
-            // an object.
-            if ([ivarType contains:@"@"]) {
-                NSAssert(false, @"the types do not match : %@ vs %@", ivarType, @"NSNumber");
-            }
-        } else if ([value isKindOfClass:[NSDictionary class]]) {
-            NSString *typeName = [ivarType stringByReplacingOccurrencesOfString:@"@" withString:@""];
-            typeName = [typeName stringByReplacingOccurrencesOfString:@"\"" withString:@""];
-            Class objectClass = NSClassFromString(typeName);
-            BOOL isSHModelObject = [self isSHModelObject:objectClass];
-            if (isSHModelObject) {
-                value = [objectClass objectWithDictionary:value];
-            } else if (![ivarType contains:@"Dictionary"]) {
-                NSAssert(false, @"the types do not match : %@ vs %@", ivarType, @"NSDictionary or NSMutableDictionary");
-            }
-        } else if ([value isKindOfClass:[NSArray class]]) {
-            if (![ivarType contains:@"Array"]) {
-                NSAssert(false, @"the types do not match : %@ vs %@", ivarType, @"NSArray or NSMutableArray");
-            }
-
-            id availableMappingClass = _mappings[key];
-            if (availableMappingClass && [availableMappingClass isKindOfClass:[NSString class]]) {
-                // mapping string available.
-                Class objectClass = NSClassFromString(availableMappingClass);
-                BOOL isSHModelObject = [self isSHModelObject:objectClass];
-                if (isSHModelObject) {
-                    NSMutableArray *valueArray = [NSMutableArray arrayWithCapacity:[value count]];
-                    for (id item in value) {
-                        // item should be a dictionary
-                        if ([item isKindOfClass:[NSDictionary class]]) {
-                            id itemObject = [objectClass objectWithDictionary:item mappings:_mappings];
-                            if (itemObject) {
-                                [valueArray addObject:itemObject];
-                            }
-                        } else {
-                            NSLog(@"object %@ is not a NSDictionary object, skipping.", [item description]);
-                        }
-                    }
-                    value = valueArray;
-                }
-            }
-        }
+// the value as it is stored in the ivar, converted by the converter the class plan chose for the ivar and the kind
+// of the value. see `valueConverterForIvar:kind:`.
+- (id)convertedValue:(id)value forIvar:(SHModelIvarDescriptor *)descriptor withKey:(id)key {
+    return SHModelConvertValue(self, descriptor, value, key);
+}
 
-        [self setValue:value forKey:ivarName];
+// class of the elements of an array ivar, from the schema or from the mapping for the key
+- (Class)elementClassForIvar:(SHModelIvarDescriptor *)descriptor key:(id)key {
+    if (descriptor.elementClass) {
+        return descriptor.elementClass;
+    }
+    return [_context mappedClassForKey:key];
+}
+
+- (void)countTypeMismatch {
+    if (_counters) {
+        SHDecodingCounterAdd(&_counters->typeMismatches, 1);
     }
 }
 
@@ -435,6 +1421,10 @@ static NSDateFormatter *_customFormatter;
     return [self isSHModelObject:[class superclass]];
 }
 
+- (SHModelClassPlan *)classPlan {
+    return [SHModelClassPlan planForClass:[self class] rootClass:[SHModelObject class]];
+}
+
 #pragma mark - NSObject overriden methods
 
     //
@@ -450,71 +1440,287 @@ static NSDateFormatter *_customFormatter;
         return NO;
     }
 
-    if ((!IS_VALID_STRING(key)) || (!IS_VALID_STRING(ivarName))) {
+    // both are normalized (stripped of `-`, `_` and ` ` and lowercased) and interned, so this does not allocate for
+    // keys that were seen before.
+    SHNormalizedKey *normalizedKey = [SHNormalizedKey normalizedKeyForString:key];
+    SHNormalizedKey *normalizedIvar = [SHNormalizedKey normalizedKeyForString:ivarName];
+    if (nil == normalizedKey || nil == normalizedIvar) {
         return NO;
     }
+    return [normalizedKey isEqual:normalizedIvar];
+}
+
+// formatter passed with `inputDateFormatter:`, or this thread's formatter for the `inputDateFormat:` string
+- (NSDateFormatter *)customDateFormatter {
+    return [_context dateFormatter];
+}
 
-    NSMutableString *prettyKey = [NSMutableString stringWithCapacity:key.length];
-    NSMutableString *prettyIvar = [NSMutableString stringWithCapacity:ivarName.length];
+// formatter for the custom date format of the ivar's schema, or `customDateFormatter`
+- (NSDateFormatter *)customDateFormatterForIvar:(SHModelIvarDescriptor *)descriptor {
+    return descriptor.dateFormat ? SHDateFormatterForFormat(descriptor.dateFormat) : [self customDateFormatter];
+}
 
-    NSScanner *scannerForKey = [NSScanner scannerWithString:key];
-    NSScanner *scannerForIvar = [NSScanner scannerWithString:ivarName];
+- (NSDate *)dateFromDotNetJSONString:(NSString *)string {
+    NSTimeInterval interval = 0;
+    if (!SHParseDotNetJSONDate(string, &interval)) {
+        return nil;
+    }
+    return [NSDate dateWithTimeIntervalSince1970:interval];
+}
 
-    scannerForKey.caseSensitive = NO;
-    scannerForIvar.caseSensitive = NO;
+#pragma mark - Value converters
+
+// a date string in `format` as an `NSDate`, or as an `NSTimeInterval` number (0 if it cannot be parsed)
+- (id)dateFromString:(NSString *)string
+              format:(kInputDateFormat)format
+                ivar:(SHModelIvarDescriptor *)descriptor
+      asTimeInterval:(BOOL)asTimeInterval {
+    uint64_t start = _counters ? SHDecodingTimestamp() : 0;
+    NSTimeInterval interval = 0;
+    BOOL parsed = NO;
+    switch (format) {
+        case kInputDateFormatDotNetSimple: {
+            parsed = SHParseDotNetSimpleDate(string, &interval);
+        } break;
+        case kInputDateFormatDotNetWithTimeZone: {
+            parsed = SHParseDotNetDateWithTimeZone(string, &interval);
+        } break;
+        case kInputDateFormatCustom: {
+            NSDate *date = [[self customDateFormatterForIvar:descriptor] dateFromString:string];
+            parsed = (nil != date);
+            interval = [date timeIntervalSince1970];
+        } break;
+        default: { parsed = SHParseDotNetJSONDate(string, &interval); } break;
+    }
+    if (_counters) {
+        SHDecodingCounterAdd(&_counters->dateConversionTicks, (int64_t)(SHDecodingTimestamp() - start));
+    }
+    if (asTimeInterval) {
+        return @(interval);
+    }
+    return parsed ? [NSDate dateWithTimeIntervalSince1970:interval] : nil;
+}
 
-    NSCharacterSet *stripChars = [[NSCharacterSet characterSetWithCharactersInString:PATTERN_TO_STRIP] invertedSet];
-    while ([scannerForKey isAtEnd] == NO) {
-        NSString *buffer;
-        if ([scannerForKey scanCharactersFromSet:stripChars intoString:&buffer]) {
-            [prettyKey appendString:buffer];
+// the string as a number when all of it is a JSON number, nil otherwise. integers stay integers.
+static NSNumber *SHNumberFromString(NSString *string) {
+    char buffer[64];
+    if (![string getCString:buffer maxLength:sizeof(buffer) encoding:NSASCIIStringEncoding]) {
+        return nil;
+    }
+    SHJSONReader reader;
+    SHJSONReaderInit(&reader, buffer, strlen(buffer));
+    SHJSONNumber number;
+    if (SHJSONReaderPeek(&reader) != SHJSONValueTypeNumber || reader.cursor != reader.start ||
+        !SHJSONReaderReadNumber(&reader, &number) || reader.cursor != reader.end) {
+        return nil;
+    }
+    return SHJSONNumberObject(&number);
+}
 
-        } else {
-            [scannerForKey setScanLocation:([scannerForKey scanLocation] + 1)];
+// strings that are not JSON numbers (" 12", "12px", "1,5") are read up to the first character that does not belong
+// to a number, like key value coding did with `intValue`, `doubleValue` and `boolValue`
+static NSNumber *SHNumberFromStringLeniently(NSString *string, SHModelIvarDescriptor *descriptor) {
+    switch (descriptor.type) {
+        case SHIvarTypeBool: return @([string boolValue]);
+        case SHIvarTypeFloat:
+        case SHIvarTypeDouble: return @([string doubleValue]);
+        case SHIvarTypeObject: {
+            if ([descriptor.objectClass isSubclassOfClass:[NSDecimalNumber class]]) {
+                return [NSDecimalNumber decimalNumberWithString:string];
+            }
+            long long integer = [string longLongValue];
+            double number = [string doubleValue];
+            return (number == (double)integer) ? @(integer) : @(number);
         }
+        default: return @([string longLongValue]);
     }
+}
 
-    while ([scannerForIvar isAtEnd] == NO) {
-        NSString *buffer;
-        if ([scannerForIvar scanCharactersFromSet:stripChars intoString:&buffer]) {
-            [prettyIvar appendString:buffer];
-        } else {
-            [scannerForIvar setScanLocation:([scannerForIvar scanLocation] + 1)];
+// values that do not fit the ivar are stored as they are and fail in debug builds
+static id SHConvertMismatch(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    [object countTypeMismatch];
+    NSCAssert(false, @"the types do not match : %@ vs %@", descriptor.typeEncoding, NSStringFromClass([value class]));
+    return value;
+}
+
+static id SHConvertWithTransformer(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    Class objectClass = descriptor.objectClass;
+    if (objectClass && [value isKindOfClass:objectClass]) {
+        return value;
+    }
+    return [descriptor.valueTransformer transformedValue:value];
+}
+
+static id SHConvertStringInterned(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    SHDecodingSession *session = [SHDecodingSession currentSession];
+    return session ? [session internedString:value] : value;
+}
+
+// dates use the format of the schema, or the context of the object
+static id SHConvertStringToDate(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    __unsafe_unretained SHModelObject *model = object;
+    kInputDateFormat format = descriptor.inputDateFormat;
+    if (0 == format) {
+        switch (model->_context.dateConversionOption) {
+            case kDateConverstionFromNSStringToNSDateOption: format = model->_context.inputDateFormat; break;
+            case kDateConverstionFromNSStringToNSStringOption: return SHConvertMismatch(object, descriptor, value, key);
+            default: return value;
         }
     }
+    return [model dateFromString:value format:format ivar:descriptor asTimeInterval:NO];
+}
 
-    return ([[prettyKey lowercaseString] isEqualToString:[prettyIvar lowercaseString]]);
+// date strings become time intervals when the schema or the context of the object ask for it, other strings are
+// coerced to numbers, leniently when they are not JSON numbers
+static id SHConvertStringToScalar(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    __unsafe_unretained SHModelObject *model = object;
+    if (descriptor.inputDateFormat != 0) {
+        return [model dateFromString:value format:descriptor.inputDateFormat ivar:descriptor asTimeInterval:YES];
+    }
+    SHDecodingContext *context = model->_context;
+    if (context.dateConversionOption == kDateConverstionFromNSStringToNSTimeIntervalOption) {
+        return [model dateFromString:value format:context.inputDateFormat ivar:descriptor asTimeInterval:YES];
+    }
+    return SHNumberFromString(value) ?: SHNumberFromStringLeniently(value, descriptor);
 }
 
-- (NSDate *)dateFromDotNetJSONString:(NSString *)string {
-    if (!string) {
-        return nil;
+static id SHConvertStringToBool(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    if ([value caseInsensitiveCompare:@"true"] == NSOrderedSame ||
+        [value caseInsensitiveCompare:@"yes"] == NSOrderedSame) {
+        return @YES;
     }
-    static NSRegularExpression *dateRegEx = nil;
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-      dateRegEx = [[NSRegularExpression alloc] initWithPattern:@"^\\/date\\((-?\\d++)(?:([+-])(\\d{2})(\\d{2}))?\\)\\/$"
-                                                       options:NSRegularExpressionCaseInsensitive
-                                                         error:nil];
-    });
-    NSTextCheckingResult *regexResult =
-        [dateRegEx firstMatchInString:string options:0 range:NSMakeRange(0, [string length])];
+    if ([value caseInsensitiveCompare:@"false"] == NSOrderedSame ||
+        [value caseInsensitiveCompare:@"no"] == NSOrderedSame) {
+        return @NO;
+    }
+    NSNumber *number = SHNumberFromString(value);
+    return number ? @([number boolValue]) : SHNumberFromStringLeniently(value, descriptor);
+}
 
-    if (regexResult) {
-        // milliseconds
-        NSTimeInterval seconds = [[string substringWithRange:[regexResult rangeAtIndex:1]] doubleValue] / 1000.0;
-        // timezone offset
-        if ([regexResult rangeAtIndex:2].location != NSNotFound) {
-            NSString *sign = [string substringWithRange:[regexResult rangeAtIndex:2]];
-            // hours
-            seconds += [[NSString stringWithFormat:@"%@%@", sign, [string substringWithRange:[regexResult rangeAtIndex:3]]] doubleValue] * 60.0 * 60.0;
-            // minutes
-            seconds += [[NSString stringWithFormat:@"%@%@", sign, [string substringWithRange:[regexResult rangeAtIndex:4]]] doubleValue] * 60.0;
-        }
+static id SHConvertStringToNumber(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    if ([descriptor.objectClass isSubclassOfClass:[NSDecimalNumber class]]) {
+        return [NSDecimalNumber decimalNumberWithString:value];
+    }
+    return SHNumberFromString(value) ?: SHNumberFromStringLeniently(value, descriptor);
+}
+
+static id SHConvertNumberToString(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    return [value stringValue];
+}
+
+static id SHConvertNumberToDecimal(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    if ([value isKindOfClass:[NSDecimalNumber class]]) {
+        return value;
+    }
+    return [NSDecimalNumber decimalNumberWithDecimal:[value decimalValue]];
+}
+
+// nested models are decoded with the context the object containing them has for the field
+static id SHConvertDictionaryToModel(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    __unsafe_unretained SHModelObject *model = object;
+    Class objectClass = descriptor.objectClass;
+    SHDecodingContext *context = [model->_context contextForIvar:descriptor];
+    if ([[model class] decodesNestedObjectsLazily]) {
+        NSDictionary *source = [value copy];
+        return SHLazyValueWithCurrentSession(^id {
+            return [objectClass objectWithDictionary:source context:context];
+        });
+    }
+    SHDecodingCounters *counters = model->_counters;
+    uint64_t start = counters ? SHDecodingTimestamp() : 0;
+    id nested = [objectClass objectWithDictionary:value context:context];
+    if (counters) {
+        SHDecodingCounterAdd(&counters->nestedDecodingTicks, (int64_t)(SHDecodingTimestamp() - start));
+    }
+    return nested;
+}
+
+// arrays with an element class from the schema or the mappings become arrays of models
+static id SHConvertArray(id object, SHModelIvarDescriptor *descriptor, id value, id key) {
+    __unsafe_unretained SHModelObject *model = object;
+    Class objectClass = [model elementClassForIvar:descriptor key:key];
+    if (![model isSHModelObject:objectClass]) {
+        return value;
+    }
+    SHDecodingContext *context = [model->_context contextForIvar:descriptor];
+    if ([[model class] decodesNestedObjectsLazily]) {
+        NSArray *source = [value copy];
+        return SHLazyValueWithCurrentSession(^id {
+            return [objectClass objectsWithArray:source context:context];
+        });
+    }
+    // created in parallel once the array is longer than `parallelBatchThreshold` if `objectClass` opts in
+    SHDecodingCounters *counters = model->_counters;
+    uint64_t start = counters ? SHDecodingTimestamp() : 0;
+    id models = [objectClass objectsWithArray:value context:context];
+    if (counters) {
+        SHDecodingCounterAdd(&counters->nestedDecodingTicks, (int64_t)(SHDecodingTimestamp() - start));
+    }
+    return models;
+}
 
-        return [NSDate dateWithTimeIntervalSince1970:seconds];
+// chosen once per ivar and kind of value when the class plan is built, so converting a value is one call
++ (SHValueConverter)valueConverterForIvar:(SHModelIvarDescriptor *)descriptor kind:(SHValueKind)kind {
+    if (kind == SHValueKindOther) {
+        return NULL;
+    }
+    if (descriptor.valueTransformer) {
+        return SHConvertWithTransformer;
+    }
+
+    Class target = descriptor.objectClass;
+    BOOL isObject = (descriptor.type == SHIvarTypeObject);
+    // `id` ivars and ivars of classes that are not linked in take any value
+    BOOL isAnyObject = isObject && Nil == target;
+    if (descriptor.type == SHIvarTypeUnknown) {
+        return (kind == SHValueKindNumber) ? NULL : SHConvertMismatch;
+    }
+
+    switch (kind) {
+        case SHValueKindString: {
+            if (!isObject) {
+                return (descriptor.type == SHIvarTypeBool) ? SHConvertStringToBool : SHConvertStringToScalar;
+            }
+            if (isAnyObject || [target isSubclassOfClass:[NSString class]]) {
+                return descriptor.interned ? SHConvertStringInterned : NULL;
+            }
+            if ([target isSubclassOfClass:[NSDate class]]) {
+                return SHConvertStringToDate;
+            }
+            if ([target isSubclassOfClass:[NSNumber class]]) {
+                return SHConvertStringToNumber;
+            }
+        } break;
+        case SHValueKindNumber: {
+            if (!isObject || isAnyObject) {
+                return NULL;
+            }
+            if ([target isSubclassOfClass:[NSDecimalNumber class]]) {
+                return SHConvertNumberToDecimal;
+            }
+            if ([target isSubclassOfClass:[NSNumber class]]) {
+                return NULL;
+            }
+            if ([target isSubclassOfClass:[NSString class]]) {
+                return SHConvertNumberToString;
+            }
+        } break;
+        case SHValueKindDictionary: {
+            if (descriptor.isModelClass) {
+                return SHConvertDictionaryToModel;
+            }
+            if (isAnyObject || [target isSubclassOfClass:[NSDictionary class]]) {
+                return NULL;
+            }
+        } break;
+        case SHValueKindArray: {
+            if (isAnyObject || [target isSubclassOfClass:[NSArray class]]) {
+                return SHConvertArray;
+            }
+        } break;
+        default: break;
     }
-    return nil;
+    return SHConvertMismatch;
 }
 
 @end
@@ -0,0 +1,117 @@
+// SHModelObjectPool.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class SHModelObject;
+@class SHDecodingContext;
+
+/**
+ *  The `SHModelObjectPool` keeps idle instances of one `SHModelObject` subclass, so screens that create and drop many
+ *  small objects reuse them instead of allocating new ones. recycled objects are cleared with `prepareForReuse` and
+ *  filled again through `updateWithDictionary:`.
+ *
+ *  every class has its own pool with its own lock, pools of different classes never wait on each other. idle objects
+ *  of all pools are released on memory warnings. all methods are thread-safe.
+ *
+ *  @code
+ *  SHModelObjectPool *pool = [SHModelObjectPool poolForClass:[SHQuote class]];
+ *  SHQuote *quote = [pool objectWithDictionary:dictionary];
+ *  ...
+ *  [pool recycleObject:quote];
+ *  @endcode
+ */
+@interface SHModelObjectPool : NSObject
+
+/**
+ *  returns the shared pool of the class, creating it on first use.
+ *
+ *  @param cls a `SHModelObject` subclass
+ *
+ *  @return the pool for `cls`, nil if `cls` is nil
+ */
++ (instancetype)poolForClass:(Class)cls;
+
+// releases the idle objects of all pools, called on memory warnings
++ (void)drainAllPools;
+
+// the class of the pooled objects
+@property (nonatomic, readonly) Class modelClass;
+
+// number of idle objects the pool keeps at most, 64 by default. lowering it releases the idle objects above it.
+@property (nonatomic) NSUInteger capacity;
+
+// number of idle objects in the pool
+@property (nonatomic, readonly) NSUInteger idleCount;
+
+/**
+ *  returns an idle object, or a new one when the pool is empty. the object is cleared, fill it with one of the
+ *  `updateWithDictionary:` variants.
+ *
+ *  @return an instance of `modelClass`
+ */
+- (id)dequeueObject;
+
+/**
+ *  pooled variant of `+[SHModelObject objectWithDictionary:]`
+ *
+ *  @param dictionary dictionary containing key/value pairs for the object
+ *
+ *  @return an instance of `modelClass` populated with the values from `dictionary`, nil if `dictionary` is not a
+ *  dictionary
+ */
+- (id)objectWithDictionary:(NSDictionary *)dictionary;
+
+/**
+ *  pooled variant of `+[SHModelObject objectWithDictionary:mappings:]`
+ *
+ *  @param dictionary dictionary containing key/value pairs for the object
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return an instance of `modelClass` populated with the values from `dictionary`, nil if `dictionary` is not a
+ *  dictionary
+ */
+- (id)objectWithDictionary:(NSDictionary *)dictionary mappings:(NSDictionary *)mapping;
+
+/**
+ *  pooled variant of `+[SHModelObject objectWithDictionary:context:]`
+ *
+ *  @param dictionary dictionary containing key/value pairs for the object
+ *  @param context `SHDecodingContext` with the date options and mappings, nil for the default context
+ *
+ *  @return an instance of `modelClass` populated with the values from `dictionary`, nil if `dictionary` is not a
+ *  dictionary
+ */
+- (id)objectWithDictionary:(NSDictionary *)dictionary context:(SHDecodingContext *)context;
+
+/**
+ *  hands an object back to the pool once it is no longer used. the object is cleared with `prepareForReuse` right
+ *  away and released when the pool is full. objects observed through KVO are not pooled.
+ *
+ *  @param object an instance of `modelClass`, nil is ignored
+ */
+- (void)recycleObject:(SHModelObject *)object;
+
+// releases the idle objects of the pool
+- (void)drain;
+
+@end
@@ -0,0 +1,215 @@
+// SHModelObjectPool.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHModelObjectPool.h"
+#import "SHModelObject.h"
+#import <pthread.h>
+
+// idle objects a new pool keeps at most
+#define DEFAULT_POOL_CAPACITY 64
+
+@implementation SHModelObjectPool {
+    pthread_mutex_t _lock;
+    // idle objects, owned by the pool through `__bridge_retained`
+    void **_objects;
+    NSUInteger _count;
+    // slots allocated in `_objects`, grows up to the capacity
+    NSUInteger _allocated;
+    NSUInteger _capacity;
+}
+
+static NSMapTable *_pools;
+static pthread_rwlock_t _poolsLock = PTHREAD_RWLOCK_INITIALIZER;
+
++ (instancetype)poolForClass:(Class)cls {
+    if (cls == nil) {
+        return nil;
+    }
+    NSAssert([cls isSubclassOfClass:[SHModelObject class]], @"%@ is not a SHModelObject", cls);
+
+    pthread_rwlock_rdlock(&_poolsLock);
+    SHModelObjectPool *pool = [_pools objectForKey:cls];
+    pthread_rwlock_unlock(&_poolsLock);
+    if (pool) {
+        return pool;
+    }
+
+    pthread_rwlock_wrlock(&_poolsLock);
+    if (nil == _pools) {
+        _pools = [[NSMapTable alloc]
+            initWithKeyOptions:(NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality)
+                  valueOptions:NSPointerFunctionsStrongMemory
+                      capacity:16];
+        [self observeMemoryWarnings];
+    }
+    pool = [_pools objectForKey:cls];
+    if (nil == pool) {
+        pool = [[self alloc] initWithClass:cls];
+        [_pools setObject:pool forKey:cls];
+    }
+    pthread_rwlock_unlock(&_poolsLock);
+
+    return pool;
+}
+
++ (void)drainAllPools {
+    pthread_rwlock_rdlock(&_poolsLock);
+    NSArray *pools = [[_pools objectEnumerator] allObjects];
+    pthread_rwlock_unlock(&_poolsLock);
+    for (SHModelObjectPool *pool in pools) {
+        [pool drain];
+    }
+}
+
+// Foundation only, so the UIKit notification is observed by name
++ (void)observeMemoryWarnings {
+#if TARGET_OS_IPHONE
+    [[NSNotificationCenter defaultCenter] addObserverForName:@"UIApplicationDidReceiveMemoryWarningNotification"
+                                                      object:nil
+                                                       queue:nil
+                                                  usingBlock:^(NSNotification *notification) {
+                                                      [SHModelObjectPool drainAllPools];
+                                                  }];
+#elif defined(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE)
+    static dispatch_source_t source;
+    source = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+                                    DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL,
+                                    dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0));
+    dispatch_source_set_event_handler(source, ^{
+        [SHModelObjectPool drainAllPools];
+    });
+    dispatch_resume(source);
+#endif
+}
+
+- (instancetype)initWithClass:(Class)cls {
+    if ((self = [super init])) {
+        pthread_mutex_init(&_lock, NULL);
+        _modelClass = cls;
+        _capacity = DEFAULT_POOL_CAPACITY;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self drain];
+    free(_objects);
+    pthread_mutex_destroy(&_lock);
+}
+
+- (NSUInteger)capacity {
+    pthread_mutex_lock(&_lock);
+    NSUInteger capacity = _capacity;
+    pthread_mutex_unlock(&_lock);
+    return capacity;
+}
+
+- (void)setCapacity:(NSUInteger)capacity {
+    // released after unlocking, deallocating models can take a while
+    NSMutableArray *released = [NSMutableArray array];
+    pthread_mutex_lock(&_lock);
+    _capacity = capacity;
+    while (_count > capacity) {
+        [released addObject:(__bridge_transfer id)_objects[--_count]];
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+- (NSUInteger)idleCount {
+    pthread_mutex_lock(&_lock);
+    NSUInteger count = _count;
+    pthread_mutex_unlock(&_lock);
+    return count;
+}
+
+- (id)dequeueObject {
+    id object = nil;
+    pthread_mutex_lock(&_lock);
+    if (_count > 0) {
+        object = (__bridge_transfer id)_objects[--_count];
+    }
+    pthread_mutex_unlock(&_lock);
+    return object ?: [[_modelClass alloc] init];
+}
+
+- (id)objectWithDictionary:(NSDictionary *)dictionary {
+    return [self objectWithDictionary:dictionary context:[SHDecodingContext defaultContext]];
+}
+
+- (id)objectWithDictionary:(NSDictionary *)dictionary mappings:(NSDictionary *)mapping {
+    if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+    return [self objectWithDictionary:dictionary
+                              context:[[SHDecodingContext alloc]
+                                          initWithDateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                                         inputDateType:kInputDateFormatJSON
+                                                              mappings:mapping]];
+}
+
+- (id)objectWithDictionary:(NSDictionary *)dictionary context:(SHDecodingContext *)context {
+    if (nil == dictionary || ![dictionary isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+    return [[self dequeueObject] updateWithDictionary:dictionary context:context];
+}
+
+- (void)recycleObject:(SHModelObject *)object {
+    if (nil == object) {
+        return;
+    }
+    NSAssert([object class] == _modelClass, @"%@ does not belong to the pool of %@", object, _modelClass);
+    // observers expect their object to keep its values
+    if (nil != [object observationInfo]) {
+        return;
+    }
+
+    // cleared outside the lock, also releases the values of the object right away
+    [object prepareForReuse];
+
+    pthread_mutex_lock(&_lock);
+    if (_count < _capacity) {
+        if (_count == _allocated) {
+            _allocated = MAX(_allocated * 2, (NSUInteger)16);
+            _objects = realloc(_objects, _allocated * sizeof(void *));
+        }
+        _objects[_count++] = (__bridge_retained void *)object;
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+- (void)drain {
+    NSMutableArray *released = [NSMutableArray array];
+    pthread_mutex_lock(&_lock);
+    while (_count > 0) {
+        [released addObject:(__bridge_transfer id)_objects[--_count]];
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %p %@ idle: %lu/%lu>", NSStringFromClass([self class]), self,
+                                      NSStringFromClass(_modelClass), (unsigned long)[self idleCount],
+                                      (unsigned long)[self capacity]];
+}
+
+@end
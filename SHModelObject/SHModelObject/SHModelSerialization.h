@@ -22,6 +22,25 @@
 
 #import <Foundation/Foundation.h>
 
+// `NSArray` of additional dictionary keys for the ivar, matched like the ivar name
+extern NSString *const SHModelSchemaKeysKey;
+
+// class of an object ivar, for `id` ivars holding a nested model
+extern NSString *const SHModelSchemaClassKey;
+
+// class of the elements of an array ivar, used instead of the `mappings` passed when decoding
+extern NSString *const SHModelSchemaElementClassKey;
+
+// format of date strings for the ivar, a `kInputDateFormat` as `NSNumber` or a custom `NSDateFormatter` format string
+extern NSString *const SHModelSchemaDateFormatKey;
+
+// `NSValueTransformer` for the values of the ivar, or the name it was registered with through
+// `+[NSValueTransformer setValueTransformer:forName:]`. exporting uses its reverse transformation, if it has one.
+extern NSString *const SHModelSchemaTransformerKey;
+
+// `@YES` to share equal strings of the field inside a `SHDecodingSession`, for low-cardinality values like types
+extern NSString *const SHModelSchemaInternedKey;
+
 /**
  *  The `SHModalSerialization` protocol is adopted by any class that will then implement how to serialize the key/value
  *  pair passed to the class.
@@ -40,4 +59,38 @@
  */
 - (void) serializeValue:(id)value withKey:(id)key;
 
+@optional
+
+/**
+ *  declares the decoding rules of the fields of the class, so they do not have to be written in an override of
+ *  `serializeValue:withKey:`. the keys are ivar names (matched like dictionary keys, `title` finds `_title`), the
+ *  values dictionaries with the `SHModelSchema...Key` keys above. the schema is read once, when the class plan is
+ *  built.
+ *
+ *  a date format makes strings for the ivar dates independent of the options passed when decoding: `NSDate` ivars
+ *  get an `NSDate`, `double` ivars an `NSTimeInterval`. exporting writes them in the same format.
+ *
+ *  @code
+ *  + (NSDictionary *)modelSchema {
+ *      return @{ @"title" : @{ SHModelSchemaKeysKey : @[ @"headline" ] },
+ *                @"entries" : @{ SHModelSchemaElementClassKey : [Entry class] },
+ *                @"published" : @{ SHModelSchemaDateFormatKey : @(kInputDateFormatDotNetSimple) } };
+ *  }
+ *  @endcode
+ *
+ *  subclasses inherit the schema of their superclass, an override has to merge it with `[super modelSchema]`.
+ *
+ *  @return the schema, nil if the class has none
+ */
++ (NSDictionary *)modelSchema;
+
+/**
+ *  names the ivar identifying objects of the class, matched like a dictionary key. inside a `SHDecodingSession`
+ *  dictionaries with a primary key already decoded resolve to the object decoded first, the repeated dictionary is
+ *  not decoded again.
+ *
+ *  @return the key of the primary key ivar, nil if the class has none
+ */
++ (NSString *)primaryKey;
+
 @end
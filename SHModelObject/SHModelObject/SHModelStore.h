@@ -0,0 +1,103 @@
+// SHModelStore.h
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ *  The `SHModelStore` keeps a list of `SHModelObject` instances in one file with an index of record offsets. the file
+ *  is memory mapped and `objectAtIndex:` decodes only the requested record straight from the mapping, so opening a
+ *  store costs the same no matter how many objects it holds.
+ *
+ *  records are encoded like `SHModelArchiver` archives, with one schema table for the whole file. appended records
+ *  and a new index are written behind the existing data and the header is switched to them last, an interrupted
+ *  write leaves the previous state readable. removed records are only marked in the index until `compact` rewrites
+ *  the file without them.
+ *
+ *  all methods are thread-safe, reads run concurrently.
+ */
+@interface SHModelStore : NSObject
+
+/**
+ *  opens the store at the path, creating an empty store if there is no file yet
+ *
+ *  @param path file path
+ *
+ *  @return the store, nil if the file is not a store or cannot be created
+ */
+- (instancetype)initWithPath:(NSString *)path;
+
+// path of the store file
+@property (nonatomic, readonly) NSString *path;
+
+// number of records, removed ones not included
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ *  decodes the record at the index
+ *
+ *  @param index index of the record, records keep the order they were appended in
+ *
+ *  @return the decoded object, nil if the index is out of bounds or the record cannot be decoded
+ */
+- (id)objectAtIndex:(NSUInteger)index;
+
+/**
+ *  decodes the records in the range, see `objectAtIndex:`
+ *
+ *  @param range range of records
+ *
+ *  @return the decoded objects, records that cannot be decoded are left out
+ */
+- (NSArray *)objectsInRange:(NSRange)range;
+
+/**
+ *  appends objects to the end of the store
+ *
+ *  @param objects `SHModelObject` instances
+ *
+ *  @return `NO` if writing the file failed. the store is unchanged then, unless only syncing the new header failed:
+ *  the file is kept and the store has the records the header points at. a store whose file cannot be mapped again
+ *  after a write has no records and refuses further writes.
+ */
+- (BOOL)appendObjects:(NSArray *)objects;
+
+/**
+ *  removes the record at the index. the record is marked as removed, its bytes stay in the file until `compact`.
+ *
+ *  @param index index of the record
+ *
+ *  @return `NO` if the index is out of bounds or writing the file failed
+ */
+- (BOOL)removeObjectAtIndex:(NSUInteger)index;
+
+// bytes of removed records and replaced indexes that `compact` would free
+@property (nonatomic, readonly) unsigned long long reclaimableLength;
+
+/**
+ *  rewrites the file without removed records and old indexes. the records are copied as they are, without decoding
+ *  them. the new file replaces the old one atomically.
+ *
+ *  @return `NO` if writing the new file failed, the store is unchanged then
+ */
+- (BOOL)compact;
+
+@end
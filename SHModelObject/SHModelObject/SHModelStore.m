@@ -0,0 +1,523 @@
+// SHModelStore.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import "SHModelStore.h"
+#import "SHModelArchiver.h"
+#import <fcntl.h>
+#import <pthread.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+/*
+ file layout, all integers little-endian:
+
+ header    `SHMS`, format version (1 byte), 3 reserved bytes, offset of the current trailer (8 bytes)
+ records   encoded values, one after the other. appends add records and a new trailer at the end of the file.
+ trailer   schema table length (8 bytes), schema table, record count (8 bytes), removed record count (8 bytes),
+           one index entry per record: offset (8 bytes), length (4 bytes), flags (4 bytes)
+ */
+
+static const uint8_t SHModelStoreMagic[] = { 'S', 'H', 'M', 'S' };
+
+#define HEADER_LENGTH 16
+#define TRAILER_OFFSET_POSITION 8
+#define ENTRY_LENGTH 16
+#define ENTRY_FLAGS_POSITION 12
+
+// set in the flags of removed records
+#define ENTRY_FLAG_REMOVED 1
+
+// bytes copied at a time when compacting
+#define COPY_BUFFER_LENGTH (256 * 1024)
+
+static inline uint64_t SHReadLittleEndian(const uint8_t *bytes, NSUInteger size) {
+    uint64_t value = 0;
+    for (NSUInteger i = 0; i < size; i++) {
+        value |= (uint64_t)bytes[i] << (8 * i);
+    }
+    return value;
+}
+
+static inline void SHWriteLittleEndian(uint8_t *bytes, uint64_t value, NSUInteger size) {
+    for (NSUInteger i = 0; i < size; i++) {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static inline void SHAppendLittleEndian(NSMutableData *data, uint64_t value, NSUInteger size) {
+    uint8_t bytes[8];
+    SHWriteLittleEndian(bytes, value, size);
+    [data appendBytes:bytes length:size];
+}
+
+static BOOL SHWriteFully(int fd, const void *bytes, size_t length, off_t offset) {
+    const uint8_t *cursor = bytes;
+    while (length > 0) {
+        ssize_t written = pwrite(fd, cursor, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NO;
+        }
+        cursor += written;
+        length -= (size_t)written;
+        offset += written;
+    }
+    return YES;
+}
+
+// header pointing at the trailer at `trailerOffset`
+static NSData *SHHeaderData(uint64_t trailerOffset) {
+    uint8_t header[HEADER_LENGTH] = { 0 };
+    memcpy(header, SHModelStoreMagic, sizeof(SHModelStoreMagic));
+    header[sizeof(SHModelStoreMagic)] = SHModelArchiveFormatVersion;
+    SHWriteLittleEndian(header + TRAILER_OFFSET_POSITION, trailerOffset, 8);
+    return [NSData dataWithBytes:header length:HEADER_LENGTH];
+}
+
+// trailer with the schema table and the index entries
+static NSMutableData *SHTrailerData(NSData *schemaData, NSUInteger recordCount, NSUInteger removedCount) {
+    NSMutableData *trailer = [NSMutableData dataWithCapacity:24 + [schemaData length] + recordCount * ENTRY_LENGTH];
+    SHAppendLittleEndian(trailer, [schemaData length], 8);
+    [trailer appendData:schemaData];
+    SHAppendLittleEndian(trailer, recordCount, 8);
+    SHAppendLittleEndian(trailer, removedCount, 8);
+    return trailer;
+}
+
+static inline void SHAppendEntry(NSMutableData *trailer, uint64_t offset, uint32_t length, uint32_t flags) {
+    SHAppendLittleEndian(trailer, offset, 8);
+    SHAppendLittleEndian(trailer, length, 4);
+    SHAppendLittleEndian(trailer, flags, 4);
+}
+
+@implementation SHModelStore {
+    pthread_rwlock_t _lock;
+    int _fd;
+    uint8_t *_map;
+    size_t _mapLength;
+
+    uint64_t _trailerOffset;
+    const uint8_t *_schemaBytes;
+    NSUInteger _schemaLength;
+    // index entries inside the mapping
+    const uint8_t *_entries;
+    NSUInteger _recordCount;
+    NSUInteger _removedCount;
+
+    // positions of the records that are not removed, NULL as long as nothing is removed
+    NSUInteger *_live;
+    NSUInteger _liveCount;
+
+    SHModelArchiveReader *_reader;
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    if ((self = [super init])) {
+        _path = [path copy];
+        _fd = -1;
+        pthread_rwlock_init(&_lock, NULL);
+        if (![self openFile]) {
+            return nil;
+        }
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [self closeFile];
+    pthread_rwlock_destroy(&_lock);
+}
+
+#pragma mark - file
+
+- (BOOL)openFile {
+    _fd = open([_path fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+    if (_fd < 0) {
+        NSLog(@"cannot open the store at %@: %s", _path, strerror(errno));
+        return NO;
+    }
+
+    struct stat info;
+    if (fstat(_fd, &info) != 0) {
+        return NO;
+    }
+    if (info.st_size == 0 && ![self writeEmptyStore]) {
+        NSLog(@"cannot create the store at %@: %s", _path, strerror(errno));
+        return NO;
+    }
+    return [self mapFile];
+}
+
+- (BOOL)writeEmptyStore {
+    NSData *schemaData = [[[SHModelArchiveWriter alloc] init] schemaData];
+    NSMutableData *file = [SHHeaderData(HEADER_LENGTH) mutableCopy];
+    [file appendData:SHTrailerData(schemaData, 0, 0)];
+    return SHWriteFully(_fd, [file bytes], [file length], 0) && fsync(_fd) == 0;
+}
+
+- (void)closeFile {
+    [self unmapFile];
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+// leaves an empty store without records, nothing points into the old mapping afterwards
+- (void)unmapFile {
+    if (_map) {
+        munmap(_map, _mapLength);
+    }
+    _map = NULL;
+    _mapLength = 0;
+    _trailerOffset = 0;
+    _schemaBytes = NULL;
+    _schemaLength = 0;
+    _entries = NULL;
+    _recordCount = 0;
+    _removedCount = 0;
+    free(_live);
+    _live = NULL;
+    _liveCount = 0;
+    _reader = nil;
+}
+
+// maps the file and reads the trailer the header points at
+- (BOOL)mapFile {
+    [self unmapFile];
+
+    struct stat info;
+    if (fstat(_fd, &info) != 0 || info.st_size < HEADER_LENGTH) {
+        return NO;
+    }
+    _mapLength = (size_t)info.st_size;
+    void *map = mmap(NULL, _mapLength, PROT_READ, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED) {
+        NSLog(@"cannot map the store at %@: %s", _path, strerror(errno));
+        _mapLength = 0;
+        return NO;
+    }
+    _map = map;
+
+    if (memcmp(_map, SHModelStoreMagic, sizeof(SHModelStoreMagic)) != 0 ||
+        _map[sizeof(SHModelStoreMagic)] > SHModelArchiveFormatVersion) {
+        NSLog(@"%@ is not a store of a supported version.", _path);
+        [self unmapFile];
+        return NO;
+    }
+
+    // every length is checked against the file before it is used
+    uint64_t trailerOffset = SHReadLittleEndian(_map + TRAILER_OFFSET_POSITION, 8);
+    uint64_t length = _mapLength;
+    if (trailerOffset < HEADER_LENGTH || trailerOffset > length || length - trailerOffset < 8) {
+        [self unmapFile];
+        return NO;
+    }
+    uint64_t schemaLength = SHReadLittleEndian(_map + trailerOffset, 8);
+    uint64_t countsOffset = trailerOffset + 8 + schemaLength;
+    if (schemaLength > length || countsOffset > length || length - countsOffset < 16) {
+        [self unmapFile];
+        return NO;
+    }
+    uint64_t recordCount = SHReadLittleEndian(_map + countsOffset, 8);
+    uint64_t removedCount = SHReadLittleEndian(_map + countsOffset + 8, 8);
+    uint64_t entriesOffset = countsOffset + 16;
+    if (recordCount > (length - entriesOffset) / ENTRY_LENGTH || removedCount > recordCount) {
+        [self unmapFile];
+        return NO;
+    }
+
+    _trailerOffset = trailerOffset;
+    _schemaBytes = _map + trailerOffset + 8;
+    _schemaLength = (NSUInteger)schemaLength;
+    _entries = _map + entriesOffset;
+    _recordCount = (NSUInteger)recordCount;
+    _removedCount = (NSUInteger)removedCount;
+    _liveCount = _recordCount;
+    _reader = [[SHModelArchiveReader alloc] initWithSchemaBytes:_schemaBytes length:_schemaLength];
+    if (nil == _reader) {
+        [self unmapFile];
+        return NO;
+    }
+
+    // only stores with removed records need the table of live records
+    if (_removedCount > 0) {
+        [self buildLiveRecords];
+    }
+    return YES;
+}
+
+- (void)buildLiveRecords {
+    free(_live);
+    _live = malloc(MAX(_recordCount, 1) * sizeof(NSUInteger));
+    _liveCount = 0;
+    for (NSUInteger i = 0; i < _recordCount; i++) {
+        if (!([self flagsOfEntry:i] & ENTRY_FLAG_REMOVED)) {
+            _live[_liveCount++] = i;
+        }
+    }
+}
+
+- (uint64_t)offsetOfEntry:(NSUInteger)entry {
+    return SHReadLittleEndian(_entries + entry * ENTRY_LENGTH, 8);
+}
+
+- (uint32_t)lengthOfEntry:(NSUInteger)entry {
+    return (uint32_t)SHReadLittleEndian(_entries + entry * ENTRY_LENGTH + 8, 4);
+}
+
+- (uint32_t)flagsOfEntry:(NSUInteger)entry {
+    return (uint32_t)SHReadLittleEndian(_entries + entry * ENTRY_LENGTH + ENTRY_FLAGS_POSITION, 4);
+}
+
+- (NSData *)schemaData {
+    return [NSData dataWithBytes:_schemaBytes length:_schemaLength];
+}
+
+#pragma mark - reading
+
+- (NSUInteger)count {
+    pthread_rwlock_rdlock(&_lock);
+    NSUInteger count = _liveCount;
+    pthread_rwlock_unlock(&_lock);
+    return count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+    pthread_rwlock_rdlock(&_lock);
+    id object = [self decodeObjectAtIndex:index];
+    pthread_rwlock_unlock(&_lock);
+    return object;
+}
+
+- (NSArray *)objectsInRange:(NSRange)range {
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:range.length];
+    pthread_rwlock_rdlock(&_lock);
+    for (NSUInteger i = range.location; i < NSMaxRange(range) && i < _liveCount; i++) {
+        id object = [self decodeObjectAtIndex:i];
+        if (object) {
+            [objects addObject:object];
+        }
+    }
+    pthread_rwlock_unlock(&_lock);
+    return objects;
+}
+
+// decodes straight from the mapping, the caller holds the lock
+- (id)decodeObjectAtIndex:(NSUInteger)index {
+    if (index >= _liveCount) {
+        return nil;
+    }
+    NSUInteger entry = _live ? _live[index] : index;
+    uint64_t offset = [self offsetOfEntry:entry];
+    uint32_t length = [self lengthOfEntry:entry];
+    if (offset < HEADER_LENGTH || offset > _trailerOffset || _trailerOffset - offset < length) {
+        NSLog(@"record %lu of the store at %@ is out of bounds.", (unsigned long)index, _path);
+        return nil;
+    }
+
+    BOOL error = NO;
+    id object = [_reader decodeObjectFromBytes:_map + offset length:length decodedLength:NULL error:&error];
+    if (error) {
+        NSLog(@"record %lu of the store at %@ cannot be decoded.", (unsigned long)index, _path);
+    }
+    return object;
+}
+
+#pragma mark - writing
+
+- (BOOL)appendObjects:(NSArray *)objects {
+    pthread_rwlock_wrlock(&_lock);
+    BOOL success = [self writeAppendingObjects:objects];
+    pthread_rwlock_unlock(&_lock);
+    return success;
+}
+
+- (BOOL)writeAppendingObjects:(NSArray *)objects {
+    if ([objects count] == 0) {
+        return YES;
+    }
+    // a store whose file could not be mapped again is not written, the file may still hold its records
+    if (NULL == _map) {
+        return NO;
+    }
+
+    SHModelArchiveWriter *writer = [[SHModelArchiveWriter alloc] initWithSchemaData:[self schemaData]];
+    if (nil == writer) {
+        return NO;
+    }
+
+    // new records and the new trailer go behind everything in the file
+    uint64_t start = _mapLength;
+    NSMutableData *records = [NSMutableData data];
+    NSMutableArray *lengths = [NSMutableArray arrayWithCapacity:[objects count]];
+    for (id object in objects) {
+        NSData *record = [writer dataWithObject:object];
+        if (nil == record || [record length] > UINT32_MAX) {
+            return NO;
+        }
+        [records appendData:record];
+        [lengths addObject:@([record length])];
+    }
+
+    NSUInteger recordCount = _recordCount + [objects count];
+    NSMutableData *trailer = SHTrailerData([writer schemaData], recordCount, _removedCount);
+    [trailer appendBytes:_entries length:_recordCount * ENTRY_LENGTH];
+    uint64_t offset = start;
+    for (NSNumber *length in lengths) {
+        SHAppendEntry(trailer, offset, (uint32_t)[length unsignedIntegerValue], 0);
+        offset += [length unsignedIntegerValue];
+    }
+    [records appendData:trailer];
+
+    // the header is switched to the new trailer only when everything else is on disk
+    if (!SHWriteFully(_fd, [records bytes], [records length], (off_t)start) || fsync(_fd) != 0) {
+        NSLog(@"cannot append to the store at %@: %s", _path, strerror(errno));
+        ftruncate(_fd, (off_t)start);
+        return NO;
+    }
+    // the header may already point at the new trailer, both trailers stay valid and the file is mapped again with
+    // whichever the header points at
+    NSData *header = SHHeaderData(offset);
+    if (!SHWriteFully(_fd, [header bytes], [header length], 0) || fsync(_fd) != 0) {
+        NSLog(@"cannot append to the store at %@: %s", _path, strerror(errno));
+        [self mapFile];
+        return NO;
+    }
+    return [self mapFile];
+}
+
+- (BOOL)removeObjectAtIndex:(NSUInteger)index {
+    pthread_rwlock_wrlock(&_lock);
+    BOOL success = [self writeRemovingObjectAtIndex:index];
+    pthread_rwlock_unlock(&_lock);
+    return success;
+}
+
+- (BOOL)writeRemovingObjectAtIndex:(NSUInteger)index {
+    if (index >= _liveCount) {
+        return NO;
+    }
+    NSUInteger entry = _live ? _live[index] : index;
+
+    // the count goes first, an interrupted removal then only leaves the record in place
+    uint8_t removedCount[8];
+    SHWriteLittleEndian(removedCount, _removedCount + 1, 8);
+    uint8_t flags[4];
+    SHWriteLittleEndian(flags, [self flagsOfEntry:entry] | ENTRY_FLAG_REMOVED, 4);
+    off_t entriesOffset = (off_t)(_entries - _map);
+    if (!SHWriteFully(_fd, removedCount, sizeof(removedCount), entriesOffset - 8) ||
+        !SHWriteFully(_fd, flags, sizeof(flags), entriesOffset + (off_t)(entry * ENTRY_LENGTH + ENTRY_FLAGS_POSITION))) {
+        NSLog(@"cannot remove from the store at %@: %s", _path, strerror(errno));
+        [self mapFile];
+        return NO;
+    }
+    // the mapping already shows what was written, it is read again like the file is after a restart
+    if (fsync(_fd) != 0) {
+        NSLog(@"cannot remove from the store at %@: %s", _path, strerror(errno));
+        [self mapFile];
+        return NO;
+    }
+
+    _removedCount++;
+    if (NULL == _live) {
+        [self buildLiveRecords];
+    } else {
+        memmove(_live + index, _live + index + 1, (_liveCount - index - 1) * sizeof(NSUInteger));
+        _liveCount--;
+    }
+    return YES;
+}
+
+- (unsigned long long)reclaimableLength {
+    pthread_rwlock_rdlock(&_lock);
+    uint64_t used = HEADER_LENGTH + (_mapLength - _trailerOffset);
+    for (NSUInteger i = 0; i < _liveCount; i++) {
+        used += [self lengthOfEntry:_live ? _live[i] : i];
+    }
+    unsigned long long reclaimable = _mapLength - used;
+    pthread_rwlock_unlock(&_lock);
+    return reclaimable;
+}
+
+- (BOOL)compact {
+    pthread_rwlock_wrlock(&_lock);
+    BOOL success = [self writeCompactedFile];
+    pthread_rwlock_unlock(&_lock);
+    return success;
+}
+
+- (BOOL)writeCompactedFile {
+    if (NULL == _map) {
+        return NO;
+    }
+    NSString *temporaryPath = [_path stringByAppendingString:@".compacting"];
+    int fd = open([temporaryPath fileSystemRepresentation], O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        NSLog(@"cannot compact the store at %@: %s", _path, strerror(errno));
+        return NO;
+    }
+
+    // the records are valid with the same schema table, they are copied without decoding
+    NSMutableData *trailer = SHTrailerData([self schemaData], _liveCount, 0);
+    NSMutableData *buffer = [NSMutableData dataWithCapacity:COPY_BUFFER_LENGTH];
+    uint64_t offset = HEADER_LENGTH;
+    uint64_t bufferOffset = HEADER_LENGTH;
+    BOOL success = YES;
+    for (NSUInteger i = 0; i < _liveCount && success; i++) {
+        NSUInteger entry = _live ? _live[i] : i;
+        uint64_t recordOffset = [self offsetOfEntry:entry];
+        uint32_t length = [self lengthOfEntry:entry];
+        if (recordOffset < HEADER_LENGTH || recordOffset > _trailerOffset || _trailerOffset - recordOffset < length) {
+            success = NO;
+            break;
+        }
+
+        [buffer appendBytes:_map + recordOffset length:length];
+        SHAppendEntry(trailer, offset, length, 0);
+        offset += length;
+        if ([buffer length] >= COPY_BUFFER_LENGTH) {
+            success = SHWriteFully(fd, [buffer bytes], [buffer length], (off_t)bufferOffset);
+            bufferOffset += [buffer length];
+            [buffer setLength:0];
+        }
+    }
+    [buffer appendData:trailer];
+
+    NSData *header = SHHeaderData(offset);
+    success = success && SHWriteFully(fd, [buffer bytes], [buffer length], (off_t)bufferOffset) &&
+              SHWriteFully(fd, [header bytes], [header length], 0) && fsync(fd) == 0;
+    close(fd);
+    if (!success || rename([temporaryPath fileSystemRepresentation], [_path fileSystemRepresentation]) != 0) {
+        NSLog(@"cannot compact the store at %@: %s", _path, strerror(errno));
+        unlink([temporaryPath fileSystemRepresentation]);
+        return NO;
+    }
+
+    [self closeFile];
+    return [self openFile];
+}
+
+@end
@@ -25,6 +25,8 @@
 #import <Realm/RLMObject.h>
 #import "SHConstants.h"
 
+@class RLMRealm;
+
 /**
  *  The `SHRealmObject` is a base class that uses objective-c runtime to populate a modal class instance variables
  *  by passing a NSDictionary to it. The NSDictionary key is compared with the instance variable name and the value is
@@ -220,6 +222,38 @@
                   inputDateFormatter:(NSDateFormatter *)inputDateFormatter
                             mappings:(NSDictionary *)mapping;
 
+/**
+ *  imports an array of dictionaries into a realm, e.g. a whole API response. the objects are decoded before any write
+ *  transaction begins, on all cores for arrays of 1024 or more dictionaries unless the class overrides
+ *  `serializeValue:withKey:`, then written in transactions of `writeBatchSize` objects. objects whose
+ *  primary key is already in the realm are updated, classes without a `+primaryKey` only add objects.
+ *
+ *  when the realm is already in a write transaction the objects are added to it and nothing is committed. otherwise
+ *  the transactions committed before a failing one stay in the realm.
+ *
+ *  @param array array of dictionaries, items that are not dictionaries are skipped
+ *  @param realm the realm to write to
+ *
+ *  @return the objects, managed by the realm. nil if `array` is not an array or a transaction failed
+ */
++ (NSArray *)createOrUpdateObjectsWithArray:(NSArray *)array inRealm:(RLMRealm *)realm;
+
+/**
+ *  like `createOrUpdateObjectsWithArray:inRealm:`, the objects are decoded like `objectWithDictionary:mappings:`
+ *
+ *  @param array array of dictionaries
+ *  @param realm the realm to write to
+ *  @param mapping dictionary to define the mappings for date conversion and array <-> object.
+ *
+ *  @return the objects, managed by the realm. nil if `array` is not an array or a transaction failed
+ */
++ (NSArray *)createOrUpdateObjectsWithArray:(NSArray *)array inRealm:(RLMRealm *)realm mappings:(NSDictionary *)mapping;
+
+// number of objects `createOrUpdateObjectsWithArray:inRealm:` writes in one transaction. 1000 by default, can be
+// changed from any thread.
++ (NSUInteger)writeBatchSize;
++ (void)setWriteBatchSize:(NSUInteger)batchSize;
+
 @end
 
 @interface NSString (Additions)
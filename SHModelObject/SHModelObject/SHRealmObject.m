@@ -22,41 +22,20 @@
 
 #import "SHRealmObject.h"
 #import <objc/runtime.h>
+#import <Realm/RLMArray.h>
+#import <Realm/RLMRealm.h>
+#import "SHModelClassPlan.h"
+#import "SHKeyNormalizer.h"
+#import "SHDateParsing.h"
 #import <objc/message.h>
 
-/**
- *  trims a given NSString
- *
- *  @param val the NSString to be trimmed
- *
- *  @return trimmed NSString
- */
-#define TRIM_STRING(val) [val stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]]
-
-/**
- *  checks if a NSString is valid
- *
- *  @param val a NSString to be checked
- *
- *  @return `YES` or `NO` based on the validity of the NSString
- */
-#define IS_VALID_STRING(val)                                                                                           \
-    (val != nil) && [val length] != 0 && ([TRIM_STRING(val) length] != 0) && ![val isEqualToString:@"(null)"]
-
-// pattern to strip from the dictionary key and ivarname for comparision
-#define PATTERN_TO_STRIP @"-_ "
-
-static NSDateFormatter *_simpleDateFormatter;
-static NSDateFormatter *_timezoneDateFormatter;
-static NSDateFormatter *_customFormatter;
-
 @implementation SHRealmObject {
-    Ivar *_ivars;
-    unsigned int _outCount;
+    SHModelClassPlan *_plan;
     kDateConversionOption _converstionOption;
     kInputDateFormat _inputDateFormat;
     NSDictionary *_mappings;
     NSString *_customInputDateFormatString;
+    NSDateFormatter *_customFormatter;
 }
 
 #pragma mark - Factory methods for object creation
@@ -137,6 +116,131 @@ static NSDateFormatter *_customFormatter;
                                            mappings:mapping];
 }
 
+#pragma mark - Bulk import
+
+// can be changed while other threads import, so it is only read and written atomically
+static NSUInteger _writeBatchSize = 1000;
+
+// arrays shorter than this are decoded on the calling thread, the default `+[SHModelObject parallelBatchThreshold]`
+static const NSUInteger SHRealmParallelDecodeThreshold = 1024;
+
+// number of dictionaries decoded by one parallel work item
+static const NSUInteger SHRealmDecodeGrainSize = 256;
+
++ (NSUInteger)writeBatchSize {
+    return __atomic_load_n(&_writeBatchSize, __ATOMIC_RELAXED);
+}
+
++ (void)setWriteBatchSize:(NSUInteger)batchSize {
+    __atomic_store_n(&_writeBatchSize, MAX(batchSize, 1), __ATOMIC_RELAXED);
+}
+
++ (NSArray *)createOrUpdateObjectsWithArray:(NSArray *)array inRealm:(RLMRealm *)realm {
+    NSArray *objects = [self objectsWithArray:array usingBlock:^id(NSDictionary *item) {
+        return [self objectWithDictionary:item];
+    }];
+    return [self writeObjects:objects toRealm:realm];
+}
+
++ (NSArray *)createOrUpdateObjectsWithArray:(NSArray *)array
+                                    inRealm:(RLMRealm *)realm
+                                   mappings:(NSDictionary *)mapping {
+    NSArray *objects = [self objectsWithArray:array usingBlock:^id(NSDictionary *item) {
+        return [self objectWithDictionary:item mappings:mapping];
+    }];
+    return [self writeObjects:objects toRealm:realm];
+}
+
+// decodes the dictionaries into unmanaged objects, on all cores for large arrays. the order is kept
++ (NSArray *)objectsWithArray:(NSArray *)array usingBlock:(id (^)(NSDictionary *item))block {
+    if (nil == array || ![array isKindOfClass:[NSArray class]]) {
+        return nil;
+    }
+
+    NSArray *items = [array copy];
+    NSUInteger count = [items count];
+    __strong id *objects = (__strong id *)calloc(MAX(count, 1), sizeof(id));
+    void (^createObjects)(NSUInteger, NSUInteger) = ^(NSUInteger start, NSUInteger end) {
+        for (NSUInteger i = start; i < end; i++) {
+            id item = items[i];
+            if ([item isKindOfClass:[NSDictionary class]]) {
+                objects[i] = block(item);
+            } else {
+                NSLog(@"object %@ is not a NSDictionary object, skipping.", [item description]);
+            }
+        }
+    };
+
+    // a `serializeValue:withKey:` override is not known to be thread safe
+    SEL serializeSelector = @selector(serializeValue:withKey:);
+    BOOL overridesSerializeValue = [self instanceMethodForSelector:serializeSelector] !=
+                                   [SHRealmObject instanceMethodForSelector:serializeSelector];
+    if (count < SHRealmParallelDecodeThreshold || overridesSerializeValue) {
+        createObjects(0, count);
+    } else {
+        // the plan is built once before the workers share it
+        [SHModelClassPlan planForClass:self rootClass:[SHRealmObject class]];
+        size_t chunks = (count + SHRealmDecodeGrainSize - 1) / SHRealmDecodeGrainSize;
+        // every work item fills its own range of `objects`, so no locking is needed
+        dispatch_apply(chunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+            @autoreleasepool {
+                createObjects(chunk * SHRealmDecodeGrainSize, MIN((chunk + 1) * SHRealmDecodeGrainSize, count));
+            }
+        });
+    }
+
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        if (objects[i]) {
+            [result addObject:objects[i]];
+            objects[i] = nil;
+        }
+    }
+    free(objects);
+    return result;
+}
+
+// writes the objects in transactions of `writeBatchSize` objects, updating objects with the same primary key
++ (NSArray *)writeObjects:(NSArray *)objects toRealm:(RLMRealm *)realm {
+    if (nil == objects || nil == realm) {
+        return nil;
+    }
+
+    BOOL upsert = ([self primaryKey] != nil);
+    void (^write)(NSArray *) = ^(NSArray *batch) {
+        if (upsert) {
+            [realm addOrUpdateObjects:batch];
+        } else {
+            [realm addObjects:batch];
+        }
+    };
+
+    // the caller's transaction is not ours to commit
+    if (realm.inWriteTransaction) {
+        write(objects);
+        return objects;
+    }
+
+    NSUInteger count = [objects count];
+    NSUInteger batchSize = [self writeBatchSize];
+    for (NSUInteger start = 0; start < count; start += batchSize) {
+        @autoreleasepool {
+            NSArray *batch = [objects subarrayWithRange:NSMakeRange(start, MIN(batchSize, count - start))];
+            [realm beginWriteTransaction];
+            write(batch);
+            NSError *error = nil;
+            if (![realm commitWriteTransaction:&error]) {
+                NSLog(@"writing %@ objects failed: %@", NSStringFromClass(self), error);
+                if (realm.inWriteTransaction) {
+                    [realm cancelWriteTransaction];
+                }
+                return nil;
+            }
+        }
+    }
+    return objects;
+}
+
 //
 - (instancetype)initWithDictionary:(NSDictionary *)dictionary;
 {
@@ -191,24 +295,7 @@ static NSDateFormatter *_customFormatter;
 
 // NSCoding
 - (NSArray *)propertyNames {
-    NSMutableArray *array = [NSMutableArray array];
-
-    // List of ivars
-    NSString *selfClassName = NSStringFromClass([self class]);
-    NSString *actualClassName = [[selfClassName componentsSeparatedByString:@"_"] lastObject];
-    id class = objc_getClass([actualClassName UTF8String]);
-    _ivars = class_copyIvarList(class, &_outCount);
-
-    // If it match our ivar name, then set it
-    for (unsigned int i = 0; i < _outCount; i++) {
-        Ivar ivar = _ivars[i];
-        NSString *ivarName = [NSString stringWithCString:ivar_getName(ivar) encoding:NSUTF8StringEncoding];
-        [array addObject:ivarName];
-    }
-
-    free(_ivars);
-    _ivars = NULL;
-    return array;
+    return [[self classPlan] ivarNames];
 }
 
 - (id)initWithCoder:(NSCoder *)aDecoder {
@@ -234,11 +321,8 @@ static NSDateFormatter *_customFormatter;
 
 //
 - (instancetype)updateWithDictionary:(NSDictionary *)dictionary {
-    // List of ivars
-    NSString *selfClassName = NSStringFromClass([self class]);
-    NSString *actualClassName = [[selfClassName componentsSeparatedByString:@"_"] lastObject];
-    id class = objc_getClass([actualClassName UTF8String]);
-    _ivars = class_copyIvarList(class, &_outCount);
+    // cached list of ivars
+    _plan = [self classPlan];
 
     // For each top-level property in the dictionary
     NSEnumerator *enumerator = [dictionary keyEnumerator];
@@ -248,9 +332,6 @@ static NSDateFormatter *_customFormatter;
         [self serializeValue:value withKey:key];
     }
 
-    free(_ivars);
-    _ivars = NULL;
-
     return self;
 }
 
@@ -263,16 +344,6 @@ static NSDateFormatter *_customFormatter;
     _inputDateFormat = inputDateType;
     _mappings = mapping;
 
-    if (nil == _simpleDateFormatter) {
-        _simpleDateFormatter = [[NSDateFormatter alloc] init];
-        [_simpleDateFormatter setDateFormat:@"yyyy-MM-dd'T'HH:mm:ss"];
-    }
-
-    if (nil == _timezoneDateFormatter) {
-        _timezoneDateFormatter = [[NSDateFormatter alloc] init];
-        [_timezoneDateFormatter setDateFormat:@"yyyy-MM-dd'T'HH:mm:ssZZZZZ"];
-    }
-
     return [self updateWithDictionary:dictionary];
 }
 
@@ -283,10 +354,8 @@ static NSDateFormatter *_customFormatter;
     _converstionOption = option;
     _inputDateFormat = kInputDateFormatCustom;
     _customInputDateFormatString = inputDateFormat;
-    if (_customInputDateFormatString && !_customFormatter) {
-        _customFormatter = [[NSDateFormatter alloc] init];
-        [_customFormatter setDateFormat:_customInputDateFormatString];
-    }
+    // resolved per thread when parsing, see `customDateFormatter`
+    _customFormatter = nil;
     _mappings = mapping;
 
     return [self updateWithDictionary:dictionary];
@@ -299,6 +368,7 @@ static NSDateFormatter *_customFormatter;
     _converstionOption = option;
     _inputDateFormat = kInputDateFormatCustom;
     _customFormatter = inputDateFormatter;
+    _customInputDateFormatString = nil;
     _mappings = mapping;
 
     return [self updateWithDictionary:dictionary];
@@ -318,17 +388,25 @@ static NSDateFormatter *_customFormatter;
     }
 
     // If it match our ivar name, then set it
-    for (unsigned int i = 0; i < _outCount; i++) {
-        Ivar ivar = _ivars[i];
-        NSString *ivarName = [NSString stringWithCString:ivar_getName(ivar) encoding:NSUTF8StringEncoding];
-        NSString *ivarType = [NSString stringWithCString:ivar_getTypeEncoding(ivar) encoding:NSUTF8StringEncoding];
-
-        if ([self matchesPattern:key ivar:ivarName] == NO) {
-            continue;
-        }
+    if (nil == _plan) {
+        _plan = [self classPlan];
+    }
+    SHModelIvarDescriptor *descriptor = [_plan ivarForKey:key];
+    if (descriptor) {
+        NSString *ivarName = descriptor.name;
+        NSString *ivarType = descriptor.typeEncoding;
 
         // it will be NSString, NSNumber, NSArray, NSDictionary or NSNull
         if ([value isKindOfClass:[NSString class]]) {
+            kDateConversionOption conversionOption = _converstionOption;
+            kInputDateFormat inputDateFormat = _inputDateFormat;
+            if (descriptor.inputDateFormat != 0) {
+                // dates declared in the schema are converted to the type of the ivar
+                inputDateFormat = descriptor.inputDateFormat;
+                conversionOption = (descriptor.type == SHIvarTypeObject)
+                                       ? kDateConverstionFromNSStringToNSDateOption
+                                       : kDateConverstionFromNSStringToNSTimeIntervalOption;
+            }
 
             /*
              converting the .NET JSON Date representation to either NSDate, NSTimeInterval or keeping it as
@@ -336,21 +414,25 @@ static NSDateFormatter *_customFormatter;
              value and set for yourself and make sure you call [super serializeValue: key:] for all other values so
              that they are parsed correctly.
             */
-            switch (_converstionOption) {
+            switch (conversionOption) {
                 case kDateConverstionFromNSStringToNSDateOption: {
                     if ([ivarType contains:@"NSDate"]) {
-                        switch (_inputDateFormat) {
+                        switch (inputDateFormat) {
                             case kInputDateFormatJSON: {
                                 value = (NSDate *)[self dateFromDotNetJSONString:value];
                             } break;
                             case kInputDateFormatDotNetSimple: {
-                                value = (NSDate *)[_simpleDateFormatter dateFromString:value];
+                                NSTimeInterval interval = 0;
+                                BOOL parsed = SHParseDotNetSimpleDate(value, &interval);
+                                value = parsed ? [NSDate dateWithTimeIntervalSince1970:interval] : nil;
                             } break;
                             case kInputDateFormatDotNetWithTimeZone: {
-                                value = (NSDate *)[_timezoneDateFormatter dateFromString:value];
+                                NSTimeInterval interval = 0;
+                                BOOL parsed = SHParseDotNetDateWithTimeZone(value, &interval);
+                                value = parsed ? [NSDate dateWithTimeIntervalSince1970:interval] : nil;
                             } break;
                             case kInputDateFormatCustom: {
-                                value = (NSDate *)[_customFormatter dateFromString:value];
+                                value = (NSDate *)[[self customDateFormatterForIvar:descriptor] dateFromString:value];
                             } break;
 
                             default: { value = (NSDate *)[self dateFromDotNetJSONString:value]; } break;
@@ -359,21 +441,30 @@ static NSDateFormatter *_customFormatter;
                 } break;
                 case kDateConverstionFromNSStringToNSTimeIntervalOption: {
                     if (![ivarType contains:@"@"]) {
-                        switch (_inputDateFormat) {
+                        switch (inputDateFormat) {
                             case kInputDateFormatJSON: {
-                                value = @([[self dateFromDotNetJSONString:value] timeIntervalSince1970]);
+                                NSTimeInterval interval = 0;
+                                SHParseDotNetJSONDate(value, &interval);
+                                value = @(interval);
                             } break;
                             case kInputDateFormatDotNetSimple: {
-                                value = @([[_simpleDateFormatter dateFromString:value] timeIntervalSince1970]);
+                                NSTimeInterval interval = 0;
+                                SHParseDotNetSimpleDate(value, &interval);
+                                value = @(interval);
                             } break;
                             case kInputDateFormatDotNetWithTimeZone: {
-                                value = @([[_timezoneDateFormatter dateFromString:value] timeIntervalSince1970]);
+                                NSTimeInterval interval = 0;
+                                SHParseDotNetDateWithTimeZone(value, &interval);
+                                value = @(interval);
                             } break;
                             case kInputDateFormatCustom: {
-                                value = @([[_customFormatter dateFromString:value] timeIntervalSince1970]);
+                                NSDateFormatter *formatter = [self customDateFormatterForIvar:descriptor];
+                                value = @([[formatter dateFromString:value] timeIntervalSince1970]);
                             } break;
                             default: {
-                                value = @([[self dateFromDotNetJSONString:value] timeIntervalSince1970]);
+                                NSTimeInterval interval = 0;
+                                SHParseDotNetJSONDate(value, &interval);
+                                value = @(interval);
                             } break;
                         }
                     }
@@ -391,12 +482,8 @@ static NSDateFormatter *_customFormatter;
                 NSAssert(false, @"the types do not match : %@ vs %@", ivarType, @"NSNumber");
             }
         } else if ([value isKindOfClass:[NSDictionary class]]) {
-            NSString *typeName = [ivarType stringByReplacingOccurrencesOfString:@"@" withString:@""];
-            typeName = [typeName stringByReplacingOccurrencesOfString:@"\"" withString:@""];
-            Class objectClass = NSClassFromString(typeName);
-            BOOL isSHRealmObject = [self isSHRealmObject:objectClass];
-            if (isSHRealmObject) {
-                value = [objectClass objectWithDictionary:value];
+            if (descriptor.isModelClass) {
+                value = [descriptor.objectClass objectWithDictionary:value];
             } else if (![ivarType contains:@"Dictionary"]) {
                 NSAssert(false, @"the types do not match : %@ vs %@", ivarType, @"NSDictionary or NSMutableDictionary");
             }
@@ -405,43 +492,45 @@ static NSDateFormatter *_customFormatter;
                 NSAssert(false, @"the types do not match : %@ vs %@", ivarType, @"NSArray or NSMutableArray");
             }
 
+            Class objectClass = descriptor.elementClass;
             id availableMappingClass = _mappings[key];
-            if (availableMappingClass && [availableMappingClass isKindOfClass:[NSString class]]) {
+            if (Nil == objectClass && availableMappingClass && [availableMappingClass isKindOfClass:[NSString class]]) {
                 // mapping string available.
-                Class objectClass = NSClassFromString(availableMappingClass);
-                BOOL isSHRealmObject = [self isSHRealmObject:objectClass];
-                if (isSHRealmObject) {
-
-                    NSString *propName = [ivarName substringFromIndex:1];
-                    id realmArray = ((id (*)(id, SEL))objc_msgSend)(self, NSSelectorFromString(propName));
-                    for (id item in value) {
-                        // item should be a dictionary
-                        if ([item isKindOfClass:[NSDictionary class]]) {
-                            id itemObject = [objectClass objectWithDictionary:item mappings:_mappings];
-                            if (itemObject) {
-                                if ([realmArray respondsToSelector:@selector(addObject:)]) {
-                                    [realmArray addObject:itemObject];
-                                }
-                            }
-                        } else {
-                            NSLog(@"object %@ is not a NSDictionary object, skipping.", [item description]);
+                objectClass = NSClassFromString(availableMappingClass);
+            }
+            if ([objectClass isSubclassOfClass:[SHRealmObject class]]) {
+                NSString *propName = [ivarName substringFromIndex:1];
+                id realmArray = ((id (*)(id, SEL))objc_msgSend)(self, NSSelectorFromString(propName));
+                if (![realmArray respondsToSelector:@selector(addObjects:)]) {
+                    return;
+                }
+                NSMutableArray *itemObjects = [NSMutableArray arrayWithCapacity:[value count]];
+                for (id item in value) {
+                    // item should be a dictionary
+                    if ([item isKindOfClass:[NSDictionary class]]) {
+                        id itemObject = [objectClass objectWithDictionary:item mappings:_mappings];
+                        if (itemObject) {
+                            [itemObjects addObject:itemObject];
                         }
+                    } else {
+                        NSLog(@"object %@ is not a NSDictionary object, skipping.", [item description]);
                     }
                 }
+                [realmArray addObjects:itemObjects];
             }
             return;
         }
-        [self setValue:value forKey:ivarName];
+        if (nil == self.realm) {
+            SHModelSetIvarValue(self, descriptor, value);
+        } else {
+            // managed objects keep their values in the realm, not in the ivars
+            [self setValue:value forKey:ivarName];
+        }
     }
 }
 
-- (BOOL)isSHRealmObject:(Class) class {
-    if (class == nil)
-        return NO;
-    if (class == [SHRealmObject class]) {
-        return YES;
-    }
-    return [self isSHRealmObject:[class superclass]];
+- (SHModelClassPlan *)classPlan {
+    return [SHModelClassPlan planForClass:[self class] rootClass:[SHRealmObject class]];
 }
 
 #pragma mark - NSObject overriden methods
@@ -459,72 +548,32 @@ static NSDateFormatter *_customFormatter;
         return NO;
     }
 
-    if ((!IS_VALID_STRING(key)) || (!IS_VALID_STRING(ivarName))) {
+    // both are normalized (stripped of `-`, `_` and ` ` and lowercased) and interned, so this does not allocate for
+    // keys that were seen before.
+    SHNormalizedKey *normalizedKey = [SHNormalizedKey normalizedKeyForString:key];
+    SHNormalizedKey *normalizedIvar = [SHNormalizedKey normalizedKeyForString:ivarName];
+    if (nil == normalizedKey || nil == normalizedIvar) {
         return NO;
     }
+    return [normalizedKey isEqual:normalizedIvar];
+}
 
-    NSMutableString *prettyKey = [NSMutableString stringWithCapacity:key.length];
-    NSMutableString *prettyIvar = [NSMutableString stringWithCapacity:ivarName.length];
-
-    NSScanner *scannerForKey = [NSScanner scannerWithString:key];
-    NSScanner *scannerForIvar = [NSScanner scannerWithString:ivarName];
-
-    scannerForKey.caseSensitive = NO;
-    scannerForIvar.caseSensitive = NO;
-
-    NSCharacterSet *stripChars = [[NSCharacterSet characterSetWithCharactersInString:PATTERN_TO_STRIP] invertedSet];
-    while ([scannerForKey isAtEnd] == NO) {
-        NSString *buffer;
-        if ([scannerForKey scanCharactersFromSet:stripChars intoString:&buffer]) {
-            [prettyKey appendString:buffer];
-
-        } else {
-            [scannerForKey setScanLocation:([scannerForKey scanLocation] + 1)];
-        }
-    }
-
-    while ([scannerForIvar isAtEnd] == NO) {
-        NSString *buffer;
-        if ([scannerForIvar scanCharactersFromSet:stripChars intoString:&buffer]) {
-            [prettyIvar appendString:buffer];
-        } else {
-            [scannerForIvar setScanLocation:([scannerForIvar scanLocation] + 1)];
-        }
-    }
+// formatter passed with `inputDateFormatter:`, or this thread's formatter for the `inputDateFormat:` string
+- (NSDateFormatter *)customDateFormatter {
+    return _customFormatter ?: SHDateFormatterForFormat(_customInputDateFormatString);
+}
 
-    return ([[prettyKey lowercaseString] isEqualToString:[prettyIvar lowercaseString]]);
+// formatter for the custom date format of the ivar's schema, or `customDateFormatter`
+- (NSDateFormatter *)customDateFormatterForIvar:(SHModelIvarDescriptor *)descriptor {
+    return descriptor.dateFormat ? SHDateFormatterForFormat(descriptor.dateFormat) : [self customDateFormatter];
 }
 
 - (NSDate *)dateFromDotNetJSONString:(NSString *)string {
-    if (!string) {
+    NSTimeInterval interval = 0;
+    if (!SHParseDotNetJSONDate(string, &interval)) {
         return nil;
     }
-    static NSRegularExpression *dateRegEx = nil;
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-        dateRegEx =
-            [[NSRegularExpression alloc] initWithPattern:@"^\\/date\\((-?\\d++)(?:([+-])(\\d{2})(\\d{2}))?\\)\\/$"
-                                                 options:NSRegularExpressionCaseInsensitive
-                                                   error:nil];
-    });
-    NSTextCheckingResult *regexResult =
-        [dateRegEx firstMatchInString:string options:0 range:NSMakeRange(0, [string length])];
-
-    if (regexResult) {
-        // milliseconds
-        NSTimeInterval seconds = [[string substringWithRange:[regexResult rangeAtIndex:1]] doubleValue] / 1000.0;
-        // timezone offset
-        if ([regexResult rangeAtIndex:2].location != NSNotFound) {
-            NSString *sign = [string substringWithRange:[regexResult rangeAtIndex:2]];
-            // hours
-            seconds += [[NSString stringWithFormat:@"%@%@", sign, [string substringWithRange:[regexResult rangeAtIndex:3]]] doubleValue] * 60.0 * 60.0;
-            // minutes
-            seconds += [[NSString stringWithFormat:@"%@%@", sign, [string substringWithRange:[regexResult rangeAtIndex:4]]] doubleValue] * 60.0;
-        }
-
-        return [NSDate dateWithTimeIntervalSince1970:seconds];
-    }
-    return nil;
+    return [NSDate dateWithTimeIntervalSince1970:interval];
 }
 
 @end
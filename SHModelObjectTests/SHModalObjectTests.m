@@ -7,12 +7,471 @@
 //
 
 #import <XCTest/XCTest.h>
+#import "SHModelObject.h"
+#import "SHKeyNormalizer.h"
+#import "SHModelClassPlan.h"
+#import "SHModelArrayDecoder.h"
+#import "SHDateParsing.h"
+#import "SHModelArchiver.h"
+#import "SHModelStore.h"
+#import "SHLazyValue.h"
+#import "SHDecodingStatistics.h"
+#import "SHModelObjectPool.h"
+#import "SHDecodingSession.h"
+#import "SHModelCollection.h"
+#import "SHTestModal.h"
+#import "SHAnotherModel.h"
+
+@interface SHModelObject (Testing)
+
+- (BOOL)matchesPattern:(NSString *)key ivar:(NSString *)ivarName;
+- (NSArray *)propertyNames;
+
+@end
+
+/**
+ *  the NSScanner based key matching `matchesPattern:ivar:` used before keys were normalized in a single pass. kept
+ *  here as the reference the new implementation is compared against.
+ */
+static BOOL SHReferenceMatchesPattern(NSString *key, NSString *ivarName) {
+    if (nil == key || nil == ivarName) {
+        return NO;
+    }
+
+    for (NSString *val in @[ key, ivarName ]) {
+        if ([val length] == 0 ||
+            [[val stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]] length] == 0 ||
+            [val isEqualToString:@"(null)"]) {
+            return NO;
+        }
+    }
+
+    NSMutableString *prettyKey = [NSMutableString stringWithCapacity:key.length];
+    NSMutableString *prettyIvar = [NSMutableString stringWithCapacity:ivarName.length];
+
+    NSScanner *scannerForKey = [NSScanner scannerWithString:key];
+    NSScanner *scannerForIvar = [NSScanner scannerWithString:ivarName];
+
+    scannerForKey.caseSensitive = NO;
+    scannerForIvar.caseSensitive = NO;
+
+    NSCharacterSet *stripChars = [[NSCharacterSet characterSetWithCharactersInString:@"-_ "] invertedSet];
+    while ([scannerForKey isAtEnd] == NO) {
+        NSString *buffer;
+        if ([scannerForKey scanCharactersFromSet:stripChars intoString:&buffer]) {
+            [prettyKey appendString:buffer];
+        } else {
+            [scannerForKey setScanLocation:([scannerForKey scanLocation] + 1)];
+        }
+    }
+
+    while ([scannerForIvar isAtEnd] == NO) {
+        NSString *buffer;
+        if ([scannerForIvar scanCharactersFromSet:stripChars intoString:&buffer]) {
+            [prettyIvar appendString:buffer];
+        } else {
+            [scannerForIvar setScanLocation:([scannerForIvar scanLocation] + 1)];
+        }
+    }
+
+    return ([[prettyKey lowercaseString] isEqualToString:[prettyIvar lowercaseString]]);
+}
+
+/**
+ *  the regular expression based parsing of `dateFromDotNetJSONString:` before it was replaced by
+ *  `SHParseDotNetJSONDate`, the reference for the differential test.
+ */
+static NSDate *SHReferenceDateFromDotNetJSONString(NSString *string) {
+    static NSRegularExpression *dateRegEx = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        dateRegEx = [[NSRegularExpression alloc] initWithPattern:@"^\\/date\\((-?\\d++)(?:([+-])(\\d{2})(\\d{2}))?\\)\\/$"
+                                                         options:NSRegularExpressionCaseInsensitive
+                                                           error:nil];
+    });
+    NSTextCheckingResult *regexResult =
+        [dateRegEx firstMatchInString:string options:0 range:NSMakeRange(0, [string length])];
+    if (nil == regexResult) {
+        return nil;
+    }
+
+    NSTimeInterval seconds = [[string substringWithRange:[regexResult rangeAtIndex:1]] doubleValue] / 1000.0;
+    if ([regexResult rangeAtIndex:2].location != NSNotFound) {
+        NSString *sign = [string substringWithRange:[regexResult rangeAtIndex:2]];
+        NSString *hours = [string substringWithRange:[regexResult rangeAtIndex:3]];
+        NSString *minutes = [string substringWithRange:[regexResult rangeAtIndex:4]];
+        seconds += [[NSString stringWithFormat:@"%@%@", sign, hours] doubleValue] * 60.0 * 60.0;
+        seconds += [[NSString stringWithFormat:@"%@%@", sign, minutes] doubleValue] * 60.0;
+    }
+    return [NSDate dateWithTimeIntervalSince1970:seconds];
+}
+
+@interface SHPrimitiveModel : SHModelObject {
+    int _intValue;
+    BOOL _flag;
+    float _ratio;
+    unsigned long long _bigValue;
+    int _doubledValue;
+    __weak id _weakValue;
+}
+
+@property (nonatomic) double doubleValue;
+@property (nonatomic) NSInteger integerValue;
+@property (nonatomic) int doubledValue;
+
+@end
+
+@implementation SHPrimitiveModel
+
+// custom property setter for `_doubledValue`, must be honored by the direct ivar stores
+- (void)setDoubledValue:(int)value {
+    _doubledValue = value * 2;
+}
+
+- (int)doubledValue {
+    return _doubledValue;
+}
+
+@end
+
+@interface SHFeedModel : SHModelObject {
+    NSString *_title;
+    int _count;
+    double _score;
+    BOOL _active;
+    SHAnotherModel *_featured;
+    NSArray *_entries;
+}
+
+@end
+
+@implementation SHFeedModel
+
+@end
+
+@interface SHLazyFeedModel : SHFeedModel
+
+@end
+
+@implementation SHLazyFeedModel
+
++ (BOOL)decodesNestedObjectsLazily {
+    return YES;
+}
+
+@end
+
+@interface SHSchemaModel : SHModelObject {
+    NSString *_title;
+    id _author;
+    NSArray *_entries;
+    NSDate *_published;
+    NSTimeInterval _updated;
+    NSDate *_created;
+}
+
+@end
+
+@implementation SHSchemaModel
+
++ (NSDictionary *)modelSchema {
+    return @{
+        @"title" : @{SHModelSchemaKeysKey : @[ @"headline", @"name" ]},
+        @"author" : @{SHModelSchemaClassKey : [SHAnotherModel class]},
+        @"entries" : @{SHModelSchemaElementClassKey : [SHAnotherModel class], SHModelSchemaKeysKey : @[ @"items" ]},
+        @"published" : @{SHModelSchemaDateFormatKey : @(kInputDateFormatDotNetSimple)},
+        @"updated" : @{SHModelSchemaDateFormatKey : @(kInputDateFormatJSON)},
+        @"created" : @{SHModelSchemaDateFormatKey : @"dd.MM.yyyy"}
+    };
+}
+
+@end
+
+// only used by the prewarming test, so their plans are not built by other tests
+@interface SHPrewarmItemModel : SHModelObject {
+    NSString *_text;
+}
+
+@end
+
+@implementation SHPrewarmItemModel
+
+@end
+
+@interface SHPrewarmFeaturedModel : SHPrewarmItemModel
+
+@end
+
+@implementation SHPrewarmFeaturedModel
+
+@end
+
+@interface SHPrewarmModel : SHModelObject {
+    SHPrewarmFeaturedModel *_featured;
+    NSArray *_items;
+}
+
+@end
+
+@implementation SHPrewarmModel
+
++ (NSDictionary *)modelSchema {
+    return @{ @"items" : @{SHModelSchemaElementClassKey : [SHPrewarmItemModel class]} };
+}
+
+@end
+
+@interface SHAuthorModel : SHModelObject {
+    NSString *_id;
+    NSString *_name;
+}
+
+@end
+
+@implementation SHAuthorModel
+
++ (NSString *)primaryKey {
+    return @"id";
+}
+
+@end
+
+@interface SHCommentModel : SHModelObject {
+    NSString *_text;
+    NSString *_modelType;
+    SHAuthorModel *_author;
+}
+
+@end
+
+@implementation SHCommentModel
+
++ (NSDictionary *)modelSchema {
+    return @{ @"modelType" : @{SHModelSchemaInternedKey : @YES} };
+}
+
+@end
+
+@interface SHLazyCommentModel : SHCommentModel
+
+@end
+
+@implementation SHLazyCommentModel
+
++ (BOOL)decodesNestedObjectsLazily {
+    return YES;
+}
+
+@end
+
+@interface SHURLTransformer : NSValueTransformer
+
+@end
+
+@implementation SHURLTransformer
+
++ (BOOL)allowsReverseTransformation {
+    return YES;
+}
+
+- (id)transformedValue:(id)value {
+    return [value isKindOfClass:[NSString class]] ? [NSURL URLWithString:value] : nil;
+}
+
+- (id)reverseTransformedValue:(id)value {
+    return [value absoluteString];
+}
+
+@end
+
+@interface SHConverterModel : SHModelObject {
+    NSString *_label;
+    int _count;
+    BOOL _enabled;
+    double _ratio;
+    NSNumber *_amount;
+    NSDecimalNumber *_price;
+}
+
+@end
+
+@implementation SHConverterModel
+
+@end
+
+// transformers are chosen when the plan is built, only decode this class after registering them
+@interface SHTransformerModel : SHModelObject {
+    NSURL *_link;
+    NSURL *_mirror;
+}
+
+@end
+
+@implementation SHTransformerModel
+
++ (NSDictionary *)modelSchema {
+    return @{ @"mirror" : @{SHModelSchemaTransformerKey : @"SHURLTransformer"} };
+}
+
+@end
+
+@interface SHEventModel : SHModelObject {
+    NSDate *_start;
+}
+
+@end
+
+@implementation SHEventModel
+
+@end
+
+@interface SHScheduleModel : SHModelObject {
+    NSDate *_updated;
+    SHEventModel *_main;
+    NSArray *_events;
+}
+
+@end
+
+@implementation SHScheduleModel
+
++ (NSDictionary *)modelSchema {
+    return @{ @"events" : @{SHModelSchemaElementClassKey : [SHEventModel class]} };
+}
+
+@end
+
+@interface SHParallelModel : SHAnotherModel
+
+@end
+
+@implementation SHParallelModel
+
++ (BOOL)decodesArraysInParallel {
+    return YES;
+}
+
+@end
+
+// opts in to parallel decoding, but the override keeps it on the calling thread
+static BOOL _serializedOffCallingThread;
+
+@interface SHSerializingParallelModel : SHParallelModel
+
+@end
+
+@implementation SHSerializingParallelModel
+
+- (void)serializeValue:(id)value withKey:(id)key {
+    if (![NSThread isMainThread]) {
+        _serializedOffCallingThread = YES;
+    }
+    [super serializeValue:value withKey:key];
+}
+
+@end
+
+typedef struct {
+    char tag;
+    double amount;
+} SHPaddedEntry;
+
+// a struct ivar with padding between its fields
+@interface SHPaddedModel : SHModelObject {
+    SHPaddedEntry _entry;
+}
+
+@property (nonatomic) double ratio;
+
+// copies the struct with its padding bytes
+- (void)copyEntryBytes:(const SHPaddedEntry *)entry;
+
+@end
+
+@implementation SHPaddedModel
+
+- (void)copyEntryBytes:(const SHPaddedEntry *)entry {
+    memcpy(&_entry, entry, sizeof(_entry));
+}
+
+@end
+
+// an archive written before `SHPrimitiveModel` had most of its ivars
+@interface SHLegacyPrimitiveArchive : NSObject <NSCoding>
+
+@end
+
+@implementation SHLegacyPrimitiveArchive
+
+- (id)initWithCoder:(NSCoder *)aDecoder {
+    return [self init];
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+    [aCoder encodeObject:@7 forKey:@"_intValue"];
+}
+
+@end
+
+// children point back at their parent
+@interface SHTreeNodeModel : SHModelObject
+
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, copy) NSArray *children;
+@property (nonatomic, weak) SHTreeNodeModel *parent;
+
+@end
+
+@implementation SHTreeNodeModel
+
+@end
+
+// three versions of an archived class, the names have the same length so archives can be patched from one to another
+@interface SHArchiveModelV1 : SHModelObject {
+    NSString *_name;
+    int _count;
+    double _score;
+    NSString *_removed;
+}
+
+@end
+
+@implementation SHArchiveModelV1
+
+@end
+
+@interface SHArchiveModelV2 : SHModelObject {
+    NSString *_name;
+    long long _count;
+    float _score;
+    NSDate *_added;
+}
+
+@end
+
+@implementation SHArchiveModelV2
+
+@end
+
+@interface SHArchiveModelV3 : SHArchiveModelV1
+
+@end
+
+@implementation SHArchiveModelV3
+
++ (NSUInteger)archiveVersion {
+    return 1;
+}
+
+@end
 
 @interface SHModalObjectTests : XCTestCase
 
 @end
 
-@implementation SHModalObjectTests
+@implementation SHModalObjectTests {
+    NSInteger _observedChanges;
+}
 
 - (void)setUp
 {
@@ -31,4 +490,1966 @@
     XCTFail(@"No implementation for \"%s\"", __PRETTY_FUNCTION__);
 }
 
+#pragma mark - key matching
+
+- (NSArray *)keyCorpus
+{
+    return @[
+        @"", @" ", @"  ", @"\t", @"\n", @" \t\n", @"(null)", @"(NULL)", @" (null)", @"-", @"_", @"__", @"-_ ",
+        @"_-_a", @"a", @"A", @"userName", @"user_name", @"USER_NAME", @"USERNAME", @"UserName", @"_userName",
+        @"user-name", @"user name", @"user__name", @"user_ name", @"user _name", @"user\tname", @"user_\tname",
+        @"\tuserName", @"userName\t", @"user\nname", @"user_\nname", @"user name", @"_ userName",
+        @"user name", @"intValue", @"INTVALUE", @"_intValue", @"int_value", @"anotherIntValue",
+        @"another_int_value", @"AnotherIntValue", @"time1", @"TIME_1", @"time-1", @"_my_dictionary", @"myDictionary",
+        @"numberVALUE", @"Äpfel", @"äpfel", @"_ä_pfel", @"straße", @"STRASSE", @"İd", @"i̇d",
+        @"ΣΣ", @"σς", @"café", @"CAFÉ", @"\U0001F600key", @"key\U0001F600",
+        @"a-b_c d", @"ABC-DEF", @"abcdef", @"x", @"X_", @"_X"
+    ];
+}
+
+- (void)testMatchesPatternAgreesWithReferenceImplementation
+{
+    NSArray *corpus = [self keyCorpus];
+    SHModelObject *object = [[SHModelObject alloc] init];
+    for (NSString *key in corpus) {
+        for (NSString *ivarName in corpus) {
+            XCTAssertEqual([object matchesPattern:key ivar:ivarName], SHReferenceMatchesPattern(key, ivarName),
+                           @"key '%@' ivar '%@'", key, ivarName);
+        }
+    }
+}
+
+- (void)testNormalizedKeysAreInterned
+{
+    SHNormalizedKey *first = [SHNormalizedKey normalizedKeyForString:@"another_int_value"];
+    SHNormalizedKey *second = [SHNormalizedKey normalizedKeyForString:[NSMutableString stringWithString:@"another_int_value"]];
+    XCTAssertEqualObjects(first.string, @"anotherintvalue");
+    XCTAssertTrue(first == second);
+    XCTAssertEqualObjects(first, [SHNormalizedKey normalizedKeyForString:@"AnotherIntValue"]);
+    XCTAssertEqual(first.keyHash, [[SHNormalizedKey normalizedKeyForString:@"AnotherIntValue"] keyHash]);
+    XCTAssertNil([SHNormalizedKey normalizedKeyForString:@"(null)"]);
+    XCTAssertNil([SHNormalizedKey normalizedKeyForString:@" \t"]);
+}
+
+#pragma mark - decoding
+
+- (NSDictionary *)sampleDictionary
+{
+    return @{
+        @"string_value" : @"shan",
+        @"another_string_value" : @"ul haq",
+        @"INTVALUE" : @12,
+        @"AnotherIntValue" : @23,
+        @"integerValue" : @78,
+        @"another_integer_value" : @98,
+        @"numberVALUE" : @YES,
+        @"another_numberVALUE" : @NO,
+        @"remember" : @(true),
+        @"do_it_my_self" : @"Yahooo",
+        @"unknown_key" : @"ignored",
+        @"myArray" : @[ @"one", @2, @NO, @"four" ],
+        @"_my_dictionary" : @{@"name" : @"correct name"},
+        @"anotherModel" : @{@"modelId" : @1, @"modelName" : @"My Model", @"modelType" : @"My Model Type"},
+        @"arrayOfAnotherModels" : @[
+            @{@"modelId" : @2, @"modelName" : @"My Model 2", @"modelType" : @"My Model Type 2"},
+            @{@"modelId" : @3, @"modelName" : @"My Model 3", @"modelType" : @"My Model Type 3"}
+        ]
+    };
+}
+
+- (void)testDecodesSampleDictionary
+{
+    SHTestModal *model = [SHTestModal objectWithDictionary:[self sampleDictionary]
+                                                  mappings:@{ @"arrayOfAnotherModels" : @"SHAnotherModel" }];
+    XCTAssertEqualObjects(model.stringValue, @"shan");
+    XCTAssertEqualObjects([model valueForKey:@"_anotherStringValue"], @"ul haq");
+    XCTAssertEqualObjects([model valueForKey:@"_intValue"], @12);
+    XCTAssertEqual(model.anotherIntValue, 23);
+    XCTAssertEqualObjects([model valueForKey:@"_integerValue"], @78);
+    XCTAssertEqual(model.anotherIntegerValue, 98);
+    XCTAssertEqualObjects([model valueForKey:@"_remember"], @YES);
+    XCTAssertEqualObjects([model valueForKey:@"_myDictionary"], @{@"name" : @"correct name"});
+    XCTAssertEqual(model.anotherModel.modelId, 1);
+    XCTAssertEqualObjects(model.anotherModel.modelName, @"My Model");
+    XCTAssertEqual([model.arrayOfAnotherModels count], (NSUInteger)2);
+    XCTAssertEqualObjects([model.arrayOfAnotherModels[1] modelType], @"My Model Type 3");
+}
+
+- (void)testStoresPrimitivesDirectly
+{
+    id weakTarget = [NSObject new];
+    SHPrimitiveModel *model = [SHPrimitiveModel objectWithDictionary:@{
+        @"int_value" : @42,
+        @"flag" : @YES,
+        @"ratio" : @0.5,
+        @"big_value" : @(ULLONG_MAX),
+        @"double_value" : @3.25,
+        @"integer_value" : @(-7),
+        @"doubled_value" : @21,
+        @"weak_value" : weakTarget
+    }];
+    XCTAssertEqualObjects([model valueForKey:@"_intValue"], @42);
+    XCTAssertEqualObjects([model valueForKey:@"_flag"], @YES);
+    XCTAssertEqualObjects([model valueForKey:@"_ratio"], @0.5f);
+    XCTAssertEqualObjects([model valueForKey:@"_bigValue"], @(ULLONG_MAX));
+    XCTAssertEqual(model.doubleValue, 3.25);
+    XCTAssertEqual(model.integerValue, -7);
+    XCTAssertEqual(model.doubledValue, 42);
+    XCTAssertEqual([model valueForKey:@"_weakValue"], weakTarget);
+
+    [model updateWithDictionary:@{ @"doubled_value" : @5 }];
+    XCTAssertEqual(model.doubledValue, 10);
+}
+
+- (void)testObservedObjectsStillSendKVONotifications
+{
+    SHPrimitiveModel *model = [[SHPrimitiveModel alloc] init];
+    [model addObserver:self forKeyPath:@"_intValue" options:NSKeyValueObservingOptionNew context:NULL];
+    _observedChanges = 0;
+    [model updateWithDictionary:@{ @"intValue" : @5 }];
+    [model removeObserver:self forKeyPath:@"_intValue"];
+    XCTAssertEqual(_observedChanges, 1);
+    XCTAssertEqualObjects([model valueForKey:@"_intValue"], @5);
+}
+
+#pragma mark - JSON data
+
+- (NSData *)JSONDataWithObject:(id)object
+{
+    return [NSJSONSerialization dataWithJSONObject:object options:0 error:NULL];
+}
+
+- (void)testDecodesJSONDataLikeDictionary
+{
+    NSDictionary *mappings = @{ @"arrayOfAnotherModels" : @"SHAnotherModel" };
+    NSData *data = [self JSONDataWithObject:[self sampleDictionary]];
+    SHTestModal *model = [SHTestModal objectWithJSONData:data mappings:mappings];
+    SHTestModal *reference = [SHTestModal objectWithDictionary:[self sampleDictionary] mappings:mappings];
+    for (NSString *key in @[ @"stringValue", @"_anotherStringValue", @"_intValue", @"anotherIntValue", @"_integerValue",
+                             @"anotherIntegerValue", @"_remember", @"_doItMySelf", @"_myArray", @"_myDictionary" ]) {
+        XCTAssertEqualObjects([model valueForKey:key], [reference valueForKey:key], @"%@", key);
+    }
+    XCTAssertEqual(model.anotherModel.modelId, 1);
+    XCTAssertEqualObjects(model.anotherModel.modelName, @"My Model");
+    XCTAssertEqual([model.arrayOfAnotherModels count], (NSUInteger)2);
+    XCTAssertEqualObjects([model.arrayOfAnotherModels[1] modelType], @"My Model Type 3");
+}
+
+- (void)testJSONDataStoresPrimitivesDirectly
+{
+    NSData *data = [@"{\"int_value\": 42, \"flag\": true, \"ratio\": 0.5, \"big_value\": 9223372036854775807, "
+                    @"\"double_value\": 3.25e0, \"integer_value\": -7, \"doubled_value\": 21, "
+                    @"\"unknown\": {\"a\": [1, 2.5, {\"b\": null}, \"\\u00e9\"]}, \"int\\u005fvalue\": 43}"
+        dataUsingEncoding:NSUTF8StringEncoding];
+    SHPrimitiveModel *model = [SHPrimitiveModel objectWithJSONData:data];
+    XCTAssertEqualObjects([model valueForKey:@"_intValue"], @43);
+    XCTAssertEqualObjects([model valueForKey:@"_flag"], @YES);
+    XCTAssertEqualObjects([model valueForKey:@"_ratio"], @0.5f);
+    XCTAssertEqualObjects([model valueForKey:@"_bigValue"], @(LLONG_MAX));
+    XCTAssertEqual(model.doubleValue, 3.25);
+    XCTAssertEqual(model.integerValue, -7);
+    XCTAssertEqual(model.doubledValue, 42);
+}
+
+- (void)testJSONDataKeepsUnsignedIntegersExact
+{
+    for (NSString *digits in @[ @"18446744073709551615", @"9223372036854775808" ]) {
+        NSString *json = [NSString stringWithFormat:@"{\"big_value\": %@, \"unknown\": [%@]}", digits, digits];
+        SHPrimitiveModel *model = [SHPrimitiveModel objectWithJSONData:[json dataUsingEncoding:NSUTF8StringEncoding]];
+        unsigned long long expected = strtoull([digits UTF8String], NULL, 10);
+        XCTAssertEqualObjects([model valueForKey:@"_bigValue"], @(expected));
+    }
+
+    // one more than ULLONG_MAX is a double
+    SHPrimitiveModel *model = [SHPrimitiveModel
+        objectWithJSONData:[@"{\"double_value\": 18446744073709551616}" dataUsingEncoding:NSUTF8StringEncoding]];
+    XCTAssertEqual(model.doubleValue, 18446744073709551616.0);
+}
+
+- (void)testJSONDataDecodesNestedModels
+{
+    NSDictionary *feed = @{
+        @"title" : @"feed",
+        @"count" : @2,
+        @"score" : @1.5,
+        @"active" : @YES,
+        @"featured" : @{@"model_id" : @7, @"model_name" : @"featured"},
+        @"entries" : @[ @{@"modelId" : @1}, @"not an object", @{@"modelId" : @2, @"extra" : @[ @1, @2 ]} ]
+    };
+    SHFeedModel *model = [SHFeedModel objectWithJSONData:[self JSONDataWithObject:feed]
+                                                mappings:@{ @"entries" : @"SHAnotherModel" }];
+    XCTAssertEqualObjects([model valueForKey:@"_title"], @"feed");
+    XCTAssertEqualObjects([model valueForKey:@"_count"], @2);
+    XCTAssertEqualObjects([model valueForKey:@"_score"], @1.5);
+    XCTAssertEqualObjects([model valueForKey:@"_active"], @YES);
+    XCTAssertEqual([[model valueForKey:@"_featured"] modelId], 7);
+    XCTAssertEqualObjects([[model valueForKey:@"_featured"] modelName], @"featured");
+    NSArray *entries = [model valueForKey:@"_entries"];
+    XCTAssertEqual([entries count], (NSUInteger)2);
+    XCTAssertEqual([entries[1] modelId], 2);
+}
+
+- (void)testJSONDataRejectsMalformedInput
+{
+    XCTAssertNil([SHPrimitiveModel objectWithJSONData:nil]);
+    for (NSString *json in @[ @"", @"[1]", @"{\"a\":1,}", @"{\"a\":1} x", @"{\"a\":01}", @"{\"a\":\"\\x\"}",
+                              @"{\"int_value\":1", @"{\"a\" 1}" ]) {
+        XCTAssertNil([SHPrimitiveModel objectWithJSONData:[json dataUsingEncoding:NSUTF8StringEncoding]], @"%@", json);
+    }
+}
+
+- (NSData *)benchmarkFeedData
+{
+    NSMutableArray *entries = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 40000; i++) {
+        [entries addObject:@{
+            @"model_id" : @(i),
+            @"model_name" : [NSString stringWithFormat:@"model %lu", (unsigned long)i],
+            @"model_type" : @"benchmark",
+            @"description" : @"a longer text the model does not have an ivar for, skipped while decoding"
+        }];
+    }
+    return [self JSONDataWithObject:@{
+        @"title" : @"benchmark",
+        @"count" : @([entries count]),
+        @"score" : @0.75,
+        @"active" : @YES,
+        @"entries" : entries
+    }];
+}
+
+- (void)testPerformanceDecodingJSONData
+{
+    NSData *data = [self benchmarkFeedData];
+    [self measureBlock:^{
+        SHFeedModel *model = [SHFeedModel objectWithJSONData:data mappings:@{ @"entries" : @"SHAnotherModel" }];
+        XCTAssertEqual([[model valueForKey:@"_entries"] count], (NSUInteger)40000);
+    }];
+}
+
+- (void)testPerformanceDecodingThroughNSJSONSerialization
+{
+    NSData *data = [self benchmarkFeedData];
+    [self measureBlock:^{
+        NSDictionary *dictionary = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+        SHFeedModel *model = [SHFeedModel objectWithDictionary:dictionary mappings:@{ @"entries" : @"SHAnotherModel" }];
+        XCTAssertEqual([[model valueForKey:@"_entries"] count], (NSUInteger)40000);
+    }];
+}
+
+#pragma mark - streaming arrays
+
+- (NSData *)modelArrayData
+{
+    NSMutableArray *array = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 50; i++) {
+        [array addObject:@{
+            @"model_id" : @(i),
+            @"model_name" : [NSString stringWithFormat:@"m\u00f6del \"%lu\" [{", (unsigned long)i],
+            @"extra" : @{@"nested" : @[ @1, @{@"deep" : @"]}"} ]}
+        }];
+        if (i == 10) {
+            [array addObject:@"not an object"];
+            [array addObject:@12];
+        }
+    }
+    return [self JSONDataWithObject:array];
+}
+
+- (SHModelArrayDecoder *)modelArrayDecoderCollectingInto:(NSMutableArray *)objects
+{
+    SHModelArrayDecoder *decoder = [[SHModelArrayDecoder alloc] initWithModelClass:[SHAnotherModel class]
+                                                              dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                                                     inputDateType:kInputDateFormatJSON
+                                                                          mappings:nil];
+    decoder.objectHandler = ^(id object) {
+        [objects addObject:object];
+    };
+    return decoder;
+}
+
+- (void)testArrayDecoderDecodesChunkedData
+{
+    NSData *data = [self modelArrayData];
+    for (NSNumber *chunk in @[ @1, @7, @4096 ]) {
+        NSUInteger chunkLength = [chunk unsignedIntegerValue];
+        NSMutableArray *objects = [NSMutableArray array];
+        SHModelArrayDecoder *decoder = [self modelArrayDecoderCollectingInto:objects];
+        for (NSUInteger offset = 0; offset < [data length]; offset += chunkLength) {
+            NSRange range = NSMakeRange(offset, MIN(chunkLength, [data length] - offset));
+            XCTAssertTrue([decoder appendData:[data subdataWithRange:range]]);
+        }
+        XCTAssertTrue([decoder finish]);
+        XCTAssertEqual([objects count], (NSUInteger)50);
+        XCTAssertEqual(decoder.objectCount, (NSUInteger)50);
+        XCTAssertEqual([objects[42] modelId], 42);
+        XCTAssertEqualObjects([objects[3] modelName], @"m\u00f6del \"3\" [{");
+    }
+}
+
+- (void)testArrayDecoderHandsOutBatches
+{
+    NSMutableArray *batchCounts = [NSMutableArray array];
+    SHModelArrayDecoder *decoder = [self modelArrayDecoderCollectingInto:[NSMutableArray array]];
+    decoder.batchSize = 16;
+    decoder.batchHandler = ^(NSArray *objects) {
+        [batchCounts addObject:@([objects count])];
+    };
+    XCTAssertTrue([decoder decodeStream:[NSInputStream inputStreamWithData:[self modelArrayData]]]);
+    XCTAssertEqualObjects(batchCounts, (@[ @16, @16, @16, @2 ]));
+}
+
+- (void)testArrayDecoderTakesCustomDateFormats
+{
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    [formatter setDateFormat:@"dd/MM/yyyy"];
+    NSData *data = [@"[{\"time1\": \"20/04/2014\"}]" dataUsingEncoding:NSUTF8StringEncoding];
+
+    NSMutableArray *objects = [NSMutableArray array];
+    SHModelArrayDecoder *formatDecoder =
+        [[SHModelArrayDecoder alloc] initWithModelClass:[SHTestModal class]
+                                   dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                        inputDateFormat:@"dd/MM/yyyy"
+                                               mappings:nil];
+    SHModelArrayDecoder *formatterDecoder =
+        [[SHModelArrayDecoder alloc] initWithModelClass:[SHTestModal class]
+                                   dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                     inputDateFormatter:formatter
+                                               mappings:nil];
+    for (SHModelArrayDecoder *decoder in @[ formatDecoder, formatterDecoder ]) {
+        decoder.objectHandler = ^(id object) {
+            [objects addObject:object];
+        };
+        XCTAssertTrue([decoder appendData:data]);
+        XCTAssertTrue([decoder finish]);
+    }
+
+    XCTAssertEqual([objects count], (NSUInteger)2);
+    for (SHTestModal *object in objects) {
+        XCTAssertEqualObjects([object valueForKey:@"time1"], [formatter dateFromString:@"20/04/2014"]);
+    }
+}
+
+- (void)testArrayDecoderRejectsMalformedArrays
+{
+    for (NSString *json in @[ @"", @"{}", @"[{}", @"[1,]", @"[,1]", @"[{} {}]", @"[{\"a\":}]", @"[] x" ]) {
+        SHModelArrayDecoder *decoder = [self modelArrayDecoderCollectingInto:[NSMutableArray array]];
+        BOOL appended = [decoder appendData:[json dataUsingEncoding:NSUTF8StringEncoding]];
+        XCTAssertFalse(appended && [decoder finish], @"%@", json);
+    }
+}
+
+#pragma mark - arrays of objects
+
+- (NSArray *)modelDictionariesWithCount:(NSUInteger)count
+{
+    NSMutableArray *array = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [array addObject:@{
+            @"model_id" : @(i),
+            @"model_name" : [NSString stringWithFormat:@"model %lu", (unsigned long)i],
+            @"model_type" : @"batch"
+        }];
+    }
+    return array;
+}
+
+- (void)testObjectsWithArrayKeepsOrderInParallel
+{
+    NSUInteger threshold = [SHModelObject parallelBatchThreshold];
+    NSUInteger grainSize = [SHModelObject batchGrainSize];
+    [SHModelObject setParallelBatchThreshold:100];
+    [SHModelObject setBatchGrainSize:7];
+
+    NSMutableArray *array = [[self modelDictionariesWithCount:5000] mutableCopy];
+    [array insertObject:@"not a dictionary" atIndex:1234];
+    NSArray *objects = [SHParallelModel objectsWithArray:array];
+
+    [SHModelObject setParallelBatchThreshold:threshold];
+    [SHModelObject setBatchGrainSize:grainSize];
+
+    XCTAssertEqual([objects count], (NSUInteger)5000);
+    for (NSUInteger i = 0; i < [objects count]; i++) {
+        XCTAssertEqual([objects[i] modelId], (int)i);
+    }
+    XCTAssertNil([SHParallelModel objectsWithArray:(NSArray *)@{}]);
+}
+
+- (void)testParallelDecodingIsOptIn
+{
+    XCTAssertFalse([SHAnotherModel decodesArraysInParallel]);
+    XCTAssertTrue([SHParallelModel decodesArraysInParallel]);
+
+    NSUInteger threshold = [SHModelObject parallelBatchThreshold];
+    NSUInteger grainSize = [SHModelObject batchGrainSize];
+    [SHModelObject setParallelBatchThreshold:10];
+    [SHModelObject setBatchGrainSize:7];
+
+    // the test runs on the main thread, a serializeValue:withKey: override must see every object there
+    XCTAssertTrue([NSThread isMainThread]);
+    _serializedOffCallingThread = NO;
+    NSArray *objects = [SHSerializingParallelModel objectsWithArray:[self modelDictionariesWithCount:2000]];
+
+    [SHModelObject setParallelBatchThreshold:threshold];
+    [SHModelObject setBatchGrainSize:grainSize];
+
+    XCTAssertEqual([objects count], (NSUInteger)2000);
+    XCTAssertEqualObjects([objects[1999] modelName], @"model 1999");
+    XCTAssertFalse(_serializedOffCallingThread);
+}
+
+- (void)testMappedArraysUseBatchCreation
+{
+    NSUInteger threshold = [SHModelObject parallelBatchThreshold];
+    [SHModelObject setParallelBatchThreshold:10];
+    SHFeedModel *model = [SHFeedModel objectWithDictionary:@{ @"entries" : [self modelDictionariesWithCount:2000] }
+                                                  mappings:@{ @"entries" : @"SHParallelModel" }];
+    [SHModelObject setParallelBatchThreshold:threshold];
+
+    NSArray *entries = [model valueForKey:@"_entries"];
+    XCTAssertEqual([entries count], (NSUInteger)2000);
+    XCTAssertEqualObjects([entries[1999] modelName], @"model 1999");
+}
+
+- (void)testPerformanceObjectsWithArrayInParallel
+{
+    NSArray *array = [self modelDictionariesWithCount:50000];
+    [self measureBlock:^{
+        XCTAssertEqual([[SHParallelModel objectsWithArray:array] count], (NSUInteger)50000);
+    }];
+}
+
+- (void)testPerformanceObjectsWithArraySerially
+{
+    NSArray *array = [self modelDictionariesWithCount:50000];
+    [self measureBlock:^{
+        XCTAssertEqual([[SHAnotherModel objectsWithArray:array] count], (NSUInteger)50000);
+    }];
+}
+
+#pragma mark - dates
+
+- (NSArray *)dotNetDateCorpus
+{
+    return @[
+        @"2014-04-20T13:45:00", @"1970-01-01T00:00:00", @"2000-02-29T23:59:59", @"2100-12-31T12:00:00",
+        @"1583-01-01T00:00:00", @"1500-06-15T10:00:00", @"2014-03-09T02:30:00", @"2014-11-02T01:30:00",
+        @"2014-03-30T02:30:00", @"2014-10-26T02:30:00", @"2001-02-29T10:00:00", @"2014-13-01T10:00:00",
+        @"2014-04-31T10:00:00", @"2014-04-20T24:00:00", @"2014-04-20T13:60:00", @"2014-4-20T13:45:00",
+        @"2014-04-20 13:45:00", @"2014-04-20T13:45", @"", @"not a date",
+        @"2014-04-20T13:45:00Z", @"2014-04-20T13:45:00+08:00", @"2014-04-20T13:45:00-05:30",
+        @"2014-04-20T13:45:00+14:00", @"2014-04-20T13:45:00+23:59", @"2014-04-20T13:45:00+0800",
+        @"2014-04-20T13:45:00+08:60", @"2014-04-20T13:45:00z", @"1969-12-31T23:59:59-00:00"
+    ];
+}
+
+- (void)assertParser:(BOOL (*)(NSString *, NSTimeInterval *))parser matchesFormat:(NSString *)format
+{
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    [formatter setDateFormat:format];
+
+    for (NSString *string in [self dotNetDateCorpus]) {
+        NSDate *expected = [formatter dateFromString:string];
+        NSTimeInterval interval = 0;
+        BOOL parsed = parser(string, &interval);
+        XCTAssertEqual(parsed, (BOOL)(expected != nil), @"%@ in %@", string, format);
+        if (parsed && expected) {
+            XCTAssertEqual(interval, [expected timeIntervalSince1970], @"%@ in %@", string, format);
+        }
+    }
+}
+
+- (void)testDotNetDateParsersAgreeWithDateFormatter
+{
+    NSTimeZone *timeZone = [NSTimeZone defaultTimeZone];
+    for (NSString *name in @[ @"UTC", @"America/New_York", @"Europe/Berlin", @"Asia/Kolkata", @"Australia/Lord_Howe" ]) {
+        [NSTimeZone setDefaultTimeZone:[NSTimeZone timeZoneWithName:name]];
+        [self assertParser:SHParseDotNetSimpleDate matchesFormat:SHDotNetSimpleDateFormat];
+        [self assertParser:SHParseDotNetDateWithTimeZone matchesFormat:SHDotNetDateWithTimeZoneFormat];
+    }
+    [NSTimeZone setDefaultTimeZone:timeZone];
+
+    NSTimeInterval interval = 0;
+    XCTAssertTrue(SHParseDotNetDateWithTimeZone(@"1970-01-02T01:00:00+01:00", &interval));
+    XCTAssertEqual(interval, (NSTimeInterval)86400);
+    XCTAssertFalse(SHParseDotNetSimpleDate((NSString *)@42, &interval));
+}
+
+- (void)testCachedFormattersFollowTheDefaultTimeZone
+{
+    NSTimeZone *timeZone = [NSTimeZone defaultTimeZone];
+    [NSTimeZone setDefaultTimeZone:[NSTimeZone timeZoneWithName:@"Asia/Kolkata"]];
+    NSDateFormatter *formatter = SHDateFormatterForFormat(SHDotNetSimpleDateFormat);
+    NSDate *kolkata = [formatter dateFromString:@"2014-04-20T12:00:00"];
+
+    [NSTimeZone setDefaultTimeZone:[NSTimeZone timeZoneWithName:@"UTC"]];
+    XCTAssertEqual(SHDateFormatterForFormat(SHDotNetSimpleDateFormat), formatter);
+    XCTAssertEqualObjects([formatter timeZone], [NSTimeZone timeZoneWithName:@"UTC"]);
+    NSDate *utc = [SHDateFormatterForFormat(SHDotNetSimpleDateFormat) dateFromString:@"2014-04-20T12:00:00"];
+    XCTAssertEqualWithAccuracy([utc timeIntervalSinceDate:kolkata], 19800.0, 0.001);
+    [NSTimeZone setDefaultTimeZone:timeZone];
+}
+
+- (void)testCustomDateFormatsAreNotShared
+{
+    NSDictionary *dictionary = @{ @"time1" : @"20/04/2014" };
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    [formatter setDateFormat:@"dd/MM/yyyy"];
+
+    SHTestModal *first = [SHTestModal objectWithDictionary:dictionary
+                                      dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                           inputDateFormat:@"dd/MM/yyyy"
+                                                  mappings:nil];
+    SHTestModal *second = [SHTestModal objectWithDictionary:@{ @"time1" : @"2014.04.20" }
+                                       dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                            inputDateFormat:@"yyyy.MM.dd"
+                                                   mappings:nil];
+
+    XCTAssertEqualObjects([first valueForKey:@"time1"], [formatter dateFromString:@"20/04/2014"]);
+    XCTAssertEqualObjects([second valueForKey:@"time1"], [formatter dateFromString:@"20/04/2014"]);
+}
+
+- (NSArray *)benchmarkDateStringsWithFormat:(NSString *)format
+{
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    [formatter setDateFormat:format];
+    [formatter setTimeZone:[NSTimeZone timeZoneWithName:@"UTC"]];
+
+    NSMutableArray *strings = [NSMutableArray arrayWithCapacity:100000];
+    for (NSUInteger i = 0; i < 100000; i++) {
+        [strings addObject:[formatter stringFromDate:[NSDate dateWithTimeIntervalSince1970:1.0e9 + i * 7919.0]]];
+    }
+    return strings;
+}
+
+- (void)measureDatesPerSecond:(NSArray *)strings usingParser:(BOOL (^)(NSString *string))parser
+{
+    [self measureBlock:^{
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for (NSString *string in strings) {
+            XCTAssertTrue(parser(string));
+        }
+        NSLog(@"%.0f dates/sec", [strings count] / (CFAbsoluteTimeGetCurrent() - start));
+    }];
+}
+
+- (void)testPerformanceParsingDotNetDates
+{
+    NSArray *strings = [self benchmarkDateStringsWithFormat:SHDotNetDateWithTimeZoneFormat];
+    [self measureDatesPerSecond:strings usingParser:^BOOL(NSString *string) {
+        NSTimeInterval interval;
+        return SHParseDotNetDateWithTimeZone(string, &interval);
+    }];
+}
+
+- (void)testPerformanceParsingDotNetDatesWithDateFormatter
+{
+    NSArray *strings = [self benchmarkDateStringsWithFormat:SHDotNetDateWithTimeZoneFormat];
+    NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+    [formatter setDateFormat:SHDotNetDateWithTimeZoneFormat];
+    [self measureDatesPerSecond:strings usingParser:^BOOL(NSString *string) {
+        return [formatter dateFromString:string] != nil;
+    }];
+}
+
+- (void)testJSONDateScannerAgreesWithRegularExpression
+{
+    // pieces the fuzzed strings are made of, around the structure of `/Date(1398000000000+0800)/`
+    unichar highSurrogate = 0xD835;
+    NSArray *pieces = @[
+        @"/", @"Date", @"date", @"DATE", @"dAtE", @"Dat", @"(", @")", @"-", @"+", @"0", @"1", @"7", @"9", @"08", @"0800",
+        @"1398000000000", @"99999999999999999999", @"\u0663", @"\U0001D7CE",
+        [NSString stringWithCharacters:&highSurrogate length:1], @"\n", @"\r", @"\r\n", @"\u0085", @"\u2028", @" ",
+        @"x", @"e", @""
+    ];
+    NSArray *templates = @[
+        @[ @"/", @"Date", @"(", @"1398000000000", @")", @"/" ],
+        @[ @"/", @"Date", @"(", @"-", @"1398000000000", @"+", @"0800", @")", @"/" ],
+        @[ @"/", @"date", @"(", @"1", @"-", @"08", @"08", @")", @"/", @"\r\n" ]
+    ];
+
+    uint32_t seed = 20140420;
+    for (NSUInteger iteration = 0; iteration < 50000; iteration++) {
+        // mutate a valid date or build a random one
+        seed = seed * 1664525 + 1013904223;
+        NSMutableArray *parts = [templates[(seed >> 8) % [templates count]] mutableCopy];
+        if ((seed >> 4) % 4 == 0) {
+            [parts removeAllObjects];
+        }
+        NSUInteger mutations = (seed >> 16) % 4;
+        for (NSUInteger m = 0; m < mutations || [parts count] == 0; m++) {
+            seed = seed * 1664525 + 1013904223;
+            NSString *piece = pieces[(seed >> 8) % [pieces count]];
+            NSUInteger index = [parts count] ? (seed >> 20) % [parts count] : 0;
+            switch ((seed >> 2) % 3) {
+                case 0: [parts insertObject:piece atIndex:index]; break;
+                case 1: [parts addObject:piece]; break;
+                default: {
+                    if ([parts count]) {
+                        parts[index] = piece;
+                    } else {
+                        [parts addObject:piece];
+                    }
+                } break;
+            }
+        }
+
+        NSString *string = [parts componentsJoinedByString:@""];
+        NSDate *expected = SHReferenceDateFromDotNetJSONString(string);
+        NSTimeInterval interval = 0;
+        BOOL parsed = SHParseDotNetJSONDate(string, &interval);
+        XCTAssertEqual(parsed, (BOOL)(expected != nil), @"%@", string);
+        if (parsed && expected) {
+            XCTAssertEqual(interval, [expected timeIntervalSince1970], @"%@", string);
+        }
+    }
+}
+
+- (void)testTimeIntervalsFromJSONDates
+{
+    SHPrimitiveModel *model =
+        [SHPrimitiveModel objectWithDictionary:@{ @"doubleValue" : @"/Date(1398000000000+0130)/" }
+                          dateConversionOption:kDateConverstionFromNSStringToNSTimeIntervalOption
+                                 inputDateType:kInputDateFormatJSON
+                                      mappings:nil];
+    XCTAssertEqual(model.doubleValue, 1398000000.0 + 5400.0);
+}
+
+- (NSArray *)benchmarkJSONDateStrings
+{
+    NSMutableArray *strings = [NSMutableArray arrayWithCapacity:100000];
+    for (NSUInteger i = 0; i < 100000; i++) {
+        [strings addObject:[NSString stringWithFormat:@"/Date(%llu+0800)/", 1398000000000ULL + i * 7919000ULL]];
+    }
+    return strings;
+}
+
+- (void)testPerformanceParsingJSONDates
+{
+    [self measureDatesPerSecond:[self benchmarkJSONDateStrings] usingParser:^BOOL(NSString *string) {
+        NSTimeInterval interval;
+        return SHParseDotNetJSONDate(string, &interval);
+    }];
+}
+
+- (void)testPerformanceParsingJSONDatesWithRegularExpression
+{
+    [self measureDatesPerSecond:[self benchmarkJSONDateStrings] usingParser:^BOOL(NSString *string) {
+        return SHReferenceDateFromDotNetJSONString(string) != nil;
+    }];
+}
+
+#pragma mark - archiving
+
+- (SHFeedModel *)archiveFeedWithEntryCount:(NSUInteger)count
+{
+    NSDictionary *feed = @{
+        @"title" : @"feed é",
+        @"count" : @(count),
+        @"score" : @1.5,
+        @"active" : @YES,
+        @"featured" : @{@"model_id" : @7, @"model_name" : @"featured"},
+        @"entries" : [self modelDictionariesWithCount:count]
+    };
+    return [SHFeedModel objectWithDictionary:feed mappings:@{ @"entries" : @"SHAnotherModel" }];
+}
+
+- (void)assertModel:(SHModelObject *)model equalsModel:(SHModelObject *)reference
+{
+    XCTAssertEqualObjects([model class], [reference class]);
+    for (NSString *name in [reference propertyNames]) {
+        id value = [model valueForKey:name];
+        id expected = [reference valueForKey:name];
+        if ([expected isKindOfClass:[SHModelObject class]]) {
+            [self assertModel:value equalsModel:expected];
+        } else if ([expected isKindOfClass:[NSArray class]] &&
+                   [[expected firstObject] isKindOfClass:[SHModelObject class]]) {
+            XCTAssertEqual([value count], [expected count], @"%@", name);
+            for (NSUInteger i = 0; i < MIN([value count], [expected count]); i++) {
+                [self assertModel:value[i] equalsModel:expected[i]];
+            }
+        } else {
+            XCTAssertEqualObjects(value, expected, @"%@", name);
+        }
+    }
+}
+
+- (void)testArchiverDecodesLikeKeyedUnarchiver
+{
+    SHTestModal *modal = [SHTestModal objectWithDictionary:[self sampleDictionary]];
+    [modal setValue:[NSDate dateWithTimeIntervalSince1970:1398000000] forKey:@"time1"];
+    SHPrimitiveModel *primitives = [SHPrimitiveModel objectWithDictionary:@{
+        @"int_value" : @-42, @"flag" : @YES, @"ratio" : @0.25, @"big_value" : @(ULLONG_MAX), @"double_value" : @3.25,
+        @"integer_value" : @(NSIntegerMin), @"doubled_value" : @21
+    }];
+
+    for (SHModelObject *model in @[ modal, primitives, [self archiveFeedWithEntryCount:3] ]) {
+        id expected = [NSKeyedUnarchiver unarchiveObjectWithData:[NSKeyedArchiver archivedDataWithRootObject:model]];
+        id decoded = [SHModelArchiver unarchiveObjectWithData:[SHModelArchiver archivedDataWithRootObject:model]];
+        [self assertModel:decoded equalsModel:expected];
+    }
+
+    // mutable ivars stay mutable
+    SHTestModal *decoded = [SHModelArchiver unarchiveObjectWithData:[SHModelArchiver archivedDataWithRootObject:modal]];
+    XCTAssertNoThrow([[decoded valueForKey:@"_myArray"] addObject:@"more"]);
+
+    NSData *bytes = [@"bytes" dataUsingEncoding:NSUTF8StringEncoding];
+    NSArray *graph = @[ modal, @{ @"key" : [NSNull null], @"data" : bytes } ];
+    NSData *data = [SHModelArchiver archivedDataWithRootObject:graph];
+    NSArray *decodedGraph = [SHModelArchiver unarchiveObjectWithData:data];
+    XCTAssertEqual([decodedGraph count], (NSUInteger)2);
+    XCTAssertEqualObjects(decodedGraph[1], graph[1]);
+}
+
+- (NSData *)archiveData:(NSData *)data replacingClassName:(NSString *)className withClassName:(NSString *)newClassName
+{
+    NSData *search = [className dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *replacement = [newClassName dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData *patched = [data mutableCopy];
+    NSRange range = [patched rangeOfData:search options:0 range:NSMakeRange(0, [patched length])];
+    [patched replaceBytesInRange:range withBytes:[replacement bytes]];
+    return patched;
+}
+
+- (void)testArchiverToleratesAddedAndRemovedIvars
+{
+    SHArchiveModelV1 *model = [SHArchiveModelV1
+        objectWithDictionary:@{ @"name" : @"model", @"count" : @-3, @"score" : @0.75, @"removed" : @"gone" }];
+    NSData *data = [SHModelArchiver archivedDataWithRootObject:@[ model ]];
+
+    NSData *patched = [self archiveData:data replacingClassName:@"SHArchiveModelV1" withClassName:@"SHArchiveModelV2"];
+    NSArray *objects = [SHModelArchiver unarchiveObjectWithData:patched];
+    SHArchiveModelV2 *decoded = [objects firstObject];
+    XCTAssertEqualObjects([decoded class], [SHArchiveModelV2 class]);
+    XCTAssertEqualObjects([decoded valueForKey:@"_name"], @"model");
+    XCTAssertEqualObjects([decoded valueForKey:@"_count"], @-3LL);
+    XCTAssertEqualObjects([decoded valueForKey:@"_score"], @0.75f);
+    XCTAssertNil([decoded valueForKey:@"_added"]);
+
+    // an unknown class decodes as nil, without failing the archive
+    patched = [self archiveData:data replacingClassName:@"SHArchiveModelV1" withClassName:@"SHArchiveModelV9"];
+    objects = [SHModelArchiver unarchiveObjectWithData:patched];
+    XCTAssertEqualObjects(objects, @[]);
+}
+
+- (void)testArchiverRejectsOtherArchiveVersionsAndBrokenData
+{
+    SHArchiveModelV1 *model = [SHArchiveModelV1 objectWithDictionary:@{ @"name" : @"model" }];
+    NSData *data = [SHModelArchiver archivedDataWithRootObject:model];
+    XCTAssertNotNil([SHModelArchiver unarchiveObjectWithData:data]);
+    NSData *patched = [self archiveData:data replacingClassName:@"SHArchiveModelV1" withClassName:@"SHArchiveModelV3"];
+    XCTAssertNil([SHModelArchiver unarchiveObjectWithData:patched]);
+
+    data = [SHModelArchiver archivedDataWithRootObject:[self archiveFeedWithEntryCount:3]];
+    for (NSUInteger length = 0; length < [data length]; length++) {
+        XCTAssertNil([SHModelArchiver unarchiveObjectWithData:[data subdataWithRange:NSMakeRange(0, length)]]);
+    }
+    XCTAssertNil([SHModelArchiver unarchiveObjectWithData:[@"not an archive" dataUsingEncoding:NSUTF8StringEncoding]]);
+}
+
+- (void)testArchiverKeepsStringsWithoutUTF8Form
+{
+    unichar characters[] = { 'a', 0xD800, 'b' };
+    NSString *loneSurrogate = [NSString stringWithCharacters:characters length:3];
+    XCTAssertEqual([loneSurrogate lengthOfBytesUsingEncoding:NSUTF8StringEncoding], (NSUInteger)0);
+
+    SHAnotherModel *model = [[SHAnotherModel alloc] init];
+    model.modelName = loneSurrogate;
+    model.modelType = @"plain";
+    NSData *data = [SHModelArchiver archivedDataWithRootObject:model];
+    SHAnotherModel *decoded = [SHModelArchiver unarchiveObjectWithData:data];
+    XCTAssertEqualObjects(decoded.modelName, loneSurrogate);
+    XCTAssertEqualObjects(decoded.modelType, @"plain");
+
+    NSArray *strings = @[ loneSurrogate, @"", @"plain" ];
+    data = [SHModelArchiver archivedDataWithRootObject:strings];
+    XCTAssertEqualObjects([SHModelArchiver unarchiveObjectWithData:data], strings);
+}
+
+- (void)testPerformanceUnarchivingModels
+{
+    NSData *data = [SHModelArchiver archivedDataWithRootObject:[self archiveFeedWithEntryCount:200000]];
+    [self measureBlock:^{
+        XCTAssertNotNil([SHModelArchiver unarchiveObjectWithData:data]);
+    }];
+}
+
+- (void)testPerformanceKeyedUnarchivingModels
+{
+    NSData *data = [NSKeyedArchiver archivedDataWithRootObject:[self archiveFeedWithEntryCount:200000]];
+    [self measureBlock:^{
+        XCTAssertNotNil([NSKeyedUnarchiver unarchiveObjectWithData:data]);
+    }];
+}
+
+#pragma mark - lazy nested objects
+
+- (NSDictionary *)feedDictionaryWithEntryCount:(NSUInteger)count
+{
+    return @{
+        @"title" : @"feed",
+        @"count" : @(count),
+        @"featured" : @{@"model_id" : @7, @"model_name" : @"featured"},
+        @"entries" : [self modelDictionariesWithCount:count]
+    };
+}
+
+- (void)testLazyNestedObjectsAreDecodedOnFirstUse
+{
+    NSDictionary *mappings = @{ @"entries" : @"SHAnotherModel" };
+    NSDictionary *dictionary = [self feedDictionaryWithEntryCount:3];
+    NSData *json = [NSJSONSerialization dataWithJSONObject:dictionary options:0 error:nil];
+    SHFeedModel *expected = [SHFeedModel objectWithDictionary:dictionary mappings:mappings];
+
+    for (NSUInteger i = 0; i < 2; i++) {
+        [SHLazyValue resetCounters];
+        SHLazyFeedModel *feed = (i == 0) ? [SHLazyFeedModel objectWithDictionary:dictionary mappings:mappings]
+                                         : [SHLazyFeedModel objectWithJSONData:json mappings:mappings];
+        XCTAssertEqual([SHLazyValue createdCount], (NSUInteger)2);
+        XCTAssertEqual([SHLazyValue forcedCount], (NSUInteger)0);
+        XCTAssertEqualObjects([feed valueForKey:@"_title"], @"feed");
+        XCTAssertTrue(SHLazyValueIsPending([feed valueForKey:@"_featured"]));
+
+        SHAnotherModel *featured = [feed valueForKey:@"_featured"];
+        XCTAssertTrue([featured isKindOfClass:[SHAnotherModel class]]);
+        XCTAssertEqualObjects([featured modelName], @"featured");
+        XCTAssertEqual([SHLazyValue forcedCount], (NSUInteger)1);
+        XCTAssertTrue(SHLazyValueIsPending([feed valueForKey:@"_entries"]));
+
+        // forcing happens once, the decoded value is kept
+        XCTAssertEqual([[feed valueForKey:@"_entries"] count], (NSUInteger)3);
+        XCTAssertEqual([[feed valueForKey:@"_entries"] count], (NSUInteger)3);
+        XCTAssertEqual([SHLazyValue forcedCount], (NSUInteger)2);
+        XCTAssertEqual(SHLazyValueResolve([feed valueForKey:@"_featured"]),
+                       SHLazyValueResolve([feed valueForKey:@"_featured"]));
+        [self assertModel:featured equalsModel:[expected valueForKey:@"_featured"]];
+        for (NSUInteger j = 0; j < 3; j++) {
+            [self assertModel:[feed valueForKey:@"_entries"][j] equalsModel:[expected valueForKey:@"_entries"][j]];
+        }
+    }
+
+    // lazy values are archived decoded
+    SHLazyFeedModel *feed = [SHLazyFeedModel objectWithDictionary:dictionary mappings:mappings];
+    SHLazyFeedModel *decoded = [SHModelArchiver unarchiveObjectWithData:[SHModelArchiver archivedDataWithRootObject:feed]];
+    XCTAssertFalse(SHLazyValueIsPending([decoded valueForKey:@"_featured"]));
+    [self assertModel:decoded equalsModel:feed];
+}
+
+- (void)testLazyNestedObjectsAreForcedOnceAcrossThreads
+{
+    NSDictionary *mappings = @{ @"entries" : @"SHAnotherModel" };
+    SHLazyFeedModel *feed = [SHLazyFeedModel objectWithDictionary:[self feedDictionaryWithEntryCount:100] mappings:mappings];
+    [SHLazyValue resetCounters];
+
+    id lazyEntries = [feed valueForKey:@"_entries"];
+    __strong id *resolved = (__strong id *)calloc(64, sizeof(id));
+    dispatch_apply(64, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        resolved[i] = SHLazyValueResolve(lazyEntries);
+    });
+    XCTAssertEqual([SHLazyValue forcedCount], (NSUInteger)1);
+    for (NSUInteger i = 0; i < 64; i++) {
+        XCTAssertEqual(resolved[i], resolved[0]);
+        resolved[i] = nil;
+    }
+    free(resolved);
+}
+
+- (void)testLazyNestedObjectsFromJSONDataAreShared
+{
+    NSData *first = [self JSONDataWithObject:@{ @"text" : @"a", @"author" : @{ @"id" : @"1", @"name" : @"first" } }];
+    NSData *second = [self JSONDataWithObject:@{ @"text" : @"b", @"author" : @{ @"id" : @"1", @"name" : @"second" } }];
+    SHDecodingSession *session = [[SHDecodingSession alloc] init];
+    __block SHLazyCommentModel *firstComment = nil;
+    __block SHLazyCommentModel *secondComment = nil;
+    [session performDecoding:^{
+        firstComment = [SHLazyCommentModel objectWithJSONData:first];
+        secondComment = [SHLazyCommentModel objectWithJSONData:second];
+    }];
+
+    // forced after the session is no longer current
+    XCTAssertTrue(SHLazyValueIsPending([firstComment valueForKey:@"_author"]));
+    id firstAuthor = SHLazyValueResolve([firstComment valueForKey:@"_author"]);
+    id secondAuthor = SHLazyValueResolve([secondComment valueForKey:@"_author"]);
+    XCTAssertEqual(firstAuthor, secondAuthor);
+    XCTAssertEqual([session objectOfClass:[SHAuthorModel class] primaryKey:@"1"], firstAuthor);
+    XCTAssertEqualObjects([firstAuthor valueForKey:@"_name"], @"first");
+}
+
+- (void)testLazyNestedObjectsFromDictionariesAreShared
+{
+    NSDictionary *first = @{ @"text" : @"a", @"author" : @{@"id" : @"1", @"name" : @"first"} };
+    NSDictionary *second = @{ @"text" : @"b", @"author" : @{@"id" : @"1", @"name" : @"second"} };
+    SHDecodingSession *session = [[SHDecodingSession alloc] init];
+    __block SHLazyCommentModel *firstComment = nil;
+    __block SHLazyCommentModel *secondComment = nil;
+    [session performDecoding:^{
+        firstComment = [SHLazyCommentModel objectWithDictionary:first];
+        secondComment = [SHLazyCommentModel objectWithDictionary:second];
+    }];
+
+    XCTAssertTrue(SHLazyValueIsPending([secondComment valueForKey:@"_author"]));
+    id secondAuthor = SHLazyValueResolve([secondComment valueForKey:@"_author"]);
+    id firstAuthor = SHLazyValueResolve([firstComment valueForKey:@"_author"]);
+    XCTAssertEqual(firstAuthor, secondAuthor);
+    XCTAssertEqualObjects([firstAuthor valueForKey:@"_name"], @"second");
+    XCTAssertEqual([session objectOfClass:[SHAuthorModel class] primaryKey:@"1"], firstAuthor);
+}
+
+- (void)testUpdatesReplacePendingLazyValuesWithoutForcingThem
+{
+    NSDictionary *author = @{ @"id" : @"1", @"name" : @"first" };
+    SHLazyCommentModel *comment = [SHLazyCommentModel objectWithDictionary:@{ @"text" : @"a", @"author" : author }];
+    [SHLazyValue resetCounters];
+
+    NSSet *changedKeys = [comment changedKeysByUpdatingWithDictionary:@{ @"author" : author }];
+    XCTAssertEqualObjects(changedKeys, [NSSet setWithObject:@"author"]);
+    XCTAssertTrue(SHLazyValueIsPending([comment valueForKey:@"_author"]));
+    XCTAssertEqual([SHLazyValue forcedCount], (NSUInteger)0);
+    XCTAssertEqualObjects([SHLazyValueResolve([comment valueForKey:@"_author"]) valueForKey:@"_name"], @"first");
+}
+
+- (void)testLazyValuesDecodedToNilDoNotSwallowMessages
+{
+    id value = [[SHLazyValue alloc] initWithBlock:^id { return nil; }];
+    XCTAssertNil(SHLazyValueResolve(value));
+    XCTAssertFalse([value isKindOfClass:[NSString class]]);
+    XCTAssertThrows([value length]);
+}
+
+- (NSArray *)feedDictionariesWithCount:(NSUInteger)count
+{
+    NSMutableArray *feeds = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [feeds addObject:[self feedDictionaryWithEntryCount:20]];
+    }
+    return feeds;
+}
+
+// a list screen with 1,000 rows that only shows the top level fields
+- (void)testPerformanceLazyNestedObjects
+{
+    NSArray *feeds = [self feedDictionariesWithCount:1000];
+    [SHLazyValue resetCounters];
+    [self measureBlock:^{
+        for (NSDictionary *dictionary in feeds) {
+            SHLazyFeedModel *feed = [SHLazyFeedModel objectWithDictionary:dictionary
+                                                                 mappings:@{ @"entries" : @"SHAnotherModel" }];
+            XCTAssertNotNil([feed valueForKey:@"_title"]);
+        }
+    }];
+    XCTAssertEqual([SHLazyValue forcedCount], (NSUInteger)0);
+}
+
+- (void)testPerformanceEagerNestedObjects
+{
+    NSArray *feeds = [self feedDictionariesWithCount:1000];
+    [self measureBlock:^{
+        for (NSDictionary *dictionary in feeds) {
+            SHFeedModel *feed = [SHFeedModel objectWithDictionary:dictionary mappings:@{ @"entries" : @"SHAnotherModel" }];
+            XCTAssertNotNil([feed valueForKey:@"_title"]);
+        }
+    }];
+}
+
+#pragma mark - model store
+
+- (NSString *)temporaryStorePath
+{
+    NSString *name = [NSString stringWithFormat:@"%@.store", [[NSUUID UUID] UUIDString]];
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:name];
+}
+
+- (NSArray *)storeModelsWithCount:(NSUInteger)count
+{
+    return [[self archiveFeedWithEntryCount:count] valueForKey:@"entries"];
+}
+
+- (void)testStoreAppendsAndReadsRecords
+{
+    NSString *path = [self temporaryStorePath];
+    NSArray *models = [self storeModelsWithCount:10];
+    SHModelStore *store = [[SHModelStore alloc] initWithPath:path];
+    XCTAssertEqual([store count], (NSUInteger)0);
+    XCTAssertTrue([store appendObjects:[models subarrayWithRange:NSMakeRange(0, 4)]]);
+    XCTAssertTrue([store appendObjects:@[ [self archiveFeedWithEntryCount:2] ]]);
+
+    // appending after reopening keeps the records written before readable
+    store = [[SHModelStore alloc] initWithPath:path];
+    XCTAssertTrue([store appendObjects:[models subarrayWithRange:NSMakeRange(4, 6)]]);
+    store = [[SHModelStore alloc] initWithPath:path];
+    XCTAssertEqual([store count], (NSUInteger)11);
+    for (NSUInteger i = 0; i < 4; i++) {
+        [self assertModel:[store objectAtIndex:i] equalsModel:models[i]];
+    }
+    [self assertModel:[store objectAtIndex:4] equalsModel:[self archiveFeedWithEntryCount:2]];
+    NSArray *objects = [store objectsInRange:NSMakeRange(5, 10)];
+    XCTAssertEqual([objects count], (NSUInteger)6);
+    for (NSUInteger i = 0; i < [objects count]; i++) {
+        [self assertModel:objects[i] equalsModel:models[i + 4]];
+    }
+    XCTAssertNil([store objectAtIndex:11]);
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testStoreRemovesAndCompactsRecords
+{
+    NSString *path = [self temporaryStorePath];
+    NSArray *models = [self storeModelsWithCount:10];
+    SHModelStore *store = [[SHModelStore alloc] initWithPath:path];
+    XCTAssertTrue([store appendObjects:models]);
+    XCTAssertTrue([store removeObjectAtIndex:0]);
+    XCTAssertTrue([store removeObjectAtIndex:4]);
+    XCTAssertFalse([store removeObjectAtIndex:8]);
+    XCTAssertEqual([store count], (NSUInteger)8);
+    XCTAssertTrue([store reclaimableLength] > 0);
+
+    NSArray *expected = @[ models[1], models[2], models[3], models[4], models[6], models[7], models[8], models[9] ];
+    store = [[SHModelStore alloc] initWithPath:path];
+    XCTAssertEqual([store count], (NSUInteger)8);
+    XCTAssertTrue([store compact]);
+    XCTAssertEqual([store reclaimableLength], 0ULL);
+    store = [[SHModelStore alloc] initWithPath:path];
+    XCTAssertEqual([store count], [expected count]);
+    for (NSUInteger i = 0; i < [expected count]; i++) {
+        [self assertModel:[store objectAtIndex:i] equalsModel:expected[i]];
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testStoreRejectsOtherFiles
+{
+    NSString *path = [self temporaryStorePath];
+    [[@"not a store" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:path atomically:YES];
+    XCTAssertNil([[SHModelStore alloc] initWithPath:path]);
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testPerformanceOpeningStoreAndReadingRecords
+{
+    NSString *path = [self temporaryStorePath];
+    XCTAssertTrue([[[SHModelStore alloc] initWithPath:path] appendObjects:[self storeModelsWithCount:200000]]);
+    [self measureBlock:^{
+        SHModelStore *store = [[SHModelStore alloc] initWithPath:path];
+        for (NSUInteger i = 0; i < 20; i++) {
+            XCTAssertNotNil([store objectAtIndex:i * 10000]);
+        }
+    }];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+- (void)testPerformanceKeyedUnarchivingFileAndReadingRecords
+{
+    NSString *path = [self temporaryStorePath];
+    XCTAssertTrue([NSKeyedArchiver archiveRootObject:[self storeModelsWithCount:200000] toFile:path]);
+    [self measureBlock:^{
+        NSArray *models = [NSKeyedUnarchiver unarchiveObjectWithFile:path];
+        for (NSUInteger i = 0; i < 20; i++) {
+            XCTAssertNotNil(models[i * 10000]);
+        }
+    }];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+#pragma mark - change-aware updates
+
+- (void)testChangedKeysReportOnlyRealChanges
+{
+    NSDictionary *dictionary = [self feedDictionaryWithEntryCount:3];
+    SHFeedModel *feed = [SHFeedModel objectWithDictionary:dictionary mappings:@{ @"entries" : @"SHAnotherModel" }];
+    [feed updateWithDictionary:@{ @"score" : @1.5, @"active" : @YES }];
+    id featured = [feed valueForKey:@"_featured"];
+    id entries = [feed valueForKey:@"_entries"];
+
+    XCTAssertEqualObjects([feed changedKeysByUpdatingWithDictionary:dictionary], [NSSet set]);
+    XCTAssertEqualObjects([feed changedKeysByUpdatingWithDictionary:@{ @"score" : @1.5, @"active" : @YES }], [NSSet set]);
+
+    // patches only touch the keys they contain
+    NSSet *changedKeys = [feed changedKeysByUpdatingWithDictionary:@{ @"title" : @"new title", @"count" : @3 }];
+    XCTAssertEqualObjects(changedKeys, [NSSet setWithObject:@"title"]);
+    XCTAssertEqualObjects([feed valueForKey:@"_title"], @"new title");
+    XCTAssertEqualObjects([feed valueForKey:@"_score"], @1.5);
+
+    // nested models and mapped arrays are patched in place
+    changedKeys = [feed changedKeysByUpdatingWithDictionary:@{ @"featured" : @{@"model_name" : @"other"} }];
+    XCTAssertEqualObjects(changedKeys, [NSSet setWithObject:@"featured"]);
+    XCTAssertEqual([feed valueForKey:@"_featured"], featured);
+    XCTAssertEqualObjects([featured modelName], @"other");
+    XCTAssertEqual([featured modelId], 7);
+
+    NSMutableArray *entryDictionaries = [dictionary[@"entries"] mutableCopy];
+    XCTAssertEqualObjects([feed changedKeysByUpdatingWithDictionary:@{ @"entries" : entryDictionaries }], [NSSet set]);
+    entryDictionaries[1] = @{ @"model_id" : @1, @"model_name" : @"renamed" };
+    changedKeys = [feed changedKeysByUpdatingWithDictionary:@{ @"entries" : entryDictionaries }];
+    XCTAssertEqualObjects(changedKeys, [NSSet setWithObject:@"entries"]);
+    XCTAssertEqual([feed valueForKey:@"_entries"], entries);
+    XCTAssertEqualObjects([entries[1] modelName], @"renamed");
+
+    // a different number of elements replaces the array
+    [entryDictionaries removeLastObject];
+    changedKeys = [feed changedKeysByUpdatingWithDictionary:@{ @"entries" : entryDictionaries }];
+    XCTAssertEqualObjects(changedKeys, [NSSet setWithObject:@"entries"]);
+    XCTAssertEqual([[feed valueForKey:@"_entries"] count], (NSUInteger)2);
+}
+
+- (void)testChangedKeysPatchSharedNestedModels
+{
+    NSDictionary *dictionary = [self feedDictionaryWithEntryCount:3];
+    SHFeedModel *feed = [SHFeedModel objectWithDictionary:dictionary mappings:@{ @"entries" : @"SHAnotherModel" }];
+    SHFeedModel *copy = [feed copy];
+    SHFeedModel *deepCopy = [feed deepCopy];
+
+    NSMutableArray *entryDictionaries = [dictionary[@"entries"] mutableCopy];
+    entryDictionaries[1] = @{ @"model_id" : @1, @"model_name" : @"renamed" };
+    [feed changedKeysByUpdatingWithDictionary:@{
+        @"featured" : @{@"model_name" : @"other"},
+        @"entries" : entryDictionaries
+    }];
+
+    // a shallow copy shares the nested models, a deep copy does not
+    XCTAssertEqualObjects([[copy valueForKey:@"_featured"] modelName], @"other");
+    XCTAssertEqualObjects([[copy valueForKey:@"_entries"][1] modelName], @"renamed");
+    XCTAssertNotEqualObjects([[deepCopy valueForKey:@"_featured"] modelName], @"other");
+    XCTAssertNotEqualObjects([[deepCopy valueForKey:@"_entries"][1] modelName], @"renamed");
+
+    // so do objects with the same primary key from a session
+    SHDecodingSession *session = [[SHDecodingSession alloc] init];
+    __block NSArray *comments = nil;
+    [session performDecoding:^{
+        comments = [SHCommentModel objectsWithArray:@[
+            @{ @"text" : @"a", @"author" : @{@"id" : @"1", @"name" : @"first"} },
+            @{ @"text" : @"b", @"author" : @{@"id" : @"1", @"name" : @"first"} }
+        ]];
+    }];
+    NSSet *changedKeys = [comments[0] changedKeysByUpdatingWithDictionary:@{ @"author" : @{@"name" : @"renamed"} }];
+    XCTAssertEqualObjects(changedKeys, [NSSet setWithObject:@"author"]);
+    XCTAssertEqualObjects([[comments[1] valueForKey:@"_author"] valueForKey:@"_name"], @"renamed");
+}
+
+- (void)testChangedKeysReportEveryKeyForSerializeValueOverrides
+{
+    SHTestModal *model = [SHTestModal objectWithDictionary:@{ @"numberVALUE" : @1 }];
+    NSSet *changedKeys = [model changedKeysByUpdatingWithDictionary:@{ @"numberVALUE" : @1 }];
+    XCTAssertEqualObjects(changedKeys, [NSSet setWithObject:@"numberVALUE"]);
+}
+
+- (void)testChangedKeysSendKVONotificationsOnlyForChanges
+{
+    SHPrimitiveModel *model = [SHPrimitiveModel objectWithDictionary:@{ @"int_value" : @5, @"ratio" : @0.25 }];
+    [model addObserver:self forKeyPath:@"_intValue" options:NSKeyValueObservingOptionNew context:NULL];
+    _observedChanges = 0;
+    XCTAssertEqualObjects([model changedKeysByUpdatingWithDictionary:@{ @"int_value" : @5, @"ratio" : @0.25 }],
+                          [NSSet set]);
+    XCTAssertEqual(_observedChanges, 0);
+    XCTAssertEqualObjects([model changedKeysByUpdatingWithDictionary:@{ @"int_value" : @6, @"ratio" : @0.25 }],
+                          [NSSet setWithObject:@"int_value"]);
+    [model removeObserver:self forKeyPath:@"_intValue"];
+    XCTAssertEqual(_observedChanges, 1);
+    XCTAssertEqualObjects([model valueForKey:@"_intValue"], @6);
+}
+
+- (void)testPerformanceUpdatingUnchangedObjects
+{
+    NSArray *dictionaries = [self feedDictionariesWithCount:1000];
+    NSArray *feeds = [SHFeedModel objectsWithArray:dictionaries mappings:@{ @"entries" : @"SHAnotherModel" }];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < [feeds count]; i++) {
+            XCTAssertEqual([[feeds[i] changedKeysByUpdatingWithDictionary:dictionaries[i]] count], (NSUInteger)0);
+        }
+    }];
+}
+
+- (void)testPerformanceUpdatingObjectsWithUpdateWithDictionary
+{
+    NSArray *dictionaries = [self feedDictionariesWithCount:1000];
+    NSArray *feeds = [SHFeedModel objectsWithArray:dictionaries mappings:@{ @"entries" : @"SHAnotherModel" }];
+    [self measureBlock:^{
+        for (NSUInteger i = 0; i < [feeds count]; i++) {
+            [feeds[i] updateWithDictionary:dictionaries[i]];
+        }
+    }];
+}
+
+#pragma mark - exporting
+
+- (SHTestModal *)exportedSampleModel
+{
+    SHTestModal *model = [SHTestModal objectWithDictionary:[self sampleDictionary]
+                                                  mappings:@{ @"arrayOfAnotherModels" : @"SHAnotherModel" }];
+    [model setValue:[NSDate dateWithTimeIntervalSince1970:1398000000.25] forKey:@"time1"];
+    return model;
+}
+
+- (void)testOutputKeysFollowKeyStyle
+{
+    XCTAssertEqualObjects(SHOutputKeyForIvarName(@"_anotherIntValue", kOutputKeyStyleIvarName), @"anotherIntValue");
+    XCTAssertEqualObjects(SHOutputKeyForIvarName(@"_anotherIntValue", kOutputKeyStyleSnakeCase), @"another_int_value");
+    XCTAssertEqualObjects(SHOutputKeyForIvarName(@"_another_int_value", kOutputKeyStyleCamelCase), @"anotherIntValue");
+    XCTAssertEqualObjects(SHOutputKeyForIvarName(@"_URLString", kOutputKeyStyleSnakeCase), @"url_string");
+    XCTAssertEqualObjects(SHOutputKeyForIvarName(@"_URLString", kOutputKeyStyleCamelCase), @"urlString");
+    XCTAssertEqualObjects(SHOutputKeyForIvarName(@"time1", kOutputKeyStyleSnakeCase), @"time1");
+}
+
+- (void)testDictionaryRepresentationRoundTrips
+{
+    SHTestModal *model = [self exportedSampleModel];
+    NSDictionary *dictionary = [model dictionaryRepresentation];
+    XCTAssertEqualObjects(dictionary[@"stringValue"], @"shan");
+    XCTAssertEqualObjects(dictionary[@"anotherIntValue"], @23);
+    XCTAssertEqualObjects(dictionary[@"remember"], @YES);
+    XCTAssertEqualObjects(dictionary[@"time1"], @"/Date(1398000000250)/");
+    XCTAssertEqualObjects(dictionary[@"anotherModel"][@"modelName"], @"My Model");
+    XCTAssertEqualObjects(dictionary[@"arrayOfAnotherModels"][1][@"modelId"], @3);
+    XCTAssertEqualObjects([model dictionaryRepresentationWithKeyStyle:kOutputKeyStyleSnakeCase][@"do_it_my_self"],
+                          @"Yahooo");
+
+    for (kOutputKeyStyle style = kOutputKeyStyleIvarName; style <= kOutputKeyStyleCamelCase; style++) {
+        NSDictionary *exported = [model dictionaryRepresentationWithKeyStyle:style];
+        SHTestModal *decoded = [SHTestModal objectWithDictionary:exported
+                                                        mappings:@{ @"arrayOfAnotherModels" : @"SHAnotherModel" }];
+        [self assertModel:decoded equalsModel:model];
+    }
+}
+
+- (void)testJSONDataRepresentationMatchesDictionaryRepresentation
+{
+    SHTestModal *model = [self exportedSampleModel];
+    model.stringValue = @"quote \" backslash \\ newline \n tab \t control \x01 accent é emoji \U0001F600";
+    for (kOutputKeyStyle style = kOutputKeyStyleIvarName; style <= kOutputKeyStyleCamelCase; style++) {
+        NSData *json = [model JSONDataRepresentationWithKeyStyle:style];
+        id parsed = [NSJSONSerialization JSONObjectWithData:json options:0 error:nil];
+        XCTAssertEqualObjects(parsed, [model dictionaryRepresentationWithKeyStyle:style]);
+        SHTestModal *decoded = [SHTestModal objectWithJSONData:json
+                                                      mappings:@{ @"arrayOfAnotherModels" : @"SHAnotherModel" }];
+        [self assertModel:decoded equalsModel:model];
+    }
+
+    SHPrimitiveModel *primitives = [SHPrimitiveModel objectWithDictionary:@{
+        @"int_value" : @-42, @"flag" : @YES, @"ratio" : @0.1f, @"big_value" : @(LLONG_MAX), @"double_value" : @0.1,
+        @"integer_value" : @(NSIntegerMin)
+    }];
+    [self assertModel:[SHPrimitiveModel objectWithJSONData:[primitives JSONDataRepresentation]] equalsModel:primitives];
+
+    // JSON has no NaN
+    primitives.doubleValue = NAN;
+    XCTAssertNil([primitives JSONDataRepresentation]);
+}
+
+- (void)testPerformanceJSONRoundTrip
+{
+    SHFeedModel *feed = [self archiveFeedWithEntryCount:20000];
+    [self measureBlock:^{
+        NSData *json = [feed JSONDataRepresentation];
+        XCTAssertNotNil([SHFeedModel objectWithJSONData:json mappings:@{ @"entries" : @"SHAnotherModel" }]);
+    }];
+}
+
+- (void)testPerformanceJSONRoundTripThroughNSJSONSerialization
+{
+    SHFeedModel *feed = [self archiveFeedWithEntryCount:20000];
+    [self measureBlock:^{
+        NSData *json = [NSJSONSerialization dataWithJSONObject:[feed dictionaryRepresentation] options:0 error:nil];
+        NSDictionary *dictionary = [NSJSONSerialization JSONObjectWithData:json options:0 error:nil];
+        XCTAssertNotNil([SHFeedModel objectWithDictionary:dictionary mappings:@{ @"entries" : @"SHAnotherModel" }]);
+    }];
+}
+
+#pragma mark - schema
+
+- (NSDictionary *)schemaDictionary
+{
+    return @{
+        @"headline" : @"Schema",
+        @"author" : @{@"modelId" : @1, @"modelName" : @"Author"},
+        @"items" : @[ @{@"modelId" : @2}, @{@"modelId" : @3} ],
+        @"published" : @"2014-04-20T13:45:00",
+        @"updated" : @"/Date(1398000000000)/",
+        @"created" : @"20.04.2014"
+    };
+}
+
+- (void)assertSchemaModel:(SHSchemaModel *)model
+{
+    XCTAssertEqualObjects([model valueForKey:@"title"], @"Schema");
+    XCTAssertTrue([[model valueForKey:@"author"] isKindOfClass:[SHAnotherModel class]]);
+    XCTAssertEqualObjects([[model valueForKey:@"author"] modelName], @"Author");
+    NSArray *entries = [model valueForKey:@"entries"];
+    XCTAssertEqual([entries count], (NSUInteger)2);
+    XCTAssertTrue([entries[1] isKindOfClass:[SHAnotherModel class]]);
+    XCTAssertEqual([entries[1] modelId], 3);
+
+    NSTimeInterval published = 0;
+    XCTAssertTrue(SHParseDotNetSimpleDate(@"2014-04-20T13:45:00", &published));
+    XCTAssertEqualObjects([model valueForKey:@"published"], [NSDate dateWithTimeIntervalSince1970:published]);
+    XCTAssertEqualObjects([model valueForKey:@"updated"], @1398000000.0);
+    XCTAssertEqualObjects([model valueForKey:@"created"],
+                          [SHDateFormatterForFormat(@"dd.MM.yyyy") dateFromString:@"20.04.2014"]);
+}
+
+- (void)testSchemaDeclaresKeysClassesAndDates
+{
+    SHModelClassPlan *plan = [SHModelClassPlan planForClass:[SHSchemaModel class] rootClass:[SHModelObject class]];
+    XCTAssertEqualObjects([plan ivarForKey:@"headline"].name, @"_title");
+    XCTAssertEqualObjects([plan ivarForKey:@"NAME"].name, @"_title");
+    XCTAssertEqualObjects([plan ivarForKey:@"title"].name, @"_title");
+    XCTAssertTrue([plan ivarForKey:@"author"].isModelClass);
+    XCTAssertEqualObjects([plan ivarForKey:@"items"].elementClass, [SHAnotherModel class]);
+    XCTAssertEqual([plan ivarForKey:@"created"].inputDateFormat, kInputDateFormatCustom);
+
+    // the schema applies whatever date options are passed
+    [self assertSchemaModel:[SHSchemaModel objectWithDictionary:[self schemaDictionary]]];
+    [self assertSchemaModel:[SHSchemaModel objectWithDictionary:[self schemaDictionary]
+                                           dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                                  inputDateType:kInputDateFormatDotNetWithTimeZone
+                                                       mappings:nil]];
+
+    NSData *json = [NSJSONSerialization dataWithJSONObject:[self schemaDictionary] options:0 error:nil];
+    [self assertSchemaModel:[SHSchemaModel objectWithJSONData:json]];
+}
+
+- (void)testSchemaDatesAreExportedInTheirFormat
+{
+    SHSchemaModel *model = [SHSchemaModel objectWithDictionary:[self schemaDictionary]];
+    NSDictionary *dictionary = [model dictionaryRepresentation];
+    XCTAssertEqualObjects(dictionary[@"published"], @"2014-04-20T13:45:00");
+    XCTAssertEqualObjects(dictionary[@"updated"], @"/Date(1398000000000)/");
+    XCTAssertEqualObjects(dictionary[@"created"], @"20.04.2014");
+
+    [self assertSchemaModel:[SHSchemaModel objectWithDictionary:dictionary]];
+    [self assertSchemaModel:[SHSchemaModel objectWithJSONData:[model JSONDataRepresentation]]];
+}
+
+- (void)testPrewarmClassesBuildsNestedPlans
+{
+    XCTAssertNil([SHModelClassPlan cachedPlanForClass:[SHPrewarmModel class]]);
+
+    dispatch_semaphore_t done = dispatch_semaphore_create(0);
+    [SHModelObject prewarmClasses:@[ [SHPrewarmModel class] ] completion:^{ dispatch_semaphore_signal(done); }];
+    XCTAssertEqual(dispatch_semaphore_wait(done, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(10 * NSEC_PER_SEC))), 0L);
+
+    XCTAssertNotNil([SHModelClassPlan cachedPlanForClass:[SHPrewarmModel class]]);
+    XCTAssertNotNil([SHModelClassPlan cachedPlanForClass:[SHPrewarmFeaturedModel class]]);
+    XCTAssertNotNil([SHModelClassPlan cachedPlanForClass:[SHPrewarmItemModel class]]);
+}
+
+#pragma mark - decoding statistics
+
+- (void)testDecodingStatisticsCountKeysAndTimes
+{
+    NSDictionary *mappings = @{ @"entries" : @"SHAnotherModel" };
+    [SHDecodingStatistics reset];
+    [SHDecodingStatistics setEnabled:YES];
+    SHFeedModel *feed = [SHFeedModel objectWithDictionary:[self feedDictionaryWithEntryCount:3] mappings:mappings];
+    NSArray *models = [SHAnotherModel objectsWithArray:@[ @{@"model_id" : @1, @"unknown" : @2}, @"not a dictionary" ]];
+    [SHDecodingStatistics setEnabled:NO];
+    XCTAssertNotNil(feed);
+    XCTAssertEqual([models count], (NSUInteger)1);
+
+    NSDictionary *snapshot = [SHDecodingStatistics snapshot];
+    SHDecodingStatistics *feedStatistics = snapshot[@"SHFeedModel"];
+    XCTAssertEqual(feedStatistics.modelClass, [SHFeedModel class]);
+    XCTAssertEqual(feedStatistics.objectsDecoded, 1ULL);
+    XCTAssertEqual(feedStatistics.keysMatched, 4ULL);
+    XCTAssertEqual(feedStatistics.keysDropped, 0ULL);
+    XCTAssertTrue(feedStatistics.nestedDecodingNanoseconds > 0);
+
+    // the featured model, three entries and the array
+    SHDecodingStatistics *modelStatistics = snapshot[@"SHAnotherModel"];
+    XCTAssertEqual(modelStatistics.objectsDecoded, 5ULL);
+    XCTAssertEqual(modelStatistics.keysMatched, 12ULL);
+    XCTAssertEqual(modelStatistics.keysDropped, 1ULL);
+    XCTAssertEqual(modelStatistics.typeMismatches, 1ULL);
+
+    // nothing is counted while disabled
+    [SHFeedModel objectWithDictionary:[self feedDictionaryWithEntryCount:3] mappings:mappings];
+    XCTAssertEqual([[SHDecodingStatistics snapshot][@"SHFeedModel"] objectsDecoded], 1ULL);
+}
+
+- (void)testDecodingStatisticsFlushToSink
+{
+    __block NSDictionary *flushed = nil;
+    [SHDecodingStatistics reset];
+    [SHDecodingStatistics setSink:^(NSDictionary *statistics) { flushed = statistics; }];
+    [SHDecodingStatistics setEnabled:YES];
+    NSDictionary *dates = @{ @"time1" : @"/Date(1398000000000)/" };
+    [SHTestModal objectWithDictionary:dates
+                 dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                        inputDateType:kInputDateFormatJSON
+                             mappings:nil];
+    [SHDecodingStatistics setEnabled:NO];
+    [SHDecodingStatistics flush];
+    [SHDecodingStatistics setSink:nil];
+
+    SHDecodingStatistics *statistics = flushed[@"SHTestModal"];
+    XCTAssertEqual(statistics.objectsDecoded, 1ULL);
+    XCTAssertTrue(statistics.dateConversionNanoseconds > 0);
+    XCTAssertEqual([[SHDecodingStatistics snapshot] count], (NSUInteger)0);
+}
+
+#pragma mark - Pooling
+
+- (void)testPoolForNilClassIsNil
+{
+    XCTAssertNil([SHModelObjectPool poolForClass:Nil]);
+}
+
+- (void)testPoolRecyclesClearedObjects
+{
+    SHModelObjectPool *pool = [SHModelObjectPool poolForClass:[SHPrimitiveModel class]];
+    [pool drain];
+    SHPrimitiveModel *model = [pool objectWithDictionary:@{
+        @"int_value" : @42,
+        @"double_value" : @3.25,
+        @"doubled_value" : @21,
+        @"weak_value" : self
+    }];
+    XCTAssertEqual(model.doubledValue, 42);
+    [pool recycleObject:model];
+    XCTAssertEqual(pool.idleCount, (NSUInteger)1);
+
+    SHPrimitiveModel *reused = [pool objectWithDictionary:@{ @"flag" : @YES }];
+    XCTAssertEqual(reused, model);
+    XCTAssertEqual(pool.idleCount, (NSUInteger)0);
+    XCTAssertEqualObjects([reused valueForKey:@"_intValue"], @0);
+    XCTAssertEqualObjects([reused valueForKey:@"_flag"], @YES);
+    XCTAssertEqual(reused.doubleValue, 0.0);
+    XCTAssertEqual(reused.doubledValue, 0);
+    XCTAssertNil([reused valueForKey:@"_weakValue"]);
+}
+
+- (void)testPoolKeepsAtMostCapacityObjects
+{
+    SHModelObjectPool *pool = [SHModelObjectPool poolForClass:[SHFeedModel class]];
+    [pool drain];
+    pool.capacity = 4;
+    dispatch_apply(64, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        [pool recycleObject:[pool objectWithDictionary:@{ @"title" : @"title", @"count" : @(i) }]];
+    });
+    XCTAssertTrue(pool.idleCount <= 4);
+
+    pool.capacity = 1;
+    XCTAssertTrue(pool.idleCount <= 1);
+    [SHModelObjectPool drainAllPools];
+    XCTAssertEqual(pool.idleCount, (NSUInteger)0);
+    pool.capacity = 64;
+}
+
+- (void)testPoolSkipsObservedObjects
+{
+    SHModelObjectPool *pool = [SHModelObjectPool poolForClass:[SHPrimitiveModel class]];
+    [pool drain];
+    SHPrimitiveModel *model = [pool objectWithDictionary:@{ @"int_value" : @5 }];
+    [model addObserver:self forKeyPath:@"_intValue" options:NSKeyValueObservingOptionNew context:NULL];
+    [pool recycleObject:model];
+    XCTAssertEqual(pool.idleCount, (NSUInteger)0);
+    XCTAssertEqualObjects([model valueForKey:@"_intValue"], @5);
+    [model removeObserver:self forKeyPath:@"_intValue"];
+}
+
+#pragma mark - Decoding sessions
+
+- (NSArray *)commentDictionariesWithCount:(NSUInteger)count
+{
+    NSMutableArray *comments = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [comments addObject:@{
+            @"text" : [NSString stringWithFormat:@"comment %lu", (unsigned long)i],
+            @"model_type" : [NSMutableString stringWithString:@"comment"],
+            @"author" : @{ @"id" : [NSString stringWithFormat:@"%lu", (unsigned long)(i % 3)], @"name" : @"name" }
+        }];
+    }
+    return comments;
+}
+
+- (void)testSessionSharesObjectsWithTheSamePrimaryKey
+{
+    NSArray *dictionaries = [self commentDictionariesWithCount:3000];
+    SHDecodingSession *session = [[SHDecodingSession alloc] init];
+    __block NSArray *comments = nil;
+    [session performDecoding:^{
+        comments = [SHCommentModel objectsWithArray:dictionaries];
+    }];
+    XCTAssertNil([SHDecodingSession currentSession]);
+    XCTAssertEqual([comments count], (NSUInteger)3000);
+    XCTAssertEqual(session.objectCount, (NSUInteger)3);
+    XCTAssertEqual([comments[0] valueForKey:@"_author"], [comments[3] valueForKey:@"_author"]);
+    SHAuthorModel *author = [session objectOfClass:[SHAuthorModel class] primaryKey:@"2"];
+    XCTAssertEqual([comments[2999] valueForKey:@"_author"], author);
+    XCTAssertEqual([comments[0] valueForKey:@"_modelType"], [comments[2999] valueForKey:@"_modelType"]);
+    XCTAssertEqual(session.internedStringCount, (NSUInteger)1);
+
+    // outside of a session every dictionary gets its own object
+    NSArray *unshared = [SHCommentModel objectsWithArray:dictionaries];
+    XCTAssertNotEqual([unshared[0] valueForKey:@"_author"], [unshared[3] valueForKey:@"_author"]);
+    XCTAssertNotEqual([unshared[0] valueForKey:@"_modelType"], [unshared[3] valueForKey:@"_modelType"]);
+}
+
+- (void)testSessionSharesObjectsDecodedFromJSONData
+{
+    NSData *first = [self JSONDataWithObject:@{ @"text" : @"a", @"author" : @{ @"id" : @"1", @"name" : @"first" } }];
+    NSData *second = [self JSONDataWithObject:@{ @"text" : @"b", @"author" : @{ @"id" : @"1", @"name" : @"second" } }];
+    SHDecodingSession *session = [[SHDecodingSession alloc] init];
+    __block SHCommentModel *firstComment = nil;
+    __block SHCommentModel *secondComment = nil;
+    [session performDecoding:^{
+        firstComment = [SHCommentModel objectWithJSONData:first];
+        secondComment = [SHCommentModel objectWithJSONData:second];
+    }];
+    SHAuthorModel *author = [firstComment valueForKey:@"_author"];
+    XCTAssertEqual([secondComment valueForKey:@"_author"], author);
+    XCTAssertEqualObjects([author valueForKey:@"_name"], @"first");
+
+    [session removeAllObjects];
+    XCTAssertEqual(session.objectCount, (NSUInteger)0);
+}
+
+#pragma mark - Value converters
+
+- (void)testConvertersCoerceStringsAndNumbers
+{
+    SHConverterModel *model = [SHConverterModel objectWithDictionary:@{
+        @"label" : @42,
+        @"count" : @"17",
+        @"enabled" : @"true",
+        @"ratio" : @"0.25",
+        @"amount" : @"-3",
+        @"price" : @"19.99"
+    }];
+    XCTAssertEqualObjects([model valueForKey:@"_label"], @"42");
+    XCTAssertEqualObjects([model valueForKey:@"_count"], @17);
+    XCTAssertEqualObjects([model valueForKey:@"_enabled"], @YES);
+    XCTAssertEqualObjects([model valueForKey:@"_ratio"], @0.25);
+    XCTAssertEqualObjects([model valueForKey:@"_amount"], @(-3));
+    XCTAssertEqualObjects([model valueForKey:@"_price"], [NSDecimalNumber decimalNumberWithString:@"19.99"]);
+    XCTAssertTrue([[model valueForKey:@"_price"] isKindOfClass:[NSDecimalNumber class]]);
+
+    model = [SHConverterModel objectWithJSONData:[self JSONDataWithObject:@{ @"label" : @7, @"enabled" : @"no" }]];
+    XCTAssertEqualObjects([model valueForKey:@"_label"], @"7");
+    XCTAssertEqualObjects([model valueForKey:@"_enabled"], @NO);
+}
+
+- (void)testConvertersCoerceNonNumericStringsLeniently
+{
+    SHConverterModel *model = [SHConverterModel objectWithDictionary:@{
+        @"count" : @" 12",
+        @"enabled" : @"Y",
+        @"ratio" : @"1,5",
+        @"amount" : @"12px",
+        @"price" : @"3.50 EUR"
+    }];
+    XCTAssertEqualObjects([model valueForKey:@"_count"], @12);
+    XCTAssertEqualObjects([model valueForKey:@"_enabled"], @YES);
+    XCTAssertEqualObjects([model valueForKey:@"_ratio"], @1);
+    XCTAssertEqualObjects([model valueForKey:@"_amount"], @12);
+    XCTAssertEqualObjects([model valueForKey:@"_price"], [NSDecimalNumber decimalNumberWithString:@"3.5"]);
+
+    model = [SHConverterModel objectWithJSONData:[self JSONDataWithObject:@{ @"count" : @"n/a", @"ratio" : @"" }]];
+    XCTAssertEqualObjects([model valueForKey:@"_count"], @0);
+    XCTAssertEqualObjects([model valueForKey:@"_ratio"], @0);
+}
+
+- (void)testConvertersUseRegisteredAndSchemaTransformers
+{
+    [NSValueTransformer setValueTransformer:[[SHURLTransformer alloc] init] forName:@"SHURLTransformer"];
+    [SHModelObject setValueTransformer:[[SHURLTransformer alloc] init] forClass:[NSURL class]];
+    NSDictionary *dictionary = @{ @"link" : @"http://grevolution.me", @"mirror" : @"http://example.com" };
+    SHTransformerModel *model = [SHTransformerModel objectWithDictionary:dictionary];
+    [SHModelObject setValueTransformer:nil forClass:[NSURL class]];
+
+    XCTAssertEqualObjects([model valueForKey:@"_link"], [NSURL URLWithString:@"http://grevolution.me"]);
+    XCTAssertEqualObjects([model valueForKey:@"_mirror"], [NSURL URLWithString:@"http://example.com"]);
+    NSDictionary *exported = [model dictionaryRepresentation];
+    XCTAssertEqualObjects(exported[@"_link"], @"http://grevolution.me");
+    XCTAssertEqualObjects(exported[@"_mirror"], @"http://example.com");
+}
+
+- (void)testContextIsHandedToNestedModels
+{
+    SHDecodingContext *context =
+        [[SHDecodingContext alloc] initWithDateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                                inputDateFormat:@"dd.MM.yyyy"
+                                                       mappings:nil];
+    NSDictionary *dictionary = @{
+        @"updated" : @"20.04.2014",
+        @"main" : @{@"start" : @"21.04.2014"},
+        @"events" : @[ @{@"start" : @"22.04.2014"}, @{@"start" : @"23.04.2014"} ]
+    };
+    NSData *json = [NSJSONSerialization dataWithJSONObject:dictionary options:0 error:nil];
+    NSDateFormatter *formatter = [context dateFormatter];
+
+    for (SHScheduleModel *schedule in @[
+             [SHScheduleModel objectWithDictionary:dictionary context:context],
+             [SHScheduleModel objectWithJSONData:json context:context]
+         ]) {
+        XCTAssertEqualObjects([schedule valueForKey:@"updated"], [formatter dateFromString:@"20.04.2014"]);
+        SHEventModel *main = [schedule valueForKey:@"main"];
+        XCTAssertEqualObjects([main valueForKey:@"start"], [formatter dateFromString:@"21.04.2014"]);
+        XCTAssertEqual(main.decodingContext, context);
+        NSArray *events = [schedule valueForKey:@"events"];
+        XCTAssertEqual([events count], (NSUInteger)2);
+        XCTAssertEqualObjects([events[1] valueForKey:@"start"], [formatter dateFromString:@"23.04.2014"]);
+        XCTAssertEqual([events[1] decodingContext], context);
+    }
+}
+
+- (void)testArrayVariantsShareOneContext
+{
+    NSArray *dictionaries = @[ @{@"model_id" : @1}, @{@"model_id" : @2}, @{@"model_id" : @3} ];
+    NSArray *models = [SHAnotherModel objectsWithArray:dictionaries
+                                  dateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                       inputDateFormat:@"dd.MM.yyyy"
+                                              mappings:nil];
+
+    XCTAssertEqual([models count], (NSUInteger)3);
+    SHDecodingContext *context = [models[0] decodingContext];
+    XCTAssertEqual(context.inputDateFormat, kInputDateFormatCustom);
+    XCTAssertEqualObjects(context.dateFormat, @"dd.MM.yyyy");
+    for (SHAnotherModel *model in models) {
+        XCTAssertEqual(model.decodingContext, context);
+    }
+    XCTAssertEqual([[SHAnotherModel objectWithDictionary:dictionaries[0]] decodingContext],
+                   [SHDecodingContext defaultContext]);
+    XCTAssertEqual([[[SHAnotherModel alloc] init] decodingContext], [SHDecodingContext defaultContext]);
+}
+
+- (void)testCollectionStoresRowsInColumns
+{
+    NSArray *dictionaries = @[
+        @{@"model_id" : @1, @"model_name" : @"first", @"model_type" : @"post"},
+        @"not a dictionary",
+        @{@"model_id" : @2, @"model_name" : @"second", @"model_type" : @"post"},
+        @{@"model_id" : @3, @"model_type" : @"comment"}
+    ];
+    SHModelCollection *collection = [SHModelCollection collectionWithArray:dictionaries
+                                                                modelClass:[SHAnotherModel class]];
+
+    XCTAssertEqual(collection.count, (NSUInteger)3);
+    // `post` is stored once
+    XCTAssertEqual(collection.uniqueStringCount, (NSUInteger)4);
+    XCTAssertEqualObjects(collection[1][@"modelName"], @"second");
+    XCTAssertNil(collection[2][@"modelName"]);
+    XCTAssertEqual([collection[2] longLongValueForKey:@"model_id"], 3LL);
+
+    __block NSUInteger rows = 0;
+    [collection enumerateRowsUsingBlock:^(SHModelRow *row, BOOL *stop) {
+        XCTAssertEqual(row.index, rows);
+        rows++;
+    }];
+    XCTAssertEqual(rows, (NSUInteger)3);
+
+    NSArray *objects = [collection allObjects];
+    SHAnotherModel *second = objects[1];
+    XCTAssertEqual(second.modelId, 2);
+    XCTAssertEqualObjects(second.modelName, @"second");
+    XCTAssertEqualObjects(second.modelType, @"post");
+
+    SHModelCollection *fromObjects = [SHModelCollection collectionWithObjects:objects];
+    XCTAssertEqual(fromObjects.count, (NSUInteger)3);
+    XCTAssertEqualObjects(fromObjects[0][@"modelType"], @"post");
+    XCTAssertEqualObjects([fromObjects sumForKey:@"modelId"], @6);
+}
+
+- (void)testCollectionAggregatesNumericColumns
+{
+    NSArray *dictionaries = @[
+        @{@"int_value" : @5, @"double_value" : @1.5, @"ratio" : @2},
+        @{@"int_value" : @-3, @"double_value" : @0.25, @"ratio" : @(NAN)},
+        @{@"int_value" : @5, @"double_value" : @-4, @"ratio" : @1},
+        @{@"int_value" : @7, @"double_value" : @10, @"ratio" : @3}
+    ];
+    SHModelCollection *collection = [SHModelCollection collectionWithArray:dictionaries
+                                                                modelClass:[SHPrimitiveModel class]];
+
+    XCTAssertTrue([collection isNumericKey:@"intValue"]);
+    XCTAssertFalse([collection isNumericKey:@"weakValue"]);
+    XCTAssertEqualObjects([collection sumForKey:@"intValue"], @14);
+    XCTAssertEqualWithAccuracy([[collection sumForKey:@"doubleValue"] doubleValue], 7.75, 0.0001);
+    XCTAssertEqualObjects([collection minimumForKey:@"intValue"], @-3);
+    XCTAssertEqualObjects([collection maximumForKey:@"doubleValue"], @10);
+    XCTAssertEqualObjects([collection minimumForKey:@"ratio"], @1);
+    XCTAssertNil([collection sumForKey:@"weakValue"]);
+    XCTAssertNil([collection sumForKey:@"unknown"]);
+
+    NSIndexSet *indexes = [collection indexesForKey:@"doubleValue" from:0 to:2];
+    XCTAssertEqualObjects(indexes, [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 2)]);
+    SHModelCollection *filtered = [collection collectionWithIndexes:indexes];
+    XCTAssertEqualObjects([filtered sumForKey:@"intValue"], @2);
+
+    // stable, the two rows with 5 keep their order
+    SHModelCollection *sorted = [collection collectionSortedByKey:@"intValue" ascending:NO];
+    XCTAssertEqual([sorted longLongValueAtIndex:0 forKey:@"intValue"], 7LL);
+    XCTAssertEqual([sorted doubleValueAtIndex:1 forKey:@"doubleValue"], 1.5);
+    XCTAssertEqual([sorted doubleValueAtIndex:2 forKey:@"doubleValue"], -4.0);
+    XCTAssertEqual([sorted longLongValueAtIndex:3 forKey:@"intValue"], -3LL);
+
+    // NaN goes last
+    SHModelCollection *byRatio = [collection collectionSortedByKey:@"ratio" ascending:YES];
+    XCTAssertEqual([byRatio doubleValueAtIndex:0 forKey:@"ratio"], 1.0);
+    XCTAssertTrue(isnan([byRatio doubleValueAtIndex:3 forKey:@"ratio"]));
+}
+
+- (void)testOnlyKeysDecodesProjectedFields
+{
+    NSDictionary *dictionary = @{
+        @"text" : @"first",
+        @"model_type" : @"comment",
+        @"author" : @{@"id" : @"a1", @"name" : @"Shan"}
+    };
+    NSData *json = [NSJSONSerialization dataWithJSONObject:dictionary options:0 error:nil];
+    NSSet *keys = [NSSet setWithObjects:@"text", @"author.name", nil];
+    SHDecodingContext *context = [[SHDecodingContext defaultContext] contextWithOnlyKeys:keys];
+    XCTAssertEqualObjects(context.onlyKeys, keys);
+
+    for (SHCommentModel *comment in @[
+             [SHCommentModel objectWithDictionary:dictionary onlyKeys:keys],
+             [SHCommentModel objectWithJSONData:json context:context]
+         ]) {
+        XCTAssertEqualObjects([comment valueForKey:@"text"], @"first");
+        XCTAssertNil([comment valueForKey:@"modelType"]);
+        SHAuthorModel *author = [comment valueForKey:@"author"];
+        XCTAssertEqualObjects([author valueForKey:@"name"], @"Shan");
+        XCTAssertNil([author valueForKey:@"id"]);
+    }
+
+    // a field without a path is decoded whole
+    SHCommentModel *whole = [SHCommentModel objectWithDictionary:dictionary
+                                                        onlyKeys:[NSSet setWithObjects:@"_author", nil]];
+    XCTAssertNil([whole valueForKey:@"text"]);
+    XCTAssertEqualObjects([[whole valueForKey:@"author"] valueForKey:@"id"], @"a1");
+    XCTAssertNil([[[whole valueForKey:@"author"] decodingContext] onlyKeys]);
+}
+
+- (void)testOnlyKeysMatchIvarsSpelledDifferently
+{
+    NSDictionary *dictionary = @{
+        @"text" : @"first",
+        @"model_type" : @"comment",
+        @"author" : @{@"id" : @"a1", @"name" : @"Shan"}
+    };
+    for (NSSet *keys in @[
+             [NSSet setWithObjects:@"text", @"model_type", nil],
+             [NSSet setWithObjects:@"Text", @"modelType", nil],
+             [NSSet setWithObjects:@"_text", @"MODEL-TYPE", nil]
+         ]) {
+        SHCommentModel *comment = [SHCommentModel objectWithDictionary:dictionary onlyKeys:keys];
+        XCTAssertEqualObjects([comment valueForKey:@"text"], @"first", @"%@", keys);
+        XCTAssertEqualObjects([comment valueForKey:@"modelType"], @"comment", @"%@", keys);
+        XCTAssertNil([comment valueForKey:@"author"], @"%@", keys);
+    }
+}
+
+- (void)testOnlyKeysReachIntoMappedArrays
+{
+    SHDecodingContext *context =
+        [[SHDecodingContext alloc] initWithDateConversionOption:kDateConverstionFromNSStringToNSDateOption
+                                                inputDateFormat:@"dd.MM.yyyy"
+                                                       mappings:nil];
+    SHDecodingContext *projected = [context contextWithOnlyKeys:[NSSet setWithObjects:@"events.start", nil]];
+    XCTAssertEqualObjects(projected.dateFormat, @"dd.MM.yyyy");
+    NSDictionary *dictionary = @{
+        @"updated" : @"20.04.2014",
+        @"main" : @{@"start" : @"21.04.2014"},
+        @"events" : @[ @{@"start" : @"22.04.2014"}, @{@"start" : @"23.04.2014"} ]
+    };
+    NSData *json = [NSJSONSerialization dataWithJSONObject:dictionary options:0 error:nil];
+
+    for (SHScheduleModel *schedule in @[
+             [SHScheduleModel objectWithDictionary:dictionary context:projected],
+             [SHScheduleModel objectWithJSONData:json context:projected]
+         ]) {
+        XCTAssertNil([schedule valueForKey:@"updated"]);
+        XCTAssertNil([schedule valueForKey:@"main"]);
+        NSArray *events = [schedule valueForKey:@"events"];
+        XCTAssertEqual([events count], (NSUInteger)2);
+        XCTAssertEqualObjects([events[1] valueForKey:@"start"], [[context dateFormatter] dateFromString:@"23.04.2014"]);
+    }
+
+    NSArray *comments = [SHCommentModel objectsWithArray:@[ @{@"text" : @"first"}, @{@"text" : @"second"} ]
+                                                onlyKeys:[NSSet setWithObjects:@"author", nil]];
+    XCTAssertEqual([comments count], (NSUInteger)2);
+    XCTAssertEqual([comments[0] decodingContext], [comments[1] decodingContext]);
+    XCTAssertNil([comments[1] valueForKey:@"text"]);
+}
+
+- (void)testOnlyKeysApplyToTheirDecodeOnly
+{
+    NSDictionary *dictionary = @{ @"text" : @"first", @"author" : @{@"id" : @"a1", @"name" : @"Shan"} };
+    NSSet *keys = [NSSet setWithObjects:@"text", @"author.id", nil];
+    SHDecodingSession *session = [[SHDecodingSession alloc] init];
+    __block SHCommentModel *projected = nil;
+    __block SHCommentModel *projectedFromJSON = nil;
+    __block SHCommentModel *full = nil;
+    [session performDecoding:^{
+        projected = [SHCommentModel objectWithDictionary:dictionary onlyKeys:keys];
+        projectedFromJSON = [SHCommentModel objectWithJSONData:[self JSONDataWithObject:dictionary]
+                                                       context:[[SHDecodingContext defaultContext]
+                                                                   contextWithOnlyKeys:keys]];
+        full = [SHCommentModel objectWithDictionary:dictionary];
+    }];
+
+    // projected authors are not shared, the full decode gets a complete author
+    XCTAssertNil([[projected valueForKey:@"author"] valueForKey:@"name"]);
+    XCTAssertNil([[projectedFromJSON valueForKey:@"author"] valueForKey:@"name"]);
+    SHAuthorModel *author = [full valueForKey:@"author"];
+    XCTAssertEqualObjects([author valueForKey:@"name"], @"Shan");
+    XCTAssertEqual([session objectOfClass:[SHAuthorModel class] primaryKey:@"a1"], author);
+    XCTAssertNil([projected.decodingContext onlyKeys]);
+    XCTAssertNil([[[projected valueForKey:@"author"] decodingContext] onlyKeys]);
+
+    // later updates decode every field
+    NSSet *changedKeys = [projected changedKeysByUpdatingWithDictionary:@{ @"model_type" : @"comment" }];
+    XCTAssertEqualObjects(changedKeys, [NSSet setWithObject:@"model_type"]);
+    [projectedFromJSON updateWithDictionary:@{ @"model_type" : @"comment", @"author" : @{@"name" : @"Shan"} }];
+    XCTAssertEqualObjects([projectedFromJSON valueForKey:@"modelType"], @"comment");
+    XCTAssertEqualObjects([[projectedFromJSON valueForKey:@"author"] valueForKey:@"name"], @"Shan");
+    [full updateWithDictionary:@{ @"text" : @"second" }];
+    XCTAssertEqualObjects([full valueForKey:@"text"], @"second");
+}
+
+- (void)testEqualityAndCopyUseTheIvarLayout
+{
+    NSDictionary *dictionary = @{
+        @"int_value" : @5,
+        @"flag" : @YES,
+        @"ratio" : @0.5,
+        @"big_value" : @12345678901234ULL,
+        @"doubled_value" : @3,
+        @"double_value" : @1.5
+    };
+    SHPrimitiveModel *first = [SHPrimitiveModel objectWithDictionary:dictionary];
+    SHPrimitiveModel *second = [SHPrimitiveModel objectWithDictionary:dictionary];
+    XCTAssertEqualObjects(first, second);
+    XCTAssertEqual([first hash], [second hash]);
+    XCTAssertEqual([[NSSet setWithObjects:first, second, nil] count], (NSUInteger)1);
+
+    second.doubleValue = 2.5;
+    XCTAssertNotEqualObjects(first, second);
+    XCTAssertFalse([first isEqual:[SHAnotherModel objectWithDictionary:@{}]]);
+
+    // the custom setter of `_doubledValue` is not called again
+    SHPrimitiveModel *copy = [first copy];
+    XCTAssertNotEqual(copy, first);
+    XCTAssertEqualObjects(copy, first);
+    XCTAssertEqual(copy.doubledValue, 6);
+    XCTAssertEqual(copy.doubleValue, 1.5);
+    XCTAssertEqual(copy.decodingContext, first.decodingContext);
+
+    // only the primary key is hashed
+    SHAuthorModel *author = [SHAuthorModel objectWithDictionary:@{@"id" : @"a1", @"name" : @"Shan"}];
+    SHAuthorModel *renamed = [SHAuthorModel objectWithDictionary:@{@"id" : @"a1", @"name" : @"Ul Haq"}];
+    XCTAssertEqual([author hash], [renamed hash]);
+    XCTAssertNotEqualObjects(author, renamed);
+}
+
+- (void)testEqualityComparesFloatsByValueAndSkipsPadding
+{
+    SHPaddedEntry entry;
+    memset(&entry, 0xAB, sizeof(entry));
+    entry.tag = 'a';
+    entry.amount = 1.5;
+    SHPaddedEntry otherEntry;
+    memset(&otherEntry, 0, sizeof(otherEntry));
+    otherEntry.tag = 'a';
+    otherEntry.amount = 1.5;
+
+    SHPaddedModel *first = [[SHPaddedModel alloc] init];
+    SHPaddedModel *second = [[SHPaddedModel alloc] init];
+    [first copyEntryBytes:&entry];
+    [second copyEntryBytes:&otherEntry];
+    first.ratio = 0.0;
+    second.ratio = -0.0;
+    XCTAssertEqualObjects(first, second);
+    XCTAssertEqual([first hash], [second hash]);
+
+    otherEntry.amount = -1.5;
+    [second copyEntryBytes:&otherEntry];
+    XCTAssertNotEqualObjects(first, second);
+
+    SHPaddedModel *notANumber = [[SHPaddedModel alloc] init];
+    notANumber.ratio = NAN;
+    XCTAssertFalse([notANumber isEqual:[notANumber copy]]);
+}
+
+- (void)testKeyedUnarchivingSkipsMissingIvars
+{
+    NSMutableData *data = [NSMutableData data];
+    NSKeyedArchiver *archiver = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+    [archiver setClassName:NSStringFromClass([SHPrimitiveModel class]) forClass:[SHLegacyPrimitiveArchive class]];
+    [archiver encodeObject:[[SHLegacyPrimitiveArchive alloc] init] forKey:NSKeyedArchiveRootObjectKey];
+    [archiver finishEncoding];
+
+    SHPrimitiveModel *model = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+    XCTAssertTrue([model isKindOfClass:[SHPrimitiveModel class]]);
+    XCTAssertEqualObjects([model valueForKey:@"_intValue"], @7);
+    XCTAssertEqualObjects([model valueForKey:@"_flag"], @NO);
+    XCTAssertEqual(model.doubleValue, 0.0);
+}
+
+- (void)testDeepCopyCopiesNestedModels
+{
+    NSDictionary *dictionary = @{
+        @"title" : @"feed",
+        @"count" : @2,
+        @"featured" : @{@"model_id" : @1, @"model_name" : @"featured"},
+        @"entries" : @[ @{@"model_id" : @2}, @{@"model_id" : @3} ]
+    };
+    NSDictionary *mappings = @{ @"entries" : @"SHAnotherModel" };
+    SHFeedModel *feed = [SHFeedModel objectWithDictionary:dictionary mappings:mappings];
+
+    SHFeedModel *copy = [feed copy];
+    XCTAssertEqual([copy valueForKey:@"featured"], [feed valueForKey:@"featured"]);
+
+    SHFeedModel *deepCopy = [feed deepCopy];
+    XCTAssertEqualObjects(deepCopy, feed);
+    XCTAssertNotEqual([deepCopy valueForKey:@"featured"], [feed valueForKey:@"featured"]);
+    XCTAssertEqualObjects([deepCopy valueForKey:@"featured"], [feed valueForKey:@"featured"]);
+    XCTAssertNotEqual([deepCopy valueForKey:@"entries"][1], [feed valueForKey:@"entries"][1]);
+    XCTAssertEqual([[deepCopy valueForKey:@"entries"][1] modelId], 3);
+
+    // lazy values are decoded before they are compared
+    SHLazyFeedModel *lazy = [SHLazyFeedModel objectWithDictionary:dictionary mappings:mappings];
+    XCTAssertEqualObjects(lazy, [SHLazyFeedModel objectWithDictionary:dictionary mappings:mappings]);
+    XCTAssertEqualObjects([[lazy deepCopy] valueForKey:@"featured"], [feed valueForKey:@"featured"]);
+}
+
+- (SHTreeNodeModel *)treeWithChildNames:(NSArray *)names
+{
+    SHTreeNodeModel *root = [[SHTreeNodeModel alloc] init];
+    root.name = @"root";
+    NSMutableArray *children = [NSMutableArray array];
+    for (NSString *name in names) {
+        SHTreeNodeModel *child = [[SHTreeNodeModel alloc] init];
+        child.name = name;
+        child.parent = root;
+        [children addObject:child];
+    }
+    root.children = children;
+    return root;
+}
+
+- (void)testEqualityAndDeepCopyHandleCycles
+{
+    SHTreeNodeModel *tree = [self treeWithChildNames:@[ @"a", @"b" ]];
+    SHTreeNodeModel *sameTree = [self treeWithChildNames:@[ @"a", @"b" ]];
+    XCTAssertEqualObjects(tree, sameTree);
+    XCTAssertEqual([tree hash], [sameTree hash]);
+    XCTAssertNotEqualObjects(tree, [self treeWithChildNames:@[ @"a", @"c" ]]);
+    XCTAssertEqualObjects(tree.children[1], sameTree.children[1]);
+
+    SHTreeNodeModel *copy = [tree deepCopy];
+    XCTAssertEqualObjects(copy, tree);
+    SHTreeNodeModel *child = copy.children[0];
+    XCTAssertNotEqual(child, tree.children[0]);
+    XCTAssertEqual(child.parent, copy);
+}
+
+- (void)observeValueForKeyPath:(NSString *)keyPath
+                      ofObject:(id)object
+                        change:(NSDictionary *)change
+                       context:(void *)context
+{
+    _observedChanges++;
+}
+
 @end
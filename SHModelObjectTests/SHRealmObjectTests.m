@@ -0,0 +1,166 @@
+// SHRealmObjectTests.m
+//
+// Copyright (c) 2014 Shan Ul Haq (http://grevolution.me)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#import <XCTest/XCTest.h>
+#import <Realm/RLMRealm.h>
+#import "SHRealmObject.h"
+
+// the tests run against the in-memory `RLMRealm` stand-in of `Benchmarks/RealmStub/`, imported on its own because
+// `SHModelObject.h` declares `NSString (Additions)` too
+
+@interface SHRealmAuthor : SHRealmObject
+
+@property NSString *authorId;
+@property NSString *name;
+
+@end
+
+@implementation SHRealmAuthor
+
++ (NSString *)primaryKey {
+    return @"authorId";
+}
+
+@end
+
+@interface SHRealmNote : SHRealmObject
+
+@property NSString *text;
+
+@end
+
+@implementation SHRealmNote
+
+@end
+
+@interface SHRealmObjectTests : XCTestCase
+
+@end
+
+@implementation SHRealmObjectTests {
+    RLMRealm *_realm;
+    NSUInteger _writeBatchSize;
+}
+
+- (void)setUp
+{
+    [super setUp];
+    _realm = [[RLMRealm alloc] init];
+    _writeBatchSize = [SHRealmObject writeBatchSize];
+}
+
+- (void)tearDown
+{
+    [SHRealmObject setWriteBatchSize:_writeBatchSize];
+    _realm = nil;
+    [super tearDown];
+}
+
+- (NSArray *)authorDictionariesWithCount:(NSUInteger)count
+{
+    NSMutableArray *array = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [array addObject:@{
+            @"author_id" : [NSString stringWithFormat:@"a%lu", (unsigned long)i],
+            @"name" : [NSString stringWithFormat:@"author %lu", (unsigned long)i]
+        }];
+    }
+    return array;
+}
+
+- (void)testCreateOrUpdateUpdatesObjectsWithTheSamePrimaryKey
+{
+    NSArray *first = [SHRealmAuthor createOrUpdateObjectsWithArray:[self authorDictionariesWithCount:3] inRealm:_realm];
+    XCTAssertEqual([first count], (NSUInteger)3);
+    XCTAssertEqual([first[0] realm], _realm);
+
+    NSArray *second = [SHRealmAuthor createOrUpdateObjectsWithArray:@[ @{@"author_id" : @"a1", @"name" : @"renamed"} ]
+                                                            inRealm:_realm];
+    XCTAssertEqual([second count], (NSUInteger)1);
+    XCTAssertEqualObjects([second[0] name], @"renamed");
+    XCTAssertEqual([_realm countOfObjectsOfClass:[SHRealmAuthor class]], (NSUInteger)3);
+}
+
+- (void)testCreateOrUpdateAppendsObjectsWithoutPrimaryKey
+{
+    NSArray *notes = @[ @{@"text" : @"first"}, @{@"text" : @"second"} ];
+    XCTAssertEqual([[SHRealmNote createOrUpdateObjectsWithArray:notes inRealm:_realm] count], (NSUInteger)2);
+    XCTAssertEqual([[SHRealmNote createOrUpdateObjectsWithArray:notes inRealm:_realm] count], (NSUInteger)2);
+    XCTAssertEqual([_realm countOfObjectsOfClass:[SHRealmNote class]], (NSUInteger)4);
+}
+
+- (void)testCreateOrUpdateWritesInBatches
+{
+    NSArray *authors = [self authorDictionariesWithCount:7];
+    [SHRealmObject setWriteBatchSize:3];
+    XCTAssertEqual([[SHRealmAuthor createOrUpdateObjectsWithArray:authors inRealm:_realm] count], (NSUInteger)7);
+    XCTAssertEqual(_realm.commitCount, (NSUInteger)3);
+
+    [SHRealmObject setWriteBatchSize:1];
+    XCTAssertEqual([[SHRealmAuthor createOrUpdateObjectsWithArray:authors inRealm:_realm] count], (NSUInteger)7);
+    XCTAssertEqual(_realm.commitCount, (NSUInteger)10);
+    XCTAssertEqual([_realm countOfObjectsOfClass:[SHRealmAuthor class]], (NSUInteger)7);
+
+    [SHRealmObject setWriteBatchSize:0];
+    XCTAssertEqual([SHRealmObject writeBatchSize], (NSUInteger)1);
+}
+
+- (void)testCreateOrUpdateDoesNotCommitTheCallersTransaction
+{
+    [_realm beginWriteTransaction];
+    NSArray *authors = [self authorDictionariesWithCount:5];
+    NSArray *objects = [SHRealmAuthor createOrUpdateObjectsWithArray:authors inRealm:_realm];
+    XCTAssertEqual([objects count], (NSUInteger)5);
+    XCTAssertTrue(_realm.inWriteTransaction);
+    XCTAssertEqual(_realm.commitCount, (NSUInteger)0);
+    XCTAssertEqual([_realm countOfObjectsOfClass:[SHRealmAuthor class]], (NSUInteger)0);
+
+    XCTAssertTrue([_realm commitWriteTransaction:NULL]);
+    XCTAssertEqual([_realm countOfObjectsOfClass:[SHRealmAuthor class]], (NSUInteger)5);
+}
+
+- (void)testCreateOrUpdateReturnsNilWhenACommitFails
+{
+    _realm.nextCommitError = [NSError errorWithDomain:@"io.realm" code:1 userInfo:nil];
+    XCTAssertNil([SHRealmAuthor createOrUpdateObjectsWithArray:[self authorDictionariesWithCount:5] inRealm:_realm]);
+    XCTAssertFalse(_realm.inWriteTransaction);
+    XCTAssertEqual([_realm countOfObjectsOfClass:[SHRealmAuthor class]], (NSUInteger)0);
+}
+
+- (void)testCreateOrUpdateSkipsItemsThatAreNotDictionaries
+{
+    // small arrays are decoded on the calling thread, large ones on all cores
+    for (NSNumber *count in @[ @5, @3000 ]) {
+        NSMutableArray *array = [[self authorDictionariesWithCount:[count unsignedIntegerValue]] mutableCopy];
+        [array insertObject:@"not a dictionary" atIndex:1];
+        [array insertObject:[NSNull null] atIndex:3];
+
+        NSArray *objects = [SHRealmAuthor createOrUpdateObjectsWithArray:array inRealm:_realm];
+        XCTAssertEqual([objects count], [count unsignedIntegerValue]);
+        for (NSUInteger i = 0; i < [objects count]; i++) {
+            XCTAssertEqualObjects([objects[i] authorId], ([NSString stringWithFormat:@"a%lu", (unsigned long)i]));
+        }
+    }
+    XCTAssertNil([SHRealmAuthor createOrUpdateObjectsWithArray:(NSArray *)@{} inRealm:_realm]);
+}
+
+@end